@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+#include "bench_harness.h"
+
+namespace {
+
+std::atomic<std::uint64_t> gAllocations{0};
+volatile std::uint64_t gSink = 0;
+
+double Percentile(const std::vector<double> &sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const auto index = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+} // namespace
+
+void *operator new(std::size_t size) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace mctetris::bench {
+
+std::uint64_t AllocationCount() {
+    return gAllocations.load(std::memory_order_relaxed);
+}
+
+void Consume(std::uint64_t value) {
+    gSink = gSink + value;
+}
+
+BenchHarness::BenchHarness(std::string filter, int samples)
+    : filter_(std::move(filter)), samples_(samples) {}
+
+const std::vector<BenchResult> &BenchHarness::Results() const {
+    return results_;
+}
+
+bool BenchHarness::Enabled(const std::string &name) const {
+    return filter_.empty() || name.find(filter_) != std::string::npos;
+}
+
+void BenchHarness::Record(const std::string &name, std::int64_t batch, std::vector<double> perOp,
+                          std::uint64_t allocs) {
+    BenchResult result;
+    result.name = name;
+    result.samples = static_cast<std::int64_t>(perOp.size());
+    result.opsPerSample = batch;
+    std::sort(perOp.begin(), perOp.end());
+    double total = 0.0;
+    for (double value : perOp) {
+        total += value;
+    }
+    if (!perOp.empty()) {
+        result.meanNs = total / static_cast<double>(perOp.size());
+        result.minNs = perOp.front();
+        result.maxNs = perOp.back();
+    }
+    result.p50Ns = Percentile(perOp, 0.50);
+    result.p90Ns = Percentile(perOp, 0.90);
+    result.p99Ns = Percentile(perOp, 0.99);
+    const double ops = static_cast<double>(result.samples) * static_cast<double>(batch);
+    result.allocsPerOp = ops > 0.0 ? static_cast<double>(allocs) / ops : 0.0;
+    results_.push_back(result);
+    std::fprintf(stderr, "  %s done\n", name.c_str());
+}
+
+void BenchHarness::PrintTable() const {
+    std::printf("%-36s %12s %12s %12s %12s %10s\n", "benchmark", "mean ns/op", "p50", "p90", "p99",
+                "allocs/op");
+    for (const auto &result : results_) {
+        std::printf("%-36s %12.1f %12.1f %12.1f %12.1f %10.3f\n", result.name.c_str(), result.meanNs,
+                    result.p50Ns, result.p90Ns, result.p99Ns, result.allocsPerOp);
+    }
+}
+
+bool BenchHarness::WriteJson(const std::string &path) const {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << "{\n  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results_.size(); ++i) {
+        const auto &result = results_[i];
+        out << "    {\"name\": \"" << result.name << "\""
+            << ", \"samples\": " << result.samples
+            << ", \"ops_per_sample\": " << result.opsPerSample
+            << ", \"ns_per_op\": {\"mean\": " << result.meanNs
+            << ", \"min\": " << result.minNs
+            << ", \"p50\": " << result.p50Ns
+            << ", \"p90\": " << result.p90Ns
+            << ", \"p99\": " << result.p99Ns
+            << ", \"max\": " << result.maxNs << "}"
+            << ", \"allocs_per_op\": " << result.allocsPerOp << "}"
+            << (i + 1 < results_.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+} // namespace mctetris::bench
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mctetris::bench {
+
+struct BenchResult {
+    std::string name;
+    std::int64_t samples = 0;
+    std::int64_t opsPerSample = 0;
+    double meanNs = 0.0;
+    double minNs = 0.0;
+    double p50Ns = 0.0;
+    double p90Ns = 0.0;
+    double p99Ns = 0.0;
+    double maxNs = 0.0;
+    double allocsPerOp = 0.0;
+};
+
+// Heap allocations made by this process so far (counted by the bench binary's
+// replacement operator new).
+[[nodiscard]] std::uint64_t AllocationCount();
+
+// Folds a value into a sink the optimiser cannot see through.
+void Consume(std::uint64_t value);
+
+class BenchHarness {
+  public:
+    BenchHarness(std::string filter, int samples);
+
+    // Times `op` in batches sized so one sample lasts about a tenth of a
+    // millisecond, then records per-op percentiles across samples.
+    template <typename Op>
+    void Run(const std::string &name, Op &&op) {
+        if (!Enabled(name)) {
+            return;
+        }
+        const std::int64_t batch = Calibrate(op);
+        std::vector<double> perOp;
+        perOp.reserve(static_cast<std::size_t>(samples_));
+        const std::uint64_t allocsBefore = AllocationCount();
+        for (int sample = 0; sample < samples_; ++sample) {
+            const auto start = Clock::now();
+            for (std::int64_t i = 0; i < batch; ++i) {
+                op();
+            }
+            const auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            perOp.push_back(elapsed / static_cast<double>(batch));
+        }
+        const std::uint64_t allocs = AllocationCount() - allocsBefore;
+        Record(name, batch, std::move(perOp), allocs);
+    }
+
+    [[nodiscard]] const std::vector<BenchResult> &Results() const;
+    void PrintTable() const;
+    [[nodiscard]] bool WriteJson(const std::string &path) const;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    template <typename Op>
+    std::int64_t Calibrate(Op &op) {
+        constexpr auto kTargetSample = std::chrono::microseconds(100);
+        std::int64_t batch = 1;
+        while (batch < (std::int64_t{1} << 30)) {
+            const auto start = Clock::now();
+            for (std::int64_t i = 0; i < batch; ++i) {
+                op();
+            }
+            if (Clock::now() - start >= kTargetSample) {
+                break;
+            }
+            batch *= 2;
+        }
+        return batch;
+    }
+
+    [[nodiscard]] bool Enabled(const std::string &name) const;
+    void Record(const std::string &name, std::int64_t batch, std::vector<double> perOp, std::uint64_t allocs);
+
+    std::string filter_;
+    int samples_ = 0;
+    std::vector<BenchResult> results_;
+};
+
+void RegisterModelBenches(BenchHarness &harness);
+void RegisterBotBenches(BenchHarness &harness);
+void RegisterEnvBenches(BenchHarness &harness);
+void RegisterRenderBenches(BenchHarness &harness);
+void RegisterScoreBenches(BenchHarness &harness);
+
+} // namespace mctetris::bench
@@ -0,0 +1,72 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string>
+
+#include "bench_harness.h"
+
+namespace {
+
+struct BenchOptions {
+    std::string filter;
+    std::string jsonPath;
+    int samples = 200;
+};
+
+void PrintUsage() {
+    std::fprintf(stderr,
+                 "Usage: mctetris_bench [--filter TEXT] [--samples N] [--json FILE]\n"
+                 "\n"
+                 "Runs the model, bot, env, render and score store microbenchmarks and prints ns/op\n"
+                 "percentiles and heap allocations per op. --json writes the same results for\n"
+                 "diffing.\n");
+}
+
+std::optional<BenchOptions> ParseOptions(int argc, char **argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            return std::nullopt;
+        }
+        const char *arg = argv[i];
+        const char *value = argv[++i];
+        if (std::strcmp(arg, "--filter") == 0) {
+            options.filter = value;
+        } else if (std::strcmp(arg, "--json") == 0) {
+            options.jsonPath = value;
+        } else if (std::strcmp(arg, "--samples") == 0) {
+            options.samples = std::atoi(value);
+            if (options.samples <= 0) {
+                return std::nullopt;
+            }
+        } else {
+            return std::nullopt;
+        }
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const auto options = ParseOptions(argc, argv);
+    if (!options) {
+        PrintUsage();
+        return 1;
+    }
+
+    mctetris::bench::BenchHarness harness(options->filter, options->samples);
+    mctetris::bench::RegisterModelBenches(harness);
+    mctetris::bench::RegisterBotBenches(harness);
+    mctetris::bench::RegisterEnvBenches(harness);
+    mctetris::bench::RegisterRenderBenches(harness);
+    mctetris::bench::RegisterScoreBenches(harness);
+
+    harness.PrintTable();
+    if (!options->jsonPath.empty() && !harness.WriteJson(options->jsonPath)) {
+        std::fprintf(stderr, "mctetris_bench: cannot write '%s'\n", options->jsonPath.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "bench_harness.h"
+#include "bot/batch_features.h"
+#include "bot/bot.h"
+#include "bot/move_generator.h"
+#include "model/game_session.h"
+
+namespace mctetris::bench {
+namespace {
+
+// Games are restarted after this many pieces so the stack stays in the
+// shapes a bot actually sees rather than drifting towards an empty board.
+constexpr int kPiecesPerGame = 200;
+
+bot::BotConfig SearchConfig(int threads, int unknownDepth, int tableBits) {
+    bot::BotConfig config;
+    config.threads = threads;
+    config.unknownDepth = unknownDepth;
+    config.tableBits = tableBits;
+    return config;
+}
+
+void BenchDecide(BenchHarness &harness, const std::string &name, bot::BotConfig config) {
+    bot::Bot player(config);
+    std::mt19937 rng(7);
+    model::GameSession session(rng());
+    harness.Run(name, [&]() {
+        if (session.Model().IsGameOver() || session.PiecesSpawned() > kPiecesPerGame) {
+            session.Reset(rng());
+        }
+        const auto decision = player.Decide(session.Model(), session.NextType());
+        for (const auto action : decision->actions) {
+            (void)model::ApplyReplayAction(session, action);
+        }
+        Consume(static_cast<std::uint64_t>(decision->nodes));
+    });
+}
+
+void BenchSearchParts(BenchHarness &harness) {
+    model::GameSession session(11);
+    bot::Bot player(SearchConfig(1, 0, 0));
+    for (int i = 0; i < 30 && !session.Model().IsGameOver(); ++i) {
+        const auto decision = player.Decide(session.Model(), session.NextType());
+        for (const auto action : decision->actions) {
+            (void)model::ApplyReplayAction(session, action);
+        }
+    }
+    const model::Board board = session.Model().GetBoard();
+    harness.Run("bot::ComputeFeatures", [&]() {
+        Consume(static_cast<std::uint64_t>(bot::ComputeFeatures(board).aggregateHeight));
+    });
+
+    int type = 0;
+    bot::PlacementList placements;
+    harness.Run("bot::EnumeratePlacements", [&]() {
+        bot::EnumeratePlacements(board, model::GameModel::SpawnPosition(static_cast<model::TetrominoType>(type)),
+                                 placements);
+        Consume(static_cast<std::uint64_t>(placements.count));
+        type = (type + 1) % 7;
+    });
+
+    bot::MoveGenerator generator;
+    type = 0;
+    harness.Run("bot::MoveGenerator::Generate", [&]() {
+        Consume(static_cast<std::uint64_t>(
+            generator.Generate(board, model::GameModel::SpawnPosition(static_cast<model::TetrominoType>(type)))));
+        type = (type + 1) % 7;
+    });
+}
+
+// Every board one search ply produces from a few mid-game positions: each
+// placement of each piece, lines cleared.
+std::vector<model::Board> CandidateBoards(int count) {
+    std::vector<model::Board> boards;
+    model::GameSession session(13);
+    bot::Bot player(SearchConfig(1, 0, 0));
+    while (static_cast<int>(boards.size()) < count) {
+        if (session.Model().IsGameOver() || session.PiecesSpawned() > kPiecesPerGame) {
+            session.Reset(static_cast<std::uint32_t>(boards.size()));
+        }
+        const model::Board board = session.Model().GetBoard();
+        bot::PlacementList placements;
+        for (int type = 0; type < 7; ++type) {
+            bot::EnumeratePlacements(
+                board, model::GameModel::SpawnPosition(static_cast<model::TetrominoType>(type)), placements);
+            for (int i = 0; i < placements.count && static_cast<int>(boards.size()) < count; ++i) {
+                model::Board child = board;
+                child.Place(placements.items[i].piece, placements.items[i].x, placements.items[i].y);
+                (void)child.ClearFullLines();
+                boards.push_back(child);
+            }
+        }
+        for (int i = 0; i < 5 && !session.Model().IsGameOver(); ++i) {
+            const auto decision = player.Decide(session.Model(), session.NextType());
+            for (const auto action : decision->actions) {
+                (void)model::ApplyReplayAction(session, action);
+            }
+        }
+    }
+    return boards;
+}
+
+// Compares every kernel against the cell-by-cell reference before timing it,
+// so a wrong kernel fails loudly instead of posting a good number.
+void CheckKernels(const std::vector<model::Board> &boards, const bot::BoardBatch &batch) {
+    bot::FeatureBatch features;
+    for (const auto kernel : {bot::FeatureKernel::Scalar, bot::FeatureKernel::Sse41, bot::FeatureKernel::Avx2}) {
+        if (!bot::KernelSupported(kernel)) {
+            continue;
+        }
+        bot::ComputeFeatureBatch(batch, features, kernel);
+        for (std::size_t i = 0; i < boards.size(); ++i) {
+            const bot::DetailedFeatures expected = bot::ComputeFeaturesReference(boards[i]);
+            const bot::DetailedFeatures actual = features.At(static_cast<int>(i));
+            if (actual.columnHeights != expected.columnHeights || actual.holes != expected.holes ||
+                actual.bumpiness != expected.bumpiness || actual.aggregateHeight != expected.aggregateHeight ||
+                actual.maxHeight != expected.maxHeight || actual.wells != expected.wells ||
+                actual.rowTransitions != expected.rowTransitions) {
+                std::fprintf(stderr, "%s feature kernel disagrees with the reference on board %zu\n",
+                             bot::KernelName(kernel), i);
+                std::abort();
+            }
+        }
+    }
+}
+
+// One op scores the whole candidate set, so evaluations per second are
+// kCandidateBoards / mean.
+void BenchBatchFeatures(BenchHarness &harness) {
+    constexpr int kCandidateBoards = 256;
+    const std::vector<model::Board> boards = CandidateBoards(kCandidateBoards);
+    bot::BoardBatch batch;
+    for (const auto &board : boards) {
+        batch.Add(board);
+    }
+    CheckKernels(boards, batch);
+
+    harness.Run("bot::ComputeFeatures x256 per board", [&]() {
+        std::uint64_t sum = 0;
+        for (const auto &board : boards) {
+            sum += static_cast<std::uint64_t>(bot::ComputeFeatures(board).holes);
+        }
+        Consume(sum);
+    });
+    bot::FeatureBatch features;
+    for (const auto kernel : {bot::FeatureKernel::Scalar, bot::FeatureKernel::Sse41, bot::FeatureKernel::Avx2}) {
+        if (!bot::KernelSupported(kernel)) {
+            continue;
+        }
+        harness.Run(std::string("bot::ComputeFeatureBatch x256 ") + bot::KernelName(kernel), [&]() {
+            bot::ComputeFeatureBatch(batch, features, kernel);
+            Consume(features.holes[0]);
+        });
+    }
+}
+
+} // namespace
+
+void RegisterBotBenches(BenchHarness &harness) {
+    BenchSearchParts(harness);
+    BenchBatchFeatures(harness);
+    BenchDecide(harness, "Bot::Decide 1 thread", SearchConfig(1, 1, 18));
+    BenchDecide(harness, "Bot::Decide all threads", SearchConfig(0, 1, 18));
+    BenchDecide(harness, "Bot::Decide 1 thread, no table", SearchConfig(1, 1, 0));
+}
+
+} // namespace mctetris::bench
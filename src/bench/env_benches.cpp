@@ -0,0 +1,40 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_harness.h"
+#include "env/batch_env.h"
+
+namespace mctetris::bench {
+namespace {
+
+constexpr int kBatchGames = 1024;
+
+// One lockstep step of kBatchGames games with random actions, observations
+// written into one flat buffer; divide the mean by kBatchGames for the cost
+// per game step.
+void BenchBatchStep(BenchHarness &harness, int threads) {
+    env::BatchEnv batch(kBatchGames, 17, 1, threads);
+    std::vector<std::uint8_t> observations(kBatchGames * env::kObservationBytes);
+    std::vector<float> rewards(kBatchGames);
+    std::vector<std::uint8_t> dones(kBatchGames);
+    std::vector<std::uint8_t> actions(kBatchGames);
+    std::mt19937 rng(3);
+    batch.Reset(observations.data());
+    harness.Run("BatchEnv::Step x1024 threads=" + std::to_string(threads), [&]() {
+        for (auto &action : actions) {
+            action = static_cast<std::uint8_t>(rng() % 6);
+        }
+        batch.Step(actions.data(), observations.data(), rewards.data(), dones.data());
+        Consume(observations[rng() % observations.size()]);
+    });
+}
+
+} // namespace
+
+void RegisterEnvBenches(BenchHarness &harness) {
+    BenchBatchStep(harness, 1);
+    BenchBatchStep(harness, 0);
+}
+
+} // namespace mctetris::bench
@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_harness.h"
+#include "model/game_session.h"
+#include "model/snapshot.h"
+
+namespace mctetris::bench {
+namespace {
+
+using model::Board;
+using model::GameModel;
+using model::GameSession;
+using model::Tetromino;
+using model::TetrominoType;
+
+constexpr std::size_t kBoardSetSize = 64;
+
+struct Placement {
+    std::size_t board = 0;
+    Tetromino piece;
+    int x = 0;
+    int y = 0;
+};
+
+int StackHeight(const Board &board) {
+    const auto &heights = board.ColumnHeights();
+    return *std::max_element(heights.begin(), heights.end());
+}
+
+// Drops the active piece at a random rotation and column.
+template <typename Model>
+void PlayRandomPiece(Model &model, std::mt19937 &rng) {
+    constexpr int kWidth = Model::BoardType::kWidth;
+    const int rotations = static_cast<int>(rng() % 4);
+    for (int i = 0; i < rotations; ++i) {
+        (void)model.RotateCW();
+    }
+    const int shift = static_cast<int>(rng() % kWidth) - kWidth / 2;
+    const int step = shift < 0 ? -1 : 1;
+    for (int i = 0; i != shift; i += step) {
+        if (!model.Move(step, 0)) {
+            break;
+        }
+    }
+    model.HardDrop();
+}
+
+// Mid-game boards with stacks between 4 and 12 rows tall, the range a real
+// session spends most of its time in.
+std::vector<Board> RealisticBoards() {
+    std::vector<Board> boards;
+    boards.reserve(kBoardSetSize);
+    std::mt19937 rng(1234);
+    GameSession session;
+    while (boards.size() < kBoardSetSize) {
+        session.Reset(rng());
+        auto &model = session.Model();
+        while (!model.IsGameOver() && boards.size() < kBoardSetSize) {
+            PlayRandomPiece(model, rng);
+            const int height = StackHeight(model.GetBoard());
+            if (height >= 4 && height <= 12 && rng() % 4 == 0) {
+                boards.push_back(model.GetBoard());
+            }
+            if (height > 12) {
+                break;
+            }
+            session.SpawnIfNeeded();
+        }
+    }
+    return boards;
+}
+
+// Resting placements for every piece and rotation on each board, so Place
+// benches see pieces landing on the real surface.
+std::vector<Placement> RestingPlacements(const std::vector<Board> &boards) {
+    std::vector<Placement> placements;
+    for (std::size_t index = 0; index < boards.size(); ++index) {
+        const Board &board = boards[index];
+        for (int type = 0; type < 7; ++type) {
+            for (int rotation = 0; rotation < 4; ++rotation) {
+                const Tetromino piece{static_cast<TetrominoType>(type), rotation};
+                for (int x = -2; x < model::kBoardWidth; ++x) {
+                    if (board.CanPlace(piece, x, 0)) {
+                        placements.push_back({index, piece, x, board.DropDistance(piece, x, 0)});
+                    }
+                }
+            }
+        }
+    }
+    return placements;
+}
+
+// Boards with one to four complete rows under a ragged stack.
+std::vector<Board> BoardsWithFullRows(const std::vector<Board> &boards) {
+    std::vector<Board> result;
+    result.reserve(boards.size());
+    const Tetromino bar{TetrominoType::I, 1};
+    for (std::size_t i = 0; i < boards.size(); ++i) {
+        Board board = boards[i];
+        const int fullRows = static_cast<int>(i % 4) + 1;
+        // A vertical I fills each column from its first gap down to the floor.
+        for (int x = 0; x < model::kBoardWidth; ++x) {
+            for (int y = model::kBoardHeight - fullRows; y < model::kBoardHeight; ++y) {
+                if (board.IsEmpty(x, y)) {
+                    board.Place(bar, x - 2, y);
+                    break;
+                }
+            }
+        }
+        result.push_back(board);
+    }
+    return result;
+}
+
+void BenchCanPlace(BenchHarness &harness, const std::vector<Board> &boards) {
+    std::size_t cursor = 0;
+    int x = -1;
+    int y = 0;
+    int shape = 0;
+    harness.Run("Board::CanPlace", [&]() {
+        const Tetromino piece{static_cast<TetrominoType>(shape % 7), shape / 7};
+        Consume(boards[cursor].CanPlace(piece, x, y) ? 1 : 0);
+        if (++x > model::kBoardWidth - 2) {
+            x = -1;
+            if (++y > model::kBoardHeight - 2) {
+                y = 0;
+                shape = (shape + 1) % 28;
+                cursor = (cursor + 1) % boards.size();
+            }
+        }
+    });
+}
+
+void BenchPlace(BenchHarness &harness, const std::vector<Board> &boards,
+                const std::vector<Placement> &placements) {
+    std::size_t cursor = 0;
+    Board board;
+    harness.Run("Board copy (baseline)", [&]() {
+        board = boards[cursor % boards.size()];
+        Consume(board.RowMasks()[model::kBoardHeight - 1]);
+        ++cursor;
+    });
+    cursor = 0;
+    harness.Run("Board::Place (incl. copy)", [&]() {
+        const auto &placement = placements[cursor];
+        board = boards[placement.board];
+        board.Place(placement.piece, placement.x, placement.y);
+        Consume(board.RowMasks()[model::kBoardHeight - 1]);
+        cursor = (cursor + 1) % placements.size();
+    });
+}
+
+void BenchClearFullLines(BenchHarness &harness, const std::vector<Board> &fullBoards) {
+    std::size_t cursor = 0;
+    Board board;
+    harness.Run("Board::ClearFullLines (incl. copy)", [&]() {
+        board = fullBoards[cursor];
+        Consume(static_cast<std::uint64_t>(board.ClearFullLines()));
+        cursor = (cursor + 1) % fullBoards.size();
+    });
+    harness.Run("Board::ClearFullLines no-op", [&]() {
+        Consume(static_cast<std::uint64_t>(board.ClearFullLines()));
+    });
+}
+
+void BenchBlocks(BenchHarness &harness) {
+    int shape = 0;
+    harness.Run("Tetromino::Blocks", [&]() {
+        const Tetromino piece{static_cast<TetrominoType>(shape % 7), shape / 7};
+        const auto blocks = piece.Blocks();
+        Consume(static_cast<std::uint64_t>(blocks[3].x + blocks[3].y));
+        shape = (shape + 1) % 28;
+    });
+}
+
+void BenchHardDropSequence(BenchHarness &harness) {
+    std::mt19937 rng(99);
+    GameSession session(rng());
+    harness.Run("GameModel::HardDrop+LockPiece", [&]() {
+        auto &model = session.Model();
+        if (model.IsGameOver()) {
+            session.Reset(rng());
+        }
+        PlayRandomPiece(model, rng);
+        session.SpawnIfNeeded();
+        Consume(static_cast<std::uint64_t>(model.Score()));
+    });
+}
+
+// The same drop-and-lock loop on each of the other board sizes, so the cost
+// of a wider row type or a taller board shows up next to the standard one.
+template <typename Model>
+void BenchHardDropOn(BenchHarness &harness, const std::string &size) {
+    std::mt19937 rng(99);
+    model::PieceGenerator pieces(model::Randomizer::Bag7, rng());
+    Model model;
+    (void)model.Spawn(pieces.Next());
+    harness.Run("HardDrop+LockPiece " + size, [&]() {
+        if (model.IsGameOver()) {
+            model = Model{};
+        }
+        PlayRandomPiece(model, rng);
+        (void)model.Spawn(pieces.Next());
+        Consume(static_cast<std::uint64_t>(model.Score()));
+    });
+}
+
+void BenchBoardSizes(BenchHarness &harness) {
+    BenchHardDropOn<model::TallGameModel>(harness, "10x40");
+    BenchHardDropOn<model::NarrowGameModel>(harness, "4x20");
+    BenchHardDropOn<model::WideGameModel>(harness, "16x24");
+    BenchHardDropOn<model::StressGameModel>(harness, "32x32");
+}
+
+void BenchPieceGenerators(BenchHarness &harness) {
+    // The per-piece cost GameSession paid before PieceGenerator, for comparison.
+    std::mt19937 rng(5);
+    harness.Run("mt19937 uniform piece", [&]() {
+        std::uniform_int_distribution<int> dist(0, 6);
+        Consume(static_cast<std::uint64_t>(dist(rng)));
+    });
+    for (const auto randomizer :
+         {model::Randomizer::Bag7, model::Randomizer::Uniform, model::Randomizer::History}) {
+        model::PieceGenerator pieces(randomizer, 5, 5);
+        harness.Run(std::string("PieceGenerator::Next ") + model::RandomizerName(randomizer),
+                    [&]() { Consume(static_cast<std::uint64_t>(pieces.Next())); });
+    }
+    model::PieceGenerator bag(model::Randomizer::Bag7, 5, 5);
+    std::uint64_t index = 0;
+    harness.Run("PieceGenerator::Seek bag", [&]() {
+        index = index * 6364136223846793005ull + 1442695040888963407ull;
+        bag.Seek(index >> 16);
+        Consume(static_cast<std::uint64_t>(bag.Peek(0)));
+    });
+}
+
+// Snapshots of mid-game positions, encoded into and decoded from one flat
+// array of records the way a batch of positions would be stored.
+void BenchSnapshots(BenchHarness &harness, const std::vector<Board> &boards) {
+    std::vector<GameModel> models(boards.size());
+    for (std::size_t i = 0; i < boards.size(); ++i) {
+        models[i].Restore(boards[i], GameModel::SpawnPosition(static_cast<TetrominoType>(i % 7)),
+                          static_cast<int>(i) * 3, static_cast<int>(i) * 3 / 10, static_cast<int>(i) * 1000, false);
+    }
+    std::vector<std::uint8_t> records(models.size() * model::kSnapshotBytes);
+    std::size_t cursor = 0;
+    harness.Run("EncodeSnapshot", [&]() {
+        Consume(model::EncodeSnapshot(models[cursor], records.data() + cursor * model::kSnapshotBytes));
+        cursor = (cursor + 1) % models.size();
+    });
+    cursor = 0;
+    GameModel decoded;
+    harness.Run("DecodeSnapshot", [&]() {
+        const bool ok =
+            model::DecodeSnapshot(records.data() + cursor * model::kSnapshotBytes, model::kSnapshotBytes, decoded);
+        Consume(ok ? decoded.GetBoard().Hash() : 0);
+        cursor = (cursor + 1) % models.size();
+    });
+}
+
+} // namespace
+
+void RegisterModelBenches(BenchHarness &harness) {
+    const auto boards = RealisticBoards();
+    const auto placements = RestingPlacements(boards);
+    const auto fullBoards = BoardsWithFullRows(boards);
+    BenchCanPlace(harness, boards);
+    BenchPlace(harness, boards, placements);
+    BenchClearFullLines(harness, fullBoards);
+    BenchBlocks(harness);
+    BenchHardDropSequence(harness);
+    BenchBoardSizes(harness);
+    BenchPieceGenerators(harness);
+    BenchSnapshots(harness, boards);
+}
+
+} // namespace mctetris::bench
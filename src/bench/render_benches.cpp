@@ -0,0 +1,164 @@
+#include <array>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <curses.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "bench_harness.h"
+#include "model/game_session.h"
+#include "ui/render.h"
+#include "ui/render_backend.h"
+
+namespace mctetris::bench {
+namespace {
+
+constexpr ui::FrameSize kGameSize{60, 120};
+// 64 boards fill this exactly.
+constexpr ui::FrameSize kGridSize{96, 192};
+
+// A curses screen whose output goes to /dev/null, so RenderGame pays for
+// composition and terminal encoding without a real terminal attached.
+class NullScreen {
+  public:
+    NullScreen() {
+        out_ = std::fopen("/dev/null", "w");
+        in_ = std::fopen("/dev/null", "r");
+        if (!out_ || !in_) {
+            return;
+        }
+        for (const char *type : {"xterm-256color", "xterm", "vt100"}) {
+            screen_ = newterm(type, out_, in_);
+            if (screen_) {
+                break;
+            }
+        }
+        if (screen_) {
+            resizeterm(kGameSize.rows, kGameSize.cols);
+            ui::InitColors();
+        }
+    }
+
+    ~NullScreen() {
+        if (screen_) {
+            endwin();
+            delscreen(screen_);
+        }
+        if (out_) {
+            std::fclose(out_);
+        }
+        if (in_) {
+            std::fclose(in_);
+        }
+    }
+
+    NullScreen(const NullScreen &) = delete;
+    NullScreen &operator=(const NullScreen &) = delete;
+
+    [[nodiscard]] bool Ready() const {
+        return screen_ != nullptr;
+    }
+
+  private:
+    std::FILE *out_ = nullptr;
+    std::FILE *in_ = nullptr;
+    SCREEN *screen_ = nullptr;
+};
+
+// Plays random drops until the stack reaches mid-height.
+model::GameSession MidGameSession() {
+    std::mt19937 rng(7);
+    model::GameSession session(rng());
+    for (int piece = 0; piece < 12; ++piece) {
+        auto &model = session.Model();
+        for (int i = 0; i < static_cast<int>(rng() % 6); ++i) {
+            (void)model.Move(rng() % 2 == 0 ? -1 : 1, 0);
+        }
+        model.HardDrop();
+        session.SpawnIfNeeded();
+    }
+    return session;
+}
+
+} // namespace
+
+void RegisterRenderBenches(BenchHarness &harness) {
+    NullScreen screen;
+    if (!screen.Ready()) {
+        std::fprintf(stderr, "  skipping render benches: no usable terminfo entry\n");
+        return;
+    }
+    const ui::ControlScheme scheme{"WASD", 'a', 'd', 's', 'w', ' ', "WASD: move/rotate  Space: hard drop"};
+    auto session = MidGameSession();
+    ui::ScreenBuffer frame;
+    bool moveLeft = false;
+    harness.Run("RenderGame (static frame)", [&]() {
+        Consume(static_cast<std::uint64_t>(
+            ui::RenderGame(frame, kGameSize, session.Model(), session.NextType(), scheme, false).runs));
+    });
+    harness.Run("RenderGame (piece moving)", [&]() {
+        (void)session.Model().Move(moveLeft ? -1 : 1, 0);
+        moveLeft = !moveLeft;
+        Consume(static_cast<std::uint64_t>(
+            ui::RenderGame(frame, kGameSize, session.Model(), session.NextType(), scheme, false).runs));
+    });
+    harness.Run("RenderGame (full redraw)", [&]() {
+        frame.Invalidate();
+        Consume(static_cast<std::uint64_t>(
+            ui::RenderGame(frame, kGameSize, session.Model(), session.NextType(), scheme, false).runs));
+    });
+
+    // One piece moves per frame, as when a single board ticks.
+    resizeterm(kGridSize.rows, kGridSize.cols);
+    std::vector<model::GameSession> boards(64, session);
+    std::vector<ui::GridTile> tiles;
+    for (const auto &board : boards) {
+        tiles.push_back(ui::GridTile{&board.Model(), 0, 0});
+    }
+    ui::ScreenBuffer gridFrame;
+    std::size_t moving = 0;
+    harness.Run("RenderGrid (64 boards, one moving)", [&]() {
+        (void)boards[moving].Model().Move(moveLeft ? -1 : 1, 0);
+        moving = (moving + 1) % boards.size();
+        moveLeft = moving == 0 ? !moveLeft : moveLeft;
+        Consume(static_cast<std::uint64_t>(ui::RenderGrid(gridFrame, kGridSize, tiles, false).runs));
+    });
+    harness.Run("RenderGrid (64 boards, full redraw)", [&]() {
+        gridFrame.Invalidate();
+        Consume(static_cast<std::uint64_t>(ui::RenderGrid(gridFrame, kGridSize, tiles, false).runs));
+    });
+    resizeterm(kGameSize.rows, kGameSize.cols);
+
+    // The same frames through the other backends: ANSI escapes written to
+    // /dev/null in one write() each, and no output at all.
+    const int devNull = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (devNull < 0) {
+        std::fprintf(stderr, "  skipping ANSI render benches: cannot open /dev/null\n");
+        return;
+    }
+    ui::AnsiBackend ansi(devNull);
+    ui::NullBackend null;
+    for (const auto &[name, backend] : {std::pair<const char *, ui::RenderBackend *>{"ansi", &ansi},
+                                        std::pair<const char *, ui::RenderBackend *>{"null", &null}}) {
+        ui::ScreenBuffer backendFrame;
+        backendFrame.SetBackend(backend);
+        harness.Run(std::string("RenderGame (piece moving, ") + name + ")", [&]() {
+            (void)session.Model().Move(moveLeft ? -1 : 1, 0);
+            moveLeft = !moveLeft;
+            Consume(static_cast<std::uint64_t>(
+                ui::RenderGame(backendFrame, kGameSize, session.Model(), session.NextType(), scheme, false).runs));
+        });
+        harness.Run(std::string("RenderGame (full redraw, ") + name + ")", [&]() {
+            backendFrame.Invalidate();
+            Consume(static_cast<std::uint64_t>(
+                ui::RenderGame(backendFrame, kGameSize, session.Model(), session.NextType(), scheme, false).runs));
+        });
+    }
+    close(devNull);
+}
+
+} // namespace mctetris::bench
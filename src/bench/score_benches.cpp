@@ -0,0 +1,92 @@
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "bench_harness.h"
+#include "scores/score_store.h"
+
+namespace mctetris::bench {
+namespace {
+
+constexpr int kPlayers = 200;
+constexpr int kAppendBatch = 4096;
+
+// A throwaway store of `records` scores from kPlayers players, indexed except
+// for the last `tail`, the most a writer leaves before it compacts.
+class ScratchStore {
+  public:
+    ScratchStore(long long records, long long tail) {
+        char pattern[] = "/tmp/mctetris-scores-XXXXXX";
+        if (mkdtemp(pattern) == nullptr) {
+            return;
+        }
+        directory_ = pattern;
+        path_ = directory_ + "/scores";
+        std::mt19937 rng(static_cast<std::uint32_t>(records));
+        std::vector<scores::ScoreEntry> batch;
+        for (long long i = 0; i < records; ++i) {
+            scores::ScoreEntry entry;
+            entry.name = "player" + std::to_string(rng() % kPlayers);
+            entry.score = static_cast<int>(rng() % 1000000);
+            entry.level = entry.score / 10000;
+            entry.lines = entry.score / 1000;
+            entry.timestamp = 1700000000 + i;
+            batch.push_back(entry);
+            if (static_cast<int>(batch.size()) == kAppendBatch || i + 1 == records || i + 1 == records - tail) {
+                (void)scores::ScoreStore::Append(path_, batch);
+                batch.clear();
+            }
+            if (i + 1 == records - tail) {
+                (void)scores::ScoreStore::Compact(path_);
+            }
+        }
+    }
+    ~ScratchStore() {
+        if (!directory_.empty()) {
+            (void)std::remove((path_ + ".idx").c_str());
+            (void)std::remove(path_.c_str());
+            (void)rmdir(directory_.c_str());
+        }
+    }
+    ScratchStore(const ScratchStore &) = delete;
+    ScratchStore &operator=(const ScratchStore &) = delete;
+
+    [[nodiscard]] const std::string &Path() const {
+        return path_;
+    }
+
+  private:
+    std::string directory_;
+    std::string path_;
+};
+
+void BenchStore(BenchHarness &harness, const std::string &label, long long records) {
+    const ScratchStore scratch(records, 1000);
+    harness.Run("ScoreStore::Open " + label, [&]() {
+        const auto store = scores::ScoreStore::Open(scratch.Path());
+        Consume(store.RecordCount());
+    });
+    const auto store = scores::ScoreStore::Open(scratch.Path());
+    harness.Run("ScoreStore::Top 10 " + label, [&]() {
+        Consume(static_cast<std::uint64_t>(store.Top(10).front().score));
+    });
+    int player = 0;
+    harness.Run("ScoreStore::TopForPlayer 10 " + label, [&]() {
+        const auto best = store.TopForPlayer("player" + std::to_string(player), 10);
+        Consume(static_cast<std::uint64_t>(best.size()));
+        player = (player + 1) % kPlayers;
+    });
+}
+
+} // namespace
+
+void RegisterScoreBenches(BenchHarness &harness) {
+    BenchStore(harness, "10k", 10000);
+    BenchStore(harness, "1M", 1000000);
+}
+
+} // namespace mctetris::bench
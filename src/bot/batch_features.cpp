@@ -0,0 +1,360 @@
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MCTETRIS_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+#include "batch_features.h"
+
+namespace mctetris::bot {
+namespace {
+
+using model::kBoardHeight;
+using model::kBoardWidth;
+using model::RowMask;
+
+// The row with a wall bit on each side, bit 0 and bit kBoardWidth + 1.
+constexpr std::uint16_t kWalledRow = static_cast<std::uint16_t>(1u | (1u << (kBoardWidth + 1)));
+constexpr std::uint16_t kTransitionMask = static_cast<std::uint16_t>((1u << (kBoardWidth + 1)) - 1);
+
+void ResizeOutput(FeatureBatch &out, int stride) {
+    const auto size = static_cast<std::size_t>(stride);
+    for (auto &column : out.columnHeights) {
+        column.resize(size);
+    }
+    out.aggregateHeight.resize(size);
+    out.maxHeight.resize(size);
+    out.holes.resize(size);
+    out.bumpiness.resize(size);
+    out.wells.resize(size);
+    out.rowTransitions.resize(size);
+}
+
+// Portable fallback: the same row-mask algorithm as the vector kernels, one
+// board at a time.
+void ScalarKernel(const BoardBatch &batch, FeatureBatch &out) {
+    for (int lane = 0; lane < batch.Stride(); ++lane) {
+        std::array<int, kBoardWidth> heights{};
+        RowMask covered = 0;
+        int holes = 0;
+        int transitions = 0;
+        for (int y = 0; y < kBoardHeight; ++y) {
+            const RowMask row = batch.Row(y)[lane];
+            for (unsigned fresh = row & ~covered & 0xffffu; fresh != 0; fresh &= fresh - 1) {
+                heights[__builtin_ctz(fresh)] = kBoardHeight - y;
+            }
+            holes += __builtin_popcount(covered & static_cast<RowMask>(~row));
+            covered = static_cast<RowMask>(covered | row);
+            const unsigned walled = (static_cast<unsigned>(row) << 1) | kWalledRow;
+            transitions += __builtin_popcount((walled ^ (walled >> 1)) & kTransitionMask);
+        }
+        int aggregate = 0;
+        int maxHeight = 0;
+        int bumpiness = 0;
+        int wells = 0;
+        for (int x = 0; x < kBoardWidth; ++x) {
+            aggregate += heights[x];
+            maxHeight = std::max(maxHeight, heights[x]);
+            if (x + 1 < kBoardWidth) {
+                bumpiness += std::abs(heights[x] - heights[x + 1]);
+            }
+            const int left = x > 0 ? heights[x - 1] : kBoardHeight;
+            const int right = x + 1 < kBoardWidth ? heights[x + 1] : kBoardHeight;
+            wells += std::max(0, std::min(left, right) - heights[x]);
+            out.columnHeights[x][lane] = static_cast<std::uint16_t>(heights[x]);
+        }
+        out.aggregateHeight[lane] = static_cast<std::uint16_t>(aggregate);
+        out.maxHeight[lane] = static_cast<std::uint16_t>(maxHeight);
+        out.holes[lane] = static_cast<std::uint16_t>(holes);
+        out.bumpiness[lane] = static_cast<std::uint16_t>(bumpiness);
+        out.wells[lane] = static_cast<std::uint16_t>(wells);
+        out.rowTransitions[lane] = static_cast<std::uint16_t>(transitions);
+    }
+}
+
+#if MCTETRIS_X86_KERNELS
+
+// Per-lane popcount of 16-bit values: nibble lookup with pshufb, then the
+// two byte counts of each lane are added.
+__attribute__((target("sse4.1"))) __m128i PopCount16(__m128i value) {
+    const __m128i lookup = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i low = _mm_shuffle_epi8(lookup, _mm_and_si128(value, nibble));
+    const __m128i high = _mm_shuffle_epi8(lookup, _mm_and_si128(_mm_srli_epi16(value, 4), nibble));
+    const __m128i bytes = _mm_add_epi8(low, high);
+    return _mm_add_epi16(_mm_and_si128(bytes, _mm_set1_epi16(0xff)), _mm_srli_epi16(bytes, 8));
+}
+
+__attribute__((target("sse4.1"))) void Sse41Kernel(const BoardBatch &batch, FeatureBatch &out) {
+    constexpr int kLanes = 8;
+    const __m128i walled = _mm_set1_epi16(static_cast<short>(kWalledRow));
+    const __m128i transitionMask = _mm_set1_epi16(static_cast<short>(kTransitionMask));
+    const __m128i fullHeight = _mm_set1_epi16(kBoardHeight);
+    for (int lane = 0; lane < batch.Stride(); lane += kLanes) {
+        __m128i heights[kBoardWidth];
+        for (__m128i &height : heights) {
+            height = _mm_setzero_si128();
+        }
+        __m128i covered = _mm_setzero_si128();
+        __m128i holes = _mm_setzero_si128();
+        __m128i transitions = _mm_setzero_si128();
+        for (int y = 0; y < kBoardHeight; ++y) {
+            const __m128i row = _mm_loadu_si128(reinterpret_cast<const __m128i *>(batch.Row(y) + lane));
+            const __m128i fresh = _mm_andnot_si128(covered, row);
+            const __m128i height = _mm_set1_epi16(static_cast<short>(kBoardHeight - y));
+            for (int x = 0; x < kBoardWidth; ++x) {
+                const __m128i bit = _mm_set1_epi16(static_cast<short>(1 << x));
+                const __m128i seen = _mm_cmpeq_epi16(_mm_and_si128(fresh, bit), bit);
+                heights[x] = _mm_or_si128(heights[x], _mm_and_si128(seen, height));
+            }
+            holes = _mm_add_epi16(holes, PopCount16(_mm_andnot_si128(row, covered)));
+            covered = _mm_or_si128(covered, row);
+            const __m128i walls = _mm_or_si128(_mm_slli_epi16(row, 1), walled);
+            const __m128i changes = _mm_and_si128(_mm_xor_si128(walls, _mm_srli_epi16(walls, 1)), transitionMask);
+            transitions = _mm_add_epi16(transitions, PopCount16(changes));
+        }
+        __m128i aggregate = _mm_setzero_si128();
+        __m128i maxHeight = _mm_setzero_si128();
+        __m128i bumpiness = _mm_setzero_si128();
+        __m128i wells = _mm_setzero_si128();
+        for (int x = 0; x < kBoardWidth; ++x) {
+            aggregate = _mm_add_epi16(aggregate, heights[x]);
+            maxHeight = _mm_max_epu16(maxHeight, heights[x]);
+            if (x + 1 < kBoardWidth) {
+                bumpiness = _mm_add_epi16(bumpiness, _mm_abs_epi16(_mm_sub_epi16(heights[x], heights[x + 1])));
+            }
+            const __m128i left = x > 0 ? heights[x - 1] : fullHeight;
+            const __m128i right = x + 1 < kBoardWidth ? heights[x + 1] : fullHeight;
+            wells = _mm_add_epi16(wells, _mm_subs_epu16(_mm_min_epu16(left, right), heights[x]));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out.columnHeights[x].data() + lane), heights[x]);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out.aggregateHeight.data() + lane), aggregate);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out.maxHeight.data() + lane), maxHeight);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out.holes.data() + lane), holes);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out.bumpiness.data() + lane), bumpiness);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out.wells.data() + lane), wells);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out.rowTransitions.data() + lane), transitions);
+    }
+}
+
+__attribute__((target("avx2"))) __m256i PopCount16x16(__m256i value) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3,
+                                            1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(value, nibble));
+    const __m256i high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(value, 4), nibble));
+    const __m256i bytes = _mm256_add_epi8(low, high);
+    return _mm256_add_epi16(_mm256_and_si256(bytes, _mm256_set1_epi16(0xff)), _mm256_srli_epi16(bytes, 8));
+}
+
+__attribute__((target("avx2"))) void Avx2Kernel(const BoardBatch &batch, FeatureBatch &out) {
+    constexpr int kLanes = 16;
+    const __m256i walled = _mm256_set1_epi16(static_cast<short>(kWalledRow));
+    const __m256i transitionMask = _mm256_set1_epi16(static_cast<short>(kTransitionMask));
+    const __m256i fullHeight = _mm256_set1_epi16(kBoardHeight);
+    for (int lane = 0; lane < batch.Stride(); lane += kLanes) {
+        __m256i heights[kBoardWidth];
+        for (__m256i &height : heights) {
+            height = _mm256_setzero_si256();
+        }
+        __m256i covered = _mm256_setzero_si256();
+        __m256i holes = _mm256_setzero_si256();
+        __m256i transitions = _mm256_setzero_si256();
+        for (int y = 0; y < kBoardHeight; ++y) {
+            const __m256i row = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(batch.Row(y) + lane));
+            const __m256i fresh = _mm256_andnot_si256(covered, row);
+            const __m256i height = _mm256_set1_epi16(static_cast<short>(kBoardHeight - y));
+            for (int x = 0; x < kBoardWidth; ++x) {
+                const __m256i bit = _mm256_set1_epi16(static_cast<short>(1 << x));
+                const __m256i seen = _mm256_cmpeq_epi16(_mm256_and_si256(fresh, bit), bit);
+                heights[x] = _mm256_or_si256(heights[x], _mm256_and_si256(seen, height));
+            }
+            holes = _mm256_add_epi16(holes, PopCount16x16(_mm256_andnot_si256(row, covered)));
+            covered = _mm256_or_si256(covered, row);
+            const __m256i walls = _mm256_or_si256(_mm256_slli_epi16(row, 1), walled);
+            const __m256i changes =
+                _mm256_and_si256(_mm256_xor_si256(walls, _mm256_srli_epi16(walls, 1)), transitionMask);
+            transitions = _mm256_add_epi16(transitions, PopCount16x16(changes));
+        }
+        __m256i aggregate = _mm256_setzero_si256();
+        __m256i maxHeight = _mm256_setzero_si256();
+        __m256i bumpiness = _mm256_setzero_si256();
+        __m256i wells = _mm256_setzero_si256();
+        for (int x = 0; x < kBoardWidth; ++x) {
+            aggregate = _mm256_add_epi16(aggregate, heights[x]);
+            maxHeight = _mm256_max_epu16(maxHeight, heights[x]);
+            if (x + 1 < kBoardWidth) {
+                bumpiness =
+                    _mm256_add_epi16(bumpiness, _mm256_abs_epi16(_mm256_sub_epi16(heights[x], heights[x + 1])));
+            }
+            const __m256i left = x > 0 ? heights[x - 1] : fullHeight;
+            const __m256i right = x + 1 < kBoardWidth ? heights[x + 1] : fullHeight;
+            wells = _mm256_add_epi16(wells, _mm256_subs_epu16(_mm256_min_epu16(left, right), heights[x]));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out.columnHeights[x].data() + lane), heights[x]);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out.aggregateHeight.data() + lane), aggregate);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out.maxHeight.data() + lane), maxHeight);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out.holes.data() + lane), holes);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out.bumpiness.data() + lane), bumpiness);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out.wells.data() + lane), wells);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out.rowTransitions.data() + lane), transitions);
+    }
+}
+
+#endif
+
+FeatureKernel DetectKernel() {
+#if MCTETRIS_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return FeatureKernel::Avx2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return FeatureKernel::Sse41;
+    }
+#endif
+    return FeatureKernel::Scalar;
+}
+
+} // namespace
+
+BoardFeatures DetailedFeatures::Basic() const {
+    return BoardFeatures{aggregateHeight, holes, bumpiness, maxHeight};
+}
+
+DetailedFeatures ComputeFeaturesReference(const model::Board &board) {
+    DetailedFeatures features;
+    const auto &cells = board.Cells();
+    auto filled = [&](int x, int y) { return cells[y][x] != model::Cell::Empty; };
+    for (int x = 0; x < kBoardWidth; ++x) {
+        int top = kBoardHeight;
+        for (int y = kBoardHeight - 1; y >= 0; --y) {
+            if (filled(x, y)) {
+                top = y;
+            }
+        }
+        features.columnHeights[x] = static_cast<std::uint8_t>(kBoardHeight - top);
+        for (int y = top + 1; y < kBoardHeight; ++y) {
+            features.holes += filled(x, y) ? 0 : 1;
+        }
+    }
+    for (int x = 0; x < kBoardWidth; ++x) {
+        const int height = features.columnHeights[x];
+        features.aggregateHeight += height;
+        features.maxHeight = std::max(features.maxHeight, height);
+        if (x + 1 < kBoardWidth) {
+            features.bumpiness += std::abs(height - features.columnHeights[x + 1]);
+        }
+        const int left = x > 0 ? features.columnHeights[x - 1] : kBoardHeight;
+        const int right = x + 1 < kBoardWidth ? features.columnHeights[x + 1] : kBoardHeight;
+        features.wells += std::max(0, std::min(left, right) - height);
+    }
+    for (int y = 0; y < kBoardHeight; ++y) {
+        bool previous = true;
+        for (int x = 0; x <= kBoardWidth; ++x) {
+            const bool current = x < kBoardWidth ? filled(x, y) : true;
+            features.rowTransitions += current != previous ? 1 : 0;
+            previous = current;
+        }
+    }
+    return features;
+}
+
+void BoardBatch::Clear() {
+    std::fill(rows_.begin(), rows_.end(), RowMask{0});
+    size_ = 0;
+}
+
+int BoardBatch::Add(const model::Board &board) {
+    if (size_ == stride_) {
+        Grow();
+    }
+    const auto &rows = board.RowMasks();
+    for (int y = 0; y < kBoardHeight; ++y) {
+        rows_[static_cast<std::size_t>(y) * stride_ + size_] = rows[y];
+    }
+    return size_++;
+}
+
+int BoardBatch::Size() const {
+    return size_;
+}
+
+int BoardBatch::Stride() const {
+    return stride_;
+}
+
+const RowMask *BoardBatch::Row(int y) const {
+    return rows_.data() + static_cast<std::size_t>(y) * stride_;
+}
+
+void BoardBatch::Grow() {
+    const int stride = std::max(kBatchLanes, stride_ * 2);
+    std::vector<RowMask> rows(static_cast<std::size_t>(stride) * kBoardHeight, 0);
+    for (int y = 0; y < kBoardHeight; ++y) {
+        std::copy_n(Row(y), size_, rows.begin() + static_cast<std::ptrdiff_t>(y) * stride);
+    }
+    rows_ = std::move(rows);
+    stride_ = stride;
+}
+
+DetailedFeatures FeatureBatch::At(int index) const {
+    const auto lane = static_cast<std::size_t>(index);
+    DetailedFeatures features;
+    for (int x = 0; x < kBoardWidth; ++x) {
+        features.columnHeights[x] = static_cast<std::uint8_t>(columnHeights[x][lane]);
+    }
+    features.aggregateHeight = aggregateHeight[lane];
+    features.maxHeight = maxHeight[lane];
+    features.holes = holes[lane];
+    features.bumpiness = bumpiness[lane];
+    features.wells = wells[lane];
+    features.rowTransitions = rowTransitions[lane];
+    return features;
+}
+
+FeatureKernel BestFeatureKernel() {
+    static const FeatureKernel kernel = DetectKernel();
+    return kernel;
+}
+
+bool KernelSupported(FeatureKernel kernel) {
+    // Kernels are ordered, and every CPU with AVX2 also has SSE4.1.
+    return static_cast<int>(kernel) <= static_cast<int>(BestFeatureKernel());
+}
+
+const char *KernelName(FeatureKernel kernel) {
+    switch (kernel) {
+    case FeatureKernel::Scalar:
+        return "scalar";
+    case FeatureKernel::Sse41:
+        return "sse4.1";
+    case FeatureKernel::Avx2:
+        return "avx2";
+    }
+    return "scalar";
+}
+
+void ComputeFeatureBatch(const BoardBatch &batch, FeatureBatch &out, FeatureKernel kernel) {
+    ResizeOutput(out, batch.Stride());
+    if (!KernelSupported(kernel)) {
+        kernel = FeatureKernel::Scalar;
+    }
+    switch (kernel) {
+#if MCTETRIS_X86_KERNELS
+    case FeatureKernel::Avx2:
+        Avx2Kernel(batch, out);
+        return;
+    case FeatureKernel::Sse41:
+        Sse41Kernel(batch, out);
+        return;
+#endif
+    default:
+        ScalarKernel(batch, out);
+        return;
+    }
+}
+
+} // namespace mctetris::bot
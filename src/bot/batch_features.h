@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "heuristics.h"
+#include "model/board.h"
+
+namespace mctetris::bot {
+
+// Every feature the batch kernels compute, for one board.
+struct DetailedFeatures {
+    std::array<std::uint8_t, model::kBoardWidth> columnHeights{};
+    int aggregateHeight = 0;
+    int maxHeight = 0;
+    int holes = 0;
+    int bumpiness = 0;
+    // Sum over columns of how far each sits below its lower neighbour; the
+    // side walls count as full height.
+    int wells = 0;
+    // Filled/empty changes along every row, walls included, so an empty row
+    // counts 2.
+    int rowTransitions = 0;
+
+    [[nodiscard]] BoardFeatures Basic() const;
+};
+
+// Cell-by-cell reference the kernels are checked against. Slow on purpose:
+// it reads Board::Cells() and shares no code with the kernels.
+[[nodiscard]] DetailedFeatures ComputeFeaturesReference(const model::Board &board);
+
+// Boards stored structure-of-arrays: row y of board i is Row(y)[i]. The
+// stride is padded with empty boards to a multiple of kBatchLanes so kernels
+// never handle a tail.
+class BoardBatch {
+  public:
+    static constexpr int kBatchLanes = 16;
+
+    void Clear();
+    // Returns the index of the added board.
+    int Add(const model::Board &board);
+
+    [[nodiscard]] int Size() const;
+    [[nodiscard]] int Stride() const;
+    [[nodiscard]] const model::RowMask *Row(int y) const;
+
+  private:
+    void Grow();
+
+    std::vector<model::RowMask> rows_;
+    int size_ = 0;
+    int stride_ = 0;
+};
+
+// Features for a whole batch, also structure-of-arrays and Stride() long.
+struct FeatureBatch {
+    std::array<std::vector<std::uint16_t>, model::kBoardWidth> columnHeights;
+    std::vector<std::uint16_t> aggregateHeight;
+    std::vector<std::uint16_t> maxHeight;
+    std::vector<std::uint16_t> holes;
+    std::vector<std::uint16_t> bumpiness;
+    std::vector<std::uint16_t> wells;
+    std::vector<std::uint16_t> rowTransitions;
+
+    [[nodiscard]] DetailedFeatures At(int index) const;
+};
+
+enum class FeatureKernel : std::uint8_t {
+    Scalar,
+    Sse41,
+    Avx2
+};
+
+// Fastest kernel this CPU supports, detected once at runtime.
+[[nodiscard]] FeatureKernel BestFeatureKernel();
+[[nodiscard]] bool KernelSupported(FeatureKernel kernel);
+[[nodiscard]] const char *KernelName(FeatureKernel kernel);
+
+void ComputeFeatureBatch(const BoardBatch &batch, FeatureBatch &out, FeatureKernel kernel = BestFeatureKernel());
+
+} // namespace mctetris::bot
@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <numeric>
+
+#include "bot.h"
+#include "trace/trace.h"
+
+namespace mctetris::bot {
+namespace {
+
+constexpr int kPieceTypes = 7;
+// Stands in for a board the next piece cannot spawn on.
+constexpr double kDeadValue = -1.0e9;
+
+} // namespace
+
+double BotStats::MeanLatencyMs() const {
+    return decisions > 0 ? std::chrono::duration<double, std::milli>(totalLatency).count() /
+                               static_cast<double>(decisions)
+                         : 0.0;
+}
+
+double BotStats::MaxLatencyMs() const {
+    return std::chrono::duration<double, std::milli>(maxLatency).count();
+}
+
+double BotStats::NodesPerSecond() const {
+    const double seconds = std::chrono::duration<double>(totalLatency).count();
+    return seconds > 0.0 ? static_cast<double>(nodes) / seconds : 0.0;
+}
+
+Bot::Bot(BotConfig config) : config_(config), pool_(config.threads) {
+    config_.beamWidth = std::max(1, config_.beamWidth);
+    beam_.reserve(static_cast<std::size_t>(std::max(config_.beamWidth, kMaxPlacements)));
+    children_.resize(static_cast<std::size_t>(config_.beamWidth) * kMaxPlacements);
+    childCounts_.resize(static_cast<std::size_t>(config_.beamWidth));
+    slotNodes_.resize(static_cast<std::size_t>(pool_.Concurrency()));
+    slotTable_.resize(static_cast<std::size_t>(pool_.Concurrency()));
+    if (config_.tableBits == kAutoTableBits) {
+        config_.tableBits = config_.unknownDepth >= kTableMinUnknownDepth ? kDefaultTableBits : 0;
+    }
+    if (config_.tableBits > 0) {
+        table_ = std::make_unique<TranspositionTable>(config_.tableBits);
+    }
+}
+
+std::optional<Decision> Bot::Decide(const model::GameModel &model, std::optional<model::TetrominoType> next) {
+    MCTETRIS_TRACE_SCOPE("Bot::Decide");
+    const auto &current = model.CurrentPiece();
+    if (!current || model.IsGameOver()) {
+        return std::nullopt;
+    }
+    using Clock = std::chrono::steady_clock;
+    const auto started = Clock::now();
+    std::fill(slotNodes_.begin(), slotNodes_.end(), 0);
+    std::fill(slotTable_.begin(), slotTable_.end(), TableStats{});
+
+    PlacementList roots;
+    EnumeratePlacements(model.GetBoard(), *current, roots);
+    if (roots.count == 0) {
+        return std::nullopt;
+    }
+    beam_.clear();
+    for (int i = 0; i < roots.count; ++i) {
+        const Placement &placement = roots.items[i];
+        Node node;
+        node.board = model.GetBoard();
+        node.board.Place(placement.piece, placement.x, placement.y);
+        node.lines = node.board.ClearFullLines();
+        node.root = i;
+        node.value = Score(node);
+        beam_.push_back(node);
+    }
+    slotNodes_[0] += roots.count;
+    KeepBest(beam_);
+
+    if (next) {
+        ExpandBeam(*next);
+    }
+    if (config_.unknownDepth > 0) {
+        ScoreUnknownReplies();
+    }
+
+    const auto best = std::max_element(beam_.begin(), beam_.end(),
+                                       [](const Node &lhs, const Node &rhs) { return lhs.value < rhs.value; });
+    Decision decision;
+    decision.placement = roots.items[best->root];
+    decision.actions = PlacementActions(*current, decision.placement);
+    decision.nodes = std::accumulate(slotNodes_.begin(), slotNodes_.end(), std::int64_t{0});
+    decision.latency = Clock::now() - started;
+
+    ++stats_.decisions;
+    stats_.nodes += decision.nodes;
+    stats_.totalLatency += decision.latency;
+    stats_.maxLatency = std::max(stats_.maxLatency, decision.latency);
+    for (const auto &table : slotTable_) {
+        stats_.table += table;
+    }
+    if (decision.latency > std::chrono::milliseconds(model.GravityDelayMs())) {
+        ++stats_.lateDecisions;
+    }
+    return decision;
+}
+
+const BotStats &Bot::Stats() const {
+    return stats_;
+}
+
+const BotConfig &Bot::Config() const {
+    return config_;
+}
+
+int Bot::Threads() const {
+    return pool_.Concurrency();
+}
+
+double Bot::Score(const Node &node) const {
+    return Evaluate(ComputeFeatures(node.board), node.lines, config_.weights);
+}
+
+void Bot::KeepBest(std::vector<Node> &nodes) const {
+    const auto keep = std::min(nodes.size(), static_cast<std::size_t>(config_.beamWidth));
+    std::partial_sort(nodes.begin(), nodes.begin() + static_cast<std::ptrdiff_t>(keep), nodes.end(),
+                      [](const Node &lhs, const Node &rhs) { return lhs.value > rhs.value; });
+    nodes.resize(keep);
+}
+
+// Replaces the beam with the best placements of `type` on each beam board.
+// Boards `type` cannot spawn on drop out; if none survive the beam is kept.
+void Bot::ExpandBeam(model::TetrominoType type) {
+    MCTETRIS_TRACE_SCOPE("Bot::ExpandBeam");
+    const model::ActivePiece spawn = model::GameModel::SpawnPosition(type);
+    pool_.ParallelFor(static_cast<int>(beam_.size()), [&](int index, int slot) {
+        const Node &parent = beam_[static_cast<std::size_t>(index)];
+        Node *out = &children_[static_cast<std::size_t>(index) * kMaxPlacements];
+        int &count = childCounts_[static_cast<std::size_t>(index)];
+        count = 0;
+        if (!parent.board.CanPlace(spawn.piece, spawn.origin.x, spawn.origin.y)) {
+            return;
+        }
+        PlacementList placements;
+        EnumeratePlacements(parent.board, spawn, placements);
+        for (int i = 0; i < placements.count; ++i) {
+            const Placement &placement = placements.items[i];
+            Node &child = out[count++];
+            child.board = parent.board;
+            child.board.Place(placement.piece, placement.x, placement.y);
+            child.lines = parent.lines + child.board.ClearFullLines();
+            child.root = parent.root;
+            child.value = Score(child);
+        }
+        slotNodes_[static_cast<std::size_t>(slot)] += placements.count;
+    });
+
+    std::vector<Node> survivors;
+    survivors.reserve(static_cast<std::size_t>(config_.beamWidth) * kMaxPlacements);
+    for (std::size_t parent = 0; parent < beam_.size(); ++parent) {
+        const Node *first = &children_[parent * kMaxPlacements];
+        survivors.insert(survivors.end(), first, first + childCounts_[parent]);
+    }
+    if (survivors.empty()) {
+        return;
+    }
+    KeepBest(survivors);
+    beam_.assign(survivors.begin(), survivors.end());
+}
+
+// Rescores each beam board by its expected best reply over the unseen pieces.
+void Bot::ScoreUnknownReplies() {
+    MCTETRIS_TRACE_SCOPE("Bot::ScoreUnknownReplies");
+    pool_.ParallelFor(static_cast<int>(beam_.size()), [&](int index, int slot) {
+        Node &parent = beam_[static_cast<std::size_t>(index)];
+        parent.value = config_.weights.lines * parent.lines + ExpectedReply(parent.board, config_.unknownDepth, slot);
+    });
+}
+
+// Mean over every piece type of the best value reachable by placing it next,
+// looking `depth` unseen pieces ahead. Lines cleared before `board` are not
+// included.
+double Bot::ExpectedReply(const model::Board &board, int depth, int slot) {
+    double total = 0.0;
+    for (int type = 0; type < kPieceTypes; ++type) {
+        total += BestReply(board, static_cast<model::TetrominoType>(type), depth, slot);
+    }
+    return total / kPieceTypes;
+}
+
+// Results are cached by (board, piece, depth). Values are rounded to float
+// whether cached or not, which keeps the search deterministic regardless of
+// which thread filled the cache first.
+double Bot::BestReply(const model::Board &board, model::TetrominoType type, int depth, int slot) {
+    const model::ActivePiece spawn = model::GameModel::SpawnPosition(type);
+    if (!board.CanPlace(spawn.piece, spawn.origin.x, spawn.origin.y)) {
+        return kDeadValue;
+    }
+    std::uint64_t key = 0;
+    if (table_) {
+        key = TranspositionTable::Key(board.Hash(), type, depth);
+        TableEntry cached;
+        if (table_->Probe(key, cached, slotTable_[static_cast<std::size_t>(slot)])) {
+            return cached.value;
+        }
+    }
+
+    PlacementList placements;
+    EnumeratePlacements(board, spawn, placements);
+    // Leaf keys are computed and their slots prefetched up front, so the
+    // probes below overlap their memory latency instead of paying it in turn.
+    std::array<std::optional<std::uint64_t>, kMaxPlacements> leafKeys{};
+    if (depth == 1 && table_) {
+        for (int i = 0; i < placements.count; ++i) {
+            const Placement &placement = placements.items[i];
+            if (const auto hash = board.HashAfterPlace(placement.piece, placement.x, placement.y)) {
+                leafKeys[i] = TranspositionTable::EvaluationKey(*hash);
+                table_->Prefetch(*leafKeys[i]);
+            }
+        }
+    }
+    TableEntry result;
+    double best = std::numeric_limits<double>::lowest();
+    for (int i = 0; i < placements.count; ++i) {
+        const Placement &placement = placements.items[i];
+        double value = 0.0;
+        if (depth > 1) {
+            model::Board child = board;
+            child.Place(placement.piece, placement.x, placement.y);
+            const int cleared = child.ClearFullLines();
+            ++slotNodes_[static_cast<std::size_t>(slot)];
+            value = config_.weights.lines * cleared + ExpectedReply(child, depth - 1, slot);
+        } else {
+            value = LeafValue(board, placement, leafKeys[i], slot);
+        }
+        if (value > best) {
+            best = value;
+            result.best = placement;
+        }
+    }
+    result.value = static_cast<float>(best);
+    if (table_) {
+        table_->Store(key, result, slotTable_[static_cast<std::size_t>(slot)]);
+    }
+    return result.value;
+}
+
+// Deep searches reach the same leaf through different placement orders (A
+// then B, or B then A). Leaves that clear no line carry a key computed from
+// the hash they would have, so a hit skips building the board at all.
+double Bot::LeafValue(const model::Board &board, const Placement &placement, std::optional<std::uint64_t> key,
+                      int slot) {
+    TableEntry result;
+    if (key && table_->Probe(*key, result, slotTable_[static_cast<std::size_t>(slot)])) {
+        return result.value;
+    }
+    model::Board child = board;
+    child.Place(placement.piece, placement.x, placement.y);
+    const int cleared = child.ClearFullLines();
+    ++slotNodes_[static_cast<std::size_t>(slot)];
+    result.value = static_cast<float>(Evaluate(ComputeFeatures(child), 0, config_.weights));
+    if (key) {
+        table_->Store(*key, result, slotTable_[static_cast<std::size_t>(slot)]);
+    }
+    return config_.weights.lines * cleared + result.value;
+}
+
+} // namespace mctetris::bot
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "heuristics.h"
+#include "model/game_model.h"
+#include "placement.h"
+#include "transposition_table.h"
+#include "work_pool.h"
+
+namespace mctetris::bot {
+
+constexpr int kAutoTableBits = -1;
+constexpr int kDefaultTableBits = 18;
+// Shallowest unknownDepth that gets a table under kAutoTableBits.
+constexpr int kTableMinUnknownDepth = 2;
+
+struct BotConfig {
+    // Candidates kept after each search level.
+    int beamWidth = 16;
+    // Search threads including the caller; 0 uses every hardware thread.
+    int threads = 0;
+    // Unseen pieces searched after the known queue: each candidate is scored
+    // by its best reply averaged over all seven piece types, this many deep.
+    // 0 scores the candidates on their own.
+    int unknownDepth = 1;
+    // log2 of the transposition table size shared by the search threads; 0
+    // searches without one. kAutoTableBits uses kDefaultTableBits once
+    // unknownDepth is deep enough for placements to transpose, and no table
+    // below that, where it would cost more in probes than its hits save.
+    int tableBits = kAutoTableBits;
+    Weights weights{};
+};
+
+struct Decision {
+    Placement placement{};
+    // Inputs that play the placement from the piece's current position.
+    std::vector<model::ReplayAction> actions;
+    std::int64_t nodes = 0;
+    std::chrono::nanoseconds latency{0};
+};
+
+struct BotStats {
+    std::int64_t decisions = 0;
+    std::int64_t nodes = 0;
+    // Decisions that took longer than the gravity interval they ran under.
+    std::int64_t lateDecisions = 0;
+    std::chrono::nanoseconds totalLatency{0};
+    std::chrono::nanoseconds maxLatency{0};
+    TableStats table{};
+
+    [[nodiscard]] double MeanLatencyMs() const;
+    [[nodiscard]] double MaxLatencyMs() const;
+    [[nodiscard]] double NodesPerSecond() const;
+};
+
+// Plays the current piece by beam search over the current piece and the
+// preview. Every evaluated board counts as one node.
+class Bot {
+  public:
+    explicit Bot(BotConfig config = {});
+
+    // Picks a placement for the model's current piece, or nothing when there
+    // is no piece to play.
+    [[nodiscard]] std::optional<Decision> Decide(const model::GameModel &model,
+                                                 std::optional<model::TetrominoType> next);
+
+    [[nodiscard]] const BotStats &Stats() const;
+    [[nodiscard]] const BotConfig &Config() const;
+    [[nodiscard]] int Threads() const;
+
+  private:
+    struct Node {
+        model::Board board{};
+        int lines = 0;
+        // Index of the first-level placement this node descends from.
+        int root = 0;
+        double value = 0.0;
+    };
+
+    [[nodiscard]] double Score(const Node &node) const;
+    void KeepBest(std::vector<Node> &nodes) const;
+    void ExpandBeam(model::TetrominoType type);
+    void ScoreUnknownReplies();
+    [[nodiscard]] double ExpectedReply(const model::Board &board, int depth, int slot);
+    [[nodiscard]] double BestReply(const model::Board &board, model::TetrominoType type, int depth, int slot);
+    [[nodiscard]] double LeafValue(const model::Board &board, const Placement &placement,
+                                   std::optional<std::uint64_t> key, int slot);
+
+    BotConfig config_;
+    WorkPool pool_;
+    std::unique_ptr<TranspositionTable> table_;
+    BotStats stats_{};
+    std::vector<Node> beam_;
+    std::vector<Node> children_;
+    std::vector<int> childCounts_;
+    std::vector<std::int64_t> slotNodes_;
+    std::vector<TableStats> slotTable_;
+};
+
+} // namespace mctetris::bot
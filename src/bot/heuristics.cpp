@@ -0,0 +1,33 @@
+#include <cstdlib>
+
+#include "heuristics.h"
+
+namespace mctetris::bot {
+
+BoardFeatures ComputeFeatures(const model::Board &board) {
+    BoardFeatures features;
+    const auto &heights = board.ColumnHeights();
+    for (int x = 0; x < model::kBoardWidth; ++x) {
+        const int height = heights[x];
+        features.aggregateHeight += height;
+        features.maxHeight = height > features.maxHeight ? height : features.maxHeight;
+        if (x > 0) {
+            features.bumpiness += std::abs(height - heights[x - 1]);
+        }
+    }
+
+    // Walking down from the top, every empty cell under an already seen block is a hole.
+    model::RowMask covered = 0;
+    for (const model::RowMask row : board.RowMasks()) {
+        features.holes += __builtin_popcount(covered & static_cast<model::RowMask>(~row));
+        covered = static_cast<model::RowMask>(covered | row);
+    }
+    return features;
+}
+
+double Evaluate(const BoardFeatures &features, int lines, const Weights &weights) {
+    return weights.aggregateHeight * features.aggregateHeight + weights.lines * lines +
+           weights.holes * features.holes + weights.bumpiness * features.bumpiness;
+}
+
+} // namespace mctetris::bot
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "model/board.h"
+
+namespace mctetris::bot {
+
+// Linear evaluation weights. The defaults are the well-known hand-tuned set
+// for aggregate height, lines, holes and bumpiness on a 10x20 board.
+struct Weights {
+    double aggregateHeight = -0.510066;
+    double lines = 0.760666;
+    double holes = -0.35663;
+    double bumpiness = -0.184483;
+};
+
+struct BoardFeatures {
+    int aggregateHeight = 0;
+    // Empty cells with a filled cell somewhere above them in the same column.
+    int holes = 0;
+    // Sum of height differences between neighbouring columns.
+    int bumpiness = 0;
+    int maxHeight = 0;
+};
+
+[[nodiscard]] BoardFeatures ComputeFeatures(const model::Board &board);
+[[nodiscard]] double Evaluate(const BoardFeatures &features, int lines, const Weights &weights);
+
+} // namespace mctetris::bot
@@ -0,0 +1,172 @@
+#include <algorithm>
+
+#include "move_generator.h"
+
+namespace mctetris::bot {
+namespace {
+
+struct Footprint {
+    int left = 0;
+    int top = 0;
+    // The occupied cells with the empty rows and columns of the box removed,
+    // four bits per row.
+    std::uint16_t shape = 0;
+};
+
+Footprint FootprintOf(const model::Tetromino &piece) {
+    const auto &masks = piece.RowMasks();
+    Footprint footprint;
+    footprint.left = 4;
+    footprint.top = -1;
+    for (int dy = 0; dy < 4; ++dy) {
+        if (masks[dy] != 0) {
+            footprint.left = std::min(footprint.left, __builtin_ctz(masks[dy]));
+            footprint.top = footprint.top < 0 ? dy : footprint.top;
+        }
+    }
+    for (int dy = footprint.top; dy < 4; ++dy) {
+        footprint.shape = static_cast<std::uint16_t>(footprint.shape |
+                                                     (masks[dy] >> footprint.left) << (4 * (dy - footprint.top)));
+    }
+    return footprint;
+}
+
+// For each piece and rotation, the lowest rotation covering the same cells
+// and how far its origin sits from this one's, so that equivalent resting
+// positions (every O rotation, the two flat I rotations, ...) share a key.
+struct Equivalence {
+    std::uint8_t rotation = 0;
+    std::int8_t dx = 0;
+    std::int8_t dy = 0;
+};
+
+using EquivalenceTable = std::array<std::array<Equivalence, 4>, 7>;
+
+EquivalenceTable BuildEquivalences() {
+    EquivalenceTable table{};
+    for (int type = 0; type < 7; ++type) {
+        std::array<Footprint, 4> footprints{};
+        for (int rotation = 0; rotation < 4; ++rotation) {
+            footprints[rotation] = FootprintOf(model::Tetromino{static_cast<model::TetrominoType>(type), rotation});
+            int same = 0;
+            while (footprints[same].shape != footprints[rotation].shape) {
+                ++same;
+            }
+            const int dx = footprints[rotation].left - footprints[same].left;
+            const int dy = footprints[rotation].top - footprints[same].top;
+            table[type][rotation] =
+                Equivalence{static_cast<std::uint8_t>(same), static_cast<std::int8_t>(dx), static_cast<std::int8_t>(dy)};
+        }
+    }
+    return table;
+}
+
+const EquivalenceTable kEquivalences = BuildEquivalences();
+
+std::uint16_t StateId(int rotation, int x, int y) {
+    return static_cast<std::uint16_t>((rotation * kMoveRows + y + kMoveSlack) * kMoveColumns + x + kMoveSlack);
+}
+
+} // namespace
+
+int MoveGenerator::Generate(const model::Board &board, const model::ActivePiece &start) {
+    count_ = 0;
+    visited_.reset();
+    locked_.reset();
+    const auto type = start.piece.type;
+    const auto &equivalences = kEquivalences[static_cast<int>(type)];
+
+    // Where each rotation fits, one word per origin row with bit x + kMoveSlack
+    // set when the origin column x is free: the AND, over the piece's cells, of
+    // the free cells in that cell's row shifted back by its column. Rows
+    // outside the board are never free.
+    const auto &rows = board.RowMasks();
+    for (int rotation = 0; rotation < 4; ++rotation) {
+        const auto &masks = model::Tetromino{type, rotation}.RowMasks();
+        for (int y = -kMoveSlack; y < model::kBoardHeight; ++y) {
+            std::uint32_t fit = (1u << kMoveColumns) - 1;
+            for (int dy = 0; dy < 4; ++dy) {
+                if (masks[dy] == 0) {
+                    continue;
+                }
+                const int row = y + dy;
+                const std::uint32_t free =
+                    row < 0 || row >= model::kBoardHeight
+                        ? 0u
+                        : static_cast<std::uint32_t>(~rows[row] & model::kFullRowMask) << kMoveSlack;
+                for (unsigned cells = masks[dy]; cells != 0; cells &= cells - 1) {
+                    fit &= free >> __builtin_ctz(cells);
+                }
+            }
+            fits_[rotation * kMoveRows + y + kMoveSlack] = fit;
+        }
+    }
+    auto fits = [&](int rotation, int x, int y) {
+        return x >= -kMoveSlack && x < model::kBoardWidth && y >= -kMoveSlack && y < model::kBoardHeight &&
+               ((fits_[rotation * kMoveRows + y + kMoveSlack] >> (x + kMoveSlack)) & 1u) != 0;
+    };
+    if (!fits(start.piece.rotation, start.origin.x, start.origin.y)) {
+        return 0;
+    }
+
+    start_ = StateId(start.piece.rotation, start.origin.x, start.origin.y);
+    visited_[start_] = true;
+    queue_[0] = start_;
+    int head = 0;
+    int tail = 1;
+    while (head < tail) {
+        const std::uint16_t state = queue_[head++];
+        const int x = state % kMoveColumns - kMoveSlack;
+        const int y = state / kMoveColumns % kMoveRows - kMoveSlack;
+        const int rotation = state / (kMoveColumns * kMoveRows);
+
+        auto visit = [&](int nextRotation, int nextX, int nextY, model::ReplayAction action) {
+            if (!fits(nextRotation, nextX, nextY)) {
+                return;
+            }
+            const std::uint16_t next = StateId(nextRotation, nextX, nextY);
+            if (visited_[next]) {
+                return;
+            }
+            visited_[next] = true;
+            parent_[next] = state;
+            via_[next] = action;
+            queue_[tail++] = next;
+        };
+        visit(rotation, x - 1, y, model::ReplayAction::MoveLeft);
+        visit(rotation, x + 1, y, model::ReplayAction::MoveRight);
+        visit((rotation + 1) % 4, x, y, model::ReplayAction::RotateCW);
+        // A piece that cannot fall any further locks here.
+        if (!fits(rotation, x, y + 1)) {
+            const auto &same = equivalences[rotation];
+            const std::uint16_t key = StateId(same.rotation, x + same.dx, y + same.dy);
+            if (!locked_[key]) {
+                locked_[key] = true;
+                placements_[count_++] =
+                    ReachablePlacement{model::ActivePiece{model::Tetromino{type, rotation}, model::Point{x, y}}, state};
+            }
+        } else {
+            visit(rotation, x, y + 1, model::ReplayAction::SoftDrop);
+        }
+    }
+    return count_;
+}
+
+int MoveGenerator::Count() const {
+    return count_;
+}
+
+const ReachablePlacement &MoveGenerator::Placement(int index) const {
+    return placements_[index];
+}
+
+void MoveGenerator::PathTo(const ReachablePlacement &placement, MovePath &out) const {
+    out.length = 0;
+    for (std::uint16_t state = placement.state; state != start_; state = parent_[state]) {
+        out.actions[out.length++] = via_[state];
+    }
+    std::reverse(out.actions.begin(), out.actions.begin() + out.length);
+    out.actions[out.length++] = model::ReplayAction::HardDrop;
+}
+
+} // namespace mctetris::bot
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+
+#include "model/active_piece.h"
+#include "model/board.h"
+#include "model/replay.h"
+
+namespace mctetris::bot {
+
+// Every (rotation, x, y) a piece origin can take: the 4x4 box may hang up to
+// three columns past the left wall and three rows above the top.
+constexpr int kMoveSlack = 3;
+constexpr int kMoveColumns = model::kBoardWidth + kMoveSlack;
+constexpr int kMoveRows = model::kBoardHeight + kMoveSlack;
+constexpr int kMoveStates = 4 * kMoveColumns * kMoveRows;
+
+// A lockable position found by MoveGenerator, with the id of its search state
+// for MoveGenerator::PathTo.
+struct ReachablePlacement {
+    model::ActivePiece piece{};
+    std::uint16_t state = 0;
+};
+
+// Shortest input sequence to a placement; a path never revisits a state, so
+// kMoveStates inputs plus the final hard drop always fit.
+struct MovePath {
+    std::array<model::ReplayAction, kMoveStates + 1> actions{};
+    int length = 0;
+};
+
+// Finds every placement a piece can reach from its start position with the
+// moves GameModel allows (shift, rotate clockwise in place, soft drop),
+// including tucks and spins under overhangs that a straight hard drop
+// misses. Gravity is taken to be slow enough never to force a lock early.
+// Placements covering the same cells are reported once, under the rotation
+// reached first. Everything lives in fixed arrays inside the generator, so a
+// search never allocates; reuse one generator across calls.
+class MoveGenerator {
+  public:
+    // Breadth-first search from `start`; returns how many distinct
+    // placements were found (none if `start` itself does not fit).
+    int Generate(const model::Board &board, const model::ActivePiece &start);
+
+    [[nodiscard]] int Count() const;
+    [[nodiscard]] const ReachablePlacement &Placement(int index) const;
+    // Inputs from the start to `placement`, ending in a hard drop. Only valid
+    // until the next Generate.
+    void PathTo(const ReachablePlacement &placement, MovePath &out) const;
+
+  private:
+    std::array<std::uint32_t, 4 * kMoveRows> fits_{};
+    std::bitset<kMoveStates> visited_{};
+    std::bitset<kMoveStates> locked_{};
+    std::array<std::uint16_t, kMoveStates> queue_{};
+    std::array<std::uint16_t, kMoveStates> parent_{};
+    std::array<model::ReplayAction, kMoveStates> via_{};
+    std::array<ReachablePlacement, kMoveStates> placements_{};
+    std::uint16_t start_ = 0;
+    int count_ = 0;
+};
+
+} // namespace mctetris::bot
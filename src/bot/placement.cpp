@@ -0,0 +1,56 @@
+#include "placement.h"
+
+namespace mctetris::bot {
+namespace {
+
+int DistinctRotations(model::TetrominoType type) {
+    switch (type) {
+    case model::TetrominoType::O:
+        return 1;
+    case model::TetrominoType::I:
+    case model::TetrominoType::S:
+    case model::TetrominoType::Z:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+} // namespace
+
+void EnumeratePlacements(const model::Board &board, const model::ActivePiece &start, PlacementList &out) {
+    out.count = 0;
+    const int startX = start.origin.x;
+    const int startY = start.origin.y;
+    model::Tetromino piece = start.piece;
+    auto add = [&](int x, int turns) {
+        out.items[out.count++] = Placement{piece, x, startY + board.DropDistance(piece, x, startY), turns};
+    };
+
+    const int rotations = DistinctRotations(piece.type);
+    for (int turns = 0; turns < rotations; ++turns) {
+        if (turns > 0) {
+            piece.rotation = (piece.rotation + 1) % 4;
+            if (!board.CanPlace(piece, startX, startY)) {
+                break;
+            }
+        }
+        for (int x = startX; board.CanPlace(piece, x, startY); --x) {
+            add(x, turns);
+        }
+        for (int x = startX + 1; board.CanPlace(piece, x, startY); ++x) {
+            add(x, turns);
+        }
+    }
+}
+
+std::vector<model::ReplayAction> PlacementActions(const model::ActivePiece &start, const Placement &placement) {
+    std::vector<model::ReplayAction> actions(static_cast<std::size_t>(placement.turns), model::ReplayAction::RotateCW);
+    const int shift = placement.x - start.origin.x;
+    const auto move = shift < 0 ? model::ReplayAction::MoveLeft : model::ReplayAction::MoveRight;
+    actions.insert(actions.end(), static_cast<std::size_t>(shift < 0 ? -shift : shift), move);
+    actions.push_back(model::ReplayAction::HardDrop);
+    return actions;
+}
+
+} // namespace mctetris::bot
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "model/active_piece.h"
+#include "model/board.h"
+#include "model/replay.h"
+
+namespace mctetris::bot {
+
+// A resting position reachable from a start position by rotating in place,
+// shifting sideways and hard dropping.
+struct Placement {
+    model::Tetromino piece{};
+    int x = 0;
+    int y = 0;
+    // Clockwise turns applied at the start position.
+    int turns = 0;
+};
+
+// Up to four rotations, each able to reach at most every column plus the
+// piece's overhang on either side.
+constexpr int kMaxPlacements = 4 * (model::kBoardWidth + 3);
+
+struct PlacementList {
+    std::array<Placement, kMaxPlacements> items{};
+    int count = 0;
+};
+
+// Fills `out` with every distinct resting placement of `start.piece`. Rotations
+// that only repeat a shape (O, and the second half of I, S and Z) are skipped.
+void EnumeratePlacements(const model::Board &board, const model::ActivePiece &start, PlacementList &out);
+
+// Input sequence that takes the piece at `start` to `placement` and locks it.
+[[nodiscard]] std::vector<model::ReplayAction> PlacementActions(const model::ActivePiece &start,
+                                                                const Placement &placement);
+
+} // namespace mctetris::bot
@@ -0,0 +1,101 @@
+#include <cstring>
+
+#include "transposition_table.h"
+
+namespace mctetris::bot {
+namespace {
+
+// Packed entry: value bits, then x + 4, y, rotation, turns and piece type,
+// with the top bit set so a stored entry is never the all-zero empty slot.
+constexpr int kXOffset = 4;
+constexpr std::uint64_t kValidBit = std::uint64_t{1} << 63;
+
+std::uint64_t Mix(std::uint64_t value) {
+    value += 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+std::uint64_t Pack(const TableEntry &entry) {
+    std::uint32_t valueBits = 0;
+    std::memcpy(&valueBits, &entry.value, sizeof(valueBits));
+    const Placement &best = entry.best;
+    return kValidBit | valueBits | static_cast<std::uint64_t>(best.x + kXOffset) << 32 |
+           static_cast<std::uint64_t>(best.y) << 36 | static_cast<std::uint64_t>(best.piece.rotation) << 41 |
+           static_cast<std::uint64_t>(best.turns) << 43 | static_cast<std::uint64_t>(best.piece.type) << 45;
+}
+
+TableEntry Unpack(std::uint64_t data) {
+    TableEntry entry;
+    const auto valueBits = static_cast<std::uint32_t>(data);
+    std::memcpy(&entry.value, &valueBits, sizeof(valueBits));
+    entry.best.x = static_cast<int>((data >> 32) & 0xf) - kXOffset;
+    entry.best.y = static_cast<int>((data >> 36) & 0x1f);
+    entry.best.piece.rotation = static_cast<int>((data >> 41) & 0x3);
+    entry.best.turns = static_cast<int>((data >> 43) & 0x3);
+    entry.best.piece.type = static_cast<model::TetrominoType>((data >> 45) & 0x7);
+    return entry;
+}
+
+} // namespace
+
+TranspositionTable::TranspositionTable(int bits)
+    : slots_(std::make_unique<Slot[]>(std::size_t{1} << bits)), mask_((std::uint64_t{1} << bits) - 1) {}
+
+std::uint64_t TranspositionTable::Key(std::uint64_t boardHash, model::TetrominoType type, int depth) {
+    return boardHash ^ Mix(static_cast<std::uint64_t>(type) << 8 | static_cast<std::uint64_t>(depth));
+}
+
+std::uint64_t TranspositionTable::EvaluationKey(std::uint64_t boardHash) {
+    // Depth 0 is never used for a reply, so this cannot alias a Key().
+    return boardHash ^ Mix(0);
+}
+
+void TranspositionTable::Prefetch(std::uint64_t key) const {
+    __builtin_prefetch(&slots_[key & mask_]);
+}
+
+bool TranspositionTable::Probe(std::uint64_t key, TableEntry &out, TableStats &stats) const {
+    const Slot &slot = slots_[key & mask_];
+    const std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+    const std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+    if ((check ^ data) == key && data != 0) {
+        out = Unpack(data);
+        ++stats.hits;
+        return true;
+    }
+    ++stats.misses;
+    // A whole entry always sits in the slot its key indexes, so words that
+    // XOR to a key for another slot were torn apart by a concurrent store.
+    // (The empty slot is the one pair of zeros.)
+    if ((check | data) != 0 && ((check ^ data) & mask_) != (key & mask_)) {
+        ++stats.rejects;
+    }
+    return false;
+}
+
+void TranspositionTable::Store(std::uint64_t key, const TableEntry &entry, TableStats &stats) {
+    Slot &slot = slots_[key & mask_];
+    // The slot was just probed, so these loads hit the cache.
+    const std::uint64_t previous = slot.data.load(std::memory_order_relaxed);
+    if (previous != 0 && (slot.check.load(std::memory_order_relaxed) ^ previous) != key) {
+        ++stats.replacements;
+    }
+    const std::uint64_t data = Pack(entry);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::Clear() {
+    for (std::uint64_t i = 0; i <= mask_; ++i) {
+        slots_[i].check.store(0, std::memory_order_relaxed);
+        slots_[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::size_t TranspositionTable::Capacity() const {
+    return static_cast<std::size_t>(mask_ + 1);
+}
+
+} // namespace mctetris::bot
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "model/tetromino.h"
+#include "placement.h"
+
+namespace mctetris::bot {
+
+struct TableStats {
+    std::int64_t hits = 0;
+    // Probes that found nothing usable: an empty slot, another position, or
+    // a slot that failed verification.
+    std::int64_t misses = 0;
+    // Of the misses, slots whose two words did not verify: torn by a store
+    // racing the probe.
+    std::int64_t rejects = 0;
+    // Stores that evicted a different position; high once the table is full.
+    std::int64_t replacements = 0;
+
+    TableStats &operator+=(const TableStats &other) {
+        hits += other.hits;
+        misses += other.misses;
+        rejects += other.rejects;
+        replacements += other.replacements;
+        return *this;
+    }
+    [[nodiscard]] double HitRate() const {
+        const std::int64_t probes = hits + misses;
+        return probes > 0 ? static_cast<double>(hits) / static_cast<double>(probes) : 0.0;
+    }
+};
+
+// Search result for one (board, piece, depth) position.
+struct TableEntry {
+    float value = 0.0f;
+    Placement best{};
+};
+
+// Fixed-size, always-replace cache shared by every search thread without
+// locks. Each slot holds two relaxed atomic words, the packed entry and the
+// entry XORed with its key; a probe only trusts a slot whose words XOR back
+// to the key it asked for, which also rejects a slot torn by a concurrent
+// store. Probe statistics go to the caller's TableStats so threads never
+// share counters.
+class TranspositionTable {
+  public:
+    // 2^bits slots of 16 bytes.
+    explicit TranspositionTable(int bits);
+
+    // Key for the best reply when `type` is played next with `depth` unseen
+    // pieces still to search.
+    [[nodiscard]] static std::uint64_t Key(std::uint64_t boardHash, model::TetrominoType type, int depth);
+    // Key for the static evaluation of a board, whichever piece produced it.
+    [[nodiscard]] static std::uint64_t EvaluationKey(std::uint64_t boardHash);
+
+    // Starts loading the slot for `key` so a later Probe does not stall on it.
+    void Prefetch(std::uint64_t key) const;
+    [[nodiscard]] bool Probe(std::uint64_t key, TableEntry &out, TableStats &stats) const;
+    void Store(std::uint64_t key, const TableEntry &entry, TableStats &stats);
+    void Clear();
+    [[nodiscard]] std::size_t Capacity() const;
+
+  private:
+    struct Slot {
+        std::atomic<std::uint64_t> check{0};
+        std::atomic<std::uint64_t> data{0};
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    std::uint64_t mask_ = 0;
+};
+
+} // namespace mctetris::bot
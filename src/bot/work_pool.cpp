@@ -0,0 +1,128 @@
+#include <algorithm>
+
+#include "trace/trace.h"
+#include "work_pool.h"
+
+namespace mctetris::bot {
+
+WorkPool::WorkPool(int threads) {
+    if (threads <= 0) {
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    for (int slot = 0; slot < threads; ++slot) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    workers_.reserve(static_cast<std::size_t>(threads - 1));
+    for (int slot = 1; slot < threads; ++slot) {
+        workers_.emplace_back([this, slot]() { WorkerLoop(slot); });
+    }
+}
+
+WorkPool::~WorkPool() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+}
+
+void WorkPool::ParallelFor(int count, const std::function<void(int index, int slot)> &fn) {
+    if (count <= 0) {
+        return;
+    }
+    if (workers_.empty() || count == 1) {
+        for (int index = 0; index < count; ++index) {
+            fn(index, 0);
+        }
+        return;
+    }
+
+    fn_ = &fn;
+    remaining_.store(count, std::memory_order_release);
+    {
+        // Publishing the range under the queue lock also publishes fn_.
+        std::lock_guard<std::mutex> lock(queues_[0]->mutex);
+        queues_[0]->ranges.push_back({0, count});
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        ++generation_;
+    }
+    wake_.notify_all();
+    Help(0);
+}
+
+int WorkPool::Concurrency() const {
+    return static_cast<int>(queues_.size());
+}
+
+void WorkPool::WorkerLoop(int slot) {
+    trace::SetThreadName("bot worker");
+    std::uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wake_.wait(lock, [&]() { return stopping_ || generation_ != seen; });
+            if (stopping_) {
+                return;
+            }
+            seen = generation_;
+        }
+        Help(slot);
+    }
+}
+
+void WorkPool::Help(int slot) {
+    MCTETRIS_TRACE_SCOPE("WorkPool::Help");
+    while (remaining_.load(std::memory_order_acquire) > 0) {
+        if (const auto range = Take(slot)) {
+            Execute(slot, *range);
+        } else {
+            // The last ranges are running elsewhere; they finish within one call of fn.
+            std::this_thread::yield();
+        }
+    }
+}
+
+std::optional<WorkPool::Range> WorkPool::Take(int slot) {
+    {
+        Queue &own = *queues_[static_cast<std::size_t>(slot)];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.ranges.empty()) {
+            const Range range = own.ranges.back();
+            own.ranges.pop_back();
+            return range;
+        }
+    }
+    const int count = Concurrency();
+    for (int offset = 1; offset < count; ++offset) {
+        Queue &victim = *queues_[static_cast<std::size_t>((slot + offset) % count)];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.ranges.empty()) {
+            const Range range = victim.ranges.front();
+            victim.ranges.pop_front();
+            return range;
+        }
+    }
+    return std::nullopt;
+}
+
+void WorkPool::Execute(int slot, Range range) {
+    // Split until a single index is left, leaving the larger halves for thieves.
+    while (range.end - range.begin > 1) {
+        const int mid = range.begin + (range.end - range.begin) / 2;
+        {
+            Queue &own = *queues_[static_cast<std::size_t>(slot)];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.ranges.push_back({mid, range.end});
+        }
+        range.end = mid;
+    }
+    (*fn_)(range.begin, slot);
+    remaining_.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+} // namespace mctetris::bot
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace mctetris::bot {
+
+// Fixed set of threads that share index ranges by work stealing. Each thread
+// owns a deque: it splits ranges in half, keeps the lower half and pushes the
+// upper half to the back of its own deque, while idle threads steal from the
+// front of other deques. The calling thread takes part in every job.
+class WorkPool {
+  public:
+    // `threads` counts the caller; 0 uses every hardware thread.
+    explicit WorkPool(int threads = 0);
+    ~WorkPool();
+
+    WorkPool(const WorkPool &) = delete;
+    WorkPool &operator=(const WorkPool &) = delete;
+
+    // Calls fn(index, slot) for every index in [0, count) and returns once all
+    // calls have finished. `slot` identifies the executing thread in
+    // [0, Concurrency()), so callers can keep per-thread scratch without
+    // locking. Not reentrant; one job runs at a time.
+    void ParallelFor(int count, const std::function<void(int index, int slot)> &fn);
+
+    [[nodiscard]] int Concurrency() const;
+
+  private:
+    struct Range {
+        int begin = 0;
+        int end = 0;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    void WorkerLoop(int slot);
+    void Help(int slot);
+    [[nodiscard]] std::optional<Range> Take(int slot);
+    void Execute(int slot, Range range);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    std::uint64_t generation_ = 0;
+    bool stopping_ = false;
+    const std::function<void(int, int)> *fn_ = nullptr;
+    std::atomic<int> remaining_{0};
+};
+
+} // namespace mctetris::bot
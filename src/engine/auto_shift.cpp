@@ -0,0 +1,226 @@
+#include <algorithm>
+
+#include "auto_shift.h"
+
+namespace mctetris::engine {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Presses of one key closer together than this are the terminal repeating
+// it rather than separate taps.
+constexpr auto kMaxRepeatGap = std::chrono::milliseconds(100);
+// A held key counts as released once its repeats stop for twice their
+// interval, kept within these bounds.
+constexpr auto kMinReleaseGap = std::chrono::milliseconds(40);
+constexpr auto kMaxReleaseGap = std::chrono::milliseconds(250);
+constexpr std::int64_t kToEdge = ShiftSteps::kToEdge;
+
+Clock::duration ReleaseGap(Clock::duration repeatInterval) {
+    return std::clamp<Clock::duration>(2 * repeatInterval, kMinReleaseGap, kMaxReleaseGap);
+}
+
+int AddSteps(int total, std::int64_t steps) {
+    return static_cast<int>(std::clamp<std::int64_t>(total + steps, -kToEdge, kToEdge));
+}
+
+} // namespace
+
+AutoShift::AutoShift(AutoShiftConfig config) : config_(config) {}
+
+void AutoShift::SetReleaseEvents(bool reported) {
+    if (reported != releaseEvents_) {
+        releaseEvents_ = reported;
+        Clear();
+    }
+}
+
+void AutoShift::Press(ShiftKey key, Clock::time_point time, bool repeat) {
+    Hold &hold = At(key);
+    if (releaseEvents_) {
+        // Held keys are timed here, so the terminal's repeats add nothing.
+        if (!repeat && !hold.down) {
+            Start(key, time, true);
+        }
+        return;
+    }
+
+    const auto gap = time - hold.lastEvent;
+    const bool streak = hold.seen && gap <= kMaxRepeatGap;
+    hold.lastEvent = time;
+    hold.seen = true;
+    if (hold.down && hold.confirmed) {
+        hold.expires = time + ReleaseGap(gap);
+    } else if (hold.down && streak) {
+        // A second press hard on the first: the terminal is repeating a
+        // held key, so start repeating it here at our own rate.
+        hold.confirmed = true;
+        hold.repeatFrom = std::max(hold.pressed + Delay(key), time);
+        hold.expires = time + ReleaseGap(gap);
+    } else {
+        // A tap, until the terminal shows otherwise.
+        Start(key, time, true);
+    }
+}
+
+void AutoShift::Release(ShiftKey key, Clock::time_point time) {
+    if (At(key).down) {
+        Stop(key, time);
+    }
+}
+
+void AutoShift::Clear() {
+    holds_ = {};
+    horizontal_.reset();
+    pending_ = {};
+}
+
+ShiftSteps AutoShift::Advance(Clock::time_point now) {
+    if (!releaseEvents_) {
+        for (const auto key : {ShiftKey::Left, ShiftKey::Right, ShiftKey::Down}) {
+            const Hold &hold = At(key);
+            if (hold.down && hold.expires <= now) {
+                Stop(key, hold.expires);
+            }
+        }
+    }
+    ShiftSteps steps = pending_;
+    pending_ = {};
+    for (const auto key : {ShiftKey::Left, ShiftKey::Right, ShiftKey::Down}) {
+        Collect(key, now, steps);
+    }
+    return steps;
+}
+
+std::optional<Clock::time_point> AutoShift::NextDeadline() const {
+    std::optional<Clock::time_point> deadline;
+    auto consider = [&deadline](Clock::time_point time) {
+        if (!deadline || time < *deadline) {
+            deadline = time;
+        }
+    };
+    if (pending_.horizontal != 0 || pending_.drops != 0) {
+        consider(Clock::time_point{});
+    }
+    for (const auto key : {ShiftKey::Left, ShiftKey::Right, ShiftKey::Down}) {
+        if (const auto next = NextStep(key)) {
+            consider(*next);
+        }
+        if (!releaseEvents_ && At(key).down) {
+            consider(At(key).expires);
+        }
+    }
+    return deadline;
+}
+
+const AutoShiftConfig &AutoShift::Config() const {
+    return config_;
+}
+
+AutoShift::Hold &AutoShift::At(ShiftKey key) {
+    return holds_[static_cast<std::size_t>(key)];
+}
+
+const AutoShift::Hold &AutoShift::At(ShiftKey key) const {
+    return holds_[static_cast<std::size_t>(key)];
+}
+
+std::chrono::nanoseconds AutoShift::Delay(ShiftKey key) const {
+    // Soft drop has no separate delay: it repeats one interval after the press.
+    return key == ShiftKey::Down ? Interval(key) : std::chrono::nanoseconds(config_.das);
+}
+
+std::chrono::nanoseconds AutoShift::Interval(ShiftKey key) const {
+    return key == ShiftKey::Down ? config_.softDrop : config_.arr;
+}
+
+bool AutoShift::Moving(ShiftKey key) const {
+    return At(key).down && (key == ShiftKey::Down || horizontal_ == key);
+}
+
+void AutoShift::Start(ShiftKey key, Clock::time_point time, bool initialStep) {
+    if (At(key).down) {
+        Stop(key, time);
+    }
+    // The other direction pauses while this one moves, but first makes the
+    // steps it already owes.
+    if (key != ShiftKey::Down && horizontal_ && horizontal_ != key && At(*horizontal_).steps < kToEdge) {
+        Collect(*horizontal_, time, pending_);
+    }
+    Hold &hold = At(key);
+    hold.down = true;
+    hold.confirmed = releaseEvents_;
+    hold.pressed = time;
+    hold.repeatFrom = time + Delay(key);
+    hold.expires = time + kMaxRepeatGap;
+    hold.steps = initialStep ? 0 : 1;
+    if (key != ShiftKey::Down) {
+        horizontal_ = key;
+    }
+}
+
+void AutoShift::Stop(ShiftKey key, Clock::time_point time) {
+    if (At(key).steps < kToEdge) {
+        Collect(key, time, pending_);
+    }
+    At(key).down = false;
+    if (horizontal_ != key) {
+        return;
+    }
+    horizontal_.reset();
+    const ShiftKey other = key == ShiftKey::Left ? ShiftKey::Right : ShiftKey::Left;
+    Hold &resumed = At(other);
+    if (resumed.down) {
+        // The other direction is still held: it takes over after a fresh DAS,
+        // without a step of its own.
+        resumed.pressed = time;
+        resumed.repeatFrom = time + Delay(other);
+        resumed.steps = 1;
+        horizontal_ = other;
+    }
+}
+
+void AutoShift::Collect(ShiftKey key, Clock::time_point now, ShiftSteps &steps) {
+    if (!Moving(key)) {
+        return;
+    }
+    Hold &hold = At(key);
+    std::int64_t target = 1;
+    if (hold.confirmed && now >= hold.repeatFrom) {
+        const auto interval = Interval(key);
+        target = interval.count() == 0 ? kToEdge : 2 + (now - hold.repeatFrom) / interval;
+    }
+    const std::int64_t due = target == kToEdge ? kToEdge : target - hold.steps;
+    if (due <= 0) {
+        return;
+    }
+    if (key == ShiftKey::Down) {
+        if (hold.steps == 0 && steps.drops == 0) {
+            steps.dropPressed = true;
+        }
+        steps.drops = AddSteps(steps.drops, due);
+    } else {
+        steps.horizontal = AddSteps(steps.horizontal, key == ShiftKey::Left ? -due : due);
+    }
+    hold.steps = target;
+}
+
+std::optional<Clock::time_point> AutoShift::NextStep(ShiftKey key) const {
+    if (!Moving(key)) {
+        return std::nullopt;
+    }
+    const Hold &hold = At(key);
+    if (hold.steps == 0) {
+        return hold.pressed;
+    }
+    if (!hold.confirmed || hold.steps >= kToEdge) {
+        return std::nullopt;
+    }
+    const auto interval = Interval(key);
+    if (interval.count() == 0 || hold.steps == 1) {
+        return hold.repeatFrom;
+    }
+    return hold.repeatFrom + (hold.steps - 1) * interval;
+}
+
+} // namespace mctetris::engine
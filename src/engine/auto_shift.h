@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace mctetris::engine {
+
+enum class ShiftKey : std::uint8_t {
+    Left,
+    Right,
+    Down
+};
+
+struct AutoShiftConfig {
+    // Delayed auto shift: how long a direction is held before it repeats.
+    std::chrono::milliseconds das{83};
+    // Auto repeat rate: time between repeated moves; zero goes straight to the wall.
+    std::chrono::milliseconds arr{0};
+    // Time between soft drops while down is held; zero goes straight to the floor.
+    std::chrono::milliseconds softDrop{25};
+};
+
+// Steps due from the held keys. Either count may be kToEdge, which comes
+// back from every Advance() while a key with a zero interval stays held, so
+// a piece that spawns or rotates off the wall goes straight back to it.
+struct ShiftSteps {
+    static constexpr int kToEdge = 1 << 20;
+
+    // Negative moves left, positive right.
+    int horizontal = 0;
+    int drops = 0;
+    // The first drop comes from a fresh press of down, so like a single soft
+    // drop it may lock a piece that has landed; held drops stop at the floor.
+    bool dropPressed = false;
+};
+
+// Delayed auto shift and auto repeat, timed from when keys were pressed
+// rather than from the terminal's own key repeat, so the same settings feel
+// the same in every terminal and no step waits for a frame.
+//
+// When the terminal reports releases, a key is held from its press to its
+// release. Otherwise the terminal's autorepeat is the only sign a key is
+// still down: each press is a single step until two arrive in quick
+// succession, and the hold then ends once the repeats stop for longer than
+// twice their interval.
+class AutoShift {
+  public:
+    explicit AutoShift(AutoShiftConfig config = {});
+
+    void SetReleaseEvents(bool reported);
+    // `repeat` marks the terminal's own repeat of a key that is already down.
+    void Press(ShiftKey key, std::chrono::steady_clock::time_point time, bool repeat);
+    void Release(ShiftKey key, std::chrono::steady_clock::time_point time);
+    // Forgets every held key, e.g. when the game pauses.
+    void Clear();
+
+    // Steps due by `now` that have not been returned yet.
+    [[nodiscard]] ShiftSteps Advance(std::chrono::steady_clock::time_point now);
+    // When Advance() next has something to return; empty while nothing is
+    // due until the next key event.
+    [[nodiscard]] std::optional<std::chrono::steady_clock::time_point> NextDeadline() const;
+    [[nodiscard]] const AutoShiftConfig &Config() const;
+
+  private:
+    struct Hold {
+        bool down = false;
+        // Known to be held rather than tapped; always true with release events.
+        bool confirmed = false;
+        std::chrono::steady_clock::time_point pressed{};
+        // When repeating starts: DAS after the press, or the first terminal
+        // repeat if that comes later.
+        std::chrono::steady_clock::time_point repeatFrom{};
+        // Without release events, when the hold is taken to have ended.
+        std::chrono::steady_clock::time_point expires{};
+        // Without release events, the last time the terminal sent the key.
+        std::chrono::steady_clock::time_point lastEvent{};
+        bool seen = false;
+        // Steps taken since the press, the first one included; kToEdge once
+        // repeating with a zero interval.
+        std::int64_t steps = 0;
+    };
+
+    [[nodiscard]] Hold &At(ShiftKey key);
+    [[nodiscard]] const Hold &At(ShiftKey key) const;
+    // Delay before `key` first repeats, and the time between repeats.
+    [[nodiscard]] std::chrono::nanoseconds Delay(ShiftKey key) const;
+    [[nodiscard]] std::chrono::nanoseconds Interval(ShiftKey key) const;
+    [[nodiscard]] bool Moving(ShiftKey key) const;
+    void Start(ShiftKey key, std::chrono::steady_clock::time_point time, bool initialStep);
+    // Adds the steps `key` owes up to `time` to pending_, then lets go of it.
+    void Stop(ShiftKey key, std::chrono::steady_clock::time_point time);
+    void Collect(ShiftKey key, std::chrono::steady_clock::time_point now, ShiftSteps &steps);
+    [[nodiscard]] std::optional<std::chrono::steady_clock::time_point> NextStep(ShiftKey key) const;
+
+    AutoShiftConfig config_;
+    bool releaseEvents_ = false;
+    std::array<Hold, 3> holds_{};
+    // The direction that moves while both are down: the one pressed last.
+    std::optional<ShiftKey> horizontal_;
+    // Steps owed by keys let go of since the last Advance().
+    ShiftSteps pending_{};
+};
+
+} // namespace mctetris::engine
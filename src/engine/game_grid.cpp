@@ -0,0 +1,101 @@
+#include <algorithm>
+
+#include "game_grid.h"
+#include "model/replay.h"
+#include "trace/trace.h"
+
+namespace mctetris::engine {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+bot::BotConfig SingleThreaded(bot::BotConfig config) {
+    config.threads = 1;
+    return config;
+}
+
+Clock::duration GravityDelay(const model::GameSession &session) {
+    return std::chrono::milliseconds(session.Model().GravityDelayMs());
+}
+
+} // namespace
+
+GameGrid::GameGrid(int boards, std::uint32_t seed, model::Randomizer randomizer, bot::BotConfig botConfig)
+    : bot_(SingleThreaded(botConfig)), seeds_(seed) {
+    boards_.reserve(static_cast<std::size_t>(std::max(boards, 0)));
+    for (int i = 0; i < boards; ++i) {
+        boards_.push_back(GridBoard{model::GameSession(seeds_(), randomizer)});
+    }
+}
+
+void GameGrid::Start(Clock::time_point now) {
+    const auto count = static_cast<Clock::rep>(boards_.size());
+    for (std::size_t i = 0; i < boards_.size(); ++i) {
+        auto &board = boards_[i];
+        const auto delay = GravityDelay(board.session);
+        board.nextTick = now + delay + delay * static_cast<Clock::rep>(i) / count;
+    }
+}
+
+int GameGrid::Advance(Clock::time_point now) {
+    MCTETRIS_TRACE_SCOPE("GameGrid::Advance");
+    int changed = 0;
+    for (auto &board : boards_) {
+        if (board.nextTick <= now) {
+            Tick(board, now);
+            ++changed;
+        }
+    }
+    return changed;
+}
+
+void GameGrid::Delay(Clock::duration pause) {
+    for (auto &board : boards_) {
+        board.nextTick += pause;
+    }
+}
+
+std::optional<Clock::time_point> GameGrid::NextDeadline() const {
+    if (boards_.empty()) {
+        return std::nullopt;
+    }
+    return std::min_element(boards_.begin(), boards_.end(),
+                            [](const GridBoard &lhs, const GridBoard &rhs) { return lhs.nextTick < rhs.nextTick; })
+        ->nextTick;
+}
+
+const std::vector<GridBoard> &GameGrid::Boards() const {
+    return boards_;
+}
+
+const bot::Bot &GameGrid::Player() const {
+    return bot_;
+}
+
+void GameGrid::Tick(GridBoard &board, Clock::time_point now) {
+    auto &session = board.session;
+    if (session.Model().IsGameOver()) {
+        ++board.gamesFinished;
+        board.bestScore = std::max(board.bestScore, session.Model().Score());
+        session.Reset(seeds_());
+        board.nextTick = now + GravityDelay(session);
+        return;
+    }
+    // As in autoplay, the bot places one piece per gravity interval.
+    if (const auto decision = bot_.Decide(session.Model(), session.NextType())) {
+        for (const auto action : decision->actions) {
+            (void)model::ApplyReplayAction(session, action);
+        }
+    }
+    session.SpawnIfNeeded();
+
+    // A fixed schedule, as on the simulation thread: lateness does not
+    // accumulate, and ticks missed during a stall are skipped.
+    const auto delay = GravityDelay(session);
+    board.nextTick += delay;
+    if (board.nextTick <= now) {
+        board.nextTick = now + delay;
+    }
+}
+
+} // namespace mctetris::engine
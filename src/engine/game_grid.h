@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "bot/bot.h"
+#include "model/game_session.h"
+
+namespace mctetris::engine {
+
+// One game of the grid, with the games it has already finished.
+struct GridBoard {
+    model::GameSession session;
+    std::chrono::steady_clock::time_point nextTick{};
+    int gamesFinished = 0;
+    int bestScore = 0;
+};
+
+// Many independent games stepped together on the calling thread, each
+// played by the same bot, for tournaments and soak tests. A board whose game
+// ends shows it for one gravity interval and then starts a new one.
+class GameGrid {
+  public:
+    // The bot always searches on the calling thread, so the grid keeps to one core.
+    GameGrid(int boards, std::uint32_t seed, model::Randomizer randomizer, bot::BotConfig botConfig);
+
+    // Schedules the first ticks, staggered over one gravity interval so the
+    // boards do not all ask the bot for a move in the same frame.
+    void Start(std::chrono::steady_clock::time_point now);
+    // Runs every tick due by `now`; returns the number of boards that changed.
+    int Advance(std::chrono::steady_clock::time_point now);
+    // Moves every schedule on by `pause`, e.g. after the grid was paused.
+    void Delay(std::chrono::steady_clock::duration pause);
+
+    [[nodiscard]] std::optional<std::chrono::steady_clock::time_point> NextDeadline() const;
+    [[nodiscard]] const std::vector<GridBoard> &Boards() const;
+    [[nodiscard]] const bot::Bot &Player() const;
+
+  private:
+    void Tick(GridBoard &board, std::chrono::steady_clock::time_point now);
+
+    std::vector<GridBoard> boards_;
+    bot::Bot bot_;
+    std::mt19937 seeds_;
+};
+
+} // namespace mctetris::engine
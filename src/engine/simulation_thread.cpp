@@ -0,0 +1,364 @@
+#include <csignal>
+#include <cstdlib>
+#include <utility>
+
+#include <pthread.h>
+
+#include "input/input_wait.h"
+#include "input/wake_pipe.h"
+#include "simulation_thread.h"
+#include "trace/trace.h"
+
+namespace mctetris::engine {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::uint32_t ElapsedMs(Clock::time_point start, Clock::time_point now) {
+    return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count());
+}
+
+} // namespace
+
+SimulationThread::SimulationThread(model::Randomizer randomizer, AutoShiftConfig autoShift, bot::Bot *bot,
+                                   GameEndHandler onGameEnd)
+    : session_(0, randomizer), bot_(bot), onGameEnd_(std::move(onGameEnd)), autoShift_(autoShift) {}
+
+SimulationThread::~SimulationThread() {
+    Stop();
+}
+
+void SimulationThread::ResumeGame(const model::GameSession &session, model::Replay recording) {
+    // Recorded times continue from the last event, so the replay has no gap.
+    const auto lastMs = recording.events.empty() ? 0 : recording.events.back().timeMs;
+    const auto now = Clock::now();
+    session_ = session;
+    recorder_.Resume(std::move(recording));
+    gameStart_ = now - std::chrono::milliseconds(lastMs);
+    nextGravity_ = now + std::chrono::milliseconds(session_.Model().GravityDelayMs());
+    gravityArmed_ = false;
+    paused_ = true;
+    inGame_ = true;
+    autoShift_.Clear();
+}
+
+bool SimulationThread::Start() {
+    if (thread_.joinable()) {
+        return true;
+    }
+    if (!input::MakePipe(commandPipe_) || !input::MakePipe(publishPipe_)) {
+        input::ClosePipe(commandPipe_);
+        input::ClosePipe(publishPipe_);
+        return false;
+    }
+    stopping_.store(false);
+
+    // Signals stay on the render thread, as for the input thread.
+    sigset_t all;
+    sigset_t previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &previous);
+    thread_ = std::thread([this]() { Run(); });
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+    return true;
+}
+
+void SimulationThread::Stop() {
+    if (thread_.joinable()) {
+        // Nothing sent is dropped: the backlog goes in as the simulation
+        // makes room, and Run() takes what is queued before it ends.
+        while (!backlog_.empty()) {
+            FlushBacklog();
+            if (!backlog_.empty()) {
+                (void)input::WaitForInput(publishPipe_[0], std::nullopt);
+                input::DrainPipe(publishPipe_[0]);
+            }
+        }
+        stopping_.store(true);
+        input::SignalPipe(commandPipe_[1]);
+        thread_.join();
+    }
+    input::ClosePipe(commandPipe_);
+    input::ClosePipe(publishPipe_);
+}
+
+void SimulationThread::NewGame(std::uint32_t seed) {
+    Command command;
+    command.kind = CommandKind::NewGame;
+    command.seed = seed;
+    Send(command);
+}
+
+void SimulationThread::Apply(model::ReplayAction action) {
+    Command command;
+    command.kind = CommandKind::Apply;
+    command.action = action;
+    Send(command);
+}
+
+void SimulationThread::Press(ShiftKey key, Clock::time_point time, bool repeat) {
+    Command command;
+    command.kind = CommandKind::Press;
+    command.key = key;
+    command.flag = repeat;
+    command.time = time;
+    Send(command);
+}
+
+void SimulationThread::Release(ShiftKey key, Clock::time_point time) {
+    Command command;
+    command.kind = CommandKind::Release;
+    command.key = key;
+    command.time = time;
+    Send(command);
+}
+
+void SimulationThread::SetReleaseEvents(bool reported) {
+    Command command;
+    command.kind = CommandKind::SetReleaseEvents;
+    command.flag = reported;
+    Send(command);
+}
+
+void SimulationThread::TogglePause() {
+    Command command;
+    command.kind = CommandKind::TogglePause;
+    Send(command);
+}
+
+std::uint64_t SimulationThread::Sent() const {
+    return sent_;
+}
+
+bool SimulationThread::Update() {
+    return snapshots_.Update();
+}
+
+const GameSnapshot &SimulationThread::Latest() const {
+    return snapshots_.Front();
+}
+
+bool SimulationThread::PopTiming(StepTiming &timing) {
+    return timings_.TryPop(timing);
+}
+
+int SimulationThread::WakeFd() const {
+    return publishPipe_[0];
+}
+
+void SimulationThread::AcknowledgeWake() {
+    input::DrainPipe(publishPipe_[0]);
+    FlushBacklog();
+}
+
+void SimulationThread::Send(const Command &command) {
+    ++sent_;
+    // Nothing overtakes a command already waiting.
+    if (backlog_.empty() && commands_.TryPush(command)) {
+        input::SignalPipe(commandPipe_[1]);
+        return;
+    }
+    backlog_.push_back(command);
+    FlushBacklog();
+}
+
+void SimulationThread::FlushBacklog() {
+    bool pushed = false;
+    while (!backlog_.empty() && commands_.TryPush(backlog_.front())) {
+        backlog_.pop_front();
+        pushed = true;
+    }
+    if (pushed) {
+        input::SignalPipe(commandPipe_[1]);
+    }
+}
+
+void SimulationThread::Run() {
+    trace::SetThreadName("simulation");
+    // Wakes the render thread too, which matters when a resumed game is
+    // already on screen.
+    Publish();
+    input::SignalPipe(publishPipe_[1]);
+    while (!stopping_.load()) {
+        std::optional<Clock::time_point> deadline;
+        if (Running()) {
+            deadline = nextGravity_;
+            const auto shift = autoShift_.NextDeadline();
+            if (shift && *shift < *deadline) {
+                deadline = shift;
+            }
+        }
+        (void)input::WaitForInput(commandPipe_[0], deadline);
+        input::DrainPipe(commandPipe_[0]);
+
+        const auto stepStart = Clock::now();
+        StepTiming timing;
+        bool changed = false;
+        Command command;
+        while (commands_.TryPop(command)) {
+            Execute(command, stepStart);
+            ++applied_;
+            changed = true;
+        }
+        if (Running() && stepStart >= nextGravity_) {
+            timing.gravityLate = StepGravity(stepStart);
+            changed = true;
+        }
+        // After gravity, so a piece spawned by this step can shift at once.
+        if (Running() && StepAutoShift(stepStart)) {
+            changed = true;
+        }
+        if (!changed) {
+            continue;
+        }
+        if (inGame_ && session_.Model().IsGameOver()) {
+            EndGame(true);
+        }
+        Publish();
+        const auto stepDone = Clock::now();
+        MCTETRIS_TRACE_COMPLETE("Simulation::Step", stepStart, stepDone);
+        timing.time = stepDone;
+        timing.update = stepDone - stepStart;
+        // Timings are only for the HUD; drop them if nobody is reading.
+        (void)timings_.TryPush(timing);
+        input::SignalPipe(publishPipe_[1]);
+    }
+    Command command;
+    while (commands_.TryPop(command)) {
+        Execute(command, Clock::now());
+        ++applied_;
+    }
+    if (inGame_) {
+        EndGame(false);
+    }
+    Publish();
+}
+
+void SimulationThread::Execute(const Command &command, Clock::time_point now) {
+    auto &model = session_.Model();
+    switch (command.kind) {
+    case CommandKind::NewGame:
+        if (inGame_) {
+            EndGame(false);
+        }
+        session_.Reset(command.seed);
+        recorder_.Begin(session_.Seed(), session_.Pieces().Kind());
+        gameStart_ = now;
+        nextGravity_ = now + std::chrono::milliseconds(model.GravityDelayMs());
+        gravityArmed_ = false;
+        paused_ = false;
+        inGame_ = true;
+        autoShift_.Clear();
+        return;
+    case CommandKind::TogglePause:
+        if (!inGame_) {
+            return;
+        }
+        paused_ = !paused_;
+        gravityArmed_ = false;
+        autoShift_.Clear();
+        // A full interval after resuming, not whatever was left when pausing.
+        nextGravity_ = now + std::chrono::milliseconds(model.GravityDelayMs());
+        return;
+    case CommandKind::Apply:
+        if (!Running() || bot_ != nullptr) {
+            return;
+        }
+        (void)RecordAction(command.action, now);
+        session_.SpawnIfNeeded();
+        return;
+    case CommandKind::Press:
+        if (Running() && bot_ == nullptr) {
+            autoShift_.Press(command.key, command.time, command.flag);
+        }
+        return;
+    case CommandKind::Release:
+        autoShift_.Release(command.key, command.time);
+        return;
+    case CommandKind::SetReleaseEvents:
+        autoShift_.SetReleaseEvents(command.flag);
+        return;
+    }
+}
+
+bool SimulationThread::RecordAction(model::ReplayAction action, Clock::time_point now) {
+    if (!model::ApplyReplayAction(session_, action)) {
+        return false;
+    }
+    recorder_.Record(action, ElapsedMs(gameStart_, now));
+    return true;
+}
+
+bool SimulationThread::StepAutoShift(Clock::time_point now) {
+    const ShiftSteps steps = autoShift_.Advance(now);
+    bool changed = false;
+    const auto move = steps.horizontal < 0 ? model::ReplayAction::MoveLeft : model::ReplayAction::MoveRight;
+    for (int i = 0; i < std::abs(steps.horizontal) && RecordAction(move, now); ++i) {
+        changed = true;
+    }
+    const int spawned = session_.PiecesSpawned();
+    for (int i = 0; i < steps.drops && session_.PiecesSpawned() == spawned; ++i) {
+        const auto &model = session_.Model();
+        const auto &piece = model.CurrentPiece();
+        if (!piece) {
+            break;
+        }
+        // Only a fresh press locks a landed piece; held drops stop at the floor.
+        const bool landed = model.GetBoard().DropDistance(piece->piece, piece->origin.x, piece->origin.y) == 0;
+        if ((landed && !(i == 0 && steps.dropPressed)) || !RecordAction(model::ReplayAction::SoftDrop, now)) {
+            break;
+        }
+        changed = true;
+    }
+    return changed;
+}
+
+std::optional<std::chrono::nanoseconds> SimulationThread::StepGravity(Clock::time_point now) {
+    std::optional<std::chrono::nanoseconds> late;
+    if (gravityArmed_) {
+        late = now - nextGravity_;
+    }
+    gravityArmed_ = true;
+    // With a bot, it places one piece per gravity interval instead.
+    if (bot_ == nullptr) {
+        (void)RecordAction(model::ReplayAction::Gravity, now);
+    } else if (const auto decision = bot_->Decide(session_.Model(), session_.NextType())) {
+        for (const auto action : decision->actions) {
+            (void)RecordAction(action, now);
+        }
+    }
+    session_.SpawnIfNeeded();
+
+    // Ticks follow a fixed schedule rather than the time the last one ran, so
+    // lateness does not accumulate; after a long stall the missed ticks are
+    // skipped instead of fired back to back.
+    const auto delay = std::chrono::milliseconds(session_.Model().GravityDelayMs());
+    nextGravity_ += delay;
+    if (nextGravity_ <= now) {
+        nextGravity_ = now + delay;
+    }
+    return late;
+}
+
+void SimulationThread::EndGame(bool finished) {
+    recorder_.Finish(session_);
+    if (onGameEnd_) {
+        onGameEnd_(session_, recorder_.Current(), finished);
+    }
+    inGame_ = false;
+}
+
+void SimulationThread::Publish() {
+    GameSnapshot &snapshot = snapshots_.Back();
+    snapshot.model = session_.Model();
+    snapshot.next = session_.NextType();
+    snapshot.paused = paused_;
+    snapshot.applied = applied_;
+    snapshots_.Publish();
+}
+
+bool SimulationThread::Running() const {
+    return inGame_ && !paused_ && !session_.Model().IsGameOver();
+}
+
+} // namespace mctetris::engine
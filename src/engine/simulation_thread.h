@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <thread>
+
+#include "bot/bot.h"
+#include "input/spsc_ring.h"
+#include "model/game_session.h"
+#include "model/replay.h"
+#include "auto_shift.h"
+#include "triple_buffer.h"
+
+namespace mctetris::engine {
+
+// Everything the game screen draws, copied out after each simulation step.
+struct GameSnapshot {
+    model::GameModel model{};
+    std::optional<model::TetrominoType> next{};
+    bool paused = false;
+    // Commands applied so far, so the render thread can tell which of the
+    // ones it sent this snapshot already shows.
+    std::uint64_t applied = 0;
+};
+
+// Cost of one simulation step, passed back for the performance HUD.
+struct StepTiming {
+    std::chrono::steady_clock::time_point time{};
+    std::chrono::nanoseconds update{0};
+    // How late this step's gravity tick fired; absent when it had none.
+    std::optional<std::chrono::nanoseconds> gravityLate{};
+};
+
+// Runs the game on its own thread: commands queued by the render thread,
+// held moves timed by AutoShift, gravity on a fixed schedule and, with a
+// bot, autoplay. After every step it
+// publishes a GameSnapshot through a triple buffer, so drawing never holds
+// up the simulation and a stalled terminal never delays gravity.
+class SimulationThread {
+  public:
+    // Called on the simulation thread once per game: with `finished` when it
+    // ends in a game over, without when it is replaced or stopped mid-game.
+    using GameEndHandler = std::function<void(const model::GameSession &session, const model::Replay &recording,
+                                              bool finished)>;
+
+    // `bot`, if given, plays instead of the player and is only touched by the
+    // simulation thread until Stop() returns.
+    SimulationThread(model::Randomizer randomizer, AutoShiftConfig autoShift, bot::Bot *bot,
+                     GameEndHandler onGameEnd);
+    ~SimulationThread();
+
+    SimulationThread(const SimulationThread &) = delete;
+    SimulationThread &operator=(const SimulationThread &) = delete;
+
+    // Puts a saved game back in play, paused, recording on from where
+    // `recording` stopped. Only before Start().
+    void ResumeGame(const model::GameSession &session, model::Replay recording);
+    [[nodiscard]] bool Start();
+    // Applies every command sent so far, reports a game still in progress,
+    // then joins the thread.
+    void Stop();
+
+    // Producer side, render thread only. A command the queue has no room for
+    // waits in a backlog and is retried, in order, by the next send or
+    // AcknowledgeWake(), so none is ever dropped.
+    void NewGame(std::uint32_t seed);
+    void Apply(model::ReplayAction action);
+    // Moves and soft drop, which repeat while held; `time` is when the key
+    // was read, so repeats are timed from the keypress itself.
+    void Press(ShiftKey key, std::chrono::steady_clock::time_point time, bool repeat);
+    void Release(ShiftKey key, std::chrono::steady_clock::time_point time);
+    void SetReleaseEvents(bool reported);
+    void TogglePause();
+    // Commands sent so far, backlog included; compare with GameSnapshot::applied.
+    [[nodiscard]] std::uint64_t Sent() const;
+
+    // Consumer side, render thread only. Update() takes the newest snapshot
+    // if one was published since the last call.
+    bool Update();
+    [[nodiscard]] const GameSnapshot &Latest() const;
+    [[nodiscard]] bool PopTiming(StepTiming &timing);
+    // Readable whenever something was published since AcknowledgeWake().
+    // The simulation publishes after taking commands, so waiting on this
+    // also waits for room for the backlog.
+    [[nodiscard]] int WakeFd() const;
+    void AcknowledgeWake();
+
+  private:
+    enum class CommandKind : std::uint8_t {
+        NewGame,
+        Apply,
+        Press,
+        Release,
+        SetReleaseEvents,
+        TogglePause
+    };
+    struct Command {
+        CommandKind kind = CommandKind::Apply;
+        model::ReplayAction action = model::ReplayAction::Gravity;
+        ShiftKey key = ShiftKey::Left;
+        // Repeat for Press, reported for SetReleaseEvents.
+        bool flag = false;
+        std::uint32_t seed = 0;
+        std::chrono::steady_clock::time_point time{};
+    };
+
+    void Send(const Command &command);
+    // Moves what fits of the backlog into the queue.
+    void FlushBacklog();
+    void Run();
+    void Execute(const Command &command, std::chrono::steady_clock::time_point now);
+    bool RecordAction(model::ReplayAction action, std::chrono::steady_clock::time_point now);
+    // Makes the moves and drops AutoShift has due; returns whether any did.
+    bool StepAutoShift(std::chrono::steady_clock::time_point now);
+    // Runs a due gravity tick (or the bot); returns how late it fired.
+    std::optional<std::chrono::nanoseconds> StepGravity(std::chrono::steady_clock::time_point now);
+    void EndGame(bool finished);
+    void Publish();
+    [[nodiscard]] bool Running() const;
+
+    model::GameSession session_;
+    bot::Bot *bot_;
+    GameEndHandler onGameEnd_;
+    AutoShift autoShift_;
+    model::ReplayRecorder recorder_;
+    std::chrono::steady_clock::time_point gameStart_{};
+    std::chrono::steady_clock::time_point nextGravity_{};
+    // Gravity lateness is only meaningful between two ticks of running play.
+    bool gravityArmed_ = false;
+    bool inGame_ = false;
+    bool paused_ = false;
+    std::uint64_t applied_ = 0;
+    std::uint64_t sent_ = 0;
+
+    input::SpscRing<Command, 256> commands_;
+    // Render thread only: commands waiting for room in commands_.
+    std::deque<Command> backlog_;
+    input::SpscRing<StepTiming, 1024> timings_;
+    TripleBuffer<GameSnapshot> snapshots_;
+    int commandPipe_[2] = {-1, -1};
+    int publishPipe_[2] = {-1, -1};
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+};
+
+} // namespace mctetris::engine
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+namespace mctetris::engine {
+
+// Hands the latest value from one producer thread to one consumer thread
+// without either ever waiting. The producer fills a back slot and swaps it
+// into the middle; the consumer swaps the middle out when it is fresh, so it
+// always reads the newest complete value and skips any it was too slow for.
+template <typename T>
+class TripleBuffer {
+  public:
+    // Producer side: fill Back(), then Publish() it.
+    [[nodiscard]] T &Back() {
+        return slots_[back_];
+    }
+    void Publish() {
+        back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    // Consumer side: takes the newest published value if there is one since
+    // the last call. Front() stays valid and unchanged until the next Update().
+    bool Update() {
+        if ((middle_.load(std::memory_order_relaxed) & kFresh) == 0) {
+            return false;
+        }
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+    [[nodiscard]] const T &Front() const {
+        return slots_[front_];
+    }
+
+  private:
+    static constexpr unsigned kIndexMask = 3;
+    static constexpr unsigned kFresh = 4;
+
+    std::array<T, 3> slots_{};
+    // Slot index plus kFresh while it holds a value the consumer has not taken.
+    alignas(64) std::atomic<unsigned> middle_{1};
+    alignas(64) unsigned back_ = 0;
+    alignas(64) unsigned front_ = 2;
+};
+
+} // namespace mctetris::engine
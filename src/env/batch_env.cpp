@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cstring>
+
+#include "batch_env.h"
+#include "model/game_model.h"
+
+namespace mctetris::env {
+namespace {
+
+// Games per pool task: enough to amortise the hand-off, few enough that
+// a few thousand games still spread over every thread.
+constexpr int kBlockSize = 64;
+
+// Eight cells of an occupancy mask as eight 0/1 bytes, cell 0 first: copy
+// the byte into every lane, keep bit k in lane k, then carry any set bit up
+// to the top of its lane and shift it down.
+std::uint64_t SpreadBits(unsigned bits) {
+    const std::uint64_t lanes = ((bits & 0xffu) * 0x0101010101010101ull) & 0x8040201008040201ull;
+    return ((lanes + 0x7f7f7f7f7f7f7f7full) >> 7) & 0x0101010101010101ull;
+}
+
+void Store64(std::uint8_t *out, std::uint64_t value) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    std::memcpy(out, &value, sizeof(value));
+}
+
+static_assert(model::kBoardWidth == 10, "the observation rows are written eight cells plus two");
+
+} // namespace
+
+template <typename Fn>
+void BatchEnv::ForEachBlock(const Fn &fn) {
+    const int blocks = (count_ + kBlockSize - 1) / kBlockSize;
+    pool_.ParallelFor(blocks, [&](int block, int) { fn(block * kBlockSize, std::min(count_, (block + 1) * kBlockSize)); });
+}
+
+BatchEnv::BatchEnv(int count, std::uint64_t seed, int gravityInterval, int threads)
+    : count_(std::max(count, 0)),
+      seed_(seed),
+      gravityInterval_(std::max(gravityInterval, 0)),
+      pool_(threads),
+      boards_(static_cast<std::size_t>(count_)),
+      pieces_(static_cast<std::size_t>(count_)),
+      type_(static_cast<std::size_t>(count_)),
+      rotation_(static_cast<std::size_t>(count_)),
+      x_(static_cast<std::size_t>(count_)),
+      y_(static_cast<std::size_t>(count_)),
+      next_(static_cast<std::size_t>(count_)),
+      score_(static_cast<std::size_t>(count_)),
+      lines_(static_cast<std::size_t>(count_)),
+      ticks_(static_cast<std::size_t>(count_)),
+      episodes_(static_cast<std::size_t>(count_)) {
+    Reset(nullptr);
+}
+
+int BatchEnv::Count() const {
+    return count_;
+}
+
+void BatchEnv::Reset(std::uint8_t *observations) {
+    ForEachBlock([&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            ResetGame(i);
+            if (observations != nullptr) {
+                Observe(i, observations + static_cast<std::size_t>(i) * kObservationBytes);
+            }
+        }
+    });
+}
+
+void BatchEnv::Step(const std::uint8_t *actions, std::uint8_t *observations, float *rewards, std::uint8_t *dones) {
+    ForEachBlock([&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const auto action = actions[i] <= static_cast<std::uint8_t>(EnvAction::None)
+                                    ? static_cast<EnvAction>(actions[i])
+                                    : EnvAction::None;
+            float reward = 0.0f;
+            std::uint8_t done = 0;
+            StepGame(i, action, reward, done);
+            if (rewards != nullptr) {
+                rewards[i] = reward;
+            }
+            if (dones != nullptr) {
+                dones[i] = done;
+            }
+            if (observations != nullptr) {
+                Observe(i, observations + static_cast<std::size_t>(i) * kObservationBytes);
+            }
+        }
+    });
+}
+
+std::int32_t BatchEnv::Score(int index) const {
+    return score_[static_cast<std::size_t>(index)];
+}
+
+void BatchEnv::ResetGame(int index) {
+    const auto i = static_cast<std::size_t>(index);
+    // Game e of env i gets its own stream, so any game can be rerun alone.
+    const std::uint64_t stream = static_cast<std::uint64_t>(index) << 32 | episodes_[i]++;
+    boards_[i] = model::Board{};
+    pieces_[i].Reset(model::CounterRng::StreamKey(seed_, stream));
+    score_[i] = 0;
+    lines_[i] = 0;
+    ticks_[i] = 0;
+    const auto spawn = model::GameModel::SpawnPosition(pieces_[i].Next());
+    type_[i] = static_cast<std::uint8_t>(spawn.piece.type);
+    rotation_[i] = static_cast<std::uint8_t>(spawn.piece.rotation);
+    x_[i] = static_cast<std::int8_t>(spawn.origin.x);
+    y_[i] = static_cast<std::int8_t>(spawn.origin.y);
+    next_[i] = static_cast<std::uint8_t>(pieces_[i].Peek(0));
+}
+
+bool BatchEnv::LockPiece(int index, float &reward) {
+    const auto i = static_cast<std::size_t>(index);
+    const model::Tetromino piece{static_cast<model::TetrominoType>(type_[i]), rotation_[i]};
+    auto &board = boards_[i];
+    board.Place(piece, x_[i], y_[i]);
+    // Only the rows the piece landed in can have filled up.
+    const auto &masks = piece.RowMasks();
+    int firstRow = 0;
+    while (masks[firstRow] == 0) {
+        ++firstRow;
+    }
+    int lastRow = 3;
+    while (masks[lastRow] == 0) {
+        --lastRow;
+    }
+    const int cleared = board.ClearFullLines(y_[i] + firstRow, y_[i] + lastRow);
+    if (cleared > 0) {
+        const int points = model::LineClearScore(cleared, model::LevelForLines(lines_[i]));
+        score_[i] += points;
+        lines_[i] += cleared;
+        reward += static_cast<float>(points);
+    }
+
+    const auto spawn = model::GameModel::SpawnPosition(pieces_[i].Next());
+    type_[i] = static_cast<std::uint8_t>(spawn.piece.type);
+    rotation_[i] = static_cast<std::uint8_t>(spawn.piece.rotation);
+    x_[i] = static_cast<std::int8_t>(spawn.origin.x);
+    y_[i] = static_cast<std::int8_t>(spawn.origin.y);
+    next_[i] = static_cast<std::uint8_t>(pieces_[i].Peek(0));
+    return board.CanPlace(spawn.piece, spawn.origin.x, spawn.origin.y);
+}
+
+void BatchEnv::StepGame(int index, EnvAction action, float &reward, std::uint8_t &done) {
+    const auto i = static_cast<std::size_t>(index);
+    const auto &board = boards_[i];
+    const model::Tetromino piece{static_cast<model::TetrominoType>(type_[i]), rotation_[i]};
+    const int x = x_[i];
+    const int y = y_[i];
+    bool alive = true;
+    bool locked = false;
+    switch (action) {
+    case EnvAction::Left:
+    case EnvAction::Right: {
+        const int nextX = x + (action == EnvAction::Left ? -1 : 1);
+        if (board.CanPlace(piece, nextX, y)) {
+            x_[i] = static_cast<std::int8_t>(nextX);
+        }
+        break;
+    }
+    case EnvAction::Rotate: {
+        const model::Tetromino turned{piece.type, (piece.rotation + 1) % 4};
+        if (board.CanPlace(turned, x, y)) {
+            rotation_[i] = static_cast<std::uint8_t>(turned.rotation);
+        }
+        break;
+    }
+    case EnvAction::SoftDrop:
+        if (board.CanPlace(piece, x, y + 1)) {
+            y_[i] = static_cast<std::int8_t>(y + 1);
+        } else {
+            alive = LockPiece(index, reward);
+            locked = true;
+        }
+        break;
+    case EnvAction::HardDrop:
+        y_[i] = static_cast<std::int8_t>(y + board.DropDistance(piece, x, y));
+        alive = LockPiece(index, reward);
+        locked = true;
+        break;
+    case EnvAction::None:
+        break;
+    }
+
+    ++ticks_[i];
+    if (alive && !locked && gravityInterval_ > 0 && ticks_[i] % static_cast<std::uint32_t>(gravityInterval_) == 0) {
+        const model::Tetromino current{static_cast<model::TetrominoType>(type_[i]), rotation_[i]};
+        if (board.CanPlace(current, x_[i], y_[i] + 1)) {
+            ++y_[i];
+        } else {
+            alive = LockPiece(index, reward);
+        }
+    }
+    if (!alive) {
+        ResetGame(index);
+        done = 1;
+    }
+}
+
+void BatchEnv::Observe(int index, std::uint8_t *out) const {
+    // Stores through `out` may alias anything, so everything read is copied
+    // out first rather than reloaded after every store.
+    const auto i = static_cast<std::size_t>(index);
+    const auto rows = boards_[i].RowMasks();
+    const auto blocks = model::Tetromino{static_cast<model::TetrominoType>(type_[i]), rotation_[i]}.Blocks();
+    const int originX = x_[i];
+    const int originY = y_[i];
+    const int next = next_[i];
+
+    for (int y = 0; y < model::kBoardHeight; ++y) {
+        std::uint8_t *row = out + y * model::kBoardWidth;
+        Store64(row, SpreadBits(rows[y]));
+        row[8] = static_cast<std::uint8_t>((rows[y] >> 8) & 1u);
+        row[9] = static_cast<std::uint8_t>((rows[y] >> 9) & 1u);
+    }
+
+    std::uint8_t *active = out + model::kBoardWidth * model::kBoardHeight;
+    std::memset(active, 0, model::kBoardWidth * model::kBoardHeight);
+    for (const auto &block : blocks) {
+        const int x = originX + block.x;
+        const int y = originY + block.y;
+        if (x >= 0 && x < model::kBoardWidth && y >= 0 && y < model::kBoardHeight) {
+            active[y * model::kBoardWidth + x] = 1;
+        }
+    }
+
+    Store64(out + kNextPieceOffset, std::uint64_t{1} << (8 * next));
+}
+
+} // namespace mctetris::env
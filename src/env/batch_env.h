@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bot/work_pool.h"
+#include "model/board.h"
+#include "model/piece_generator.h"
+
+namespace mctetris::env {
+
+// Bytes of one observation: the occupancy plane, the falling piece's plane
+// and the next piece one-hot, padded to a multiple of eight.
+constexpr std::size_t kObservationBytes = 2 * model::kBoardWidth * model::kBoardHeight + 8;
+constexpr std::size_t kNextPieceOffset = 2 * model::kBoardWidth * model::kBoardHeight;
+
+// Per-game actions, numbered like model::ReplayAction with None in place of
+// Gravity: gravity runs on its own interval.
+enum class EnvAction : std::uint8_t {
+    Left,
+    Right,
+    Rotate,
+    SoftDrop,
+    HardDrop,
+    None
+};
+
+// Many games stepped in lockstep for reinforcement learning. Game state is
+// kept as parallel arrays, one entry per game, so a step walks each array
+// front to back; the rules are GameModel's, applied directly to those
+// arrays. Steps split the games into blocks across a WorkPool, and
+// observations are written straight into the caller's buffer.
+class BatchEnv {
+  public:
+    // `gravityInterval` steps per gravity drop, 0 for none; `threads` counts
+    // the caller, 0 uses every hardware thread.
+    BatchEnv(int count, std::uint64_t seed, int gravityInterval = 1, int threads = 1);
+
+    [[nodiscard]] int Count() const;
+
+    // Starts every game afresh; writes Count() observations if given one.
+    void Reset(std::uint8_t *observations);
+    // Applies actions[i] to game i. Games that end restart at once with
+    // dones[i] set. Null outputs are skipped.
+    void Step(const std::uint8_t *actions, std::uint8_t *observations, float *rewards, std::uint8_t *dones);
+
+    // Score of game i so far, for logging.
+    [[nodiscard]] std::int32_t Score(int index) const;
+
+  private:
+    void ResetGame(int index);
+    // Locks the falling piece and spawns the next; false when the new piece
+    // does not fit, which ends the game.
+    [[nodiscard]] bool LockPiece(int index, float &reward);
+    void StepGame(int index, EnvAction action, float &reward, std::uint8_t &done);
+    void Observe(int index, std::uint8_t *out) const;
+    // Runs fn(begin, end) over blocks of games on the pool. A template, so
+    // each step's loop is compiled in rather than called per game; only the
+    // two-pointer lambda that forwards a block to it goes through
+    // ParallelFor's std::function, once per block. Defined in the .cpp,
+    // where it is only used.
+    template <typename Fn>
+    void ForEachBlock(const Fn &fn);
+
+    int count_ = 0;
+    std::uint64_t seed_ = 0;
+    int gravityInterval_ = 0;
+    bot::WorkPool pool_;
+
+    std::vector<model::Board> boards_;
+    std::vector<model::PieceGenerator> pieces_;
+    std::vector<std::uint8_t> type_;
+    std::vector<std::uint8_t> rotation_;
+    std::vector<std::int8_t> x_;
+    std::vector<std::int8_t> y_;
+    std::vector<std::uint8_t> next_;
+    std::vector<std::int32_t> score_;
+    std::vector<std::int32_t> lines_;
+    std::vector<std::uint32_t> ticks_;
+    std::vector<std::uint32_t> episodes_;
+};
+
+} // namespace mctetris::env
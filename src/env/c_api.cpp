@@ -0,0 +1,48 @@
+#include <cstdint>
+
+#include "batch_env.h"
+#include "mctetris_env.h"
+
+static_assert(MCTETRIS_ENV_OBSERVATION_BYTES == mctetris::env::kObservationBytes);
+static_assert(MCTETRIS_ENV_ACTION_NONE == static_cast<int>(mctetris::env::EnvAction::None));
+
+struct mctetris_env {
+    mctetris_env(int count, std::uint64_t seed, int gravityInterval, int threads)
+        : batch(count, seed, gravityInterval, threads) {}
+
+    mctetris::env::BatchEnv batch;
+};
+
+// Nothing may throw across the C boundary: a failed allocation is reported
+// as a null handle.
+mctetris_env *mctetris_env_create(int32_t count, uint64_t seed, int32_t gravity_interval, int32_t threads) {
+    if (count <= 0 || gravity_interval < 0 || threads < 0) {
+        return nullptr;
+    }
+    try {
+        return new mctetris_env(count, seed, gravity_interval, threads);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void mctetris_env_destroy(mctetris_env *env) {
+    delete env;
+}
+
+int32_t mctetris_env_count(const mctetris_env *env) {
+    return env->batch.Count();
+}
+
+size_t mctetris_env_observation_bytes(void) {
+    return mctetris::env::kObservationBytes;
+}
+
+void mctetris_env_reset(mctetris_env *env, uint8_t *observations) {
+    env->batch.Reset(observations);
+}
+
+void mctetris_env_step(mctetris_env *env, const uint8_t *actions, uint8_t *observations, float *rewards,
+                       uint8_t *dones) {
+    env->batch.Step(actions, observations, rewards, dones);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+/* C interface to BatchEnv for training loops (Python ctypes/cffi, Rust,
+ * ...): a batch of games stepped in lockstep, one action per game per step.
+ * Every output goes straight into buffers the caller owns, laid out as
+ * contiguous arrays of `count` records.
+ *
+ * Observation record, MCTETRIS_ENV_OBSERVATION_BYTES bytes per game:
+ *   [0, 200)   board occupancy, row-major from the top row, 1 = filled
+ *   [200, 400) cells of the falling piece, same layout
+ *   [400, 407) next piece type, one-hot in the order I O T S Z J L
+ *   [407]      zero padding
+ * A game that ends is reset in the same step; its observation is then the
+ * first of the new game and its done flag is set. Rewards are the points
+ * the step scored. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define MCTETRIS_ENV_API __attribute__((visibility("default")))
+#else
+#define MCTETRIS_ENV_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MCTETRIS_ENV_OBSERVATION_BYTES 408
+
+enum {
+    MCTETRIS_ENV_ACTION_LEFT = 0,
+    MCTETRIS_ENV_ACTION_RIGHT = 1,
+    MCTETRIS_ENV_ACTION_ROTATE = 2,
+    MCTETRIS_ENV_ACTION_SOFT_DROP = 3,
+    MCTETRIS_ENV_ACTION_HARD_DROP = 4,
+    MCTETRIS_ENV_ACTION_NONE = 5,
+    MCTETRIS_ENV_ACTION_COUNT = 6
+};
+
+typedef struct mctetris_env mctetris_env;
+
+/* `count` games seeded from `seed`. Gravity moves the piece down once every
+ * `gravity_interval` steps (0 for never); `threads` includes the caller, 0
+ * uses every hardware thread. Returns NULL on bad arguments or when out of
+ * memory. */
+MCTETRIS_ENV_API mctetris_env *mctetris_env_create(int32_t count, uint64_t seed, int32_t gravity_interval,
+                                                   int32_t threads);
+MCTETRIS_ENV_API void mctetris_env_destroy(mctetris_env *env);
+
+MCTETRIS_ENV_API int32_t mctetris_env_count(const mctetris_env *env);
+MCTETRIS_ENV_API size_t mctetris_env_observation_bytes(void);
+
+/* Starts every game afresh and writes count observation records. */
+MCTETRIS_ENV_API void mctetris_env_reset(mctetris_env *env, uint8_t *observations);
+/* Applies actions[i] to game i. Any of the output pointers may be NULL to
+ * skip that output; an action out of range counts as NONE. */
+MCTETRIS_ENV_API void mctetris_env_step(mctetris_env *env, const uint8_t *actions, uint8_t *observations,
+                                        float *rewards, uint8_t *dones);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,155 @@
+#include <array>
+#include <cerrno>
+#include <csignal>
+
+#include <poll.h>
+#include <pthread.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+#include "input_thread.h"
+#include "trace/trace.h"
+#include "wake_pipe.h"
+
+namespace mctetris::input {
+namespace {
+
+// How long a lone ESC byte waits for the rest of an escape sequence.
+constexpr int kEscapeTimeoutMs = 25;
+constexpr int kCtrlC = 3;
+
+} // namespace
+
+InputThread::InputThread() = default;
+
+InputThread::~InputThread() {
+    Stop();
+}
+
+bool InputThread::Start(int signalFd) {
+    if (thread_.joinable()) {
+        return true;
+    }
+    if (!MakePipe(wakePipe_) || !MakePipe(stopPipe_)) {
+        ClosePipe(wakePipe_);
+        ClosePipe(stopPipe_);
+        return false;
+    }
+    stopping_.store(false);
+    signalFd_ = signalFd;
+
+    // Keep signals such as SIGWINCH on the game thread, where they interrupt
+    // its wait; the reader inherits the blocked mask.
+    sigset_t all;
+    sigset_t previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &previous);
+    thread_ = std::thread([this]() { Run(); });
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+    return true;
+}
+
+void InputThread::Stop() {
+    if (thread_.joinable()) {
+        stopping_.store(true);
+        SignalPipe(stopPipe_[1]);
+        thread_.join();
+    }
+    ClosePipe(wakePipe_);
+    ClosePipe(stopPipe_);
+}
+
+bool InputThread::Pop(KeyEvent &event) {
+    return queue_.TryPop(event);
+}
+
+int InputThread::WakeFd() const {
+    return wakePipe_[0];
+}
+
+void InputThread::AcknowledgeWake() {
+    DrainPipe(wakePipe_[0]);
+}
+
+void InputThread::Run() {
+    trace::SetThreadName("input");
+    // poll() skips a negative descriptor, so no signalfd costs nothing.
+    std::array<pollfd, 3> fds{pollfd{STDIN_FILENO, POLLIN, 0}, pollfd{stopPipe_[0], POLLIN, 0},
+                              pollfd{signalFd_, POLLIN, 0}};
+    std::array<unsigned char, 256> buffer{};
+    while (!stopping_.load()) {
+        const int timeout = decoder_.Pending() ? kEscapeTimeoutMs : -1;
+        const int ready = poll(fds.data(), fds.size(), timeout);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (ready == 0) {
+            if (Publish(decoder_.Flush(), now)) {
+                SignalPipe(wakePipe_[1]);
+            }
+            continue;
+        }
+        if ((fds[1].revents & POLLIN) != 0) {
+            break;
+        }
+        if ((fds[2].revents & POLLIN) != 0) {
+            signalfd_siginfo info{};
+            if (read(signalFd_, &info, sizeof(info)) == static_cast<ssize_t>(sizeof(info))) {
+                DecodedKeys quit;
+                quit.keys[0] = kQuitRequested;
+                quit.count = 1;
+                if (Publish(quit, now)) {
+                    SignalPipe(wakePipe_[1]);
+                }
+            }
+        }
+        if ((fds[0].revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+            continue;
+        }
+        const ssize_t count = read(STDIN_FILENO, buffer.data(), buffer.size());
+        if (count <= 0) {
+            if (count < 0 && (errno == EINTR || errno == EAGAIN)) {
+                continue;
+            }
+            break;
+        }
+        bool published = false;
+        for (ssize_t i = 0; i < count; ++i) {
+            published = Publish(decoder_.Feed(buffer[static_cast<std::size_t>(i)]), now) || published;
+        }
+        if (published) {
+            SignalPipe(wakePipe_[1]);
+        }
+    }
+}
+
+bool InputThread::Publish(const DecodedKeys &keys, std::chrono::steady_clock::time_point time) {
+    for (int i = 0; i < keys.count; ++i) {
+        const auto index = static_cast<std::size_t>(i);
+        // Ctrl+C reaches us as a key when the terminal reports key events or
+        // does not turn it into SIGINT; either way it quits, once per press.
+        int key = keys.keys[index];
+        if (key == kCtrlC) {
+            if (keys.actions[index] != KeyAction::Press) {
+                continue;
+            }
+            key = kQuitRequested;
+        }
+        // Never drop a key: if the game thread has fallen a full ring behind,
+        // wait for it to catch up.
+        while (!queue_.TryPush(KeyEvent{key, keys.actions[index], time})) {
+            if (stopping_.load()) {
+                return false;
+            }
+            SignalPipe(wakePipe_[1]);
+            std::this_thread::yield();
+        }
+    }
+    return keys.count > 0;
+}
+
+} // namespace mctetris::input
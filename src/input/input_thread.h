@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "key_decoder.h"
+#include "spsc_ring.h"
+
+namespace mctetris::input {
+
+// Not a key: Ctrl+C, or a signal read from the Start() descriptor, asked the
+// game to quit. Queued as a press so the game can shut down the normal way.
+constexpr int kQuitRequested = 0x110001;
+
+struct KeyEvent {
+    int key = 0;
+    // Always Press unless the terminal reports key events.
+    KeyAction action = KeyAction::Press;
+    // When the bytes for this key were read off the terminal.
+    std::chrono::steady_clock::time_point time{};
+};
+
+// Reads stdin on its own thread, decodes keys and queues them with their
+// arrival time. The game thread drains the queue and can sleep on WakeFd()
+// until something arrives.
+class InputThread {
+  public:
+    InputThread();
+    ~InputThread();
+
+    InputThread(const InputThread &) = delete;
+    InputThread &operator=(const InputThread &) = delete;
+
+    // `signalFd`, a signalfd for the signals that should end the game, is
+    // watched alongside stdin; -1 watches none. It stays the caller's.
+    [[nodiscard]] bool Start(int signalFd = -1);
+    void Stop();
+
+    // Consumer side; events come out in arrival order.
+    [[nodiscard]] bool Pop(KeyEvent &event);
+    // Readable whenever events were queued since the last AcknowledgeWake().
+    [[nodiscard]] int WakeFd() const;
+    // Clears WakeFd(); call before draining the queue so no wake-up is lost.
+    void AcknowledgeWake();
+
+  private:
+    void Run();
+    // Queues decoded keys; returns true if any were queued.
+    bool Publish(const DecodedKeys &keys, std::chrono::steady_clock::time_point time);
+
+    SpscRing<KeyEvent, 1024> queue_;
+    int wakePipe_[2] = {-1, -1};
+    int stopPipe_[2] = {-1, -1};
+    int signalFd_ = -1;
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+    KeyDecoder decoder_;
+};
+
+} // namespace mctetris::input
@@ -0,0 +1,44 @@
+#include <array>
+#include <cerrno>
+#include <ctime>
+
+#include <poll.h>
+
+#include "input_wait.h"
+
+namespace mctetris::input {
+
+WakeReason WaitForInput(int fd, const std::optional<std::chrono::steady_clock::time_point> &deadline) {
+    return WaitForInput({fd}, deadline);
+}
+
+WakeReason WaitForInput(std::initializer_list<int> fds,
+                        const std::optional<std::chrono::steady_clock::time_point> &deadline) {
+    timespec timeout{};
+    const timespec *timeoutPtr = nullptr;
+    if (deadline) {
+        const auto remaining = *deadline - std::chrono::steady_clock::now();
+        if (remaining <= std::chrono::steady_clock::duration::zero()) {
+            return WakeReason::Deadline;
+        }
+        const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count();
+        timeout.tv_sec = static_cast<time_t>(nanos / 1000000000);
+        timeout.tv_nsec = static_cast<long>(nanos % 1000000000);
+        timeoutPtr = &timeout;
+    }
+
+    std::array<pollfd, 4> inputs{};
+    nfds_t count = 0;
+    for (const int fd : fds) {
+        if (count < inputs.size()) {
+            inputs[count++] = pollfd{fd, POLLIN, 0};
+        }
+    }
+    const int ready = ppoll(inputs.data(), count, timeoutPtr, nullptr);
+    if (ready < 0) {
+        return errno == EINTR ? WakeReason::Interrupted : WakeReason::Input;
+    }
+    return ready == 0 ? WakeReason::Deadline : WakeReason::Input;
+}
+
+} // namespace mctetris::input
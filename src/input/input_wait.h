@@ -0,0 +1,23 @@
+#pragma once
+
+#include <chrono>
+#include <initializer_list>
+#include <optional>
+
+namespace mctetris::input {
+
+enum class WakeReason {
+    Input,
+    Deadline,
+    Interrupted
+};
+
+// Sleeps until `fd` is readable or `deadline` passes, whichever comes first.
+// Without a deadline it waits for input indefinitely. Signals (e.g. SIGWINCH)
+// wake it early with WakeReason::Interrupted.
+WakeReason WaitForInput(int fd, const std::optional<std::chrono::steady_clock::time_point> &deadline);
+// As above, waking when any of `fds` is readable.
+WakeReason WaitForInput(std::initializer_list<int> fds,
+                        const std::optional<std::chrono::steady_clock::time_point> &deadline);
+
+} // namespace mctetris::input
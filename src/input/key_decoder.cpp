@@ -0,0 +1,220 @@
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <curses.h>
+#include <unistd.h>
+
+#include "key_decoder.h"
+
+namespace mctetris::input {
+namespace {
+
+constexpr unsigned char kEscape = 27;
+// Kitty protocol flags: disambiguate escape codes (1), report event types
+// (2) and report all keys as escape codes (8), so even letters come with
+// their press and release.
+constexpr const char *kPushKeyFlags = "\x1b[>11u\x1b[?u";
+constexpr const char *kPopKeyFlags = "\x1b[<u";
+// Kitty's codes for the keypad's digit, Enter and arrow keys.
+constexpr int kKittyKeypadZero = 57399;
+constexpr int kKittyKeypadEnter = 57414;
+constexpr int kKittyKeypadLeft = 57417;
+constexpr int kKittyKeypadDown = 57420;
+
+DecodedKeys One(int key, KeyAction action = KeyAction::Press) {
+    DecodedKeys keys;
+    keys.keys[0] = key;
+    keys.actions[0] = action;
+    keys.count = 1;
+    return keys;
+}
+
+// Splits "a;b:c;..." into the numbers of field `field`: returns the first
+// number and puts the one after a ':' in `sub`, both 0 when absent.
+int Field(const std::string &params, int field, int &sub) {
+    std::size_t start = 0;
+    for (int i = 0; i < field; ++i) {
+        start = params.find(';', start);
+        if (start == std::string::npos) {
+            sub = 0;
+            return 0;
+        }
+        ++start;
+    }
+    const char *text = params.c_str() + start;
+    char *end = nullptr;
+    const long value = std::strtol(text, &end, 10);
+    sub = *end == ':' ? std::atoi(end + 1) : 0;
+    return static_cast<int>(value);
+}
+
+// The event type sub-field of the modifiers: 1 press, 2 repeat, 3 release.
+KeyAction EventAction(const std::string &params) {
+    int event = 0;
+    (void)Field(params, 1, event);
+    switch (event) {
+    case 2:
+        return KeyAction::Repeat;
+    case 3:
+        return KeyAction::Release;
+    default:
+        return KeyAction::Press;
+    }
+}
+
+// Maps a kitty key code to what getch() would return; 0 for keys the game
+// has no use for, such as lone modifiers.
+int KittyKey(int code, int modifiers) {
+    // Modifiers are sent plus one; bit 2 is Ctrl.
+    const bool ctrl = modifiers > 0 && ((modifiers - 1) & 4) != 0;
+    if (ctrl && code >= 'a' && code <= 'z') {
+        return code & 0x1f;
+    }
+    if (code == 13) {
+        return '\r';
+    }
+    if (code > 0 && code < 128) {
+        return code;
+    }
+    if (code >= kKittyKeypadZero && code < kKittyKeypadZero + 10) {
+        return '0' + (code - kKittyKeypadZero);
+    }
+    if (code == kKittyKeypadEnter) {
+        return KEY_ENTER;
+    }
+    if (code >= kKittyKeypadLeft && code <= kKittyKeypadDown) {
+        static constexpr int kArrows[] = {KEY_LEFT, KEY_RIGHT, KEY_UP, KEY_DOWN};
+        return kArrows[code - kKittyKeypadLeft];
+    }
+    return 0;
+}
+
+int CursorKey(unsigned char final) {
+    switch (final) {
+    case 'A':
+        return KEY_UP;
+    case 'B':
+        return KEY_DOWN;
+    case 'C':
+        return KEY_RIGHT;
+    case 'D':
+        return KEY_LEFT;
+    case 'H':
+        return KEY_HOME;
+    case 'F':
+        return KEY_END;
+    default:
+        return 0;
+    }
+}
+
+} // namespace
+
+DecodedKeys KeyDecoder::Feed(unsigned char byte) {
+    switch (state_) {
+    case State::Ground:
+        if (byte == kEscape) {
+            state_ = State::Escape;
+            return {};
+        }
+        return One(byte);
+    case State::Escape:
+        if (byte == '[') {
+            state_ = State::Csi;
+            params_.clear();
+            return {};
+        }
+        if (byte == 'O') {
+            state_ = State::Ss3;
+            return {};
+        }
+        state_ = State::Ground;
+        if (byte == kEscape) {
+            // Two ESC presses in a row: report the first, keep waiting on the second.
+            state_ = State::Escape;
+            return One(kEscape);
+        }
+        {
+            DecodedKeys keys;
+            keys.keys = {kEscape, byte};
+            keys.count = 2;
+            return keys;
+        }
+    case State::Csi:
+        if (byte >= 0x40 && byte <= 0x7e) {
+            state_ = State::Ground;
+            return FinishCsi(byte);
+        }
+        if (params_.size() < 16) {
+            params_.push_back(static_cast<char>(byte));
+        }
+        return {};
+    case State::Ss3:
+        state_ = State::Ground;
+        if (byte == 'M') {
+            return One(KEY_ENTER);
+        }
+        if (byte >= 'p' && byte <= 'y') {
+            // Application keypad digits.
+            return One('0' + (byte - 'p'));
+        }
+        if (const int key = CursorKey(byte)) {
+            return One(key);
+        }
+        return {};
+    }
+    return {};
+}
+
+bool KeyDecoder::Pending() const {
+    return state_ != State::Ground;
+}
+
+DecodedKeys KeyDecoder::Flush() {
+    const bool loneEscape = state_ == State::Escape;
+    state_ = State::Ground;
+    return loneEscape ? One(kEscape) : DecodedKeys{};
+}
+
+DecodedKeys KeyDecoder::FinishCsi(unsigned char final) {
+    if (final == 'u') {
+        if (!params_.empty() && params_[0] == '?') {
+            return One(kKeyEventsSupported);
+        }
+        int sub = 0;
+        const int code = Field(params_, 0, sub);
+        const int modifiers = Field(params_, 1, sub);
+        if (const int key = KittyKey(code, modifiers)) {
+            return One(key, EventAction(params_));
+        }
+        return {};
+    }
+    if (const int key = CursorKey(final)) {
+        return One(key, EventAction(params_));
+    }
+    if (final == '~') {
+        int sub = 0;
+        switch (Field(params_, 0, sub)) {
+        case 1:
+            return One(KEY_HOME, EventAction(params_));
+        case 3:
+            return One(KEY_DC, EventAction(params_));
+        case 4:
+            return One(KEY_END, EventAction(params_));
+        default:
+            return {};
+        }
+    }
+    return {};
+}
+
+void RequestKeyEvents(int fd) {
+    (void)write(fd, kPushKeyFlags, std::strlen(kPushKeyFlags));
+}
+
+void RestoreKeyEvents(int fd) {
+    (void)write(fd, kPopKeyFlags, std::strlen(kPopKeyFlags));
+}
+
+} // namespace mctetris::input
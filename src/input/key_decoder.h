@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace mctetris::input {
+
+enum class KeyAction : std::uint8_t {
+    Press,
+    // Held down; only terminals that report key events send these.
+    Repeat,
+    Release
+};
+
+// Not a key: the terminal answered RequestKeyEvents(), so releases will be
+// reported from now on.
+constexpr int kKeyEventsSupported = 0x110000;
+
+struct DecodedKeys {
+    std::array<int, 2> keys{};
+    std::array<KeyAction, 2> actions{};
+    int count = 0;
+};
+
+// Turns raw terminal bytes into the key codes curses' getch() would return
+// (plain characters plus KEY_UP/KEY_LEFT/... for escape sequences), so keys
+// can be read off the terminal without going through curses. Also decodes
+// the kitty keyboard protocol's CSI u sequences, which carry press, repeat
+// and release events.
+class KeyDecoder {
+  public:
+    DecodedKeys Feed(unsigned char byte);
+    // True while an escape sequence has started but not finished.
+    [[nodiscard]] bool Pending() const;
+    // Gives up on a half-read sequence; a lone ESC is reported as key 27.
+    DecodedKeys Flush();
+
+  private:
+    enum class State {
+        Ground,
+        Escape,
+        Csi,
+        Ss3
+    };
+
+    DecodedKeys FinishCsi(unsigned char final);
+
+    State state_ = State::Ground;
+    std::string params_;
+};
+
+// Asks the terminal on `fd` to report every key as a kitty protocol event
+// with its press, repeat or release, and to answer with kKeyEventsSupported.
+// Terminals without the protocol ignore both. The flags belong to the screen
+// they were set on, so set them after curses has switched to the alternate
+// screen and they are gone when it switches back.
+void RequestKeyEvents(int fd);
+// Restores the terminal's previous key reporting.
+void RestoreKeyEvents(int fd);
+
+} // namespace mctetris::input
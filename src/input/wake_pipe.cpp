@@ -0,0 +1,41 @@
+#include <array>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "wake_pipe.h"
+
+namespace mctetris::input {
+
+bool MakePipe(int (&fds)[2]) {
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    for (int fd : fds) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return true;
+}
+
+void ClosePipe(int (&fds)[2]) {
+    for (int &fd : fds) {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+void SignalPipe(int fd) {
+    const char byte = 1;
+    (void)write(fd, &byte, 1);
+}
+
+void DrainPipe(int fd) {
+    std::array<char, 64> drain{};
+    while (read(fd, drain.data(), drain.size()) > 0) {
+    }
+}
+
+} // namespace mctetris::input
@@ -0,0 +1,13 @@
+#pragma once
+
+namespace mctetris::input {
+
+// Non-blocking, close-on-exec pipe used to wake a thread sleeping in poll().
+[[nodiscard]] bool MakePipe(int (&fds)[2]);
+void ClosePipe(int (&fds)[2]);
+// Makes the read end readable; a full pipe already is, so a failed write is fine.
+void SignalPipe(int fd);
+// Empties the read end so the next SignalPipe() wakes the reader again.
+void DrainPipe(int fd);
+
+} // namespace mctetris::input
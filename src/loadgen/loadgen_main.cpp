@@ -0,0 +1,261 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "net/client.h"
+#include "net/protocol.h"
+#include "ui/perf_metrics.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct LoadOptions {
+    std::string socketPath = mctetris::net::DefaultSocketPath();
+    long long clients = 1000;
+    long long seconds = 5;
+    // Inputs per second per client; 0 sends the next as soon as one is answered.
+    long long rate = 0;
+    std::uint32_t seed = 1;
+};
+
+struct LoadClient {
+    mctetris::net::Client connection;
+    std::mt19937 rng;
+    std::uint16_t sequence = 0;
+    // Waiting for the State that answers the last Hello or Input.
+    bool waiting = false;
+    bool hello = false;
+    Clock::time_point sentAt{};
+    Clock::time_point nextSend{};
+};
+
+struct LoadTotals {
+    std::uint64_t answered = 0;
+    std::uint64_t games = 0;
+    std::uint64_t failures = 0;
+    mctetris::ui::LatencyHistogram roundTrip;
+};
+
+void PrintUsage() {
+    std::fprintf(stderr,
+                 "Usage: mctetris-loadgen [--socket PATH] [--clients N] [--seconds S] [--rate R] [--seed S]\n"
+                 "\n"
+                 "Opens N sessions on mctetris-server, each stepping its own game with random\n"
+                 "inputs (gravity included), and reports answered inputs/sec and the round-trip\n"
+                 "time from sending an input to reading the State that acknowledges it.\n"
+                 "Each client keeps one input in flight, sent as soon as the last is answered or,\n"
+                 "with --rate, R times a second.\n");
+}
+
+std::optional<LoadOptions> ParseOptions(int argc, char **argv) {
+    LoadOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (i + 1 >= argc) {
+            return std::nullopt;
+        }
+        if (std::strcmp(arg, "--socket") == 0) {
+            options.socketPath = argv[++i];
+            continue;
+        }
+        char *end = nullptr;
+        const long long value = std::strtoll(argv[++i], &end, 10);
+        if (*end != '\0' || value < 0) {
+            return std::nullopt;
+        }
+        if (std::strcmp(arg, "--clients") == 0 && value > 0) {
+            options.clients = value;
+        } else if (std::strcmp(arg, "--seconds") == 0 && value > 0) {
+            options.seconds = value;
+        } else if (std::strcmp(arg, "--rate") == 0) {
+            options.rate = value;
+        } else if (std::strcmp(arg, "--seed") == 0) {
+            options.seed = static_cast<std::uint32_t>(value);
+        } else {
+            return std::nullopt;
+        }
+    }
+    return options;
+}
+
+void RaiseDescriptorLimit() {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        (void)setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+// Mostly moves and gravity, so games last a while, with the odd hard drop.
+mctetris::model::ReplayAction RandomAction(std::mt19937 &rng) {
+    using mctetris::model::ReplayAction;
+    const auto roll = rng() % 20;
+    if (roll < 6) {
+        return ReplayAction::MoveLeft;
+    }
+    if (roll < 12) {
+        return ReplayAction::MoveRight;
+    }
+    if (roll < 15) {
+        return ReplayAction::RotateCW;
+    }
+    if (roll < 17) {
+        return ReplayAction::SoftDrop;
+    }
+    return roll < 19 ? ReplayAction::Gravity : ReplayAction::HardDrop;
+}
+
+bool SendHello(LoadClient &client, Clock::time_point now) {
+    mctetris::net::Hello hello;
+    hello.flags = mctetris::net::kClientGravity;
+    hello.seed = static_cast<std::uint32_t>(client.rng());
+    client.sequence = 0;
+    client.waiting = true;
+    client.hello = true;
+    client.sentAt = now;
+    return client.connection.Send(hello);
+}
+
+bool SendInput(LoadClient &client, Clock::time_point now) {
+    mctetris::net::Input input;
+    input.action = RandomAction(client.rng);
+    input.sequence = ++client.sequence;
+    client.waiting = true;
+    client.hello = false;
+    client.sentAt = now;
+    return client.connection.Send(input);
+}
+
+double Ms(std::int64_t nanoseconds) {
+    return static_cast<double>(nanoseconds) / 1e6;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const auto options = ParseOptions(argc, argv);
+    if (!options) {
+        PrintUsage();
+        return 1;
+    }
+    RaiseDescriptorLimit();
+
+    const int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        std::perror("mctetris-loadgen: epoll_create1");
+        return 1;
+    }
+    std::vector<LoadClient> clients(static_cast<std::size_t>(options->clients));
+    const auto connectStart = Clock::now();
+    for (std::size_t i = 0; i < clients.size(); ++i) {
+        auto &client = clients[i];
+        client.rng.seed(options->seed + static_cast<std::uint32_t>(i) * 0x9e3779b9u);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = i;
+        if (!client.connection.Connect(options->socketPath) ||
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, client.connection.Fd(), &event) != 0 ||
+            !SendHello(client, Clock::now())) {
+            std::fprintf(stderr, "mctetris-loadgen: cannot open session %zu on '%s'\n", i,
+                         options->socketPath.c_str());
+            return 1;
+        }
+    }
+    std::fprintf(stderr, "connected %zu sessions in %.1f ms\n", clients.size(),
+                 std::chrono::duration<double, std::milli>(Clock::now() - connectStart).count());
+
+    // With --rate, clients whose next input is not due yet wait here.
+    using Due = std::pair<Clock::time_point, std::size_t>;
+    std::priority_queue<Due, std::vector<Due>, std::greater<>> due;
+    const auto interval = options->rate > 0 ? std::chrono::nanoseconds(1000000000 / options->rate)
+                                            : std::chrono::nanoseconds(0);
+    LoadTotals totals;
+    std::vector<epoll_event> events(1024);
+    const auto start = Clock::now();
+    const auto stop = start + std::chrono::seconds(options->seconds);
+    // Spread the first paced inputs over one interval rather than sending them all at once.
+    for (std::size_t i = 0; i < clients.size(); ++i) {
+        clients[i].nextSend = start - interval + interval * static_cast<long long>(i) / options->clients;
+    }
+    auto fail = [&](LoadClient &client) {
+        ++totals.failures;
+        client.waiting = false;
+        client.connection.Close();
+    };
+
+    for (auto now = Clock::now(); now < stop; now = Clock::now()) {
+        while (!due.empty() && due.top().first <= now) {
+            auto &client = clients[due.top().second];
+            due.pop();
+            if (!SendInput(client, now)) {
+                fail(client);
+            }
+        }
+        const auto wakeAt = due.empty() ? stop : std::min(stop, due.top().first);
+        const auto timeout = std::chrono::ceil<std::chrono::milliseconds>(wakeAt - now).count();
+        const int count = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), static_cast<int>(timeout));
+        const auto received = Clock::now();
+        for (int i = 0; i < std::max(count, 0); ++i) {
+            auto &client = clients[events[i].data.u64];
+            if (!client.connection.Receive()) {
+                fail(client);
+                continue;
+            }
+            bool answered = false;
+            bool gameOver = false;
+            while (const auto state = client.connection.Next()) {
+                if (client.waiting && state->sequence == client.sequence) {
+                    answered = true;
+                    gameOver = state->gameOver;
+                }
+            }
+            if (!answered) {
+                continue;
+            }
+            client.waiting = false;
+            if (!client.hello) {
+                ++totals.answered;
+                totals.roundTrip.Add(std::chrono::duration_cast<std::chrono::nanoseconds>(received - client.sentAt).count());
+            }
+            if (gameOver) {
+                ++totals.games;
+                if (!SendHello(client, received)) {
+                    fail(client);
+                }
+            } else if (interval.count() == 0) {
+                if (!SendInput(client, received)) {
+                    fail(client);
+                }
+            } else {
+                client.nextSend = std::max(client.nextSend + interval, received);
+                due.push({client.nextSend, static_cast<std::size_t>(&client - clients.data())});
+            }
+        }
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    close(epollFd);
+
+    const auto &rtt = totals.roundTrip;
+    std::fprintf(stderr, "sessions:   %zu (%llu failed)\n", clients.size(),
+                 static_cast<unsigned long long>(totals.failures));
+    std::fprintf(stderr, "inputs/sec: %.0f (%llu answered in %.1f s)\n", static_cast<double>(totals.answered) / elapsed,
+                 static_cast<unsigned long long>(totals.answered), elapsed);
+    std::fprintf(stderr, "games:      %llu finished\n", static_cast<unsigned long long>(totals.games));
+    std::fprintf(stderr, "round trip ms: p50 %.3f  p99 %.3f  p99.9 %.3f  max %.3f\n", Ms(rtt.Quantile(0.5)),
+                 Ms(rtt.Quantile(0.99)), Ms(rtt.Quantile(0.999)), Ms(rtt.Max()));
+    return totals.failures == 0 ? 0 : 2;
+}
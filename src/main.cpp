@@ -1,280 +1,572 @@
 #include <algorithm>
 #include <array>
 #include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <optional>
 #include <random>
 #include <string>
-#include <thread>
+#include <vector>
 
-#include <curses.h>
+#include <csignal>
 
-#include "model/game_model.h"
+#include <curses.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+#include "bot/bot.h"
+#include "engine/game_grid.h"
+#include "engine/simulation_thread.h"
+#include "input/input_thread.h"
+#include "input/input_wait.h"
+#include "model/game_session.h"
+#include "model/replay.h"
+#include "model/snapshot.h"
+#include "net/client.h"
+#include "net/protocol.h"
+#include "scores/score_writer.h"
+#include "trace/trace.h"
+#include "ui/perf_metrics.h"
+#include "ui/render.h"
+#include "ui/render_backend.h"
+#include "ui/terminal.h"
+#include "ui/terminal_output.h"
 
 namespace {
 
-constexpr int kBoardOffsetX = 2;
-constexpr int kBoardOffsetY = 1;
-constexpr int kCellWidth = 4;
-constexpr int kCellHeight = 2;
-constexpr int kPanelOffsetX = 16;
-constexpr int kNextPanelWidth = kCellWidth * 4 + 4;
-constexpr int kNextPanelHeight = kCellHeight * 4 + 4;
-constexpr int kStatsPanelWidth = 18;
-constexpr int kStatsPanelHeight = 6;
-
-struct ControlScheme {
-    const char *name;
-    int left;
-    int right;
-    int down;
-    int rotate;
-    int hardDrop;
-    const char *hint;
+using mctetris::ui::ControlScheme;
+
+struct FrameTotals {
+    std::uint64_t frames = 0;
+    std::uint64_t cells = 0;
+    std::uint64_t runs = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t writes = 0;
+
+    void Add(const mctetris::ui::FrameStats &stats) {
+        ++frames;
+        cells += static_cast<std::uint64_t>(stats.cellsChanged);
+        runs += static_cast<std::uint64_t>(stats.runs);
+        bytes += stats.bytes;
+        writes += stats.writes;
+    }
 };
 
-short ColorPairForCell(mctetris::model::Cell cell) {
-    using mctetris::model::Cell;
-    switch (cell) {
-    case Cell::I:
-        return 1;
-    case Cell::O:
-        return 2;
-    case Cell::T:
-        return 3;
-    case Cell::S:
-        return 4;
-    case Cell::Z:
-        return 5;
-    case Cell::J:
-        return 6;
-    case Cell::L:
-        return 7;
-    case Cell::Empty:
-        return 0;
+// Time from a key being read off the terminal to the game acting on it.
+struct InputLatency {
+    std::uint64_t count = 0;
+    std::chrono::nanoseconds total{0};
+    std::chrono::nanoseconds max{0};
+
+    void Add(std::chrono::nanoseconds latency) {
+        ++count;
+        total += latency;
+        max = std::max(max, latency);
     }
-    return 0;
+};
+
+bool IsEnterKey(int ch) {
+    return ch == '\n' || ch == '\r' || ch == KEY_ENTER;
 }
 
-void DrawBox(int top, int left, int height, int width) {
-    const int bottom = top + height - 1;
-    const int right = left + width - 1;
-    mvaddch(top, left, ACS_ULCORNER);
-    mvaddch(top, right, ACS_URCORNER);
-    mvaddch(bottom, left, ACS_LLCORNER);
-    mvaddch(bottom, right, ACS_LRCORNER);
-    for (int x = left + 1; x < right; ++x) {
-        mvaddch(top, x, ACS_HLINE);
-        mvaddch(bottom, x, ACS_HLINE);
-    }
-    for (int y = top + 1; y < bottom; ++y) {
-        mvaddch(y, left, ACS_VLINE);
-        mvaddch(y, right, ACS_VLINE);
+void PrintFrameTotals(const FrameTotals &totals) {
+    const double frames = totals.frames > 0 ? static_cast<double>(totals.frames) : 1.0;
+    std::fprintf(stderr, "frames: %llu\n", static_cast<unsigned long long>(totals.frames));
+    std::fprintf(stderr, "cells/frame: %.1f\n", static_cast<double>(totals.cells) / frames);
+    std::fprintf(stderr, "runs/frame:  %.1f\n", static_cast<double>(totals.runs) / frames);
+    std::fprintf(stderr, "bytes/frame: %.1f (total %llu)\n", static_cast<double>(totals.bytes) / frames,
+                 static_cast<unsigned long long>(totals.bytes));
+    std::fprintf(stderr, "writes/frame: %.2f\n", static_cast<double>(totals.writes) / frames);
+}
+
+void PrintInputLatency(const InputLatency &latency) {
+    const double count = latency.count > 0 ? static_cast<double>(latency.count) : 1.0;
+    std::fprintf(stderr, "keys: %llu  input latency mean %.1f us  max %.1f us\n",
+                 static_cast<unsigned long long>(latency.count),
+                 static_cast<double>(latency.total.count()) / count / 1000.0,
+                 static_cast<double>(latency.max.count()) / 1000.0);
+}
+
+void PrintBotStats(const mctetris::bot::Bot &bot) {
+    const auto &stats = bot.Stats();
+    std::fprintf(stderr, "bot: %lld decisions, threads %d, latency mean %.3f ms  max %.3f ms, %lld late\n",
+                 static_cast<long long>(stats.decisions), bot.Threads(), stats.MeanLatencyMs(), stats.MaxLatencyMs(),
+                 static_cast<long long>(stats.lateDecisions));
+    if (bot.Config().tableBits > 0) {
+        std::fprintf(stderr, "bot: %.0f nodes/sec, table hit rate %.1f%%\n", stats.NodesPerSecond(),
+                     100.0 * stats.table.HitRate());
+    } else {
+        std::fprintf(stderr, "bot: %.0f nodes/sec, no table\n", stats.NodesPerSecond());
     }
 }
 
-void DrawCell(int screenY, int screenX, mctetris::model::Cell cell) {
-    const short pair = ColorPairForCell(cell);
-    if (pair != 0) {
-        attron(COLOR_PAIR(pair));
+struct FrontEndOptions {
+    bool frameStats = false;
+    bool perfHud = false;
+    std::optional<std::string> perfDumpPath;
+    std::optional<std::string> tracePath;
+    bool autoplay = false;
+    std::optional<std::string> recordDir;
+    std::optional<std::string> replayPath;
+    mctetris::model::Randomizer randomizer = mctetris::model::Randomizer::Bag7;
+    std::optional<std::string> playerName;
+    std::optional<std::string> scoresPath;
+    // A game quit part way is saved here and resumed on the next start.
+    std::optional<std::string> savePath;
+    mctetris::engine::AutoShiftConfig autoShift{};
+    // Bot games shown side by side instead of the menu.
+    std::optional<int> gridBoards;
+    // Play on mctetris-server at this socket instead of locally.
+    std::optional<std::string> connectPath;
+    // How frames reach the terminal, and so how the terminal is set up.
+    mctetris::ui::RenderOutput renderOutput = mctetris::ui::RenderOutput::Curses;
+};
+
+// Milliseconds from 0 to 1000.
+std::optional<std::chrono::milliseconds> ParseMs(const char *text) {
+    char *end = nullptr;
+    const long value = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value < 0 || value > 1000) {
+        return std::nullopt;
     }
-    for (int dy = 0; dy < kCellHeight; ++dy) {
-        for (int dx = 0; dx < kCellWidth; ++dx) {
-            mvaddch(screenY + dy, screenX + dx, ' ');
-        }
+    return std::chrono::milliseconds(value);
+}
+
+// The setting --das, --arr or --soft-drop changes; null for any other flag.
+std::chrono::milliseconds *AutoShiftSetting(mctetris::engine::AutoShiftConfig &config, const char *flag) {
+    if (std::strcmp(flag, "--das") == 0) {
+        return &config.das;
+    }
+    if (std::strcmp(flag, "--arr") == 0) {
+        return &config.arr;
     }
-    if (pair != 0) {
-        attroff(COLOR_PAIR(pair));
+    if (std::strcmp(flag, "--soft-drop") == 0) {
+        return &config.softDrop;
     }
+    return nullptr;
 }
 
-void RenderNextPiecePanel(int top, int left, const std::optional<mctetris::model::TetrominoType> &nextType) {
-    DrawBox(top, left, kNextPanelHeight, kNextPanelWidth);
-    mvprintw(top, left + 2, "NEXT");
-    if (!nextType) {
-        return;
+std::optional<FrontEndOptions> ParseOptions(int argc, char **argv) {
+    FrontEndOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--frame-stats") == 0) {
+            options.frameStats = true;
+        } else if (std::strcmp(argv[i], "--perf-hud") == 0) {
+            options.perfHud = true;
+        } else if (std::strcmp(argv[i], "--perf-dump") == 0 && hasValue) {
+            options.perfDumpPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--trace") == 0 && hasValue) {
+            options.tracePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--autoplay") == 0) {
+            options.autoplay = true;
+        } else if (std::strcmp(argv[i], "--record") == 0 && hasValue) {
+            options.recordDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay") == 0 && hasValue) {
+            options.replayPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--randomizer") == 0 && hasValue) {
+            const auto randomizer = mctetris::model::ParseRandomizer(argv[++i]);
+            if (!randomizer) {
+                return std::nullopt;
+            }
+            options.randomizer = *randomizer;
+        } else if (std::strcmp(argv[i], "--name") == 0 && hasValue) {
+            options.playerName = argv[++i];
+        } else if (std::strcmp(argv[i], "--scores") == 0 && hasValue) {
+            options.scoresPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--save") == 0 && hasValue) {
+            options.savePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--grid") == 0 && hasValue) {
+            char *end = nullptr;
+            const long boards = std::strtol(argv[++i], &end, 10);
+            if (*end != '\0' || boards < 1 || boards > 1024) {
+                return std::nullopt;
+            }
+            options.gridBoards = static_cast<int>(boards);
+        } else if (std::strcmp(argv[i], "--render") == 0 && hasValue) {
+            const auto output = mctetris::ui::ParseRenderOutput(argv[++i]);
+            if (!output) {
+                return std::nullopt;
+            }
+            options.renderOutput = *output;
+        } else if (std::strcmp(argv[i], "--connect") == 0) {
+            const bool hasPath = hasValue && std::strncmp(argv[i + 1], "--", 2) != 0;
+            options.connectPath = hasPath ? argv[++i] : mctetris::net::DefaultSocketPath();
+        } else if (auto *setting = AutoShiftSetting(options.autoShift, argv[i]); setting != nullptr && hasValue) {
+            const auto value = ParseMs(argv[++i]);
+            if (!value) {
+                return std::nullopt;
+            }
+            *setting = *value;
+        } else {
+            return std::nullopt;
+        }
     }
+    return options;
+}
 
-    mctetris::model::Tetromino preview{*nextType, 0};
-    std::array<std::array<mctetris::model::Cell, 4>, 4> previewCells{};
-    for (auto &row : previewCells) {
-        row.fill(mctetris::model::Cell::Empty);
+std::string PlayerName(const FrontEndOptions &options) {
+    if (options.playerName) {
+        return *options.playerName;
     }
-    for (const auto &block : preview.Blocks()) {
-        if (block.y >= 0 && block.y < 4 && block.x >= 0 && block.x < 4) {
-            previewCells[block.y][block.x] = preview.CellType();
+    for (const char *variable : {"USER", "LOGNAME"}) {
+        const char *value = std::getenv(variable);
+        if (value != nullptr && *value != '\0') {
+            return value;
         }
     }
+    return "player";
+}
 
-    const int offsetY = top + 2;
-    const int offsetX = left + 2;
-    for (int y = 0; y < 4; ++y) {
-        for (int x = 0; x < 4; ++x) {
-            DrawCell(offsetY + y * kCellHeight, offsetX + x * kCellWidth, previewCells[y][x]);
-        }
+// FNV-1a over the encoded recording, stored with the score to tie the two together.
+std::uint64_t ReplayHash(const mctetris::model::Replay &replay) {
+    std::uint64_t hash = 1469598103934665603ull;
+    for (const std::uint8_t byte : mctetris::model::EncodeReplay(replay)) {
+        hash ^= byte;
+        hash *= 1099511628211ull;
     }
+    return hash;
 }
 
-void RenderStatsPanel(int top, int left, const mctetris::model::GameModel &model) {
-    DrawBox(top, left, kStatsPanelHeight, kStatsPanelWidth);
-    mvprintw(top, left + 2, "STATS");
-    mvprintw(top + 2, left + 2, "Score: %d", model.Score());
-    mvprintw(top + 3, left + 2, "Level: %d", model.Level());
-    mvprintw(top + 4, left + 2, "Lines: %d", model.LinesCleared());
+std::optional<mctetris::model::ReplayAction> ActionForKey(const ControlScheme &scheme, int ch) {
+    using mctetris::model::ReplayAction;
+    if (ch == scheme.left) {
+        return ReplayAction::MoveLeft;
+    }
+    if (ch == scheme.right) {
+        return ReplayAction::MoveRight;
+    }
+    if (ch == scheme.down) {
+        return ReplayAction::SoftDrop;
+    }
+    if (ch == scheme.rotate) {
+        return ReplayAction::RotateCW;
+    }
+    if (ch == scheme.hardDrop) {
+        return ReplayAction::HardDrop;
+    }
+    return std::nullopt;
 }
 
-void RenderOverlay(int centerY, int centerX, const char *text) {
-    mvprintw(centerY, centerX - static_cast<int>(strlen(text)) / 2, "%s", text);
+// Keys that repeat while held, timed by the simulation thread.
+std::optional<mctetris::engine::ShiftKey> ShiftKeyFor(mctetris::model::ReplayAction action) {
+    using mctetris::model::ReplayAction;
+    switch (action) {
+    case ReplayAction::MoveLeft:
+        return mctetris::engine::ShiftKey::Left;
+    case ReplayAction::MoveRight:
+        return mctetris::engine::ShiftKey::Right;
+    case ReplayAction::SoftDrop:
+        return mctetris::engine::ShiftKey::Down;
+    default:
+        return std::nullopt;
+    }
 }
 
-void RenderGame(const mctetris::model::GameModel &model,
-                const std::optional<mctetris::model::TetrominoType> &nextType,
-                const ControlScheme &scheme,
-                bool paused) {
-    using mctetris::model::kBoardHeight;
-    using mctetris::model::kBoardWidth;
-
-    const int boardHeightChars = kBoardHeight * kCellHeight;
-    const int boardWidthChars = kBoardWidth * kCellWidth;
-    std::array<std::array<mctetris::model::Cell, kBoardWidth>, kBoardHeight> buffer{};
-    const auto &cells = model.GetBoard().Cells();
-    for (int y = 0; y < kBoardHeight; ++y) {
-        for (int x = 0; x < kBoardWidth; ++x) {
-            buffer[y][x] = cells[y][x];
-        }
+// Hands the terminal back: key reporting first, while still on the
+// alternate screen.
+void EndTerminal(mctetris::ui::Terminal &terminal) {
+    if (terminal.Draws()) {
+        mctetris::input::RestoreKeyEvents(STDOUT_FILENO);
     }
+    terminal.End();
+}
 
-    if (model.CurrentPiece()) {
-        const auto &active = *model.CurrentPiece();
-        for (const auto &block : active.piece.Blocks()) {
-            const int x = active.origin.x + block.x;
-            const int y = active.origin.y + block.y;
-            if (x >= 0 && x < kBoardWidth && y >= 0 && y < kBoardHeight) {
-                buffer[y][x] = active.piece.CellType();
-            }
+// Everything reported once the terminal is handed back.
+void ReportRun(const FrontEndOptions &options, const FrameTotals &frameTotals, const InputLatency *inputLatency,
+               const mctetris::bot::Bot *bot, const mctetris::ui::PerfMetrics &perf) {
+    if (options.frameStats) {
+        PrintFrameTotals(frameTotals);
+        if (inputLatency) {
+            PrintInputLatency(*inputLatency);
         }
     }
-
-    erase();
-    DrawBox(kBoardOffsetY - 1, kBoardOffsetX - 1, boardHeightChars + 2, boardWidthChars + 2);
-    for (int y = 0; y < kBoardHeight; ++y) {
-        for (int x = 0; x < kBoardWidth; ++x) {
-            DrawCell(kBoardOffsetY + y * kCellHeight, kBoardOffsetX + x * kCellWidth, buffer[y][x]);
-        }
+    if (bot) {
+        PrintBotStats(*bot);
     }
-
-    const int panelLeft = kBoardOffsetX + boardWidthChars + kPanelOffsetX;
-    const int nextTop = kBoardOffsetY;
-    RenderNextPiecePanel(nextTop, panelLeft, nextType);
-
-    const int statsTop = nextTop + kNextPanelHeight + 1;
-    RenderStatsPanel(statsTop, panelLeft, model);
-
-    mvprintw(0, 0, "Score: %d  Level: %d  Lines: %d  Scheme: %s", model.Score(), model.Level(),
-             model.LinesCleared(), scheme.name);
-    mvprintw(kBoardOffsetY + boardHeightChars + 2, 0,
-             "%s  P: pause  Q: quit", scheme.hint);
-
-    const int centerY = kBoardOffsetY + boardHeightChars / 2;
-    const int centerX = kBoardOffsetX + boardWidthChars / 2;
-    if (paused) {
-        RenderOverlay(centerY, centerX, "PAUSED");
-    } else if (model.IsGameOver()) {
-        RenderOverlay(centerY, centerX, "GAME OVER");
+    if (options.perfDumpPath && !perf.Dump(*options.perfDumpPath)) {
+        std::fprintf(stderr, "mctetris: cannot write '%s'\n", options.perfDumpPath->c_str());
+    }
+    if (mctetris::trace::Enabled()) {
+        const auto traced = mctetris::trace::Stop();
+        std::fprintf(stderr, "trace: %llu events, %llu dropped\n", static_cast<unsigned long long>(traced.events),
+                     static_cast<unsigned long long>(traced.dropped));
     }
-    wnoutrefresh(stdscr);
-    doupdate();
 }
 
-void RenderMenu(int selectedIndex) {
-    constexpr std::array<const char *, 3> kItems = {"Start Game", "Control Scheme", "Quit"};
-    const std::string title = "MCTETRIS";
-    int maxWidth = static_cast<int>(title.size());
-    for (const char *item : kItems) {
-        maxWidth = std::max(maxWidth, static_cast<int>(std::strlen(item)));
-    }
-    const int startY = (LINES / 2) - static_cast<int>(kItems.size());
-    const int startX = (COLS - maxWidth) / 2;
-
-    erase();
-    attron(A_BOLD);
-    mvprintw(startY - 2, (COLS - static_cast<int>(title.size())) / 2, "%s", title.c_str());
-    attroff(A_BOLD);
-    for (size_t i = 0; i < kItems.size(); ++i) {
-        if (static_cast<int>(i) == selectedIndex) {
-            attron(A_REVERSE);
+// Plays a recording back at its original pace. Q stops early.
+mctetris::model::ReplayOutcome PlayReplay(const mctetris::model::Replay &replay,
+                                          mctetris::input::InputThread &input,
+                                          mctetris::ui::Terminal &terminal,
+                                          mctetris::ui::ScreenBuffer &frame,
+                                          const ControlScheme &scheme) {
+    using Clock = std::chrono::steady_clock;
+    mctetris::model::GameSession session(replay.seed, replay.randomizer);
+    const auto start = Clock::now();
+    std::size_t next = 0;
+    bool stopped = false;
+    while (!stopped) {
+        const auto now = Clock::now();
+        while (next < replay.events.size() &&
+               start + std::chrono::milliseconds(replay.events[next].timeMs) <= now) {
+            (void)mctetris::model::ApplyReplayAction(session, replay.events[next].action);
+            ++next;
         }
-        mvprintw(startY + static_cast<int>(i), startX, "%s", kItems[i]);
-        if (static_cast<int>(i) == selectedIndex) {
-            attroff(A_REVERSE);
+        mctetris::ui::RenderGame(frame, terminal.Size(), session.Model(), session.NextType(), scheme, false);
+
+        std::optional<Clock::time_point> deadline;
+        if (next < replay.events.size()) {
+            deadline = start + std::chrono::milliseconds(replay.events[next].timeMs);
+        }
+        (void)mctetris::input::WaitForInput(input.WakeFd(), deadline);
+        input.AcknowledgeWake();
+        mctetris::input::KeyEvent event;
+        while (input.Pop(event)) {
+            if (event.action != mctetris::input::KeyAction::Press ||
+                event.key == mctetris::input::kKeyEventsSupported) {
+                continue;
+            }
+            // Once the replay has finished, any key leaves the final position.
+            stopped = stopped || event.key == 'q' || event.key == 'Q' ||
+                      event.key == mctetris::input::kQuitRequested || next == replay.events.size();
         }
     }
-    mvprintw(LINES - 2, 2, "Use Up/Down and Enter to select.");
-    wnoutrefresh(stdscr);
-    doupdate();
+    // Finish off-screen if the viewer quit early, so verification still covers the whole game.
+    while (next < replay.events.size()) {
+        (void)mctetris::model::ApplyReplayAction(session, replay.events[next++].action);
+    }
+    return mctetris::model::Summarize(session);
 }
 
-void RenderControlMenu(int selectedIndex,
-                       int activeIndex,
-                       const std::array<ControlScheme, 3> &schemes) {
-    const std::string title = "CONTROL SCHEME";
-    int maxWidth = static_cast<int>(title.size());
-    for (const auto &scheme : schemes) {
-        maxWidth = std::max(maxWidth, static_cast<int>(std::strlen(scheme.name)) + 3);
-    }
-    const int startY = (LINES / 2) - static_cast<int>(schemes.size());
-    const int startX = (COLS - maxWidth) / 2;
-
-    erase();
-    attron(A_BOLD);
-    mvprintw(startY - 2, (COLS - static_cast<int>(title.size())) / 2, "%s", title.c_str());
-    attroff(A_BOLD);
-    for (size_t i = 0; i < schemes.size(); ++i) {
-        const bool isSelected = static_cast<int>(i) == selectedIndex;
-        const bool isActive = static_cast<int>(i) == activeIndex;
-        if (isSelected) {
-            attron(A_REVERSE);
+// Runs the grid until Q. Boards tick on their own schedules; the ticks due
+// together are drawn as one frame, at most 60 a second.
+void RunGrid(mctetris::engine::GameGrid &grid, mctetris::input::InputThread &input, mctetris::ui::Terminal &terminal,
+             mctetris::ui::ScreenBuffer &frame, FrameTotals &totals, mctetris::ui::PerfMetrics &perf) {
+    using Clock = std::chrono::steady_clock;
+    constexpr auto kFrameInterval = std::chrono::microseconds(16667);
+    std::vector<mctetris::ui::GridTile> tiles(grid.Boards().size());
+    bool paused = false;
+    bool dirty = true;
+    auto size = terminal.Size();
+    Clock::time_point pausedAt{};
+    Clock::time_point lastFrame{};
+    grid.Start(Clock::now());
+    while (true) {
+        const auto frameStart = Clock::now();
+        input.AcknowledgeWake();
+        mctetris::input::KeyEvent event;
+        bool quit = false;
+        while (input.Pop(event)) {
+            if (event.action != mctetris::input::KeyAction::Press) {
+                continue;
+            }
+            if (event.key == 'q' || event.key == 'Q' || event.key == mctetris::input::kQuitRequested) {
+                quit = true;
+            } else if (event.key == 'p' || event.key == 'P') {
+                paused = !paused;
+                if (paused) {
+                    pausedAt = frameStart;
+                } else {
+                    grid.Delay(frameStart - pausedAt);
+                }
+                dirty = true;
+            }
+        }
+        if (quit) {
+            break;
+        }
+        if (!paused && grid.Advance(frameStart) > 0) {
+            const auto updateDone = Clock::now();
+            perf.Add(mctetris::ui::PerfMetric::Update, updateDone - frameStart, updateDone);
+            dirty = true;
         }
-        mvprintw(startY + static_cast<int>(i), startX, "%s%s",
-                 isActive ? "* " : "  ", schemes[i].name);
-        if (isSelected) {
-            attroff(A_REVERSE);
+        if (dirty) {
+            const auto renderStart = Clock::now();
+            for (std::size_t i = 0; i < tiles.size(); ++i) {
+                const auto &board = grid.Boards()[i];
+                tiles[i] = mctetris::ui::GridTile{&board.session.Model(), board.gamesFinished, board.bestScore};
+            }
+            const auto frameStats = mctetris::ui::RenderGrid(frame, size, tiles, paused);
+            totals.Add(frameStats);
+            const auto frameDone = Clock::now();
+            const std::chrono::nanoseconds updateTime(frameStats.updateNs);
+            perf.Add(mctetris::ui::PerfMetric::Render, frameDone - renderStart - updateTime, frameDone);
+            perf.Add(mctetris::ui::PerfMetric::Doupdate, updateTime, frameDone);
+            perf.Add(mctetris::ui::PerfMetric::Frame, frameDone - frameStart, frameDone);
+            MCTETRIS_TRACE_COMPLETE("Frame", frameStart, frameDone);
+            lastFrame = frameStart;
+            dirty = false;
+        }
+
+        std::optional<Clock::time_point> deadline;
+        if (!paused) {
+            deadline = grid.NextDeadline();
+            if (deadline && *deadline < lastFrame + kFrameInterval) {
+                deadline = lastFrame + kFrameInterval;
+            }
         }
+        (void)mctetris::input::WaitForInput(input.WakeFd(), deadline);
+        size = terminal.Size();
+        dirty = dirty || size.rows != frame.Rows() || size.cols != frame.Cols();
     }
-    mvprintw(LINES - 3, 2, "Enter selects. B or Esc returns.");
-    mvprintw(LINES - 2, 2, "Current scheme is marked with *.");
-    wnoutrefresh(stdscr);
-    doupdate();
 }
 
-mctetris::model::TetrominoType RandomType(std::mt19937 &rng) {
-    std::uniform_int_distribution<int> dist(0, 6);
-    return static_cast<mctetris::model::TetrominoType>(dist(rng));
+// Plays on mctetris-server: keys go out as Inputs and the game drawn is the
+// server's, rebuilt from the States it sends back. Enter or N starts another
+// game once one ends; Q quits. False if the connection was lost.
+bool RunRemote(mctetris::net::Client &client, const mctetris::net::Hello &hello,
+               mctetris::input::InputThread &input, mctetris::ui::Terminal &terminal, mctetris::ui::ScreenBuffer &frame,
+               const ControlScheme &scheme,
+               bool showHud, FrameTotals &totals, mctetris::ui::PerfMetrics &perf) {
+    using Clock = std::chrono::steady_clock;
+    mctetris::model::GameModel model;
+    std::optional<mctetris::model::TetrominoType> next;
+    // Send times of the last inputs by sequence, until a State echoes them.
+    std::array<Clock::time_point, 256> sentAt;
+    std::uint16_t sequence = 0;
+    std::uint16_t shown = 0;
+    if (!client.Send(hello)) {
+        return false;
+    }
+    while (true) {
+        const auto frameStart = Clock::now();
+        input.AcknowledgeWake();
+        mctetris::input::KeyEvent event;
+        bool quit = false;
+        bool sent = true;
+        while (input.Pop(event)) {
+            const int ch = event.key;
+            if (event.action == mctetris::input::KeyAction::Release || ch == mctetris::input::kKeyEventsSupported) {
+                continue;
+            }
+            if (ch == 'q' || ch == 'Q' || ch == mctetris::input::kQuitRequested) {
+                quit = true;
+            } else if (ch == 'h' || ch == 'H') {
+                showHud = !showHud;
+            } else if (model.IsGameOver() && (IsEnterKey(ch) || ch == 'n' || ch == 'N')) {
+                // The server restarts sequences with every game.
+                sent = sent && client.Send(hello);
+                sequence = 0;
+                shown = 0;
+            } else if (const auto action = ActionForKey(scheme, ch); action && !model.IsGameOver()) {
+                sentAt[++sequence % sentAt.size()] = event.time;
+                sent = sent && client.Send(mctetris::net::Input{*action, sequence});
+            }
+        }
+        if (quit) {
+            return true;
+        }
+        if (!sent || !client.Receive()) {
+            return false;
+        }
+        std::uint16_t echoed = shown;
+        while (const auto state = client.Next()) {
+            mctetris::net::ApplyState(*state, model);
+            next = state->next;
+            // A State from before the last Hello can echo a stale sequence.
+            if (static_cast<std::uint16_t>(state->sequence - shown) <= static_cast<std::uint16_t>(sequence - shown)) {
+                echoed = state->sequence;
+            }
+        }
+
+        const auto renderStart = Clock::now();
+        const auto frameStats =
+            mctetris::ui::RenderGame(frame, terminal.Size(), model, next, scheme, false, showHud ? &perf : nullptr);
+        totals.Add(frameStats);
+        const auto frameDone = Clock::now();
+        const std::chrono::nanoseconds updateTime(frameStats.updateNs);
+        perf.Add(mctetris::ui::PerfMetric::Render, frameDone - renderStart - updateTime, frameDone);
+        perf.Add(mctetris::ui::PerfMetric::Doupdate, updateTime, frameDone);
+        perf.Add(mctetris::ui::PerfMetric::Frame, frameDone - frameStart, frameDone);
+        MCTETRIS_TRACE_COMPLETE("Frame", frameStart, frameDone);
+        // Key to frame here includes the round trip through the server.
+        for (; shown != echoed; ++shown) {
+            const auto keyTime = sentAt[static_cast<std::uint16_t>(shown + 1) % sentAt.size()];
+            perf.Add(mctetris::ui::PerfMetric::InputToFrame, frameDone - keyTime, frameDone);
+        }
+        (void)mctetris::input::WaitForInput({input.WakeFd(), client.Fd()}, std::nullopt);
+    }
 }
 
-bool IsEnterKey(int ch) {
-    return ch == '\n' || ch == '\r' || ch == KEY_ENTER;
+bool ReportReplay(const mctetris::model::Replay &replay, const mctetris::model::ReplayOutcome &outcome) {
+    const auto &expected = replay.outcome;
+    const bool match = outcome == expected;
+    std::fprintf(stderr, "replay %s: score %d/%d lines %d/%d level %d/%d pieces %d/%d board %016llx/%016llx\n",
+                 match ? "OK" : "MISMATCH", outcome.score, expected.score, outcome.lines, expected.lines,
+                 outcome.level, expected.level, outcome.pieces, expected.pieces,
+                 static_cast<unsigned long long>(outcome.boardHash),
+                 static_cast<unsigned long long>(expected.boardHash));
+    return match;
 }
 
 } // namespace
 
-int main() {
-    initscr();
-    cbreak();
-    noecho();
-    keypad(stdscr, true);
-    curs_set(0);
-    nodelay(stdscr, true);
-    if (has_colors()) {
-        start_color();
-        use_default_colors();
-        init_pair(1, COLOR_CYAN, COLOR_CYAN);
-        init_pair(2, COLOR_YELLOW, COLOR_YELLOW);
-        init_pair(3, COLOR_MAGENTA, COLOR_MAGENTA);
-        init_pair(4, COLOR_GREEN, COLOR_GREEN);
-        init_pair(5, COLOR_RED, COLOR_RED);
-        init_pair(6, COLOR_BLUE, COLOR_BLUE);
-        init_pair(7, COLOR_WHITE, COLOR_WHITE);
+int main(int argc, char **argv) {
+    const auto options = ParseOptions(argc, argv);
+    if (!options) {
+        std::fprintf(stderr, "Usage: mctetris [--frame-stats] [--perf-hud] [--perf-dump FILE] [--autoplay]\n"
+                             "                [--trace FILE] [--record DIR] [--replay FILE]\n"
+                             "                [--randomizer bag|uniform|history] [--name NAME] [--scores FILE]\n"
+                             "                [--das MS] [--arr MS] [--soft-drop MS] [--grid N]\n"
+                             "                [--connect [SOCKET]] [--save FILE] [--render curses|ansi|null]\n");
+        return 1;
+    }
+    const bool reportFrameStats = options->frameStats;
+    std::optional<mctetris::model::Replay> replay;
+    if (options->replayPath) {
+        replay = mctetris::model::LoadReplay(*options->replayPath);
+        if (!replay) {
+            std::fprintf(stderr, "mctetris: '%s' is not a readable replay\n", options->replayPath->c_str());
+            return 1;
+        }
+    }
+
+    // Connect before taking over the terminal so a missing server is reported plainly.
+    mctetris::net::Client client;
+    if (options->connectPath && !client.Connect(*options->connectPath)) {
+        std::fprintf(stderr, "mctetris: cannot connect to '%s'\n", options->connectPath->c_str());
+        return 1;
+    }
+
+    // SIGINT and SIGTERM reach the input thread through a descriptor and come
+    // out as kQuitRequested, so the terminal is always handed back. Blocked
+    // before any thread starts so that every thread inherits the mask. Held
+    // for the life of the process.
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &stopSignals, nullptr);
+    const int stopFd = signalfd(-1, &stopSignals, SFD_CLOEXEC);
+
+    if (options->tracePath) {
+        if (!mctetris::trace::Start(*options->tracePath)) {
+            std::fprintf(stderr, "mctetris: cannot write '%s'\n", options->tracePath->c_str());
+            return 1;
+        }
+    } else {
+        mctetris::trace::StartFromEnvironment();
+    }
+    mctetris::trace::SetThreadName("main");
+
+    // Only the curses output needs curses, and so a terminal and TERM.
+    mctetris::ui::Terminal terminal(options->renderOutput);
+    if (!terminal.Start()) {
+        std::fprintf(stderr, "mctetris: cannot set up the terminal; check TERM or try --render ansi\n");
+        return 1;
+    }
+    if (terminal.Draws()) {
+        mctetris::input::RequestKeyEvents(STDOUT_FILENO);
+    }
+
+    // Keys are read off stdin by the input thread; curses only draws.
+    mctetris::input::InputThread input;
+    if (!input.Start(stopFd)) {
+        EndTerminal(terminal);
+        std::fprintf(stderr, "mctetris: cannot start the input thread\n");
+        return 1;
     }
 
     const std::array<ControlScheme, 3> schemes = {
@@ -284,105 +576,313 @@ int main() {
         ControlScheme{"NumPad", '4', '6', '5', '8', '0',
                       "NumPad 4/6/5/8: move/rotate  0: hard drop"}};
 
-    mctetris::model::GameModel model;
     std::random_device device;
-    std::mt19937 rng(device());
-    std::optional<mctetris::model::TetrominoType> nextType;
+    mctetris::ui::AnsiBackend ansiBackend(STDOUT_FILENO);
+    mctetris::ui::NullBackend nullBackend;
+    mctetris::ui::ScreenBuffer frame;
+    if (options->renderOutput == mctetris::ui::RenderOutput::Ansi) {
+        frame.SetBackend(&ansiBackend);
+    } else if (options->renderOutput == mctetris::ui::RenderOutput::Null) {
+        frame.SetBackend(&nullBackend);
+    }
+    FrameTotals frameTotals;
+    InputLatency inputLatency;
+    mctetris::ui::OutputMeter outputMeter;
+    if (reportFrameStats) {
+        frame.SetOutputMeter(&outputMeter);
+    }
+
+    std::optional<mctetris::bot::Bot> bot;
+    if (options->autoplay) {
+        bot.emplace();
+    }
+
+    if (replay) {
+        const auto outcome = PlayReplay(*replay, input, terminal, frame, schemes[0]);
+        input.Stop();
+        EndTerminal(terminal);
+        return ReportReplay(*replay, outcome) ? 0 : 2;
+    }
+
+    if (options->gridBoards) {
+        // Scoring candidates on their own keeps a decision near 0.1 ms, so
+        // dozens of boards fit on one core.
+        mctetris::bot::BotConfig botConfig;
+        botConfig.unknownDepth = 0;
+        mctetris::engine::GameGrid grid(*options->gridBoards, device(), options->randomizer, botConfig);
+        mctetris::ui::PerfMetrics perf;
+        RunGrid(grid, input, terminal, frame, frameTotals, perf);
+        input.Stop();
+        EndTerminal(terminal);
+        ReportRun(*options, frameTotals, nullptr, &grid.Player(), perf);
+        return 0;
+    }
+
+    if (options->connectPath) {
+        mctetris::net::Hello hello;
+        hello.randomizer = options->randomizer;
+        const std::string name = PlayerName(*options).substr(0, mctetris::net::kMaxNameBytes);
+        hello.nameLength = static_cast<std::uint8_t>(name.size());
+        std::copy(name.begin(), name.end(), hello.name.begin());
+        mctetris::ui::PerfMetrics perf;
+        const bool connected =
+            RunRemote(client, hello, input, terminal, frame, schemes[0], options->perfHud, frameTotals, perf);
+        input.Stop();
+        EndTerminal(terminal);
+        if (!connected) {
+            std::fprintf(stderr, "mctetris: lost the connection to '%s'\n", options->connectPath->c_str());
+        }
+        ReportRun(*options, frameTotals, nullptr, nullptr, perf);
+        return connected ? 0 : 1;
+    }
 
     using Clock = std::chrono::steady_clock;
-    auto lastGravity = Clock::now();
     int activeScheme = 0;
     int menuIndex = 0;
     int controlIndex = 0;
-    bool paused = false;
     enum class Screen { Menu,
                         Controls,
+                        HighScores,
                         Game };
     Screen screen = Screen::Menu;
-
-    auto startGame = [&]() {
-        model = mctetris::model::GameModel{};
-        nextType = RandomType(rng);
-        (void)model.Spawn(*nextType);
-        nextType = RandomType(rng);
-        paused = false;
-        lastGravity = Clock::now();
+    const std::string playerName = PlayerName(*options);
+    mctetris::scores::ScoreWriter scoreWriter(options->scoresPath.value_or(mctetris::scores::DefaultScorePath()));
+    std::vector<mctetris::scores::ScoreEntry> topScores;
+    std::vector<mctetris::scores::ScoreEntry> playerScores;
+    mctetris::ui::PerfMetrics perf;
+    bool showHud = options->perfHud;
+    // Read times of the keys handled this iteration, for key-to-frame latency.
+    std::array<Clock::time_point, 32> frameKeys;
+    // Read times of the keys behind each simulation command, by command
+    // number, until a snapshot shows the command applied.
+    std::array<Clock::time_point, 256> commandKeys;
+    std::uint64_t commandsShown = 0;
+    // Command number of the NewGame that started the game on screen.
+    std::uint64_t gameCommand = 0;
+
+    // Written on the simulation thread, read once it has been stopped.
+    bool saveFailed = false;
+    // Runs on the simulation thread once per game.
+    auto onGameEnd = [&](const mctetris::model::GameSession &session, const mctetris::model::Replay &recording,
+                         bool finished) {
+        if (options->recordDir) {
+            const std::string path = *options->recordDir + "/mctetris-" + std::to_string(session.Seed()) + ".mctr";
+            (void)mctetris::model::SaveReplay(path, recording);
+        }
+        // Only quitting ends a game part way, so this is the save on quit.
+        if (!finished && !bot && options->savePath) {
+            saveFailed = !mctetris::model::SaveGame(*options->savePath, session, recording);
+        }
+        // Only finished games are ranked, and bot games never are.
+        if (!finished || bot) {
+            return;
+        }
+        const auto &model = session.Model();
+        mctetris::scores::ScoreEntry entry;
+        entry.name = playerName;
+        entry.score = model.Score();
+        entry.level = model.Level();
+        entry.lines = model.LinesCleared();
+        entry.timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+                              std::chrono::system_clock::now().time_since_epoch())
+                              .count();
+        entry.replayHash = ReplayHash(recording);
+        scoreWriter.Submit(std::move(entry));
+    };
+    mctetris::engine::SimulationThread sim(options->randomizer, options->autoShift, bot ? &*bot : nullptr,
+                                           onGameEnd);
+    if (options->savePath && !bot) {
+        mctetris::model::GameSession saved;
+        mctetris::model::Replay recording;
+        // Resumed once; quitting part way again saves it afresh.
+        if (mctetris::model::LoadGame(*options->savePath, saved, recording)) {
+            sim.ResumeGame(saved, std::move(recording));
+            (void)std::remove(options->savePath->c_str());
+            screen = Screen::Game;
+        }
+    }
+    if (!sim.Start()) {
+        input.Stop();
+        EndTerminal(terminal);
+        std::fprintf(stderr, "mctetris: cannot start the simulation thread\n");
+        return 1;
+    }
+    // Notes the key behind the command just sent; releases and settings
+    // have none.
+    auto sent = [&](Clock::time_point keyTime) {
+        commandKeys[(sim.Sent() - 1) % commandKeys.size()] = keyTime;
     };
     bool running = true;
     while (running) {
-        const int ch = getch();
-        if (screen == Screen::Menu) {
-            if (ch == 'q' || ch == 'Q') {
+        const auto frameStart = Clock::now();
+        std::size_t keyCount = 0;
+        // Apply every key the input thread has queued, oldest first.
+        input.AcknowledgeWake();
+        sim.AcknowledgeWake();
+        mctetris::input::KeyEvent event;
+        while (running && input.Pop(event)) {
+            const int ch = event.key;
+            if (ch == mctetris::input::kQuitRequested) {
                 running = false;
-            } else if (ch == KEY_UP || ch == 'w' || ch == 'W') {
-                menuIndex = (menuIndex + 2) % 3;
-            } else if (ch == KEY_DOWN || ch == 's' || ch == 'S') {
-                menuIndex = (menuIndex + 1) % 3;
-            } else if (IsEnterKey(ch)) {
-                if (menuIndex == 0) {
-                    startGame();
-                    screen = Screen::Game;
-                } else if (menuIndex == 1) {
-                    controlIndex = activeScheme;
-                    screen = Screen::Controls;
-                } else if (menuIndex == 2) {
-                    running = false;
+                continue;
+            }
+            if (ch == mctetris::input::kKeyEventsSupported) {
+                sim.SetReleaseEvents(true);
+                sent(Clock::time_point{});
+                continue;
+            }
+            std::optional<mctetris::engine::ShiftKey> shift;
+            if (screen == Screen::Game) {
+                if (const auto action = ActionForKey(schemes[activeScheme], ch)) {
+                    shift = ShiftKeyFor(*action);
                 }
             }
-        } else if (screen == Screen::Controls) {
-            if (ch == 27 || ch == 'b' || ch == 'B') {
-                screen = Screen::Menu;
-            } else if (ch == KEY_UP || ch == 'w' || ch == 'W') {
-                controlIndex = (controlIndex + 2) % 3;
-            } else if (ch == KEY_DOWN || ch == 's' || ch == 'S') {
-                controlIndex = (controlIndex + 1) % 3;
-            } else if (IsEnterKey(ch)) {
-                activeScheme = controlIndex;
-                screen = Screen::Menu;
+            const bool release = event.action == mctetris::input::KeyAction::Release;
+            if (release && !shift) {
+                continue;
             }
-        } else if (screen == Screen::Game) {
-            if (ch == 'p' || ch == 'P') {
-                paused = !paused;
-            } else if (ch == 'q' || ch == 'Q') {
-                running = false;
-            } else if (!paused && !model.IsGameOver()) {
-                const ControlScheme &scheme = schemes[activeScheme];
-                if (ch == scheme.left) {
-                    (void)model.Move(-1, 0);
-                } else if (ch == scheme.right) {
-                    (void)model.Move(1, 0);
-                } else if (ch == scheme.down) {
-                    (void)model.SoftDrop();
-                } else if (ch == scheme.rotate) {
-                    (void)model.RotateCW();
-                } else if (ch == scheme.hardDrop) {
-                    model.HardDrop();
+            const auto sentBefore = sim.Sent();
+            inputLatency.Add(Clock::now() - event.time);
+            if (shift) {
+                if (bot) {
+                    // The bot plays; held keys do nothing.
+                } else if (release) {
+                    sim.Release(*shift, event.time);
+                    sent(Clock::time_point{});
+                } else {
+                    const bool repeat = event.action == mctetris::input::KeyAction::Repeat;
+                    sim.Press(*shift, event.time, repeat);
+                    sent(event.time);
+                }
+            } else if (screen == Screen::Menu) {
+                if (ch == 'q' || ch == 'Q') {
+                    running = false;
+                } else if (ch == KEY_UP || ch == 'w' || ch == 'W') {
+                    menuIndex = (menuIndex + 3) % 4;
+                } else if (ch == KEY_DOWN || ch == 's' || ch == 'S') {
+                    menuIndex = (menuIndex + 1) % 4;
+                } else if (IsEnterKey(ch)) {
+                    if (menuIndex == 0) {
+                        sim.NewGame(device());
+                        sent(event.time);
+                        gameCommand = sim.Sent();
+                        screen = Screen::Game;
+                    } else if (menuIndex == 1) {
+                        controlIndex = activeScheme;
+                        screen = Screen::Controls;
+                    } else if (menuIndex == 2) {
+                        // Waits for a score still being written so it shows up.
+                        scoreWriter.Flush();
+                        const auto store = mctetris::scores::ScoreStore::Open(scoreWriter.Path());
+                        topScores = store.Top(10);
+                        playerScores = store.TopForPlayer(playerName, 3);
+                        screen = Screen::HighScores;
+                    } else if (menuIndex == 3) {
+                        running = false;
+                    }
+                }
+            } else if (screen == Screen::HighScores) {
+                if (ch == 27 || ch == 'b' || ch == 'B') {
+                    screen = Screen::Menu;
+                }
+            } else if (screen == Screen::Controls) {
+                if (ch == 27 || ch == 'b' || ch == 'B') {
+                    screen = Screen::Menu;
+                } else if (ch == KEY_UP || ch == 'w' || ch == 'W') {
+                    controlIndex = (controlIndex + 2) % 3;
+                } else if (ch == KEY_DOWN || ch == 's' || ch == 'S') {
+                    controlIndex = (controlIndex + 1) % 3;
+                } else if (IsEnterKey(ch)) {
+                    activeScheme = controlIndex;
+                    screen = Screen::Menu;
+                }
+            } else if (screen == Screen::Game && event.action == mctetris::input::KeyAction::Press) {
+                // Only moves and soft drop repeat while held.
+                if (ch == 'p' || ch == 'P') {
+                    sim.TogglePause();
+                    sent(event.time);
+                } else if (ch == 'h' || ch == 'H') {
+                    showHud = !showHud;
+                } else if (ch == 'q' || ch == 'Q') {
+                    running = false;
+                } else if (!bot) {
+                    if (const auto action = ActionForKey(schemes[activeScheme], ch)) {
+                        sim.Apply(*action);
+                        sent(event.time);
+                    }
                 }
             }
-        }
-
-        if (screen == Screen::Game) {
-            if (!paused && !model.CurrentPiece() && !model.IsGameOver()) {
-                (void)model.Spawn(nextType.value_or(RandomType(rng)));
-                nextType = RandomType(rng);
+            // Keys handled here show up in this frame; commands once a snapshot has them.
+            if (sim.Sent() == sentBefore && keyCount < frameKeys.size()) {
+                frameKeys[keyCount++] = event.time;
             }
-
-            const auto now = Clock::now();
-            const auto gravityDelay = std::chrono::milliseconds(model.GravityDelayMs());
-            if (!paused && !model.IsGameOver() && now - lastGravity >= gravityDelay) {
-                model.TickGravity();
-                lastGravity = now;
+        }
+        if (!running) {
+            break;
+        }
+        const auto inputDone = Clock::now();
+        perf.Add(mctetris::ui::PerfMetric::Input, inputDone - frameStart, inputDone);
+        MCTETRIS_TRACE_COMPLETE("Input", frameStart, inputDone);
+
+        mctetris::ui::FrameStats frameStats;
+        auto renderStart = inputDone;
+        (void)sim.Update();
+        const auto &snapshot = sim.Latest();
+        mctetris::engine::StepTiming timing;
+        while (sim.PopTiming(timing)) {
+            perf.Add(mctetris::ui::PerfMetric::Update, timing.update, timing.time);
+            if (timing.gravityLate) {
+                perf.Add(mctetris::ui::PerfMetric::GravityLate, *timing.gravityLate, timing.time);
             }
-
-            RenderGame(model, nextType, schemes[activeScheme], paused);
-        } else if (screen == Screen::Menu) {
-            RenderMenu(menuIndex);
+        }
+        const bool gameShown = screen == Screen::Game && snapshot.applied >= gameCommand;
+        if (gameShown) {
+            renderStart = Clock::now();
+            frameStats = mctetris::ui::RenderGame(frame, terminal.Size(), snapshot.model, snapshot.next,
+                                                  schemes[activeScheme], snapshot.paused, showHud ? &perf : nullptr);
+        } else if (screen == Screen::Menu || screen == Screen::Game) {
+            // Until the simulation has started the game, keep showing the menu.
+            frameStats = mctetris::ui::RenderMenu(frame, terminal.Size(), menuIndex);
+        } else if (screen == Screen::HighScores) {
+            frameStats = mctetris::ui::RenderHighScores(frame, terminal.Size(), topScores, playerScores, playerName);
         } else {
-            RenderControlMenu(controlIndex, activeScheme, schemes);
+            frameStats = mctetris::ui::RenderControlMenu(frame, terminal.Size(), controlIndex, activeScheme,
+                                                         schemes);
+        }
+        frameTotals.Add(frameStats);
+        const auto frameDone = Clock::now();
+        const std::chrono::nanoseconds updateTime(frameStats.updateNs);
+        perf.Add(mctetris::ui::PerfMetric::Render, frameDone - renderStart - updateTime, frameDone);
+        perf.Add(mctetris::ui::PerfMetric::Doupdate, updateTime, frameDone);
+        perf.Add(mctetris::ui::PerfMetric::Frame, frameDone - frameStart, frameDone);
+        MCTETRIS_TRACE_COMPLETE("Frame", frameStart, frameDone);
+        for (std::size_t i = 0; i < keyCount; ++i) {
+            perf.Add(mctetris::ui::PerfMetric::InputToFrame, frameDone - frameKeys[i], frameDone);
+        }
+        if (gameShown) {
+            // Slots of all but the last commandKeys.size() commands have been reused.
+            if (sim.Sent() > commandKeys.size()) {
+                commandsShown = std::max<std::uint64_t>(commandsShown, sim.Sent() - commandKeys.size());
+            }
+            for (; commandsShown < snapshot.applied; ++commandsShown) {
+                const auto keyTime = commandKeys[commandsShown % commandKeys.size()];
+                // Releases and settings have no key to time.
+                if (keyTime != Clock::time_point{}) {
+                    perf.Add(mctetris::ui::PerfMetric::InputToFrame, frameDone - keyTime, frameDone);
+                }
+            }
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+        // Sleeps until a key arrives or the simulation publishes a step.
+        (void)mctetris::input::WaitForInput({input.WakeFd(), sim.WakeFd()}, std::nullopt);
     }
 
-    endwin();
+    // Saves the recording of a game still in progress.
+    sim.Stop();
+    input.Stop();
+    EndTerminal(terminal);
+    if (saveFailed) {
+        std::fprintf(stderr, "mctetris: cannot write '%s'\n", options->savePath->c_str());
+    }
+    ReportRun(*options, frameTotals, &inputLatency, bot ? &*bot : nullptr, perf);
     return 0;
 }
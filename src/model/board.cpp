@@ -3,72 +3,334 @@
 #include "board.h"
 
 namespace mctetris::model {
+namespace {
 
-Board::Board() {
+// Piece rows are shifted into a lane with kGuardBits of padding on the right
+// so that negative origins stay representable; everything outside the board
+// columns counts as wall. The lane is 32 bits wide unless the board is too
+// wide for that.
+constexpr int kGuardBits = 8;
+
+template <int Width>
+using Lane = std::conditional_t<(Width + kGuardBits + 4 <= 32), std::uint32_t, std::uint64_t>;
+
+template <int Width>
+constexpr Lane<Width> kWallMask = ~(((Lane<Width>{1} << Width) - 1) << kGuardBits);
+
+// Zobrist keys are folded into per-row tables indexed by chunks of at most
+// six bits of the row mask, so a whole row hashes with a lookup per chunk
+// (two for the standard board) while single cells are still the XOR of one
+// key.
+template <int Width>
+struct HashLayout {
+    static constexpr int kChunks = (Width + 5) / 6;
+    static constexpr int kChunkBits = (Width + kChunks - 1) / kChunks;
+    static constexpr int kChunkSize = 1 << kChunkBits;
+};
+
+template <int Width, int Height>
+struct HashTables {
+    std::uint64_t chunks[Height][HashLayout<Width>::kChunks][HashLayout<Width>::kChunkSize] = {};
+};
+
+constexpr std::uint64_t NextKey(std::uint64_t &state) {
+    state += 0x9e3779b97f4a7c15ull;
+    std::uint64_t value = state;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+template <int Width, int Height>
+constexpr HashTables<Width, Height> BuildHashTables() {
+    using Layout = HashLayout<Width>;
+    HashTables<Width, Height> tables{};
+    std::uint64_t state = 0x6d637472u;
+    for (int y = 0; y < Height; ++y) {
+        for (int chunk = 0; chunk < Layout::kChunks; ++chunk) {
+            // The last chunk may be narrower; its unused keys are never looked up.
+            std::uint64_t cellKeys[Layout::kChunkBits] = {};
+            const int bits = std::min(Layout::kChunkBits, Width - chunk * Layout::kChunkBits);
+            for (int bit = 0; bit < bits; ++bit) {
+                cellKeys[bit] = NextKey(state);
+            }
+            for (int mask = 1; mask < Layout::kChunkSize; ++mask) {
+                std::uint64_t hash = 0;
+                for (int bit = 0; bit < Layout::kChunkBits; ++bit) {
+                    if ((mask & (1 << bit)) != 0) {
+                        hash ^= cellKeys[bit];
+                    }
+                }
+                tables.chunks[y][chunk][mask] = hash;
+            }
+        }
+    }
+    return tables;
+}
+
+template <int Width, int Height>
+constexpr HashTables<Width, Height> kHashTables = BuildHashTables<Width, Height>();
+
+template <int Width, int Height>
+std::uint64_t RowHash(int y, std::uint64_t mask) {
+    using Layout = HashLayout<Width>;
+    const auto &table = kHashTables<Width, Height>.chunks[y];
+    std::uint64_t hash = 0;
+    for (int chunk = 0; chunk < Layout::kChunks; ++chunk) {
+        hash ^= table[chunk][(mask >> (chunk * Layout::kChunkBits)) & (Layout::kChunkSize - 1)];
+    }
+    return hash;
+}
+
+} // namespace
+
+template <int Width, int Height>
+BasicBoard<Width, Height>::BasicBoard() {
     for (auto &row : cells_) {
         row.fill(Cell::Empty);
     }
 }
 
-bool Board::IsInside(int x, int y) const {
-    return x >= 0 && x < kBoardWidth && y >= 0 && y < kBoardHeight;
+template <int Width, int Height>
+bool BasicBoard<Width, Height>::IsInside(int x, int y) const {
+    return x >= 0 && x < Width && y >= 0 && y < Height;
 }
 
-bool Board::IsEmpty(int x, int y) const {
+template <int Width, int Height>
+bool BasicBoard<Width, Height>::IsEmpty(int x, int y) const {
     if (!IsInside(x, y)) {
         return false;
     }
-    return cells_[y][x] == Cell::Empty;
+    return ((rows_[y] >> x) & 1u) == 0;
 }
 
-bool Board::CanPlace(const Tetromino &piece, int originX, int originY) const {
-    for (const auto &block : piece.Blocks()) {
-        const int x = originX + block.x;
-        const int y = originY + block.y;
-        if (!IsInside(x, y) || !IsEmpty(x, y)) {
+template <int Width, int Height>
+bool BasicBoard<Width, Height>::CanPlace(const Tetromino &piece, int originX, int originY) const {
+    const auto &masks = piece.RowMasks();
+    const int shift = originX + kGuardBits;
+    for (int dy = 0; dy < static_cast<int>(masks.size()); ++dy) {
+        const Lane<Width> mask = masks[dy];
+        if (mask == 0) {
+            continue;
+        }
+        const int y = originY + dy;
+        if (y < 0 || y >= Height || shift < 0 || shift > kGuardBits + Width) {
+            return false;
+        }
+        const Lane<Width> blocked = kWallMask<Width> | (static_cast<Lane<Width>>(rows_[y]) << kGuardBits);
+        if (((mask << shift) & blocked) != 0) {
             return false;
         }
     }
     return true;
 }
 
-void Board::Place(const Tetromino &piece, int originX, int originY) {
+template <int Width, int Height>
+int BasicBoard<Width, Height>::DropDistance(const Tetromino &piece, int originX, int originY) const {
+    // Lowest block of the piece in each column it covers, or -1.
+    std::array<int, 4> lowest{-1, -1, -1, -1};
+    for (const auto &block : piece.Blocks()) {
+        lowest[block.x] = std::max(lowest[block.x], block.y);
+    }
+
+    int distance = Height;
+    for (int dx = 0; dx < static_cast<int>(lowest.size()); ++dx) {
+        if (lowest[dx] < 0) {
+            continue;
+        }
+        const int x = originX + dx;
+        const int y = originY + lowest[dx];
+        if (!IsInside(x, y)) {
+            return 0;
+        }
+        const int surface = Height - columnHeights_[x];
+        int gap = 0;
+        if (y < surface) {
+            gap = surface - y - 1;
+        } else {
+            // Tucked under an overhang: walk down to the next filled cell.
+            while (IsEmpty(x, y + gap + 1)) {
+                ++gap;
+            }
+        }
+        distance = std::min(distance, gap);
+    }
+    return distance;
+}
+
+template <int Width, int Height>
+void BasicBoard<Width, Height>::Place(const Tetromino &piece, int originX, int originY) {
     const Cell cell = piece.CellType();
     for (const auto &block : piece.Blocks()) {
         const int x = originX + block.x;
         const int y = originY + block.y;
         if (IsInside(x, y)) {
+            const auto bit = static_cast<RowMask>(RowMask{1} << x);
+            if (cells_[y][x] == Cell::Empty) {
+                ++rowFill_[y];
+                hash_ ^= RowHash<Width, Height>(y, bit);
+            }
             cells_[y][x] = cell;
+            rows_[y] = static_cast<RowMask>(rows_[y] | bit);
+            columnHeights_[x] = std::max(columnHeights_[x], static_cast<std::uint8_t>(Height - y));
         }
     }
 }
 
-int Board::ClearFullLines() {
+template <int Width, int Height>
+int BasicBoard<Width, Height>::ClearFullLines() {
+    return ClearFullLines(0, Height - 1);
+}
+
+template <int Width, int Height>
+int BasicBoard<Width, Height>::ClearFullLines(int firstRow, int lastRow) {
+    firstRow = std::max(firstRow, 0);
+    lastRow = std::min(lastRow, Height - 1);
+    int lowestFull = -1;
+    for (int row = lastRow; row >= firstRow; --row) {
+        if (rowFill_[row] == Width) {
+            lowestFull = row;
+            break;
+        }
+    }
+    if (lowestFull < 0) {
+        return 0;
+    }
+
+    // Rows above the tallest column are already empty and need no shifting.
+    const int stackTop = Height - *std::max_element(columnHeights_.begin(), columnHeights_.end());
     int cleared = 0;
-    int writeRow = kBoardHeight - 1;
+    int writeRow = lowestFull;
+    // Every row from the stack top down to the lowest full row may change.
+    for (int row = stackTop; row <= lowestFull; ++row) {
+        hash_ ^= RowHash<Width, Height>(row, rows_[row]);
+    }
 
-    for (int readRow = kBoardHeight - 1; readRow >= 0; --readRow) {
-        const auto &row = cells_[readRow];
-        const bool full = std::all_of(row.begin(), row.end(), [](Cell cell) { return cell != Cell::Empty; });
-        if (full) {
+    for (int readRow = lowestFull; readRow >= stackTop; --readRow) {
+        if (readRow >= firstRow && rowFill_[readRow] == Width) {
             ++cleared;
             continue;
         }
         if (writeRow != readRow) {
-            cells_[writeRow] = row;
+            cells_[writeRow] = cells_[readRow];
+            rows_[writeRow] = rows_[readRow];
+            rowFill_[writeRow] = rowFill_[readRow];
         }
         --writeRow;
     }
 
-    for (int row = writeRow; row >= 0; --row) {
+    for (int row = writeRow; row >= stackTop; --row) {
         cells_[row].fill(Cell::Empty);
+        rows_[row] = 0;
+        rowFill_[row] = 0;
+    }
+    for (int row = writeRow + 1; row <= lowestFull; ++row) {
+        hash_ ^= RowHash<Width, Height>(row, rows_[row]);
     }
 
+    RebuildColumnHeights();
     return cleared;
 }
 
-const std::array<std::array<Cell, kBoardWidth>, kBoardHeight> &Board::Cells() const {
+template <int Width, int Height>
+void BasicBoard<Width, Height>::SetRow(int y, const Row &row) {
+    if (y < 0 || y >= Height) {
+        return;
+    }
+    RowMask mask = 0;
+    std::uint8_t fill = 0;
+    for (int x = 0; x < Width; ++x) {
+        if (row[x] != Cell::Empty) {
+            mask = static_cast<RowMask>(mask | (RowMask{1} << x));
+            ++fill;
+        }
+    }
+    hash_ ^= RowHash<Width, Height>(y, rows_[y]) ^ RowHash<Width, Height>(y, mask);
+    cells_[y] = row;
+    rows_[y] = mask;
+    rowFill_[y] = fill;
+    RebuildColumnHeights();
+}
+
+template <int Width, int Height>
+void BasicBoard<Width, Height>::SetCells(const CellGrid &cells, const std::array<RowMask, Height> &masks) {
+    cells_ = cells;
+    rows_ = masks;
+    std::uint64_t hash = 0;
+    for (int y = 0; y < Height; ++y) {
+        // A bit count by halves; without -mpopcnt __builtin_popcount is a library call.
+        std::uint64_t count = masks[y] - ((std::uint64_t{masks[y]} >> 1) & 0x5555555555555555ull);
+        count = (count & 0x3333333333333333ull) + ((count >> 2) & 0x3333333333333333ull);
+        count = (count + (count >> 4)) & 0x0f0f0f0f0f0f0f0full;
+        rowFill_[y] = static_cast<std::uint8_t>((count * 0x0101010101010101ull) >> 56);
+        hash ^= RowHash<Width, Height>(y, masks[y]);
+    }
+    hash_ = hash;
+    RebuildColumnHeights();
+}
+
+template <int Width, int Height>
+const typename BasicBoard<Width, Height>::CellGrid &BasicBoard<Width, Height>::Cells() const {
     return cells_;
 }
 
+template <int Width, int Height>
+const std::array<typename BasicBoard<Width, Height>::RowMask, Height> &BasicBoard<Width, Height>::RowMasks() const {
+    return rows_;
+}
+
+template <int Width, int Height>
+const std::array<std::uint8_t, Width> &BasicBoard<Width, Height>::ColumnHeights() const {
+    return columnHeights_;
+}
+
+template <int Width, int Height>
+const std::array<std::uint8_t, Height> &BasicBoard<Width, Height>::RowFillCounts() const {
+    return rowFill_;
+}
+
+template <int Width, int Height>
+std::uint64_t BasicBoard<Width, Height>::Hash() const {
+    return hash_;
+}
+
+template <int Width, int Height>
+std::optional<std::uint64_t> BasicBoard<Width, Height>::HashAfterPlace(const Tetromino &piece, int originX,
+                                                                       int originY) const {
+    const auto &masks = piece.RowMasks();
+    std::uint64_t hash = hash_;
+    for (int dy = 0; dy < static_cast<int>(masks.size()); ++dy) {
+        if (masks[dy] == 0) {
+            continue;
+        }
+        const int y = originY + dy;
+        const auto shifted = (static_cast<Lane<Width>>(masks[dy]) << (originX + kGuardBits)) >> kGuardBits;
+        const auto row = static_cast<RowMask>((rows_[y] | shifted) & kFullRowMask);
+        if (row == kFullRowMask) {
+            return std::nullopt;
+        }
+        hash ^= RowHash<Width, Height>(y, rows_[y]) ^ RowHash<Width, Height>(y, row);
+    }
+    return hash;
+}
+
+template <int Width, int Height>
+void BasicBoard<Width, Height>::RebuildColumnHeights() {
+    columnHeights_.fill(0);
+    RowMask seen = 0;
+    for (int y = 0; y < Height && seen != kFullRowMask; ++y) {
+        // Each column is found once, so this visits Width bits in all.
+        for (std::uint64_t fresh = rows_[y] & ~seen & kFullRowMask; fresh != 0; fresh &= fresh - 1) {
+            columnHeights_[__builtin_ctzll(fresh)] = static_cast<std::uint8_t>(Height - y);
+        }
+        seen = static_cast<RowMask>(seen | rows_[y]);
+    }
+}
+
+template class BasicBoard<10, 20>;
+template class BasicBoard<10, 40>;
+template class BasicBoard<4, 20>;
+template class BasicBoard<16, 24>;
+template class BasicBoard<32, 32>;
+
 } // namespace mctetris::model
@@ -1,29 +1,99 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
 
 #include "tetromino.h"
 
 namespace mctetris::model {
 
+// The standard board, which the front end, bot and tools all play on.
 constexpr int kBoardWidth = 10;
 constexpr int kBoardHeight = 20;
 
-class Board {
+// Occupancy of one row of a `Width`-column board, bit x set when column x is
+// filled: the narrowest of uint16_t, uint32_t and uint64_t that fits.
+template <int Width>
+using RowMaskFor = std::conditional_t<(Width <= 16), std::uint16_t,
+                                      std::conditional_t<(Width <= 32), std::uint32_t, std::uint64_t>>;
+
+// A board with its dimensions fixed at compile time, so every loop over rows
+// or columns has constant bounds. Member definitions live in board.cpp and
+// are instantiated for the sizes listed at the end of this file.
+template <int Width, int Height>
+class BasicBoard {
   public:
-    Board();
+    static constexpr int kWidth = Width;
+    static constexpr int kHeight = Height;
+    using RowMask = RowMaskFor<Width>;
+    using Row = std::array<Cell, Width>;
+    using CellGrid = std::array<Row, Height>;
+    static constexpr RowMask kFullRowMask = static_cast<RowMask>((std::uint64_t{1} << Width) - 1);
+
+    // Pieces are tested in a lane holding the row, 8 guard bits either side
+    // and the 4 columns a piece can hang past the wall.
+    static_assert(Width >= 4 && Width + 12 <= 64, "board width must be between 4 and 52");
+    static_assert(Height >= 4 && Height <= 255, "column heights are stored in a byte");
+
+    BasicBoard();
 
     [[nodiscard]] bool IsInside(int x, int y) const;
     [[nodiscard]] bool IsEmpty(int x, int y) const;
     [[nodiscard]] bool CanPlace(const Tetromino &piece, int originX, int originY) const;
 
+    // Number of rows the piece can fall from the given origin before it rests.
+    [[nodiscard]] int DropDistance(const Tetromino &piece, int originX, int originY) const;
+
     void Place(const Tetromino &piece, int originX, int originY);
     int ClearFullLines();
+    // Only rows in [firstRow, lastRow] are checked for being full; rows above
+    // are shifted down as usual.
+    int ClearFullLines(int firstRow, int lastRow);
+    // Overwrites row `y` outright, e.g. with a row received from a server.
+    void SetRow(int y, const Row &row);
+    // Overwrites every cell, given the occupancy masks that go with them, and
+    // rebuilds the counts, hash and skyline in one pass.
+    void SetCells(const CellGrid &cells, const std::array<RowMask, Height> &masks);
 
-    [[nodiscard]] const std::array<std::array<Cell, kBoardWidth>, kBoardHeight> &Cells() const;
+    [[nodiscard]] const CellGrid &Cells() const;
+    [[nodiscard]] const std::array<RowMask, Height> &RowMasks() const;
+    // Skyline: for each column, Height minus the topmost filled row (0 when empty).
+    [[nodiscard]] const std::array<std::uint8_t, Width> &ColumnHeights() const;
+    [[nodiscard]] const std::array<std::uint8_t, Height> &RowFillCounts() const;
+    // Zobrist hash of which cells are filled (colours are ignored), kept up to
+    // date by Place and ClearFullLines. The empty board hashes to 0.
+    [[nodiscard]] std::uint64_t Hash() const;
+    // Hash the board would have after Place(piece, originX, originY), without
+    // copying it, or nothing if the piece would complete a row.
+    [[nodiscard]] std::optional<std::uint64_t> HashAfterPlace(const Tetromino &piece, int originX, int originY) const;
 
   private:
-    std::array<std::array<Cell, kBoardWidth>, kBoardHeight> cells_{};
+    void RebuildColumnHeights();
+
+    CellGrid cells_{};
+    std::array<RowMask, Height> rows_{};
+    std::array<std::uint8_t, Width> columnHeights_{};
+    std::array<std::uint8_t, Height> rowFill_{};
+    std::uint64_t hash_ = 0;
 };
 
+using Board = BasicBoard<kBoardWidth, kBoardHeight>;
+using RowMask = Board::RowMask;
+constexpr RowMask kFullRowMask = Board::kFullRowMask;
+
+// The other instantiated sizes: 20 hidden rows above a standard field, a
+// narrow board for training, and wide boards for stress tests.
+using TallBoard = BasicBoard<10, 40>;
+using NarrowBoard = BasicBoard<4, 20>;
+using WideBoard = BasicBoard<16, 24>;
+using StressBoard = BasicBoard<32, 32>;
+
+extern template class BasicBoard<10, 20>;
+extern template class BasicBoard<10, 40>;
+extern template class BasicBoard<4, 20>;
+extern template class BasicBoard<16, 24>;
+extern template class BasicBoard<32, 32>;
+
 } // namespace mctetris::model
@@ -1,10 +1,11 @@
+#include <algorithm>
+
 #include "game_model.h"
+#include "trace/trace.h"
 
 namespace mctetris::model {
 namespace {
 
-constexpr int kSpawnX = 3;
-constexpr int kSpawnY = 0;
 constexpr int kLinesPerLevel = 10;
 constexpr int kBaseGravityMs = 1000;
 constexpr int kGravityStepMs = 75;
@@ -31,19 +32,30 @@ int ScoreForLines(int cleared) {
 
 } // namespace
 
-bool GameModel::Spawn(TetrominoType type) {
-    Tetromino piece{type, 0};
-    if (!board_.CanPlace(piece, kSpawnX, kSpawnY)) {
+int LineClearScore(int cleared, int level) {
+    return ScoreForLines(cleared) * (level + 1);
+}
+
+int LevelForLines(int lines) {
+    return lines / kLinesPerLevel;
+}
+
+template <int Width, int Height>
+bool BasicGameModel<Width, Height>::Spawn(TetrominoType type) {
+    MCTETRIS_TRACE_SCOPE("GameModel::Spawn");
+    const ActivePiece spawned = SpawnPosition(type);
+    if (!CanPlaceAt(spawned.piece, spawned.origin)) {
         current_.reset();
         gameOver_ = true;
         return false;
     }
-    current_ = ActivePiece{piece, {kSpawnX, kSpawnY}};
+    current_ = spawned;
     gameOver_ = false;
     return true;
 }
 
-bool GameModel::Move(int dx, int dy) {
+template <int Width, int Height>
+bool BasicGameModel<Width, Height>::Move(int dx, int dy) {
     if (!current_) {
         return false;
     }
@@ -57,7 +69,8 @@ bool GameModel::Move(int dx, int dy) {
     return true;
 }
 
-bool GameModel::RotateCW() {
+template <int Width, int Height>
+bool BasicGameModel<Width, Height>::RotateCW() {
     if (!current_) {
         return false;
     }
@@ -70,7 +83,8 @@ bool GameModel::RotateCW() {
     return true;
 }
 
-bool GameModel::SoftDrop() {
+template <int Width, int Height>
+bool BasicGameModel<Width, Height>::SoftDrop() {
     const bool moved = Move(0, 1);
     if (!moved) {
         LockPiece();
@@ -78,16 +92,17 @@ bool GameModel::SoftDrop() {
     return moved;
 }
 
-void GameModel::HardDrop() {
+template <int Width, int Height>
+void BasicGameModel<Width, Height>::HardDrop() {
     if (!current_) {
         return;
     }
-    while (Move(0, 1)) {
-    }
+    current_->origin.y += board_.DropDistance(current_->piece, current_->origin.x, current_->origin.y);
     LockPiece();
 }
 
-void GameModel::TickGravity() {
+template <int Width, int Height>
+void BasicGameModel<Width, Height>::TickGravity() {
     if (!current_ || gameOver_) {
         return;
     }
@@ -96,55 +111,108 @@ void GameModel::TickGravity() {
     }
 }
 
-bool GameModel::IsGameOver() const {
+template <int Width, int Height>
+bool BasicGameModel<Width, Height>::IsGameOver() const {
     return gameOver_;
 }
 
-int GameModel::Level() const {
+template <int Width, int Height>
+int BasicGameModel<Width, Height>::Level() const {
     return level_;
 }
 
-int GameModel::LinesCleared() const {
+template <int Width, int Height>
+int BasicGameModel<Width, Height>::LinesCleared() const {
     return linesCleared_;
 }
 
-int GameModel::Score() const {
+template <int Width, int Height>
+int BasicGameModel<Width, Height>::Score() const {
     return score_;
 }
 
-int GameModel::GravityDelayMs() const {
+template <int Width, int Height>
+int BasicGameModel<Width, Height>::GravityDelayMs() const {
     const int scaled = kBaseGravityMs - level_ * kGravityStepMs;
     return scaled < kMinGravityMs ? kMinGravityMs : scaled;
 }
 
-const Board &GameModel::GetBoard() const {
+template <int Width, int Height>
+const typename BasicGameModel<Width, Height>::BoardType &BasicGameModel<Width, Height>::GetBoard() const {
     return board_;
 }
 
-const std::optional<ActivePiece> &GameModel::CurrentPiece() const {
+template <int Width, int Height>
+const std::optional<ActivePiece> &BasicGameModel<Width, Height>::CurrentPiece() const {
     return current_;
 }
 
-bool GameModel::CanPlaceAt(const Tetromino &piece, const Point &origin) const {
+template <int Width, int Height>
+std::optional<ActivePiece> BasicGameModel<Width, Height>::GhostPiece() const {
+    if (!current_) {
+        return std::nullopt;
+    }
+    ActivePiece ghost = *current_;
+    ghost.origin.y += board_.DropDistance(ghost.piece, ghost.origin.x, ghost.origin.y);
+    return ghost;
+}
+
+template <int Width, int Height>
+void BasicGameModel<Width, Height>::Restore(const BoardType &board, const std::optional<ActivePiece> &current,
+                                            int linesCleared, int level, int score, bool gameOver) {
+    board_ = board;
+    current_ = current;
+    linesCleared_ = linesCleared;
+    level_ = level;
+    score_ = score;
+    gameOver_ = gameOver;
+}
+
+template <int Width, int Height>
+ActivePiece BasicGameModel<Width, Height>::SpawnPosition(TetrominoType type) {
+    return ActivePiece{Tetromino{type, 0}, {kSpawnX, kSpawnY}};
+}
+
+template <int Width, int Height>
+bool BasicGameModel<Width, Height>::CanPlaceAt(const Tetromino &piece, const Point &origin) const {
     return board_.CanPlace(piece, origin.x, origin.y);
 }
 
-void GameModel::LockPiece() {
+template <int Width, int Height>
+void BasicGameModel<Width, Height>::LockPiece() {
+    MCTETRIS_TRACE_SCOPE("GameModel::LockPiece");
     if (!current_) {
         return;
     }
-    board_.Place(current_->piece, current_->origin.x, current_->origin.y);
+    const auto &masks = current_->piece.RowMasks();
+    int firstRow = static_cast<int>(masks.size());
+    int lastRow = -1;
+    for (int dy = 0; dy < static_cast<int>(masks.size()); ++dy) {
+        if (masks[dy] != 0) {
+            firstRow = std::min(firstRow, dy);
+            lastRow = dy;
+        }
+    }
+    const int originY = current_->origin.y;
+    board_.Place(current_->piece, current_->origin.x, originY);
     current_.reset();
-    const int cleared = board_.ClearFullLines();
+    const int cleared = board_.ClearFullLines(originY + firstRow, originY + lastRow);
     if (cleared > 0) {
-        score_ += ScoreForLines(cleared) * (level_ + 1);
+        score_ += LineClearScore(cleared, level_);
         linesCleared_ += cleared;
         UpdateLevel();
     }
 }
 
-void GameModel::UpdateLevel() {
-    level_ = linesCleared_ / kLinesPerLevel;
+template <int Width, int Height>
+void BasicGameModel<Width, Height>::UpdateLevel() {
+    level_ = LevelForLines(linesCleared_);
 }
 
+template class BasicGameModel<10, 20>;
+template class BasicGameModel<10, 40>;
+template class BasicGameModel<4, 20>;
+template class BasicGameModel<16, 24>;
+template class BasicGameModel<32, 32>;
+
 } // namespace mctetris::model
@@ -7,8 +7,22 @@
 
 namespace mctetris::model {
 
-class GameModel {
+// Points for clearing `cleared` rows with one piece on `level`.
+[[nodiscard]] int LineClearScore(int cleared, int level);
+// Level reached once `lines` rows have been cleared in all.
+[[nodiscard]] int LevelForLines(int lines);
+
+// A game on a BasicBoard<Width, Height>. Pieces spawn centred, in the two
+// rows above the bottom kBoardHeight rows; on a taller board everything
+// higher is the hidden buffer zone that renderers leave out.
+template <int Width, int Height>
+class BasicGameModel {
   public:
+    using BoardType = BasicBoard<Width, Height>;
+    static constexpr int kVisibleRows = Height < kBoardHeight ? Height : kBoardHeight;
+    static constexpr int kSpawnX = (Width - 4) / 2;
+    static constexpr int kSpawnY = Height - kVisibleRows < 2 ? 0 : Height - kVisibleRows - 2;
+
     [[nodiscard]] bool Spawn(TetrominoType type);
     [[nodiscard]] bool Move(int dx, int dy);
     [[nodiscard]] bool RotateCW();
@@ -20,15 +34,22 @@ class GameModel {
     [[nodiscard]] int LinesCleared() const;
     [[nodiscard]] int Score() const;
     [[nodiscard]] int GravityDelayMs() const;
-    [[nodiscard]] const Board &GetBoard() const;
+    [[nodiscard]] const BoardType &GetBoard() const;
     [[nodiscard]] const std::optional<ActivePiece> &CurrentPiece() const;
+    // Where the current piece would come to rest if hard dropped.
+    [[nodiscard]] std::optional<ActivePiece> GhostPiece() const;
+    // Takes on a state built elsewhere, e.g. a server's, wholesale.
+    void Restore(const BoardType &board, const std::optional<ActivePiece> &current, int linesCleared, int level, int score,
+                 bool gameOver);
+    // Where a newly spawned piece of `type` starts.
+    [[nodiscard]] static ActivePiece SpawnPosition(TetrominoType type);
 
   private:
     [[nodiscard]] bool CanPlaceAt(const Tetromino &piece, const Point &origin) const;
     void LockPiece();
     void UpdateLevel();
 
-    Board board_{};
+    BoardType board_{};
     std::optional<ActivePiece> current_{};
     int linesCleared_ = 0;
     int level_ = 0;
@@ -36,4 +57,16 @@ class GameModel {
     bool gameOver_ = false;
 };
 
+using GameModel = BasicGameModel<kBoardWidth, kBoardHeight>;
+using TallGameModel = BasicGameModel<10, 40>;
+using NarrowGameModel = BasicGameModel<4, 20>;
+using WideGameModel = BasicGameModel<16, 24>;
+using StressGameModel = BasicGameModel<32, 32>;
+
+extern template class BasicGameModel<10, 20>;
+extern template class BasicGameModel<10, 40>;
+extern template class BasicGameModel<4, 20>;
+extern template class BasicGameModel<16, 24>;
+extern template class BasicGameModel<32, 32>;
+
 } // namespace mctetris::model
@@ -0,0 +1,67 @@
+#include "game_session.h"
+
+namespace mctetris::model {
+
+GameSession::GameSession(std::uint32_t seed, Randomizer randomizer, int preview)
+    : pieces_(randomizer, seed, preview) {
+    Reset(seed);
+}
+
+void GameSession::Reset(std::uint32_t seed) {
+    Reset(seed, pieces_.Kind());
+}
+
+void GameSession::Reset(std::uint32_t seed, Randomizer randomizer) {
+    model_ = GameModel{};
+    pieces_.Reset(seed, randomizer);
+    seed_ = seed;
+    piecesSpawned_ = 0;
+    nextType_ = pieces_.Peek(0);
+    SpawnIfNeeded();
+}
+
+void GameSession::Restore(const GameModel &model, std::uint32_t seed, Randomizer randomizer, std::uint64_t pieceIndex,
+                          int piecesSpawned) {
+    model_ = model;
+    pieces_.Reset(seed, randomizer);
+    pieces_.Seek(pieceIndex);
+    seed_ = seed;
+    piecesSpawned_ = piecesSpawned;
+    nextType_ = pieces_.Peek(0);
+}
+
+void GameSession::SpawnIfNeeded() {
+    if (model_.CurrentPiece() || model_.IsGameOver()) {
+        return;
+    }
+    if (model_.Spawn(pieces_.Next())) {
+        ++piecesSpawned_;
+    }
+    nextType_ = pieces_.Peek(0);
+}
+
+GameModel &GameSession::Model() {
+    return model_;
+}
+
+const GameModel &GameSession::Model() const {
+    return model_;
+}
+
+const std::optional<TetrominoType> &GameSession::NextType() const {
+    return nextType_;
+}
+
+const PieceGenerator &GameSession::Pieces() const {
+    return pieces_;
+}
+
+std::uint32_t GameSession::Seed() const {
+    return seed_;
+}
+
+int GameSession::PiecesSpawned() const {
+    return piecesSpawned_;
+}
+
+} // namespace mctetris::model
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include "game_model.h"
+#include "piece_generator.h"
+
+namespace mctetris::model {
+
+// A single game plus the piece sequence that feeds it. Shared by the
+// interactive front end and the headless tools so they spawn identically.
+class GameSession {
+  public:
+    explicit GameSession(std::uint32_t seed = 0, Randomizer randomizer = Randomizer::Bag7, int preview = 1);
+
+    // Starts a fresh game with the first piece spawned and the next queued,
+    // keeping the current randomizer unless one is given.
+    void Reset(std::uint32_t seed);
+    void Reset(std::uint32_t seed, Randomizer randomizer);
+    // Takes on a game saved elsewhere: its model, and the piece sequence
+    // positioned at `pieceIndex`. The preview length is kept.
+    void Restore(const GameModel &model, std::uint32_t seed, Randomizer randomizer, std::uint64_t pieceIndex,
+                 int piecesSpawned);
+    // Spawns the queued piece once the previous one has locked.
+    void SpawnIfNeeded();
+
+    [[nodiscard]] GameModel &Model();
+    [[nodiscard]] const GameModel &Model() const;
+    [[nodiscard]] const std::optional<TetrominoType> &NextType() const;
+    // The full look-ahead queue; Pieces().Peek(0) is NextType().
+    [[nodiscard]] const PieceGenerator &Pieces() const;
+    [[nodiscard]] std::uint32_t Seed() const;
+    [[nodiscard]] int PiecesSpawned() const;
+
+  private:
+    GameModel model_{};
+    PieceGenerator pieces_;
+    std::optional<TetrominoType> nextType_{};
+    std::uint32_t seed_ = 0;
+    int piecesSpawned_ = 0;
+};
+
+} // namespace mctetris::model
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <utility>
+
+#include "piece_generator.h"
+
+namespace mctetris::model {
+namespace {
+
+// Start the history as if S and Z had just been dealt, so the first piece is
+// unlikely to be either.
+constexpr std::uint32_t kInitialHistory = static_cast<std::uint32_t>(TetrominoType::S) << 24 |
+                                          static_cast<std::uint32_t>(TetrominoType::Z) << 16 |
+                                          static_cast<std::uint32_t>(TetrominoType::S) << 8 |
+                                          static_cast<std::uint32_t>(TetrominoType::Z);
+// Counters per piece (or per bag) so the rolls of neighbouring indices never overlap.
+constexpr std::uint64_t kDrawsPerIndex = 8;
+
+bool InHistory(std::uint32_t history, std::uint32_t type) {
+    for (int i = 0; i < 4; ++i) {
+        if (((history >> (8 * i)) & 0xff) == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+const char *RandomizerName(Randomizer randomizer) {
+    switch (randomizer) {
+    case Randomizer::Bag7:
+        return "bag";
+    case Randomizer::Uniform:
+        return "uniform";
+    case Randomizer::History:
+        return "history";
+    }
+    return "bag";
+}
+
+std::optional<Randomizer> ParseRandomizer(const std::string &name) {
+    for (const auto randomizer : {Randomizer::Bag7, Randomizer::Uniform, Randomizer::History}) {
+        if (name == RandomizerName(randomizer)) {
+            return randomizer;
+        }
+    }
+    return std::nullopt;
+}
+
+PieceGenerator::PieceGenerator(Randomizer randomizer, std::uint64_t seed, int preview)
+    : randomizer_(randomizer), preview_(std::clamp(preview, 1, kMaxPreview)) {
+    Reset(seed);
+}
+
+void PieceGenerator::Reset(std::uint64_t seed) {
+    seed_ = seed;
+    rng_ = CounterRng(CounterRng::StreamKey(seed, 0));
+    bagNumber_ = ~std::uint64_t{0};
+    Refill(0);
+}
+
+void PieceGenerator::Reset(std::uint64_t seed, Randomizer randomizer) {
+    randomizer_ = randomizer;
+    Reset(seed);
+}
+
+TetrominoType PieceGenerator::Next() {
+    const TetrominoType type = queue_[head_];
+    queue_[head_] = Generate();
+    head_ = head_ + 1 == preview_ ? 0 : head_ + 1;
+    ++index_;
+    return type;
+}
+
+void PieceGenerator::Seek(std::uint64_t index) {
+    Refill(index);
+}
+
+TetrominoType PieceGenerator::Peek(int ahead) const {
+    const int slot = head_ + ahead;
+    return queue_[slot < preview_ ? slot : slot - preview_];
+}
+
+int PieceGenerator::Preview() const {
+    return preview_;
+}
+
+std::uint64_t PieceGenerator::Index() const {
+    return index_;
+}
+
+Randomizer PieceGenerator::Kind() const {
+    return randomizer_;
+}
+
+std::uint64_t PieceGenerator::Seed() const {
+    return seed_;
+}
+
+TetrominoType PieceGenerator::Generate() {
+    const std::uint64_t index = generated_++;
+    switch (randomizer_) {
+    case Randomizer::Bag7:
+        return FromBag(index);
+    case Randomizer::Uniform:
+        return static_cast<TetrominoType>(rng_.Below(index, kTetrominoTypeCount));
+    case Randomizer::History:
+        return FromHistory(index);
+    }
+    return TetrominoType::I;
+}
+
+TetrominoType PieceGenerator::FromBag(std::uint64_t index) {
+    const std::uint64_t bag = index / kTetrominoTypeCount;
+    if (bag != bagNumber_) {
+        // Fisher-Yates with one counter per swap, so a bag is shuffled from
+        // its number alone.
+        for (int i = 0; i < kTetrominoTypeCount; ++i) {
+            bag_[i] = static_cast<TetrominoType>(i);
+        }
+        for (int i = kTetrominoTypeCount - 1; i > 0; --i) {
+            const auto j = rng_.Below(bag * kDrawsPerIndex + static_cast<std::uint64_t>(i),
+                                      static_cast<std::uint32_t>(i + 1));
+            std::swap(bag_[i], bag_[j]);
+        }
+        bagNumber_ = bag;
+    }
+    return bag_[index % kTetrominoTypeCount];
+}
+
+TetrominoType PieceGenerator::FromHistory(std::uint64_t index) {
+    std::uint32_t type = 0;
+    for (int roll = 0; roll < kHistoryRolls; ++roll) {
+        type = rng_.Below(index * kDrawsPerIndex + static_cast<std::uint64_t>(roll), kTetrominoTypeCount);
+        if (!InHistory(history_, type)) {
+            break;
+        }
+    }
+    history_ = history_ << 8 | type;
+    return static_cast<TetrominoType>(type);
+}
+
+void PieceGenerator::Refill(std::uint64_t index) {
+    if (randomizer_ == Randomizer::History) {
+        // Each piece depends on the ones before it, so replay from the start.
+        history_ = kInitialHistory;
+        generated_ = 0;
+        while (generated_ < index) {
+            (void)Generate();
+        }
+    } else {
+        generated_ = index;
+    }
+    head_ = 0;
+    index_ = index;
+    for (int i = 0; i < preview_; ++i) {
+        queue_[i] = Generate();
+    }
+}
+
+} // namespace mctetris::model
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "tetromino.h"
+
+namespace mctetris::model {
+
+constexpr int kTetrominoTypeCount = 7;
+
+// Counter-based generator: value i is a pure hash of (key, i), so any
+// position in the stream costs one call and streams never share state.
+class CounterRng {
+  public:
+    constexpr explicit CounterRng(std::uint64_t key = 0) : key_(key) {}
+
+    [[nodiscard]] constexpr std::uint64_t At(std::uint64_t counter) const {
+        return Mix(key_ + counter * 0x9e3779b97f4a7c15ull);
+    }
+    // Uniform in [0, bound) by multiply-shift; the bias is below 2^-32.
+    [[nodiscard]] constexpr std::uint32_t Below(std::uint64_t counter, std::uint32_t bound) const {
+        return static_cast<std::uint32_t>(((At(counter) >> 32) * bound) >> 32);
+    }
+    // Key of independent stream `stream` derived from one seed, for handing
+    // each worker or game its own sequence.
+    [[nodiscard]] static constexpr std::uint64_t StreamKey(std::uint64_t seed, std::uint64_t stream) {
+        return Mix(Mix(seed) ^ Mix(~stream));
+    }
+
+  private:
+    static constexpr std::uint64_t Mix(std::uint64_t value) {
+        value += 0x9e3779b97f4a7c15ull;
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+        return value ^ (value >> 31);
+    }
+
+    std::uint64_t key_;
+};
+
+enum class Randomizer : std::uint8_t {
+    // Each run of seven pieces is a shuffled set of all seven.
+    Bag7,
+    // Every piece independent and equally likely.
+    Uniform,
+    // Rerolls up to kHistoryRolls times against the last four pieces.
+    History
+};
+
+[[nodiscard]] const char *RandomizerName(Randomizer randomizer);
+[[nodiscard]] std::optional<Randomizer> ParseRandomizer(const std::string &name);
+
+// Produces the piece sequence for one game and keeps a look-ahead queue of up
+// to kMaxPreview pieces. Piece i depends only on (randomizer, seed, i), so a
+// sequence can be reproduced from any index: Seek is O(1) for Bag7 and
+// Uniform, while History has to replay its rerolls from the start.
+class PieceGenerator {
+  public:
+    static constexpr int kMaxPreview = 7;
+    static constexpr int kHistoryRolls = 6;
+
+    explicit PieceGenerator(Randomizer randomizer = Randomizer::Bag7, std::uint64_t seed = 0, int preview = 1);
+
+    void Reset(std::uint64_t seed);
+    void Reset(std::uint64_t seed, Randomizer randomizer);
+    // Takes the front of the queue and tops the queue back up.
+    TetrominoType Next();
+    // Moves so the next piece returned is piece `index`.
+    void Seek(std::uint64_t index);
+
+    // Queued piece `ahead` places from the front; ahead < Preview().
+    [[nodiscard]] TetrominoType Peek(int ahead) const;
+    [[nodiscard]] int Preview() const;
+    // Index of the piece Next() returns.
+    [[nodiscard]] std::uint64_t Index() const;
+    [[nodiscard]] Randomizer Kind() const;
+    [[nodiscard]] std::uint64_t Seed() const;
+
+  private:
+    [[nodiscard]] TetrominoType Generate();
+    [[nodiscard]] TetrominoType FromBag(std::uint64_t index);
+    [[nodiscard]] TetrominoType FromHistory(std::uint64_t index);
+    void Refill(std::uint64_t index);
+
+    Randomizer randomizer_;
+    std::uint64_t seed_ = 0;
+    CounterRng rng_{};
+    int preview_ = 1;
+    std::array<TetrominoType, kMaxPreview> queue_{};
+    int head_ = 0;
+    std::uint64_t index_ = 0;
+    // Index of the piece Generate() makes next.
+    std::uint64_t generated_ = 0;
+    std::uint64_t bagNumber_ = ~std::uint64_t{0};
+    std::array<TetrominoType, kTetrominoTypeCount> bag_{};
+    // Last four pieces, newest in the low byte.
+    std::uint32_t history_ = 0;
+};
+
+} // namespace mctetris::model
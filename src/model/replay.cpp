@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#include "replay.h"
+
+namespace mctetris::model {
+namespace {
+
+constexpr std::uint8_t kMagic[4] = {'M', 'C', 'T', 'R'};
+constexpr std::uint8_t kVersion = 2;
+constexpr int kActionBits = 3;
+constexpr std::uint8_t kLastAction = static_cast<std::uint8_t>(ReplayAction::Gravity);
+constexpr std::uint8_t kLastRandomizer = static_cast<std::uint8_t>(Randomizer::History);
+
+void PutVarint(std::vector<std::uint8_t> &out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+void PutFixed(std::vector<std::uint8_t> &out, std::uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+    }
+}
+
+class Reader {
+  public:
+    Reader(const std::uint8_t *data, std::size_t size) : data_(data), size_(size) {}
+
+    std::optional<std::uint64_t> Varint() {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos_ >= size_) {
+                return std::nullopt;
+            }
+            const std::uint8_t byte = data_[pos_++];
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<std::uint64_t> Fixed(int bytes) {
+        if (size_ - pos_ < static_cast<std::size_t>(bytes)) {
+            return std::nullopt;
+        }
+        std::uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i) {
+            value |= static_cast<std::uint64_t>(data_[pos_++]) << (8 * i);
+        }
+        return value;
+    }
+
+    [[nodiscard]] bool AtEnd() const {
+        return pos_ == size_;
+    }
+
+  private:
+    const std::uint8_t *data_;
+    std::size_t size_;
+    std::size_t pos_ = 0;
+};
+
+} // namespace
+
+bool ApplyReplayAction(GameSession &session, ReplayAction action) {
+    GameModel &model = session.Model();
+    bool changed = true;
+    switch (action) {
+    case ReplayAction::MoveLeft:
+        changed = model.Move(-1, 0);
+        break;
+    case ReplayAction::MoveRight:
+        changed = model.Move(1, 0);
+        break;
+    case ReplayAction::RotateCW:
+        changed = model.RotateCW();
+        break;
+    case ReplayAction::SoftDrop:
+        changed = model.CurrentPiece().has_value();
+        (void)model.SoftDrop();
+        break;
+    case ReplayAction::HardDrop:
+        changed = model.CurrentPiece().has_value();
+        model.HardDrop();
+        break;
+    case ReplayAction::Gravity:
+        changed = model.CurrentPiece().has_value() && !model.IsGameOver();
+        model.TickGravity();
+        break;
+    }
+    session.SpawnIfNeeded();
+    return changed;
+}
+
+std::uint64_t BoardHash(const Board &board) {
+    std::uint64_t hash = 1469598103934665603ull;
+    for (const auto &row : board.Cells()) {
+        for (Cell cell : row) {
+            hash ^= static_cast<std::uint64_t>(cell);
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+ReplayOutcome Summarize(const GameSession &session) {
+    const GameModel &model = session.Model();
+    ReplayOutcome outcome;
+    outcome.score = model.Score();
+    outcome.lines = model.LinesCleared();
+    outcome.level = model.Level();
+    outcome.pieces = session.PiecesSpawned();
+    outcome.boardHash = BoardHash(model.GetBoard());
+    return outcome;
+}
+
+ReplayOutcome RunReplay(const Replay &replay, GameSession &session) {
+    session.Reset(replay.seed, replay.randomizer);
+    for (const auto &event : replay.events) {
+        (void)ApplyReplayAction(session, event.action);
+    }
+    return Summarize(session);
+}
+
+std::vector<std::uint8_t> EncodeReplay(const Replay &replay) {
+    std::vector<std::uint8_t> out;
+    out.reserve(32 + replay.events.size() * 2);
+    for (const std::uint8_t byte : kMagic) {
+        out.push_back(byte);
+    }
+    out.push_back(kVersion);
+    out.push_back(static_cast<std::uint8_t>(replay.randomizer));
+    PutFixed(out, replay.seed, 4);
+    PutVarint(out, replay.events.size());
+    std::uint32_t lastTime = 0;
+    for (const auto &event : replay.events) {
+        const std::uint64_t delta = event.timeMs >= lastTime ? event.timeMs - lastTime : 0;
+        PutVarint(out, (delta << kActionBits) | static_cast<std::uint8_t>(event.action));
+        lastTime = std::max(lastTime, event.timeMs);
+    }
+    PutVarint(out, static_cast<std::uint32_t>(replay.outcome.score));
+    PutVarint(out, static_cast<std::uint32_t>(replay.outcome.lines));
+    PutVarint(out, static_cast<std::uint32_t>(replay.outcome.level));
+    PutVarint(out, static_cast<std::uint32_t>(replay.outcome.pieces));
+    PutFixed(out, replay.outcome.boardHash, 8);
+    return out;
+}
+
+std::optional<Replay> DecodeReplay(const std::uint8_t *data, std::size_t size) {
+    if (size < sizeof(kMagic) + 1 || !std::equal(std::begin(kMagic), std::end(kMagic), data) ||
+        data[sizeof(kMagic)] != kVersion) {
+        return std::nullopt;
+    }
+    Reader reader(data + sizeof(kMagic) + 1, size - sizeof(kMagic) - 1);
+    Replay replay;
+    const auto randomizer = reader.Fixed(1);
+    const auto seed = reader.Fixed(4);
+    const auto count = reader.Varint();
+    // Every event takes at least one byte, which bounds a corrupt count.
+    if (!randomizer || *randomizer > kLastRandomizer || !seed || !count || *count > size) {
+        return std::nullopt;
+    }
+    replay.randomizer = static_cast<Randomizer>(*randomizer);
+    replay.seed = static_cast<std::uint32_t>(*seed);
+    replay.events.reserve(static_cast<std::size_t>(*count));
+    std::uint64_t time = 0;
+    for (std::uint64_t i = 0; i < *count; ++i) {
+        const auto packed = reader.Varint();
+        if (!packed || (*packed & ((1u << kActionBits) - 1)) > kLastAction) {
+            return std::nullopt;
+        }
+        time += *packed >> kActionBits;
+        replay.events.push_back(ReplayEvent{static_cast<std::uint32_t>(time),
+                                            static_cast<ReplayAction>(*packed & ((1u << kActionBits) - 1))});
+    }
+    const auto score = reader.Varint();
+    const auto lines = reader.Varint();
+    const auto level = reader.Varint();
+    const auto pieces = reader.Varint();
+    const auto hash = reader.Fixed(8);
+    if (!score || !lines || !level || !pieces || !hash || !reader.AtEnd()) {
+        return std::nullopt;
+    }
+    replay.outcome.score = static_cast<std::int32_t>(*score);
+    replay.outcome.lines = static_cast<std::int32_t>(*lines);
+    replay.outcome.level = static_cast<std::int32_t>(*level);
+    replay.outcome.pieces = static_cast<std::int32_t>(*pieces);
+    replay.outcome.boardHash = *hash;
+    return replay;
+}
+
+bool SaveReplay(const std::string &path, const Replay &replay) {
+    const auto bytes = EncodeReplay(replay);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(out);
+}
+
+std::optional<Replay> LoadReplay(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return std::nullopt;
+    }
+    const std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return DecodeReplay(bytes.data(), bytes.size());
+}
+
+void ReplayRecorder::Begin(std::uint32_t seed, Randomizer randomizer) {
+    replay_ = Replay{};
+    replay_.seed = seed;
+    replay_.randomizer = randomizer;
+}
+
+void ReplayRecorder::Resume(Replay replay) {
+    replay_ = std::move(replay);
+    replay_.outcome = ReplayOutcome{};
+}
+
+void ReplayRecorder::Record(ReplayAction action, std::uint32_t timeMs) {
+    replay_.events.push_back(ReplayEvent{timeMs, action});
+}
+
+void ReplayRecorder::Finish(const GameSession &session) {
+    replay_.outcome = Summarize(session);
+}
+
+const Replay &ReplayRecorder::Current() const {
+    return replay_;
+}
+
+} // namespace mctetris::model
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "game_session.h"
+
+namespace mctetris::model {
+
+enum class ReplayAction : std::uint8_t {
+    MoveLeft,
+    MoveRight,
+    RotateCW,
+    SoftDrop,
+    HardDrop,
+    Gravity
+};
+
+struct ReplayEvent {
+    // Milliseconds since the game started.
+    std::uint32_t timeMs = 0;
+    ReplayAction action = ReplayAction::Gravity;
+};
+
+// End-of-game state a replay must reproduce.
+struct ReplayOutcome {
+    std::int32_t score = 0;
+    std::int32_t lines = 0;
+    std::int32_t level = 0;
+    std::int32_t pieces = 0;
+    std::uint64_t boardHash = 0;
+
+    friend bool operator==(const ReplayOutcome &lhs, const ReplayOutcome &rhs) {
+        return lhs.score == rhs.score && lhs.lines == rhs.lines && lhs.level == rhs.level &&
+               lhs.pieces == rhs.pieces && lhs.boardHash == rhs.boardHash;
+    }
+    friend bool operator!=(const ReplayOutcome &lhs, const ReplayOutcome &rhs) {
+        return !(lhs == rhs);
+    }
+};
+
+struct Replay {
+    std::uint32_t seed = 0;
+    Randomizer randomizer = Randomizer::Bag7;
+    std::vector<ReplayEvent> events;
+    ReplayOutcome outcome{};
+};
+
+// Applies one action to the session exactly as the front end does, including
+// spawning the next piece. Returns true if the model changed, which is when
+// an action is worth recording.
+bool ApplyReplayAction(GameSession &session, ReplayAction action);
+
+// FNV-1a over every cell, colour included.
+[[nodiscard]] std::uint64_t BoardHash(const Board &board);
+[[nodiscard]] ReplayOutcome Summarize(const GameSession &session);
+
+// Re-executes `replay` from its seed as fast as possible.
+[[nodiscard]] ReplayOutcome RunReplay(const Replay &replay, GameSession &session);
+
+// Binary format: "MCTR", version, randomizer, seed, then one LEB128 varint per event
+// holding (time delta << 3 | action), then the outcome. Most events take two
+// bytes.
+[[nodiscard]] std::vector<std::uint8_t> EncodeReplay(const Replay &replay);
+[[nodiscard]] std::optional<Replay> DecodeReplay(const std::uint8_t *data, std::size_t size);
+[[nodiscard]] bool SaveReplay(const std::string &path, const Replay &replay);
+[[nodiscard]] std::optional<Replay> LoadReplay(const std::string &path);
+
+// Captures a game as it is played.
+class ReplayRecorder {
+  public:
+    void Begin(std::uint32_t seed, Randomizer randomizer);
+    // Carries on with a recording saved part way through a game.
+    void Resume(Replay replay);
+    void Record(ReplayAction action, std::uint32_t timeMs);
+    void Finish(const GameSession &session);
+    [[nodiscard]] const Replay &Current() const;
+
+  private:
+    Replay replay_{};
+};
+
+} // namespace mctetris::model
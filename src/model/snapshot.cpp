@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "snapshot.h"
+
+namespace mctetris::model {
+namespace {
+
+constexpr std::uint8_t kSaveMagic[4] = {'M', 'C', 'S', 'G'};
+constexpr std::size_t kHeaderBytes = 16;
+constexpr int kCellBits = 3;
+constexpr int kRowBits = kBoardWidth * kCellBits;
+// Rows go in pairs: 60 bits, so every pair starts on a whole or half byte.
+constexpr int kPairBits = 2 * kRowBits;
+constexpr std::uint64_t kPairBitMask = (std::uint64_t{1} << kPairBits) - 1;
+constexpr std::uint32_t kRowBitMask = (1u << kRowBits) - 1;
+constexpr std::uint8_t kHasPiece = 1u << 0;
+constexpr std::uint8_t kGameOver = 1u << 1;
+constexpr int kTypeShift = 2;
+constexpr int kRotationShift = 5;
+constexpr std::uint8_t kLastType = static_cast<std::uint8_t>(TetrominoType::L);
+constexpr std::uint8_t kLastRandomizer = static_cast<std::uint8_t>(Randomizer::History);
+
+static_assert(kBoardWidth == 10 && kBoardHeight % 2 == 0 && kPairBits + 4 <= 64,
+              "the row packing assumes ten-cell rows taken two at a time");
+static_assert(kHeaderBytes + (kBoardHeight * kRowBits + 7) / 8 == kSnapshotBytes);
+
+void Put(std::uint8_t *out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+}
+
+std::uint32_t Get(const std::uint8_t *in) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<std::uint32_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+// Eight bytes as a little-endian word, whatever the host. A single load:
+// GCC does not merge a loop of byte loads into one here.
+std::uint64_t Load64(const void *in) {
+    std::uint64_t value;
+    std::memcpy(&value, in, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+void Store64(void *out, std::uint64_t value) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    std::memcpy(out, &value, sizeof(value));
+}
+
+// Squeezes the eight byte-wide cells together a halving at a time, then
+// appends the last two.
+std::uint32_t PackRow(const std::array<Cell, kBoardWidth> &row) {
+    // Cells 0-7 as the bytes of one word, cell 0 lowest.
+    std::uint64_t bits = Load64(row.data());
+    bits = (bits | bits >> 5) & 0x003f003f003f003full;
+    bits = (bits | bits >> 10) & 0x00000fff00000fffull;
+    bits = (bits | bits >> 20) & 0xffffffull;
+    return static_cast<std::uint32_t>(bits) | static_cast<std::uint32_t>(row[8]) << 24 |
+           static_cast<std::uint32_t>(row[9]) << 27;
+}
+
+// The reverse of PackRow; also returns the row's occupancy mask.
+RowMask UnpackRow(std::uint32_t packed, std::array<Cell, kBoardWidth> &row) {
+    std::uint64_t bits = packed & 0xffffffu;
+    bits = (bits | bits << 20) & 0x00000fff00000fffull;
+    bits = (bits | bits << 10) & 0x003f003f003f003full;
+    bits = (bits | bits << 5) & 0x0707070707070707ull;
+    Store64(row.data(), bits);
+    row[8] = static_cast<Cell>((packed >> 24) & 7);
+    row[9] = static_cast<Cell>((packed >> 27) & 7);
+    // Low bit of each byte set for a filled cell, then gathered into the top byte.
+    const std::uint64_t filled = (bits | bits >> 1 | bits >> 2) & 0x0101010101010101ull;
+    return static_cast<RowMask>((filled * 0x0102040810204080ull) >> 56 | (row[8] != Cell::Empty ? 1u << 8 : 0u) |
+                                (row[9] != Cell::Empty ? 1u << 9 : 0u));
+}
+
+} // namespace
+
+std::size_t EncodeSnapshot(const GameModel &model, std::uint8_t *out) {
+    const auto &piece = model.CurrentPiece();
+    std::uint8_t flags = model.IsGameOver() ? kGameOver : 0;
+    std::int8_t x = 0;
+    std::int8_t y = 0;
+    if (piece) {
+        flags |= kHasPiece;
+        flags |= static_cast<std::uint8_t>(static_cast<std::uint8_t>(piece->piece.type) << kTypeShift);
+        flags |= static_cast<std::uint8_t>((piece->piece.rotation & 3) << kRotationShift);
+        x = static_cast<std::int8_t>(piece->origin.x);
+        y = static_cast<std::int8_t>(piece->origin.y);
+    }
+    out[0] = kSnapshotVersion;
+    out[1] = flags;
+    out[2] = static_cast<std::uint8_t>(x);
+    out[3] = static_cast<std::uint8_t>(y);
+    Put(out + 4, static_cast<std::uint32_t>(model.Score()));
+    Put(out + 8, static_cast<std::uint32_t>(model.LinesCleared()));
+    Put(out + 12, static_cast<std::uint32_t>(model.Level()));
+
+    // Each pair of rows is one 8-byte store; a pair starting mid-byte keeps
+    // the low half of that byte, which the previous pair wrote.
+    const auto &cells = model.GetBoard().Cells();
+    std::uint8_t *packed = out + kHeaderBytes;
+    for (int pair = 0; pair < kBoardHeight / 2; ++pair) {
+        const int bit = pair * kPairBits;
+        std::uint8_t *at = packed + bit / 8;
+        std::uint64_t word = (PackRow(cells[2 * pair]) | static_cast<std::uint64_t>(PackRow(cells[2 * pair + 1]))
+                                                             << kRowBits)
+                             << (bit % 8);
+        if (bit % 8 != 0) {
+            word |= *at & 0x0fu;
+        }
+        Store64(at, word);
+    }
+    return kSnapshotBytes;
+}
+
+bool DecodeSnapshot(const std::uint8_t *data, std::size_t size, GameModel &model) {
+    if (size < kSnapshotBytes || data[0] != kSnapshotVersion) {
+        return false;
+    }
+    const std::uint8_t flags = data[1];
+    std::optional<ActivePiece> piece;
+    if ((flags & kHasPiece) != 0) {
+        const auto type = static_cast<std::uint8_t>((flags >> kTypeShift) & 7);
+        if (type > kLastType) {
+            return false;
+        }
+        piece = ActivePiece{Tetromino{static_cast<TetrominoType>(type), (flags >> kRotationShift) & 3},
+                            Point{static_cast<std::int8_t>(data[2]), static_cast<std::int8_t>(data[3])}};
+    }
+
+    // Every 3-bit value is a valid Cell, so the cells need no checking.
+    std::array<std::array<Cell, kBoardWidth>, kBoardHeight> cells;
+    std::array<RowMask, kBoardHeight> masks;
+    const std::uint8_t *packed = data + kHeaderBytes;
+    for (int pair = 0; pair < kBoardHeight / 2; ++pair) {
+        const int bit = pair * kPairBits;
+        const std::uint64_t word = (Load64(packed + bit / 8) >> (bit % 8)) & kPairBitMask;
+        masks[2 * pair] = UnpackRow(static_cast<std::uint32_t>(word) & kRowBitMask, cells[2 * pair]);
+        masks[2 * pair + 1] = UnpackRow(static_cast<std::uint32_t>(word >> kRowBits), cells[2 * pair + 1]);
+    }
+    Board board;
+    board.SetCells(cells, masks);
+    if (piece && !board.CanPlace(piece->piece, piece->origin.x, piece->origin.y)) {
+        return false;
+    }
+    model.Restore(board, piece, static_cast<std::int32_t>(Get(data + 8)), static_cast<std::int32_t>(Get(data + 12)),
+                  static_cast<std::int32_t>(Get(data + 4)), (flags & kGameOver) != 0);
+    return true;
+}
+
+std::size_t EncodeSessionSnapshot(const GameSession &session, std::uint8_t *out) {
+    std::uint8_t *at = out + EncodeSnapshot(session.Model(), out);
+    at[0] = static_cast<std::uint8_t>(session.Pieces().Kind());
+    Put(at + 1, session.Seed());
+    Put(at + 5, static_cast<std::uint32_t>(session.Pieces().Index()));
+    Put(at + 9, static_cast<std::uint32_t>(session.PiecesSpawned()));
+    return kSessionSnapshotBytes;
+}
+
+bool DecodeSessionSnapshot(const std::uint8_t *data, std::size_t size, GameSession &session) {
+    GameModel model;
+    if (size < kSessionSnapshotBytes || !DecodeSnapshot(data, size, model)) {
+        return false;
+    }
+    const std::uint8_t *at = data + kSnapshotBytes;
+    if (at[0] > kLastRandomizer) {
+        return false;
+    }
+    session.Restore(model, Get(at + 1), static_cast<Randomizer>(at[0]), Get(at + 5),
+                    static_cast<int>(Get(at + 9)));
+    return true;
+}
+
+bool SaveGame(const std::string &path, const GameSession &session, const Replay &recording) {
+    std::uint8_t snapshot[kSessionSnapshotBytes];
+    (void)EncodeSessionSnapshot(session, snapshot);
+    const auto replay = EncodeReplay(recording);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(kSaveMagic), sizeof(kSaveMagic));
+    out.write(reinterpret_cast<const char *>(snapshot), sizeof(snapshot));
+    out.write(reinterpret_cast<const char *>(replay.data()), static_cast<std::streamsize>(replay.size()));
+    return static_cast<bool>(out);
+}
+
+bool LoadGame(const std::string &path, GameSession &session, Replay &recording) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    const std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    constexpr std::size_t kReplayStart = sizeof(kSaveMagic) + kSessionSnapshotBytes;
+    if (bytes.size() < kReplayStart || !std::equal(std::begin(kSaveMagic), std::end(kSaveMagic), bytes.begin())) {
+        return false;
+    }
+    auto replay = DecodeReplay(bytes.data() + kReplayStart, bytes.size() - kReplayStart);
+    GameSession saved = session;
+    if (!replay || !DecodeSessionSnapshot(bytes.data() + sizeof(kSaveMagic), kSessionSnapshotBytes, saved) ||
+        replay->seed != saved.Seed() || replay->randomizer != saved.Pieces().Kind()) {
+        return false;
+    }
+    session = std::move(saved);
+    recording = std::move(*replay);
+    return true;
+}
+
+} // namespace mctetris::model
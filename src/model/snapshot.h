@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "game_model.h"
+#include "game_session.h"
+#include "replay.h"
+
+namespace mctetris::model {
+
+// Fixed-size, versioned snapshots of a game. Every board cell takes 3 bits,
+// so a whole GameModel fits in kSnapshotBytes and a batch of them is just
+// an array of records. Encoding and decoding work in the caller's buffers
+// and never allocate.
+//
+// Layout: version; a flags byte (has piece, game over, piece type, rotation);
+// the piece origin as two signed bytes; score, lines and level as
+// little-endian u32; then the cells, row by row, 3 bits each from the low
+// bit up.
+constexpr std::uint8_t kSnapshotVersion = 1;
+constexpr std::size_t kSnapshotBytes = 16 + (kBoardWidth * kBoardHeight * 3 + 7) / 8;
+// A session adds its randomizer, seed, piece index and pieces spawned.
+constexpr std::size_t kSessionSnapshotBytes = kSnapshotBytes + 13;
+
+// Writes exactly kSnapshotBytes to `out` and returns that.
+std::size_t EncodeSnapshot(const GameModel &model, std::uint8_t *out);
+// Reads kSnapshotBytes from `data`. Fails on a short buffer, another
+// version or a piece that overlaps the board, leaving `model` untouched.
+[[nodiscard]] bool DecodeSnapshot(const std::uint8_t *data, std::size_t size, GameModel &model);
+
+// As above for a whole session, so the game resumes with the same pieces.
+std::size_t EncodeSessionSnapshot(const GameSession &session, std::uint8_t *out);
+[[nodiscard]] bool DecodeSessionSnapshot(const std::uint8_t *data, std::size_t size, GameSession &session);
+
+// A game saved on quit: "MCSG", the session snapshot, then the recording so
+// far, so a resumed game still replays from its seed.
+[[nodiscard]] bool SaveGame(const std::string &path, const GameSession &session, const Replay &recording);
+[[nodiscard]] bool LoadGame(const std::string &path, GameSession &session, Replay &recording);
+
+} // namespace mctetris::model
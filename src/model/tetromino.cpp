@@ -72,6 +72,28 @@ constexpr const std::array<std::array<Point, 4>, 4> &ShapeFor(TetrominoType type
     return kI;
 }
 
+constexpr PieceRowMasks MasksFor(const std::array<Point, 4> &blocks) {
+    PieceRowMasks masks{};
+    for (const auto &block : blocks) {
+        masks[block.y] = static_cast<std::uint16_t>(masks[block.y] | (1u << block.x));
+    }
+    return masks;
+}
+
+constexpr std::array<PieceRowMasks, 4> MasksForShape(const std::array<std::array<Point, 4>, 4> &shape) {
+    return {MasksFor(shape[0]), MasksFor(shape[1]), MasksFor(shape[2]), MasksFor(shape[3])};
+}
+
+constexpr std::array<std::array<PieceRowMasks, 4>, 7> kRowMasks = {{
+    MasksForShape(kI),
+    MasksForShape(kO),
+    MasksForShape(kT),
+    MasksForShape(kS),
+    MasksForShape(kZ),
+    MasksForShape(kJ),
+    MasksForShape(kL),
+}};
+
 } // namespace
 
 std::array<Point, 4> Tetromino::Blocks() const {
@@ -79,6 +101,10 @@ std::array<Point, 4> Tetromino::Blocks() const {
     return shape[rotation % 4];
 }
 
+const PieceRowMasks &Tetromino::RowMasks() const {
+    return kRowMasks[static_cast<std::size_t>(type)][rotation % 4];
+}
+
 Cell Tetromino::CellType() const {
     switch (type) {
     case TetrominoType::I:
@@ -28,11 +28,16 @@ enum class TetrominoType : std::uint8_t {
     L
 };
 
+// One bit per column (bit 0 = x offset 0) for each of the four rows of the
+// piece's 4x4 bounding box.
+using PieceRowMasks = std::array<std::uint16_t, 4>;
+
 struct Tetromino {
     TetrominoType type = TetrominoType::I;
     int rotation = 0;
 
     [[nodiscard]] std::array<Point, 4> Blocks() const;
+    [[nodiscard]] const PieceRowMasks &RowMasks() const;
     [[nodiscard]] Cell CellType() const;
 };
 
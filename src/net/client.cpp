@@ -0,0 +1,140 @@
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "client.h"
+
+namespace mctetris::net {
+
+Client::~Client() {
+    Close();
+}
+
+Client::Client(Client &&other) noexcept
+    : fd_(std::exchange(other.fd_, -1)), failed_(other.failed_), in_(other.in_), inStart_(other.inStart_),
+      inEnd_(other.inEnd_) {}
+
+Client &Client::operator=(Client &&other) noexcept {
+    if (this != &other) {
+        Close();
+        fd_ = std::exchange(other.fd_, -1);
+        failed_ = other.failed_;
+        in_ = other.in_;
+        inStart_ = other.inStart_;
+        inEnd_ = other.inEnd_;
+    }
+    return *this;
+}
+
+bool Client::Connect(const std::string &path) {
+    Close();
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        return false;
+    }
+    // Connect blocking, so a busy server's backlog is waited out rather than refused.
+    if (connect(fd_, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+        fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK) != 0) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void Client::Close() {
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    failed_ = false;
+    inStart_ = 0;
+    inEnd_ = 0;
+}
+
+bool Client::Send(const Hello &hello) {
+    std::array<std::uint8_t, kMaxMessageBytes> message;
+    return Write(message.data(), EncodeHello(hello, message.data()));
+}
+
+bool Client::Send(const Input &input) {
+    std::array<std::uint8_t, kMaxMessageBytes> message;
+    return Write(message.data(), EncodeInput(input, message.data()));
+}
+
+bool Client::Receive() {
+    if (fd_ < 0 || failed_) {
+        return false;
+    }
+    // Keep what is left of a partial message at the front of the buffer.
+    if (inStart_ > 0) {
+        std::memmove(in_.data(), in_.data() + inStart_, inEnd_ - inStart_);
+        inEnd_ -= inStart_;
+        inStart_ = 0;
+    }
+    while (inEnd_ < in_.size()) {
+        const ssize_t got = read(fd_, in_.data() + inEnd_, in_.size() - inEnd_);
+        if (got > 0) {
+            inEnd_ += static_cast<std::size_t>(got);
+        } else if (got < 0 && errno == EINTR) {
+            continue;
+        } else if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::optional<State> Client::Next() {
+    const auto size = MessageSize(in_.data() + inStart_, inEnd_ - inStart_);
+    if (!size) {
+        failed_ = true;
+        return std::nullopt;
+    }
+    if (*size == 0) {
+        return std::nullopt;
+    }
+    auto state = DecodeState(in_.data() + inStart_, *size);
+    if (!state) {
+        failed_ = true;
+        return std::nullopt;
+    }
+    inStart_ += *size;
+    return state;
+}
+
+int Client::Fd() const {
+    return fd_;
+}
+
+bool Client::Write(const std::uint8_t *data, std::size_t size) {
+    if (fd_ < 0) {
+        return false;
+    }
+    while (true) {
+        const ssize_t wrote = send(fd_, data, size, MSG_NOSIGNAL);
+        if (wrote == static_cast<ssize_t>(size)) {
+            return true;
+        }
+        if (wrote < 0 && errno == EINTR) {
+            continue;
+        }
+        // Stream sockets take small writes whole or not at all unless the
+        // peer has stopped reading; give up rather than resend half a message.
+        return false;
+    }
+}
+
+} // namespace mctetris::net
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "protocol.h"
+
+namespace mctetris::net {
+
+// One connection to a game server: a non-blocking Unix socket plus a fixed
+// buffer holding what has been read but not yet decoded.
+class Client {
+  public:
+    Client() = default;
+    ~Client();
+
+    Client(Client &&other) noexcept;
+    Client &operator=(Client &&other) noexcept;
+    Client(const Client &) = delete;
+    Client &operator=(const Client &) = delete;
+
+    [[nodiscard]] bool Connect(const std::string &path);
+    void Close();
+
+    // Each Send writes one whole message; false if the socket would not take
+    // all of it, which only happens when the server stops reading.
+    bool Send(const Hello &hello);
+    bool Send(const Input &input);
+    // Reads whatever has arrived. False once the server has hung up or sent
+    // something that is not a message.
+    [[nodiscard]] bool Receive();
+    // The next State read so far, if one has arrived whole.
+    [[nodiscard]] std::optional<State> Next();
+
+    [[nodiscard]] int Fd() const;
+
+  private:
+    bool Write(const std::uint8_t *data, std::size_t size);
+
+    int fd_ = -1;
+    bool failed_ = false;
+    std::array<std::uint8_t, 4096> in_{};
+    std::size_t inStart_ = 0;
+    std::size_t inEnd_ = 0;
+};
+
+} // namespace mctetris::net
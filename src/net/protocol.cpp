@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+
+#include "protocol.h"
+
+namespace mctetris::net {
+namespace {
+
+constexpr std::size_t kLengthBytes = 2;
+constexpr std::size_t kHelloFixedBytes = 1 + 1 + 1 + 4 + 1;
+constexpr std::size_t kInputBytes = 1 + 1 + 2;
+constexpr std::size_t kStateFixedBytes = 1 + 2 + 1 + 4 + 4 + 2 + 3 + 1 + 4;
+
+constexpr std::uint8_t kStateGameOver = 1u << 0;
+constexpr std::uint8_t kStateHasPiece = 1u << 1;
+constexpr std::uint8_t kStateHasNext = 1u << 2;
+constexpr std::uint32_t kAllRows = (1u << model::kBoardHeight) - 1;
+
+// Little-endian cursor over a message being written.
+class Writer {
+  public:
+    explicit Writer(std::uint8_t *out) : out_(out), at_(kLengthBytes) {}
+
+    void U8(std::uint8_t value) {
+        out_[at_++] = value;
+    }
+    void U16(std::uint16_t value) {
+        U8(static_cast<std::uint8_t>(value));
+        U8(static_cast<std::uint8_t>(value >> 8));
+    }
+    void U32(std::uint32_t value) {
+        U16(static_cast<std::uint16_t>(value));
+        U16(static_cast<std::uint16_t>(value >> 16));
+    }
+    void Bytes(const void *data, std::size_t size) {
+        std::memcpy(out_ + at_, data, size);
+        at_ += size;
+    }
+    // Fills in the length prefix and returns the message size.
+    std::size_t Finish() {
+        const auto body = static_cast<std::uint16_t>(at_ - kLengthBytes);
+        out_[0] = static_cast<std::uint8_t>(body);
+        out_[1] = static_cast<std::uint8_t>(body >> 8);
+        return at_;
+    }
+
+  private:
+    std::uint8_t *out_;
+    std::size_t at_;
+};
+
+// Reads the body of one message; callers check the size up front.
+class Reader {
+  public:
+    explicit Reader(const std::uint8_t *message) : data_(message), at_(kLengthBytes + 1) {}
+
+    std::uint8_t U8() {
+        return data_[at_++];
+    }
+    std::uint16_t U16() {
+        const std::uint16_t low = U8();
+        return static_cast<std::uint16_t>(low | (U8() << 8));
+    }
+    std::uint32_t U32() {
+        const std::uint32_t low = U16();
+        return low | (static_cast<std::uint32_t>(U16()) << 16);
+    }
+    void Bytes(void *out, std::size_t size) {
+        std::memcpy(out, data_ + at_, size);
+        at_ += size;
+    }
+
+  private:
+    const std::uint8_t *data_;
+    std::size_t at_;
+};
+
+std::size_t BodySize(const std::uint8_t *message) {
+    return static_cast<std::size_t>(message[0]) | (static_cast<std::size_t>(message[1]) << 8);
+}
+
+bool IsType(const std::uint8_t *message, std::size_t size, MessageType type) {
+    return size > kLengthBytes && BodySize(message) + kLengthBytes == size &&
+           message[kLengthBytes] == static_cast<std::uint8_t>(type);
+}
+
+int RowCount(std::uint32_t mask) {
+    return __builtin_popcount(mask);
+}
+
+} // namespace
+
+PackedRow PackRow(const std::array<model::Cell, model::kBoardWidth> &row) {
+    PackedRow packed{};
+    for (int x = 0; x < model::kBoardWidth; ++x) {
+        packed[x / 2] = static_cast<std::uint8_t>(packed[x / 2] | (static_cast<unsigned>(row[x]) << (4 * (x % 2))));
+    }
+    return packed;
+}
+
+std::array<model::Cell, model::kBoardWidth> UnpackRow(const PackedRow &row) {
+    std::array<model::Cell, model::kBoardWidth> cells{};
+    for (int x = 0; x < model::kBoardWidth; ++x) {
+        const unsigned value = (row[x / 2] >> (4 * (x % 2))) & 0xfu;
+        cells[x] = value <= static_cast<unsigned>(model::Cell::L) ? static_cast<model::Cell>(value) : model::Cell::Empty;
+    }
+    return cells;
+}
+
+std::size_t EncodeHello(const Hello &hello, std::uint8_t *out) {
+    Writer writer(out);
+    writer.U8(static_cast<std::uint8_t>(MessageType::Hello));
+    writer.U8(hello.flags);
+    writer.U8(static_cast<std::uint8_t>(hello.randomizer));
+    writer.U32(hello.seed);
+    const auto nameLength = static_cast<std::uint8_t>(std::min<std::size_t>(hello.nameLength, kMaxNameBytes));
+    writer.U8(nameLength);
+    writer.Bytes(hello.name.data(), nameLength);
+    return writer.Finish();
+}
+
+std::size_t EncodeInput(const Input &input, std::uint8_t *out) {
+    Writer writer(out);
+    writer.U8(static_cast<std::uint8_t>(MessageType::Input));
+    writer.U8(static_cast<std::uint8_t>(input.action));
+    writer.U16(input.sequence);
+    return writer.Finish();
+}
+
+std::size_t EncodeState(const State &state, std::uint8_t *out) {
+    Writer writer(out);
+    writer.U8(static_cast<std::uint8_t>(MessageType::State));
+    writer.U16(state.sequence);
+    std::uint8_t flags = state.gameOver ? kStateGameOver : 0;
+    flags = static_cast<std::uint8_t>(flags | (state.piece ? kStateHasPiece : 0) | (state.next ? kStateHasNext : 0));
+    writer.U8(flags);
+    writer.U32(static_cast<std::uint32_t>(state.score));
+    writer.U32(static_cast<std::uint32_t>(state.lines));
+    writer.U16(static_cast<std::uint16_t>(state.level));
+    const model::ActivePiece piece = state.piece.value_or(model::ActivePiece{});
+    writer.U8(static_cast<std::uint8_t>(static_cast<unsigned>(piece.piece.type) | (piece.piece.rotation << 4)));
+    writer.U8(static_cast<std::uint8_t>(static_cast<std::int8_t>(piece.origin.x)));
+    writer.U8(static_cast<std::uint8_t>(static_cast<std::int8_t>(piece.origin.y)));
+    writer.U8(static_cast<std::uint8_t>(state.next.value_or(model::TetrominoType::I)));
+    const std::uint32_t rowMask = state.rowMask & kAllRows;
+    writer.U32(rowMask);
+    for (int y = 0; y < model::kBoardHeight; ++y) {
+        if ((rowMask & (1u << y)) != 0) {
+            writer.Bytes(state.rows[y].data(), kPackedRowBytes);
+        }
+    }
+    return writer.Finish();
+}
+
+std::optional<std::size_t> MessageSize(const std::uint8_t *data, std::size_t size) {
+    if (size < kLengthBytes) {
+        return 0;
+    }
+    const std::size_t total = BodySize(data) + kLengthBytes;
+    if (total == kLengthBytes || total > kMaxMessageBytes) {
+        return std::nullopt;
+    }
+    return size >= total ? total : 0;
+}
+
+std::optional<MessageType> TypeOf(const std::uint8_t *message, std::size_t size) {
+    for (const auto type : {MessageType::Hello, MessageType::Input, MessageType::State}) {
+        if (IsType(message, size, type)) {
+            return type;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<Hello> DecodeHello(const std::uint8_t *message, std::size_t size) {
+    if (!IsType(message, size, MessageType::Hello) || size < kLengthBytes + kHelloFixedBytes) {
+        return std::nullopt;
+    }
+    Reader reader(message);
+    Hello hello;
+    hello.flags = reader.U8();
+    const std::uint8_t randomizer = reader.U8();
+    hello.seed = reader.U32();
+    hello.nameLength = reader.U8();
+    if (randomizer > static_cast<std::uint8_t>(model::Randomizer::History) || hello.nameLength > kMaxNameBytes ||
+        size != kLengthBytes + kHelloFixedBytes + hello.nameLength) {
+        return std::nullopt;
+    }
+    hello.randomizer = static_cast<model::Randomizer>(randomizer);
+    reader.Bytes(hello.name.data(), hello.nameLength);
+    return hello;
+}
+
+std::optional<Input> DecodeInput(const std::uint8_t *message, std::size_t size) {
+    if (!IsType(message, size, MessageType::Input) || size != kLengthBytes + kInputBytes) {
+        return std::nullopt;
+    }
+    Reader reader(message);
+    const std::uint8_t action = reader.U8();
+    if (action > static_cast<std::uint8_t>(model::ReplayAction::Gravity)) {
+        return std::nullopt;
+    }
+    Input input;
+    input.action = static_cast<model::ReplayAction>(action);
+    input.sequence = reader.U16();
+    return input;
+}
+
+std::optional<State> DecodeState(const std::uint8_t *message, std::size_t size) {
+    if (!IsType(message, size, MessageType::State) || size < kLengthBytes + kStateFixedBytes) {
+        return std::nullopt;
+    }
+    Reader reader(message);
+    State state;
+    state.sequence = reader.U16();
+    const std::uint8_t flags = reader.U8();
+    state.gameOver = (flags & kStateGameOver) != 0;
+    state.score = static_cast<std::int32_t>(reader.U32());
+    state.lines = static_cast<std::int32_t>(reader.U32());
+    state.level = reader.U16();
+    const std::uint8_t piece = reader.U8();
+    const auto x = static_cast<std::int8_t>(reader.U8());
+    const auto y = static_cast<std::int8_t>(reader.U8());
+    const std::uint8_t next = reader.U8();
+    state.rowMask = reader.U32();
+    if ((piece & 0xfu) >= model::kTetrominoTypeCount || (piece >> 4) > 3 || next >= model::kTetrominoTypeCount ||
+        (state.rowMask & ~kAllRows) != 0 ||
+        size != kLengthBytes + kStateFixedBytes + RowCount(state.rowMask) * kPackedRowBytes) {
+        return std::nullopt;
+    }
+    if ((flags & kStateHasPiece) != 0) {
+        state.piece = model::ActivePiece{model::Tetromino{static_cast<model::TetrominoType>(piece & 0xfu), piece >> 4},
+                                         model::Point{x, y}};
+    }
+    if ((flags & kStateHasNext) != 0) {
+        state.next = static_cast<model::TetrominoType>(next);
+    }
+    for (int row = 0; row < model::kBoardHeight; ++row) {
+        if ((state.rowMask & (1u << row)) != 0) {
+            reader.Bytes(state.rows[row].data(), kPackedRowBytes);
+        }
+    }
+    return state;
+}
+
+void ApplyState(const State &state, model::GameModel &model) {
+    model::Board board = model.GetBoard();
+    for (int y = 0; y < model::kBoardHeight; ++y) {
+        if ((state.rowMask & (1u << y)) != 0) {
+            board.SetRow(y, UnpackRow(state.rows[y]));
+        }
+    }
+    model.Restore(board, state.piece, state.lines, state.level, state.score, state.gameOver);
+}
+
+std::string DefaultSocketPath() {
+    const char *runtime = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime != nullptr && *runtime != '\0') {
+        return std::string(runtime) + "/mctetris.sock";
+    }
+    return "/tmp/mctetris-" + std::to_string(getuid()) + ".sock";
+}
+
+} // namespace mctetris::net
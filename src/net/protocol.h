@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "model/game_model.h"
+#include "model/piece_generator.h"
+#include "model/replay.h"
+
+namespace mctetris::net {
+
+// Every message is a little-endian u16 length, then that many bytes: a
+// MessageType and its body. Nothing on the wire is larger than
+// kMaxMessageBytes, so both ends can work in fixed buffers.
+//
+// A client says Hello to start a game and then sends one Input per action.
+// The server answers with a State after every batch of inputs it applies and
+// after every gravity tick. A State carries the scalars and the active piece
+// in full, but only the board rows that changed since the previous State.
+enum class MessageType : std::uint8_t {
+    Hello = 1,
+    Input = 2,
+    State = 3
+};
+
+constexpr std::size_t kMaxMessageBytes = 160;
+constexpr std::size_t kMaxNameBytes = 16;
+// Ten cells at four bits each.
+constexpr std::size_t kPackedRowBytes = 5;
+using PackedRow = std::array<std::uint8_t, kPackedRowBytes>;
+
+// Hello flags. By default the server runs gravity and ranks the finished
+// game. With kClientGravity the client's Gravity inputs step the game
+// instead and its seed is used; such games are never ranked.
+constexpr std::uint8_t kClientGravity = 1u << 0;
+
+struct Hello {
+    std::uint8_t flags = 0;
+    model::Randomizer randomizer = model::Randomizer::Bag7;
+    std::uint32_t seed = 0;
+    std::uint8_t nameLength = 0;
+    std::array<char, kMaxNameBytes> name{};
+};
+
+struct Input {
+    model::ReplayAction action = model::ReplayAction::Gravity;
+    // Echoed in the State that first shows the input applied.
+    std::uint16_t sequence = 0;
+};
+
+struct State {
+    // Sequence of the last input applied.
+    std::uint16_t sequence = 0;
+    bool gameOver = false;
+    std::int32_t score = 0;
+    std::int32_t lines = 0;
+    std::int32_t level = 0;
+    std::optional<model::ActivePiece> piece;
+    std::optional<model::TetrominoType> next;
+    // Bit y set when row y is carried in `rows`.
+    std::uint32_t rowMask = 0;
+    std::array<PackedRow, model::kBoardHeight> rows{};
+};
+
+[[nodiscard]] PackedRow PackRow(const std::array<model::Cell, model::kBoardWidth> &row);
+[[nodiscard]] std::array<model::Cell, model::kBoardWidth> UnpackRow(const PackedRow &row);
+
+// Each Encode writes one whole message, length prefix included, into `out`
+// (at least kMaxMessageBytes) and returns its size.
+std::size_t EncodeHello(const Hello &hello, std::uint8_t *out);
+std::size_t EncodeInput(const Input &input, std::uint8_t *out);
+std::size_t EncodeState(const State &state, std::uint8_t *out);
+
+// Size of the message at the front of `data`, prefix included, once all of
+// it has arrived; 0 while it is incomplete. Empty for a malformed length.
+[[nodiscard]] std::optional<std::size_t> MessageSize(const std::uint8_t *data, std::size_t size);
+// The Decode functions take one whole message as sized by MessageSize and
+// reject any other type or a body of the wrong size.
+[[nodiscard]] std::optional<MessageType> TypeOf(const std::uint8_t *message, std::size_t size);
+[[nodiscard]] std::optional<Hello> DecodeHello(const std::uint8_t *message, std::size_t size);
+[[nodiscard]] std::optional<Input> DecodeInput(const std::uint8_t *message, std::size_t size);
+[[nodiscard]] std::optional<State> DecodeState(const std::uint8_t *message, std::size_t size);
+
+// Applies a State to a client's copy of the game: the rows it carries, then
+// everything else.
+void ApplyState(const State &state, model::GameModel &model);
+
+// $XDG_RUNTIME_DIR/mctetris.sock, or /tmp/mctetris-<uid>.sock without it.
+[[nodiscard]] std::string DefaultSocketPath();
+
+} // namespace mctetris::net
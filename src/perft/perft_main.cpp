@@ -0,0 +1,238 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "bot/move_generator.h"
+#include "bot/placement.h"
+#include "model/game_model.h"
+#include "model/piece_generator.h"
+
+namespace {
+
+using mctetris::bot::MoveGenerator;
+using mctetris::bot::MovePath;
+using mctetris::model::Board;
+using mctetris::model::GameModel;
+using mctetris::model::ReplayAction;
+using mctetris::model::TetrominoType;
+
+constexpr int kMaxDepth = 8;
+
+struct PerftOptions {
+    int depth = 3;
+    std::vector<std::uint32_t> seeds;
+    mctetris::model::Randomizer randomizer = mctetris::model::Randomizer::Bag7;
+    bool verify = false;
+};
+
+void PrintUsage() {
+    std::fprintf(stderr,
+                 "Usage: mctetris-perft [--depth N] [--seed S]... [--randomizer bag|uniform|history] [--verify]\n"
+                 "\n"
+                 "Counts the positions reachable by placing the first N pieces of each seed's\n"
+                 "sequence on an empty board, every reachable placement at every ply, and\n"
+                 "reports the count per ply and the generator's throughput. Seeds default\n"
+                 "to 1, 2 and 3; depth is at most %d.\n"
+                 "--verify plays every placement's input path through GameModel and checks\n"
+                 "that it lands where the generator said, and that every straight hard drop\n"
+                 "is among the placements found.\n",
+                 kMaxDepth);
+}
+
+std::optional<long long> ParseCount(const char *text) {
+    char *end = nullptr;
+    const long long value = std::strtoll(text, &end, 10);
+    if (end == text || *end != '\0' || value < 0) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+std::optional<PerftOptions> ParseOptions(int argc, char **argv) {
+    PerftOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--verify") == 0) {
+            options.verify = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--randomizer") == 0 && hasValue) {
+            const auto randomizer = mctetris::model::ParseRandomizer(argv[++i]);
+            if (!randomizer) {
+                return std::nullopt;
+            }
+            options.randomizer = *randomizer;
+            continue;
+        }
+        if (!hasValue) {
+            return std::nullopt;
+        }
+        const auto value = ParseCount(argv[++i]);
+        if (!value) {
+            return std::nullopt;
+        }
+        if (std::strcmp(arg, "--depth") == 0 && *value >= 1 && *value <= kMaxDepth) {
+            options.depth = static_cast<int>(*value);
+        } else if (std::strcmp(arg, "--seed") == 0) {
+            options.seeds.push_back(static_cast<std::uint32_t>(*value));
+        } else {
+            return std::nullopt;
+        }
+    }
+    if (options.seeds.empty()) {
+        options.seeds = {1, 2, 3};
+    }
+    return options;
+}
+
+// Replays `path` from the spawn position on `board` and returns whether the
+// piece locked where the generator placed it.
+bool PathLandsOn(const Board &board, TetrominoType type, const MovePath &path, const Board &expected) {
+    GameModel model;
+    model.Restore(board, GameModel::SpawnPosition(type), 0, 0, 0, false);
+    for (int i = 0; i < path.length; ++i) {
+        bool moved = true;
+        switch (path.actions[i]) {
+        case ReplayAction::MoveLeft:
+            moved = model.Move(-1, 0);
+            break;
+        case ReplayAction::MoveRight:
+            moved = model.Move(1, 0);
+            break;
+        case ReplayAction::RotateCW:
+            moved = model.RotateCW();
+            break;
+        case ReplayAction::SoftDrop:
+            moved = model.SoftDrop();
+            break;
+        case ReplayAction::HardDrop:
+            model.HardDrop();
+            break;
+        case ReplayAction::Gravity:
+            return false;
+        }
+        if (!moved) {
+            return false;
+        }
+    }
+    return !model.CurrentPiece() && model.GetBoard().Cells() == expected.Cells();
+}
+
+class Perft {
+  public:
+    Perft(std::vector<TetrominoType> pieces, bool verify)
+        : pieces_(std::move(pieces)), generators_(pieces_.size()), verify_(verify) {}
+
+    void Run(const Board &board, int ply) {
+        const TetrominoType type = pieces_[static_cast<std::size_t>(ply)];
+        MoveGenerator &generator = generators_[static_cast<std::size_t>(ply)];
+        ++generated_;
+        const int count = generator.Generate(board, GameModel::SpawnPosition(type));
+        nodes_[ply] += static_cast<std::uint64_t>(count);
+        if (verify_) {
+            Verify(board, type, generator);
+        }
+        if (ply + 1 == static_cast<int>(pieces_.size())) {
+            return;
+        }
+        for (int i = 0; i < count; ++i) {
+            const auto &placement = generator.Placement(i);
+            Board child = board;
+            child.Place(placement.piece.piece, placement.piece.origin.x, placement.piece.origin.y);
+            (void)child.ClearFullLines();
+            Run(child, ply + 1);
+        }
+    }
+
+    [[nodiscard]] std::uint64_t Nodes(int ply) const {
+        return nodes_[ply];
+    }
+    [[nodiscard]] std::uint64_t Generated() const {
+        return generated_;
+    }
+    [[nodiscard]] std::uint64_t Failures() const {
+        return failures_;
+    }
+
+  private:
+    void Verify(const Board &board, TetrominoType type, const MoveGenerator &generator) {
+        MovePath path;
+        for (int i = 0; i < generator.Count(); ++i) {
+            const auto &placement = generator.Placement(i);
+            Board expected = board;
+            expected.Place(placement.piece.piece, placement.piece.origin.x, placement.piece.origin.y);
+            (void)expected.ClearFullLines();
+            generator.PathTo(placement, path);
+            if (!PathLandsOn(board, type, path, expected)) {
+                ++failures_;
+            }
+        }
+        // Every placement the bot's drop-only enumeration finds must be here too.
+        mctetris::bot::PlacementList drops;
+        mctetris::bot::EnumeratePlacements(board, GameModel::SpawnPosition(type), drops);
+        for (int d = 0; d < drops.count; ++d) {
+            Board dropped = board;
+            dropped.Place(drops.items[d].piece, drops.items[d].x, drops.items[d].y);
+            bool found = false;
+            for (int i = 0; i < generator.Count() && !found; ++i) {
+                const auto &placement = generator.Placement(i);
+                Board reached = board;
+                reached.Place(placement.piece.piece, placement.piece.origin.x, placement.piece.origin.y);
+                found = reached.RowMasks() == dropped.RowMasks();
+            }
+            failures_ += found ? 0 : 1;
+        }
+    }
+
+    std::vector<TetrominoType> pieces_;
+    std::vector<MoveGenerator> generators_;
+    bool verify_ = false;
+    std::uint64_t nodes_[kMaxDepth] = {};
+    std::uint64_t generated_ = 0;
+    std::uint64_t failures_ = 0;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const auto options = ParseOptions(argc, argv);
+    if (!options) {
+        PrintUsage();
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    std::uint64_t failures = 0;
+    for (const std::uint32_t seed : options->seeds) {
+        mctetris::model::PieceGenerator generator(options->randomizer, seed);
+        std::vector<TetrominoType> pieces;
+        std::printf("seed %u:", seed);
+        for (int i = 0; i < options->depth; ++i) {
+            pieces.push_back(generator.Next());
+            std::printf(" %c", "IOTSZJL"[static_cast<int>(pieces.back())]);
+        }
+        std::printf("\n");
+
+        Perft perft(pieces, options->verify);
+        const auto start = Clock::now();
+        perft.Run(Board{}, 0);
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        for (int ply = 0; ply < options->depth; ++ply) {
+            std::printf("  ply %d: %llu\n", ply + 1, static_cast<unsigned long long>(perft.Nodes(ply)));
+        }
+        std::printf("  %.3f s, %.0f searches/s, %.0f positions/s\n", seconds,
+                    static_cast<double>(perft.Generated()) / seconds,
+                    static_cast<double>(perft.Nodes(options->depth - 1)) / seconds);
+        if (options->verify) {
+            std::printf("  verify: %llu failures\n", static_cast<unsigned long long>(perft.Failures()));
+        }
+        failures += perft.Failures();
+    }
+    return failures == 0 ? 0 : 2;
+}
@@ -0,0 +1,408 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "score_store.h"
+
+namespace mctetris::scores {
+namespace {
+
+constexpr char kLogMagic[4] = {'M', 'C', 'S', 'L'};
+constexpr char kIndexMagic[4] = {'M', 'C', 'S', 'I'};
+constexpr std::uint32_t kFormatVersion = 1;
+constexpr const char *kIndexSuffix = ".idx";
+
+struct LogHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    std::uint32_t reserved;
+};
+
+struct Record {
+    char name[kNameBytes];
+    std::uint32_t score;
+    std::uint32_t lines;
+    std::uint32_t level;
+    // FNV-1a of the record with this field zeroed; a torn or zeroed record fails it.
+    std::uint32_t checksum;
+    std::int64_t timestamp;
+    std::uint64_t replayHash;
+};
+
+// `anchor` is the checksum field of the last covered record, so an index is
+// never applied to a log that was replaced underneath it.
+struct IndexHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t covered;
+    std::uint64_t anchor;
+    std::uint64_t entries;
+};
+
+struct PlayerKey {
+    std::uint64_t nameKey;
+    std::uint32_t score;
+    std::uint32_t ordinal;
+};
+
+static_assert(sizeof(LogHeader) == 16);
+static_assert(sizeof(Record) == 48);
+static_assert(sizeof(IndexHeader) == 32);
+static_assert(sizeof(PlayerKey) == 16);
+
+template <typename T>
+T Load(const std::uint8_t *data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+std::uint32_t Checksum(Record record) {
+    record.checksum = 0;
+    const auto *bytes = reinterpret_cast<const std::uint8_t *>(&record);
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < sizeof(Record); ++i) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+std::uint64_t NameKey(const char (&name)[kNameBytes]) {
+    std::uint64_t hash = 1469598103934665603ull;
+    for (const char c : name) {
+        hash ^= static_cast<std::uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void StoreName(const std::string &name, char (&out)[kNameBytes]) {
+    std::memset(out, 0, kNameBytes);
+    std::memcpy(out, name.data(), std::min(name.size(), kNameBytes));
+}
+
+Record ToRecord(const ScoreEntry &entry) {
+    Record record{};
+    StoreName(entry.name, record.name);
+    record.score = static_cast<std::uint32_t>(std::max(entry.score, 0));
+    record.lines = static_cast<std::uint32_t>(std::max(entry.lines, 0));
+    record.level = static_cast<std::uint32_t>(std::max(entry.level, 0));
+    record.timestamp = entry.timestamp;
+    record.replayHash = entry.replayHash;
+    record.checksum = Checksum(record);
+    return record;
+}
+
+ScoreEntry ToEntry(const Record &record) {
+    ScoreEntry entry;
+    entry.name.assign(record.name, strnlen(record.name, kNameBytes));
+    entry.score = static_cast<int>(record.score);
+    entry.lines = static_cast<int>(record.lines);
+    entry.level = static_cast<int>(record.level);
+    entry.timestamp = record.timestamp;
+    entry.replayHash = record.replayHash;
+    return entry;
+}
+
+template <typename T>
+bool Ranks(const T &lhs, const T &rhs) {
+    return lhs.score != rhs.score ? lhs.score > rhs.score : lhs.ordinal < rhs.ordinal;
+}
+
+bool WriteAll(int fd, const void *data, std::size_t size) {
+    const auto *bytes = static_cast<const std::uint8_t *>(data);
+    while (size > 0) {
+        const ssize_t written = write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+bool HasMagic(const std::uint8_t *data, const char (&magic)[4]) {
+    return std::memcmp(data, magic, sizeof(magic)) == 0 && Load<std::uint32_t>(data + 4) == kFormatVersion;
+}
+
+std::optional<Record> ReadRecord(const MappedFile &log, std::uint64_t ordinal) {
+    const Record record = Load<Record>(log.Data() + sizeof(LogHeader) + ordinal * sizeof(Record));
+    if (record.checksum != Checksum(record)) {
+        return std::nullopt;
+    }
+    return record;
+}
+
+} // namespace
+
+MappedFile::MappedFile(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    struct stat info {};
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void *mapped = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped != MAP_FAILED) {
+            data_ = static_cast<const std::uint8_t *>(mapped);
+            size_ = static_cast<std::size_t>(info.st_size);
+        }
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    Release();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept : data_(other.data_), size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        Release();
+        data_ = other.data_;
+        size_ = other.size_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+const std::uint8_t *MappedFile::Data() const {
+    return data_;
+}
+
+std::size_t MappedFile::Size() const {
+    return size_;
+}
+
+void MappedFile::Release() {
+    if (data_ != nullptr) {
+        munmap(const_cast<std::uint8_t *>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+ScoreStore::ScoreStore(std::string path) : path_(std::move(path)) {}
+
+ScoreStore ScoreStore::Open(const std::string &path) {
+    ScoreStore store(path);
+    store.Refresh();
+    return store;
+}
+
+bool ScoreStore::Append(const std::string &path, const std::vector<ScoreEntry> &entries) {
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = flock(fd, LOCK_EX) == 0;
+    struct stat info {};
+    ok = ok && fstat(fd, &info) == 0;
+    const auto size = static_cast<std::size_t>(info.st_size);
+    if (ok && size < sizeof(LogHeader)) {
+        // New file, or a crash tore the header: start over.
+        LogHeader header{};
+        std::memcpy(header.magic, kLogMagic, sizeof(kLogMagic));
+        header.version = kFormatVersion;
+        header.recordSize = sizeof(Record);
+        ok = ftruncate(fd, 0) == 0 && WriteAll(fd, &header, sizeof(header));
+    } else if (ok) {
+        std::uint8_t header[sizeof(LogHeader)];
+        ok = pread(fd, header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+             HasMagic(header, kLogMagic);
+        const std::size_t torn = (size - sizeof(LogHeader)) % sizeof(Record);
+        if (ok && torn != 0) {
+            ok = ftruncate(fd, static_cast<off_t>(size - torn)) == 0;
+        }
+    }
+    if (ok) {
+        std::vector<Record> records;
+        records.reserve(entries.size());
+        for (const auto &entry : entries) {
+            records.push_back(ToRecord(entry));
+        }
+        ok = WriteAll(fd, records.data(), records.size() * sizeof(Record)) && fdatasync(fd) == 0;
+    }
+    close(fd);
+    return ok;
+}
+
+bool ScoreStore::Compact(const std::string &path) {
+    const ScoreStore store = Open(path);
+    const std::uint64_t count = store.RecordCount();
+    std::vector<Ranked> ranks;
+    std::vector<PlayerKey> players;
+    ranks.reserve(count);
+    players.reserve(count);
+    for (std::uint64_t ordinal = 0; ordinal < count; ++ordinal) {
+        if (const auto record = ReadRecord(store.log_, ordinal)) {
+            const auto index = static_cast<std::uint32_t>(ordinal);
+            ranks.push_back(Ranked{record->score, index});
+            players.push_back(PlayerKey{NameKey(record->name), record->score, index});
+        }
+    }
+    std::sort(ranks.begin(), ranks.end(), Ranks<Ranked>);
+    std::sort(players.begin(), players.end(), [](const PlayerKey &lhs, const PlayerKey &rhs) {
+        return lhs.nameKey != rhs.nameKey ? lhs.nameKey < rhs.nameKey : Ranks(lhs, rhs);
+    });
+
+    IndexHeader header{};
+    std::memcpy(header.magic, kIndexMagic, sizeof(kIndexMagic));
+    header.version = kFormatVersion;
+    header.covered = count;
+    header.anchor = count > 0 ? Load<Record>(store.log_.Data() + sizeof(LogHeader) + (count - 1) * sizeof(Record)).checksum
+                              : 0;
+    header.entries = ranks.size();
+
+    // Each writer uses its own temporary so concurrent compactions cannot mix.
+    const std::string target = path + kIndexSuffix;
+    const std::string temporary = target + ".tmp." + std::to_string(getpid());
+    const int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    const bool ok = WriteAll(fd, &header, sizeof(header)) &&
+                    WriteAll(fd, ranks.data(), ranks.size() * sizeof(Ranked)) &&
+                    WriteAll(fd, players.data(), players.size() * sizeof(PlayerKey)) && fsync(fd) == 0;
+    close(fd);
+    if (!ok || std::rename(temporary.c_str(), target.c_str()) != 0) {
+        (void)unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+void ScoreStore::Refresh() {
+    log_ = MappedFile(path_);
+    index_ = MappedFile(path_ + kIndexSuffix);
+}
+
+std::vector<ScoreEntry> ScoreStore::Top(int count) const {
+    std::vector<Ranked> indexed;
+    if (Indexed() > 0) {
+        const auto header = Load<IndexHeader>(index_.Data());
+        // A record that fails its checksum is passed over, so read on past it.
+        for (std::uint64_t i = 0; i < header.entries && static_cast<int>(indexed.size()) < count; ++i) {
+            const auto rank = Load<Ranked>(index_.Data() + sizeof(IndexHeader) + i * sizeof(Ranked));
+            if (ReadRecord(log_, rank.ordinal)) {
+                indexed.push_back(rank);
+            }
+        }
+    }
+    return Merge(indexed, TailRanks(nullptr), count);
+}
+
+std::vector<ScoreEntry> ScoreStore::TopForPlayer(const std::string &name, int count) const {
+    char stored[kNameBytes];
+    StoreName(name, stored);
+    const std::string key(stored, strnlen(stored, kNameBytes));
+    std::vector<Ranked> indexed;
+    if (Indexed() > 0) {
+        const auto header = Load<IndexHeader>(index_.Data());
+        const std::uint8_t *players = index_.Data() + sizeof(IndexHeader) + header.entries * sizeof(Ranked);
+        const std::uint64_t nameKey = NameKey(stored);
+        // Binary search for the first entry of this player.
+        std::uint64_t low = 0;
+        std::uint64_t high = header.entries;
+        while (low < high) {
+            const std::uint64_t middle = low + (high - low) / 2;
+            if (Load<PlayerKey>(players + middle * sizeof(PlayerKey)).nameKey < nameKey) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        for (std::uint64_t i = low; i < header.entries && static_cast<int>(indexed.size()) < count; ++i) {
+            const auto entry = Load<PlayerKey>(players + i * sizeof(PlayerKey));
+            if (entry.nameKey != nameKey) {
+                break;
+            }
+            // Another name with the same hash is skipped.
+            const auto record = ReadRecord(log_, entry.ordinal);
+            if (record && std::strncmp(record->name, stored, kNameBytes) == 0) {
+                indexed.push_back(Ranked{entry.score, entry.ordinal});
+            }
+        }
+    }
+    return Merge(indexed, TailRanks(&key), count);
+}
+
+std::uint64_t ScoreStore::RecordCount() const {
+    if (log_.Size() < sizeof(LogHeader) || !HasMagic(log_.Data(), kLogMagic)) {
+        return 0;
+    }
+    return (log_.Size() - sizeof(LogHeader)) / sizeof(Record);
+}
+
+std::uint64_t ScoreStore::Unindexed() const {
+    return RecordCount() - Indexed();
+}
+
+std::uint64_t ScoreStore::Indexed() const {
+    if (index_.Size() < sizeof(IndexHeader) || !HasMagic(index_.Data(), kIndexMagic)) {
+        return 0;
+    }
+    const auto header = Load<IndexHeader>(index_.Data());
+    const std::uint64_t count = RecordCount();
+    if (header.covered == 0 || header.covered > count || header.entries > header.covered ||
+        index_.Size() != sizeof(IndexHeader) + header.entries * (sizeof(Ranked) + sizeof(PlayerKey))) {
+        return 0;
+    }
+    const auto last = Load<Record>(log_.Data() + sizeof(LogHeader) + (header.covered - 1) * sizeof(Record));
+    return last.checksum == header.anchor ? header.covered : 0;
+}
+
+std::vector<ScoreStore::Ranked> ScoreStore::TailRanks(const std::string *name) const {
+    std::vector<Ranked> tail;
+    const std::uint64_t count = RecordCount();
+    for (std::uint64_t ordinal = Indexed(); ordinal < count; ++ordinal) {
+        const auto record = ReadRecord(log_, ordinal);
+        if (record && (name == nullptr || ToEntry(*record).name == *name)) {
+            tail.push_back(Ranked{record->score, static_cast<std::uint32_t>(ordinal)});
+        }
+    }
+    std::sort(tail.begin(), tail.end(), Ranks<Ranked>);
+    return tail;
+}
+
+std::vector<ScoreEntry> ScoreStore::Merge(const std::vector<Ranked> &indexed,
+                                          const std::vector<Ranked> &tail,
+                                          int count) const {
+    std::vector<Ranked> merged(indexed.size() + tail.size());
+    std::merge(indexed.begin(), indexed.end(), tail.begin(), tail.end(), merged.begin(), Ranks<Ranked>);
+    merged.resize(std::min(merged.size(), static_cast<std::size_t>(std::max(count, 0))));
+    std::vector<ScoreEntry> entries;
+    entries.reserve(merged.size());
+    for (const auto &rank : merged) {
+        if (const auto record = ReadRecord(log_, rank.ordinal)) {
+            entries.push_back(ToEntry(*record));
+        }
+    }
+    return entries;
+}
+
+std::string DefaultScorePath() {
+    const char *home = std::getenv("HOME");
+    return std::string(home != nullptr && *home != '\0' ? home : ".") + "/.mctetris_scores";
+}
+
+} // namespace mctetris::scores
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace mctetris::scores {
+
+constexpr std::size_t kNameBytes = 16;
+// Appended records not yet in the index before a writer rebuilds it.
+constexpr std::uint64_t kCompactThreshold = 1024;
+
+struct ScoreEntry {
+    // Truncated to kNameBytes when stored.
+    std::string name;
+    int score = 0;
+    int level = 0;
+    int lines = 0;
+    // Seconds since the Unix epoch.
+    std::int64_t timestamp = 0;
+    // Hash of the encoded replay, so a score can be matched to its recording.
+    std::uint64_t replayHash = 0;
+};
+
+// Read-only mapping of a whole file; empty if the file is missing or empty.
+class MappedFile {
+  public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    [[nodiscard]] const std::uint8_t *Data() const;
+    [[nodiscard]] std::size_t Size() const;
+
+  private:
+    void Release();
+
+    const std::uint8_t *data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+// High scores kept as an append-only log of fixed-size, checksummed records
+// at `path`, plus a sorted index at `path.idx` covering a prefix of the log.
+// Opening maps both files and parses nothing, and queries read the index and
+// only the records they return, so neither grows with the history. Records
+// appended since the last compaction are scanned and merged in.
+//
+// Files are in host byte order. Appends take an exclusive flock and drop a
+// torn tail left by a crash first, so concurrent writers on one machine stay
+// record-aligned. Compaction writes a new index beside the old one and renames
+// it into place.
+class ScoreStore {
+  public:
+    [[nodiscard]] static ScoreStore Open(const std::string &path);
+    [[nodiscard]] static bool Append(const std::string &path, const std::vector<ScoreEntry> &entries);
+    [[nodiscard]] static bool Compact(const std::string &path);
+
+    // Remaps both files to pick up appends and compactions by anyone.
+    void Refresh();
+
+    // Best first; ties go to the earlier score.
+    [[nodiscard]] std::vector<ScoreEntry> Top(int count) const;
+    [[nodiscard]] std::vector<ScoreEntry> TopForPlayer(const std::string &name, int count) const;
+    // Complete records in the log, valid or not.
+    [[nodiscard]] std::uint64_t RecordCount() const;
+    // Records past the end of the index.
+    [[nodiscard]] std::uint64_t Unindexed() const;
+
+  private:
+    struct Ranked {
+        std::uint32_t score;
+        std::uint32_t ordinal;
+    };
+
+    explicit ScoreStore(std::string path);
+    [[nodiscard]] std::uint64_t Indexed() const;
+    [[nodiscard]] std::vector<Ranked> TailRanks(const std::string *name) const;
+    [[nodiscard]] std::vector<ScoreEntry> Merge(const std::vector<Ranked> &indexed,
+                                                const std::vector<Ranked> &tail,
+                                                int count) const;
+
+    std::string path_;
+    MappedFile log_;
+    MappedFile index_;
+};
+
+// $HOME/.mctetris_scores, or the working directory without a HOME.
+[[nodiscard]] std::string DefaultScorePath();
+
+} // namespace mctetris::scores
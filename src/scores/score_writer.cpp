@@ -0,0 +1,74 @@
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "score_writer.h"
+#include "trace/trace.h"
+
+namespace mctetris::scores {
+
+ScoreWriter::ScoreWriter(std::string path) : path_(std::move(path)), thread_([this]() { Run(); }) {}
+
+ScoreWriter::~ScoreWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+void ScoreWriter::Submit(ScoreEntry entry) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(entry));
+        ++submitted_;
+    }
+    wake_.notify_one();
+}
+
+void ScoreWriter::Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const std::uint64_t target = submitted_;
+    drained_.wait(lock, [&]() { return finished_ >= target; });
+}
+
+const std::string &ScoreWriter::Path() const {
+    return path_;
+}
+
+std::uint64_t ScoreWriter::Failures() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return failures_;
+}
+
+void ScoreWriter::Run() {
+    trace::SetThreadName("score writer");
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [&]() { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return;
+        }
+        // Everything queued goes out in one append.
+        std::vector<ScoreEntry> batch(std::make_move_iterator(queue_.begin()), std::make_move_iterator(queue_.end()));
+        queue_.clear();
+        lock.unlock();
+        bool written = false;
+        {
+            MCTETRIS_TRACE_SCOPE("ScoreWriter::Write");
+            written = ScoreStore::Append(path_, batch);
+            if (written && ScoreStore::Open(path_).Unindexed() >= kCompactThreshold) {
+                (void)ScoreStore::Compact(path_);
+            }
+        }
+        lock.lock();
+        if (!written) {
+            failures_ += batch.size();
+        }
+        finished_ += batch.size();
+        drained_.notify_all();
+    }
+}
+
+} // namespace mctetris::scores
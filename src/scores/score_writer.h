@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "score_store.h"
+
+namespace mctetris::scores {
+
+// Appends scores to a ScoreStore on its own thread so the game thread never
+// waits on the disk, and rebuilds the index once kCompactThreshold records
+// have piled up past it.
+class ScoreWriter {
+  public:
+    explicit ScoreWriter(std::string path);
+    // Writes whatever is still queued, then stops.
+    ~ScoreWriter();
+
+    ScoreWriter(const ScoreWriter &) = delete;
+    ScoreWriter &operator=(const ScoreWriter &) = delete;
+
+    // Queues a score and returns at once.
+    void Submit(ScoreEntry entry);
+    // Blocks until every score submitted so far has been written or dropped.
+    void Flush();
+
+    [[nodiscard]] const std::string &Path() const;
+    // Scores that could not be written.
+    [[nodiscard]] std::uint64_t Failures() const;
+
+  private:
+    void Run();
+
+    std::string path_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable drained_;
+    std::deque<ScoreEntry> queue_;
+    std::uint64_t submitted_ = 0;
+    std::uint64_t finished_ = 0;
+    std::uint64_t failures_ = 0;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+} // namespace mctetris::scores
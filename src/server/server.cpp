@@ -0,0 +1,467 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "model/game_session.h"
+#include "model/replay.h"
+#include "net/protocol.h"
+#include "server.h"
+
+namespace mctetris::server {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kMaxEvents = 256;
+// Always room for one more message after the whole ones have been decoded.
+constexpr std::size_t kInputBufferBytes = 2 * net::kMaxMessageBytes;
+// One State being written and room to encode the next.
+constexpr std::size_t kOutputBufferBytes = 2 * net::kMaxMessageBytes;
+constexpr char kGuestName[] = "guest";
+
+bool MakeAddress(const std::string &path, sockaddr_un &address) {
+    address = sockaddr_un{};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// True if a server is accepting connections at `address`.
+bool InUse(const sockaddr_un &address) {
+    const int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe < 0) {
+        return true;
+    }
+    const bool connected = connect(probe, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0;
+    close(probe);
+    return connected;
+}
+
+bool Watch(int epollFd, int fd, std::uint32_t events, int operation) {
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    return epoll_ctl(epollFd, operation, fd, &event) == 0;
+}
+
+} // namespace
+
+struct Server::Session {
+    int fd = -1;
+    // Tells a reused descriptor's session from the one a timer was set for.
+    std::uint64_t id = 0;
+    model::GameSession game;
+    bool playing = false;
+    bool ranked = false;
+    bool clientGravity = false;
+    std::uint8_t nameLength = 0;
+    std::array<char, net::kMaxNameBytes> name{};
+    Clock::time_point nextGravity{};
+    // Whether timers_ holds an entry for this session; it never holds two.
+    bool timerQueued = false;
+
+    std::uint16_t sequence = 0;
+    // The game changed, or inputs arrived, since the last State was encoded.
+    bool changed = false;
+    // Rows as the client last saw them; nothing is assumed before the first State.
+    bool sentAny = false;
+    std::array<net::PackedRow, model::kBoardHeight> sentRows{};
+    // When the oldest unanswered input arrived, and when the inputs behind
+    // the State still being written did.
+    std::optional<Clock::time_point> pendingSince;
+    std::optional<Clock::time_point> answering;
+
+    bool watchingWrite = false;
+    std::array<std::uint8_t, kInputBufferBytes> in{};
+    std::size_t inSize = 0;
+    std::array<std::uint8_t, kOutputBufferBytes> out{};
+    std::size_t outStart = 0;
+    std::size_t outEnd = 0;
+};
+
+Server::Server(ServerConfig config) : config_(std::move(config)) {}
+
+Server::~Server() {
+    for (std::size_t fd = 0; fd < sessions_.size(); ++fd) {
+        if (sessions_[fd]) {
+            close(static_cast<int>(fd));
+        }
+    }
+    for (const int fd : {listenFd_, epollFd_, timerFd_}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    if (listenFd_ >= 0) {
+        unlink(config_.socketPath.c_str());
+    }
+}
+
+bool Server::Start() {
+    sockaddr_un address{};
+    if (!MakeAddress(config_.socketPath, address)) {
+        return false;
+    }
+    const int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        return false;
+    }
+    bool bound = bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0;
+    if (!bound && errno == EADDRINUSE && !InUse(address)) {
+        unlink(config_.socketPath.c_str());
+        bound = bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0;
+    }
+    if (!bound) {
+        close(listener);
+        return false;
+    }
+    listenFd_ = listener;
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (listen(listenFd_, SOMAXCONN) != 0 || epollFd_ < 0 || timerFd_ < 0 ||
+        !Watch(epollFd_, listenFd_, EPOLLIN, EPOLL_CTL_ADD) || !Watch(epollFd_, timerFd_, EPOLLIN, EPOLL_CTL_ADD)) {
+        return false;
+    }
+    if (config_.scoresPath) {
+        scores_ = std::make_unique<scores::ScoreWriter>(*config_.scoresPath);
+    }
+    return true;
+}
+
+void Server::Run(int stopFd) {
+    if (!Watch(epollFd_, stopFd, EPOLLIN, EPOLL_CTL_ADD)) {
+        return;
+    }
+    std::array<epoll_event, kMaxEvents> events;
+    bool stopping = false;
+    while (!stopping) {
+        const int count = epoll_wait(epollFd_, events.data(), kMaxEvents, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        const auto now = Clock::now();
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            const std::uint32_t ready = events[i].events;
+            if (fd == stopFd) {
+                stopping = true;
+            } else if (fd == listenFd_) {
+                Accept();
+            } else if (fd == timerFd_) {
+                std::uint64_t expirations = 0;
+                (void)read(timerFd_, &expirations, sizeof(expirations));
+                OnTimer(now);
+            } else if (static_cast<std::size_t>(fd) < sessions_.size() && sessions_[fd]) {
+                if ((ready & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0) {
+                    OnReadable(*sessions_[fd], now);
+                }
+                if ((ready & EPOLLOUT) != 0 && sessions_[fd]) {
+                    OnWritable(*sessions_[fd]);
+                }
+            }
+        }
+    }
+    (void)epoll_ctl(epollFd_, EPOLL_CTL_DEL, stopFd, nullptr);
+}
+
+const ServerStats &Server::Stats() const {
+    return stats_;
+}
+
+void Server::Accept() {
+    while (true) {
+        const int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        ++stats_.accepted;
+        if (stats_.sessions >= config_.maxSessions || !Watch(epollFd_, fd, EPOLLIN, EPOLL_CTL_ADD)) {
+            ++stats_.rejected;
+            close(fd);
+            continue;
+        }
+        if (static_cast<std::size_t>(fd) >= sessions_.size()) {
+            sessions_.resize(static_cast<std::size_t>(fd) + 1);
+        }
+        auto session = std::make_unique<Session>();
+        session->fd = fd;
+        session->id = nextId_++;
+        sessions_[fd] = std::move(session);
+        ++stats_.sessions;
+        stats_.peakSessions = std::max(stats_.peakSessions, stats_.sessions);
+    }
+}
+
+void Server::OnReadable(Session &session, Clock::time_point now) {
+    const int fd = session.fd;
+    while (true) {
+        const ssize_t got = read(fd, session.in.data() + session.inSize, session.in.size() - session.inSize);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (got <= 0) {
+            Close(fd);
+            return;
+        }
+        stats_.bytesIn += static_cast<std::uint64_t>(got);
+        session.inSize += static_cast<std::size_t>(got);
+
+        std::size_t at = 0;
+        while (true) {
+            const auto size = net::MessageSize(session.in.data() + at, session.inSize - at);
+            if (!size || (*size > 0 && !Handle(session, session.in.data() + at, *size, now))) {
+                ++stats_.rejected;
+                Close(fd);
+                return;
+            }
+            if (*size == 0) {
+                break;
+            }
+            at += *size;
+        }
+        std::memmove(session.in.data(), session.in.data() + at, session.inSize - at);
+        session.inSize -= at;
+    }
+    // Everything read in this wakeup is answered by one State.
+    if (!Send(session)) {
+        Close(fd);
+    }
+}
+
+void Server::OnWritable(Session &session) {
+    if (!Send(session)) {
+        Close(session.fd);
+    }
+}
+
+void Server::OnTimer(Clock::time_point now) {
+    armedFor_.reset();
+    while (!timers_.empty() && timers_.top().deadline <= now) {
+        const Timer timer = timers_.top();
+        timers_.pop();
+        Session *session = static_cast<std::size_t>(timer.fd) < sessions_.size() ? sessions_[timer.fd].get() : nullptr;
+        if (session == nullptr || session->id != timer.id) {
+            continue;
+        }
+        session->timerQueued = false;
+        if (!session->playing || session->clientGravity) {
+            continue;
+        }
+        if (session->nextGravity > now) {
+            // A new game moved the schedule on since this entry was queued.
+            Schedule(*session);
+            continue;
+        }
+        stats_.gravityLate.Add(std::chrono::duration_cast<std::chrono::nanoseconds>(now - session->nextGravity).count());
+        (void)model::ApplyReplayAction(session->game, model::ReplayAction::Gravity);
+        session->changed = true;
+        AfterChange(*session);
+        if (session->playing) {
+            // A fixed schedule, as in the front end, skipping ticks missed in a stall.
+            const auto delay = std::chrono::milliseconds(session->game.Model().GravityDelayMs());
+            session->nextGravity += delay;
+            if (session->nextGravity <= now) {
+                session->nextGravity = now + delay;
+            }
+            Schedule(*session);
+        }
+        if (!Send(*session)) {
+            Close(session->fd);
+        }
+    }
+    ArmTimer();
+}
+
+bool Server::Handle(Session &session, const std::uint8_t *message, std::size_t size, Clock::time_point now) {
+    const auto type = net::TypeOf(message, size);
+    if (type == net::MessageType::Hello) {
+        const auto hello = net::DecodeHello(message, size);
+        if (!hello) {
+            return false;
+        }
+        session.clientGravity = (hello->flags & net::kClientGravity) != 0;
+        session.ranked = !session.clientGravity;
+        session.game.Reset(session.clientGravity ? hello->seed : seeds_(), hello->randomizer);
+        session.nameLength = hello->nameLength;
+        session.name = hello->name;
+        session.playing = true;
+        session.sequence = 0;
+        session.changed = true;
+        // The client starts a fresh board too, so send all of it.
+        session.sentAny = false;
+        if (!session.clientGravity) {
+            session.nextGravity = now + std::chrono::milliseconds(session.game.Model().GravityDelayMs());
+            Schedule(session);
+        }
+        return true;
+    }
+    if (type == net::MessageType::Input) {
+        const auto input = net::DecodeInput(message, size);
+        if (!input) {
+            return false;
+        }
+        ++stats_.inputs;
+        session.sequence = input->sequence;
+        // Every input is acknowledged, even one that changed nothing.
+        session.changed = true;
+        if (!session.pendingSince) {
+            session.pendingSince = now;
+        }
+        // Only the server ticks a ranked game.
+        if (session.playing && (input->action != model::ReplayAction::Gravity || session.clientGravity)) {
+            (void)model::ApplyReplayAction(session.game, input->action);
+            AfterChange(session);
+        }
+        return true;
+    }
+    return false;
+}
+
+void Server::AfterChange(Session &session) {
+    const auto &model = session.game.Model();
+    if (!session.playing || !model.IsGameOver()) {
+        return;
+    }
+    session.playing = false;
+    if (!session.ranked) {
+        return;
+    }
+    ++stats_.rankedGames;
+    if (scores_) {
+        scores::ScoreEntry entry;
+        entry.name = session.nameLength > 0 ? std::string(session.name.data(), session.nameLength) : kGuestName;
+        entry.score = model.Score();
+        entry.level = model.Level();
+        entry.lines = model.LinesCleared();
+        entry.timestamp =
+            std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+                .count();
+        scores_->Submit(std::move(entry));
+    }
+}
+
+bool Server::Send(Session &session) {
+    if (session.changed && session.out.size() - session.outEnd < net::kMaxMessageBytes && session.outStart > 0) {
+        std::memmove(session.out.data(), session.out.data() + session.outStart, session.outEnd - session.outStart);
+        session.outEnd -= session.outStart;
+        session.outStart = 0;
+    }
+    if (session.changed && session.out.size() - session.outEnd >= net::kMaxMessageBytes) {
+        const auto &model = session.game.Model();
+        net::State state;
+        state.sequence = session.sequence;
+        state.gameOver = model.IsGameOver();
+        state.score = model.Score();
+        state.lines = model.LinesCleared();
+        state.level = model.Level();
+        state.piece = model.CurrentPiece();
+        state.next = session.game.NextType();
+        const auto &cells = model.GetBoard().Cells();
+        for (int y = 0; y < model::kBoardHeight; ++y) {
+            const auto packed = net::PackRow(cells[y]);
+            if (!session.sentAny || packed != session.sentRows[y]) {
+                state.rowMask |= 1u << y;
+                state.rows[y] = packed;
+                session.sentRows[y] = packed;
+            }
+        }
+        session.sentAny = true;
+        session.outEnd += net::EncodeState(state, session.out.data() + session.outEnd);
+        session.changed = false;
+        ++stats_.states;
+        if (!session.answering) {
+            session.answering = session.pendingSince;
+        }
+        session.pendingSince.reset();
+    }
+
+    while (session.outStart < session.outEnd) {
+        const ssize_t wrote = send(session.fd, session.out.data() + session.outStart,
+                                   session.outEnd - session.outStart, MSG_NOSIGNAL);
+        if (wrote > 0) {
+            session.outStart += static_cast<std::size_t>(wrote);
+            stats_.bytesOut += static_cast<std::uint64_t>(wrote);
+        } else if (wrote < 0 && errno == EINTR) {
+            continue;
+        } else if (wrote < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+    if (session.outStart == session.outEnd) {
+        session.outStart = 0;
+        session.outEnd = 0;
+        if (session.answering) {
+            stats_.response.Add(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - *session.answering)
+                                    .count());
+            session.answering.reset();
+        }
+    }
+    // Wait for room if anything is left to write or encode.
+    WatchWritable(session, session.outStart < session.outEnd || session.changed);
+    return true;
+}
+
+void Server::WatchWritable(Session &session, bool watch) {
+    if (watch != session.watchingWrite &&
+        Watch(epollFd_, session.fd, watch ? EPOLLIN | EPOLLOUT : EPOLLIN, EPOLL_CTL_MOD)) {
+        session.watchingWrite = watch;
+    }
+}
+
+void Server::Schedule(Session &session) {
+    if (session.timerQueued) {
+        return;
+    }
+    timers_.push(Timer{session.nextGravity, session.fd, session.id});
+    session.timerQueued = true;
+    ArmTimer();
+}
+
+void Server::ArmTimer() {
+    if (timers_.empty()) {
+        return;
+    }
+    const auto deadline = timers_.top().deadline;
+    if (armedFor_ && *armedFor_ <= deadline) {
+        return;
+    }
+    // steady_clock is CLOCK_MONOTONIC, so deadlines carry over as they are.
+    const auto nanos = std::max<std::int64_t>(
+        1, std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count());
+    itimerspec spec{};
+    spec.it_value.tv_sec = static_cast<time_t>(nanos / 1000000000);
+    spec.it_value.tv_nsec = static_cast<long>(nanos % 1000000000);
+    if (timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &spec, nullptr) == 0) {
+        armedFor_ = deadline;
+    }
+}
+
+void Server::Close(int fd) {
+    (void)epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    sessions_[fd].reset();
+    --stats_.sessions;
+}
+
+} // namespace mctetris::server
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "scores/score_writer.h"
+#include "ui/perf_metrics.h"
+
+namespace mctetris::server {
+
+struct ServerConfig {
+    std::string socketPath;
+    // Ranked games are submitted here when set.
+    std::optional<std::string> scoresPath;
+    // Connections beyond this are closed as soon as they are accepted.
+    int maxSessions = 16384;
+};
+
+struct ServerStats {
+    std::uint64_t accepted = 0;
+    // Refused at maxSessions or dropped for a malformed message.
+    std::uint64_t rejected = 0;
+    int sessions = 0;
+    int peakSessions = 0;
+    std::uint64_t inputs = 0;
+    std::uint64_t states = 0;
+    std::uint64_t bytesIn = 0;
+    std::uint64_t bytesOut = 0;
+    std::uint64_t rankedGames = 0;
+    // From epoll reporting a client's inputs to the State answering them
+    // being written.
+    ui::LatencyHistogram response;
+    // How late server-run gravity ticks fired against their schedule.
+    ui::LatencyHistogram gravityLate;
+};
+
+// Hosts one game per connection on a Unix domain socket, on the calling
+// thread: an epoll loop over every client socket, with server-run gravity
+// for all games driven by a single timerfd.
+//
+// Each session is a fixed-size object with fixed input and output buffers.
+// When a client reads slowly its States are not queued up: the session only
+// remembers that its game changed, and once the output buffer drains it gets
+// one State covering everything since the last, so memory per session stays
+// bounded however far behind the client falls.
+class Server {
+  public:
+    explicit Server(ServerConfig config);
+    ~Server();
+
+    Server(const Server &) = delete;
+    Server &operator=(const Server &) = delete;
+
+    // Binds the socket, replacing a stale one left by a server that died,
+    // but not one another server is still listening on.
+    [[nodiscard]] bool Start();
+    // Serves until `stopFd` becomes readable.
+    void Run(int stopFd);
+
+    [[nodiscard]] const ServerStats &Stats() const;
+
+  private:
+    struct Session;
+    struct Timer {
+        std::chrono::steady_clock::time_point deadline;
+        int fd;
+        std::uint64_t id;
+
+        friend bool operator>(const Timer &lhs, const Timer &rhs) {
+            return lhs.deadline > rhs.deadline;
+        }
+    };
+
+    void Accept();
+    void OnReadable(Session &session, std::chrono::steady_clock::time_point now);
+    void OnWritable(Session &session);
+    void OnTimer(std::chrono::steady_clock::time_point now);
+    // Applies one message; false if the client broke the protocol.
+    [[nodiscard]] bool Handle(Session &session, const std::uint8_t *message, std::size_t size,
+                              std::chrono::steady_clock::time_point now);
+    void AfterChange(Session &session);
+    // Encodes a State if the game changed and the output buffer has room,
+    // then writes out what it can. False if the client has gone.
+    [[nodiscard]] bool Send(Session &session);
+    void WatchWritable(Session &session, bool watch);
+    void Schedule(Session &session);
+    void ArmTimer();
+    void Close(int fd);
+
+    ServerConfig config_;
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    int timerFd_ = -1;
+    std::vector<std::unique_ptr<Session>> sessions_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<>> timers_;
+    std::optional<std::chrono::steady_clock::time_point> armedFor_;
+    std::unique_ptr<scores::ScoreWriter> scores_;
+    std::random_device seeds_;
+    std::uint64_t nextId_ = 1;
+    ServerStats stats_{};
+};
+
+} // namespace mctetris::server
@@ -0,0 +1,118 @@
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string>
+
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+#include "net/protocol.h"
+#include "server.h"
+#include "trace/trace.h"
+
+namespace {
+
+void PrintUsage() {
+    std::fprintf(stderr,
+                 "Usage: mctetris-server [--socket PATH] [--scores FILE] [--max-sessions N]\n"
+                 "\n"
+                 "Hosts games for `mctetris --connect` and mctetris-loadgen on a Unix domain\n"
+                 "socket (default %s) until SIGINT or SIGTERM.\n"
+                 "Finished server-timed games are ranked in --scores when it is given.\n",
+                 mctetris::net::DefaultSocketPath().c_str());
+}
+
+std::optional<mctetris::server::ServerConfig> ParseOptions(int argc, char **argv) {
+    mctetris::server::ServerConfig config;
+    config.socketPath = mctetris::net::DefaultSocketPath();
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--socket") == 0 && hasValue) {
+            config.socketPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--scores") == 0 && hasValue) {
+            config.scoresPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--max-sessions") == 0 && hasValue) {
+            char *end = nullptr;
+            const long value = std::strtol(argv[++i], &end, 10);
+            if (*end != '\0' || value < 1 || value > 1000000) {
+                return std::nullopt;
+            }
+            config.maxSessions = static_cast<int>(value);
+        } else {
+            return std::nullopt;
+        }
+    }
+    return config;
+}
+
+// Every session is a socket, so allow as many as the hard limit does.
+void RaiseDescriptorLimit() {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        (void)setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+double Ms(std::int64_t nanoseconds) {
+    return static_cast<double>(nanoseconds) / 1e6;
+}
+
+void PrintStats(const mctetris::server::ServerStats &stats) {
+    std::fprintf(stderr, "sessions: %llu accepted, %llu rejected, peak %d\n",
+                 static_cast<unsigned long long>(stats.accepted), static_cast<unsigned long long>(stats.rejected),
+                 stats.peakSessions);
+    std::fprintf(stderr, "messages: %llu inputs in, %llu states out, %llu/%llu bytes in/out\n",
+                 static_cast<unsigned long long>(stats.inputs), static_cast<unsigned long long>(stats.states),
+                 static_cast<unsigned long long>(stats.bytesIn), static_cast<unsigned long long>(stats.bytesOut));
+    std::fprintf(stderr, "ranked games: %llu\n", static_cast<unsigned long long>(stats.rankedGames));
+    const auto &response = stats.response;
+    std::fprintf(stderr, "response ms: p50 %.3f  p99 %.3f  max %.3f\n", Ms(response.Quantile(0.5)),
+                 Ms(response.Quantile(0.99)), Ms(response.Max()));
+    const auto &late = stats.gravityLate;
+    std::fprintf(stderr, "gravity late ms: p50 %.3f  p99 %.3f  max %.3f (%llu ticks)\n", Ms(late.Quantile(0.5)),
+                 Ms(late.Quantile(0.99)), Ms(late.Max()), static_cast<unsigned long long>(late.Count()));
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const auto config = ParseOptions(argc, argv);
+    if (!config) {
+        PrintUsage();
+        return 1;
+    }
+    RaiseDescriptorLimit();
+    mctetris::trace::StartFromEnvironment();
+    mctetris::trace::SetThreadName("server");
+
+    // SIGINT and SIGTERM arrive through a descriptor the event loop watches.
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &stopSignals, nullptr);
+    const int stopFd = signalfd(-1, &stopSignals, SFD_CLOEXEC);
+    if (stopFd < 0) {
+        std::perror("mctetris-server: signalfd");
+        return 1;
+    }
+
+    mctetris::server::Server server(*config);
+    if (!server.Start()) {
+        std::fprintf(stderr, "mctetris-server: cannot listen on '%s'\n", config->socketPath.c_str());
+        close(stopFd);
+        return 1;
+    }
+    std::fprintf(stderr, "mctetris-server: listening on %s\n", config->socketPath.c_str());
+    server.Run(stopFd);
+    close(stopFd);
+    PrintStats(server.Stats());
+    if (mctetris::trace::Enabled()) {
+        (void)mctetris::trace::Stop();
+    }
+    return 0;
+}
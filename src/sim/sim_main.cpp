@@ -0,0 +1,387 @@
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bot/bot.h"
+#include "model/game_session.h"
+#include "model/replay.h"
+#include "trace/trace.h"
+
+namespace {
+
+enum class SimAction : std::uint8_t {
+    Left,
+    Right,
+    Rotate,
+    SoftDrop,
+    HardDrop,
+    Gravity
+};
+
+struct SimOptions {
+    long long games = 1000;
+    std::uint32_t seed = 1;
+    long long maxActions = 100000;
+    bool autoplay = false;
+    mctetris::model::Randomizer randomizer = mctetris::model::Randomizer::Bag7;
+    mctetris::bot::BotConfig bot{};
+    std::optional<std::string> scriptPath;
+    std::optional<std::string> tracePath;
+    std::vector<std::string> replayPaths;
+};
+
+struct SimTotals {
+    long long games = 0;
+    long long pieces = 0;
+    long long lines = 0;
+    long long actions = 0;
+    long long score = 0;
+};
+
+void PrintUsage() {
+    std::fprintf(stderr,
+                 "Usage: mctetris-sim [--games N] [--seed S] [--script FILE] [--max-actions N]\n"
+                 "                    [--randomizer bag|uniform|history] [--trace FILE]\n"
+                 "                    [--autoplay [--beam N] [--threads N] [--depth N] [--table-bits N]]\n"
+                 "       mctetris-sim --replay FILE...\n"
+                 "\n"
+                 "Runs headless games as fast as possible and reports throughput.\n"
+                 "Without --script, inputs are drawn at random from the seed.\n"
+                 "Script files hold action letters replayed in a loop each game:\n"
+                 "  L/R move, U rotate, D soft drop, H hard drop, G gravity tick.\n"
+                 "--autoplay lets the search bot play and reports its decision latency.\n"
+                 "--replay re-executes recorded games and checks their final state.\n"
+                 "--trace writes a Chrome trace-event file (also set by $MCTETRIS_TRACE).\n");
+}
+
+std::optional<long long> ParseCount(const char *text) {
+    char *end = nullptr;
+    const long long value = std::strtoll(text, &end, 10);
+    if (end == text || *end != '\0' || value < 0) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+std::optional<SimOptions> ParseOptions(int argc, char **argv) {
+    SimOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--script") == 0 && hasValue) {
+            options.scriptPath = argv[++i];
+            continue;
+        }
+        if (std::strcmp(arg, "--trace") == 0 && hasValue) {
+            options.tracePath = argv[++i];
+            continue;
+        }
+        if (std::strcmp(arg, "--randomizer") == 0 && hasValue) {
+            const auto randomizer = mctetris::model::ParseRandomizer(argv[++i]);
+            if (!randomizer) {
+                return std::nullopt;
+            }
+            options.randomizer = *randomizer;
+            continue;
+        }
+        if (std::strcmp(arg, "--autoplay") == 0) {
+            options.autoplay = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--replay") == 0 && hasValue) {
+            while (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0) {
+                options.replayPaths.emplace_back(argv[++i]);
+            }
+            continue;
+        }
+        if (!hasValue) {
+            return std::nullopt;
+        }
+        const auto value = ParseCount(argv[++i]);
+        if (!value) {
+            return std::nullopt;
+        }
+        if (std::strcmp(arg, "--games") == 0) {
+            options.games = *value;
+        } else if (std::strcmp(arg, "--seed") == 0) {
+            options.seed = static_cast<std::uint32_t>(*value);
+        } else if (std::strcmp(arg, "--max-actions") == 0) {
+            options.maxActions = *value;
+        } else if (std::strcmp(arg, "--beam") == 0) {
+            options.bot.beamWidth = static_cast<int>(*value);
+        } else if (std::strcmp(arg, "--threads") == 0) {
+            options.bot.threads = static_cast<int>(*value);
+        } else if (std::strcmp(arg, "--depth") == 0) {
+            options.bot.unknownDepth = static_cast<int>(*value);
+        } else if (std::strcmp(arg, "--table-bits") == 0 && *value <= 30) {
+            options.bot.tableBits = static_cast<int>(*value);
+        } else {
+            return std::nullopt;
+        }
+    }
+    return options;
+}
+
+std::optional<SimAction> ActionForLetter(char letter) {
+    switch (letter) {
+    case 'L':
+        return SimAction::Left;
+    case 'R':
+        return SimAction::Right;
+    case 'U':
+        return SimAction::Rotate;
+    case 'D':
+        return SimAction::SoftDrop;
+    case 'H':
+        return SimAction::HardDrop;
+    case 'G':
+        return SimAction::Gravity;
+    default:
+        return std::nullopt;
+    }
+}
+
+std::optional<std::vector<SimAction>> LoadScript(const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::fprintf(stderr, "mctetris-sim: cannot open script '%s'\n", path.c_str());
+        return std::nullopt;
+    }
+    std::vector<SimAction> script;
+    char letter = 0;
+    while (file.get(letter)) {
+        if (std::isspace(static_cast<unsigned char>(letter))) {
+            continue;
+        }
+        const auto action = ActionForLetter(letter);
+        if (!action) {
+            std::fprintf(stderr, "mctetris-sim: unknown action '%c' in script\n", letter);
+            return std::nullopt;
+        }
+        script.push_back(*action);
+    }
+    if (script.empty()) {
+        std::fprintf(stderr, "mctetris-sim: script '%s' is empty\n", path.c_str());
+        return std::nullopt;
+    }
+    return script;
+}
+
+SimAction RandomAction(std::mt19937 &rng) {
+    // Weighted so that pieces travel and rotate a little before landing.
+    constexpr SimAction kBag[] = {SimAction::Left, SimAction::Left, SimAction::Right, SimAction::Right,
+                                  SimAction::Rotate, SimAction::Rotate, SimAction::SoftDrop,
+                                  SimAction::Gravity, SimAction::Gravity, SimAction::HardDrop};
+    constexpr std::uint32_t kBagSize = sizeof(kBag) / sizeof(kBag[0]);
+    return kBag[rng() % kBagSize];
+}
+
+void ApplyAction(mctetris::model::GameModel &model, SimAction action) {
+    switch (action) {
+    case SimAction::Left:
+        (void)model.Move(-1, 0);
+        break;
+    case SimAction::Right:
+        (void)model.Move(1, 0);
+        break;
+    case SimAction::Rotate:
+        (void)model.RotateCW();
+        break;
+    case SimAction::SoftDrop:
+        (void)model.SoftDrop();
+        break;
+    case SimAction::HardDrop:
+        model.HardDrop();
+        break;
+    case SimAction::Gravity:
+        model.TickGravity();
+        break;
+    }
+}
+
+void AddGame(const mctetris::model::GameSession &session, long long actions, SimTotals &totals) {
+    ++totals.games;
+    totals.pieces += session.PiecesSpawned();
+    totals.lines += session.Model().LinesCleared();
+    totals.score += session.Model().Score();
+    totals.actions += actions;
+}
+
+void RunGame(mctetris::model::GameSession &session, const SimOptions &options,
+             const std::vector<SimAction> &script, std::mt19937 &inputRng, SimTotals &totals) {
+    auto &model = session.Model();
+    long long actions = 0;
+    std::size_t cursor = 0;
+    while (!model.IsGameOver() && actions < options.maxActions) {
+        SimAction action = SimAction::Gravity;
+        if (script.empty()) {
+            action = RandomAction(inputRng);
+        } else {
+            action = script[cursor];
+            cursor = (cursor + 1) % script.size();
+        }
+        ApplyAction(model, action);
+        session.SpawnIfNeeded();
+        ++actions;
+    }
+    AddGame(session, actions, totals);
+}
+
+// Lets the bot place every piece; each placement counts its rotate, move and drop inputs as actions.
+void RunBotGame(mctetris::model::GameSession &session, const SimOptions &options, mctetris::bot::Bot &bot,
+                SimTotals &totals) {
+    const auto &model = session.Model();
+    long long actions = 0;
+    while (!model.IsGameOver() && actions < options.maxActions) {
+        const auto decision = bot.Decide(model, session.NextType());
+        if (!decision) {
+            break;
+        }
+        for (const auto action : decision->actions) {
+            (void)mctetris::model::ApplyReplayAction(session, action);
+        }
+        actions += static_cast<long long>(decision->actions.size());
+    }
+    AddGame(session, actions, totals);
+}
+
+double PerSecond(long long count, double seconds) {
+    return seconds > 0.0 ? static_cast<double>(count) / seconds : 0.0;
+}
+
+void PrintOutcome(const char *label, const mctetris::model::ReplayOutcome &outcome) {
+    std::fprintf(stderr, "  %s score %d lines %d level %d pieces %d board %016llx\n", label, outcome.score,
+                 outcome.lines, outcome.level, outcome.pieces, static_cast<unsigned long long>(outcome.boardHash));
+}
+
+// Re-executes each recording without timing and compares its outcome.
+int VerifyReplays(const std::vector<std::string> &paths) {
+    std::vector<mctetris::model::Replay> replays;
+    replays.reserve(paths.size());
+    for (const auto &path : paths) {
+        auto replay = mctetris::model::LoadReplay(path);
+        if (!replay) {
+            std::fprintf(stderr, "mctetris-sim: cannot read replay '%s'\n", path.c_str());
+            return 1;
+        }
+        replays.push_back(std::move(*replay));
+    }
+
+    mctetris::model::GameSession session;
+    long long events = 0;
+    int mismatches = 0;
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    for (std::size_t i = 0; i < replays.size(); ++i) {
+        const auto outcome = mctetris::model::RunReplay(replays[i], session);
+        events += static_cast<long long>(replays[i].events.size());
+        if (outcome != replays[i].outcome) {
+            ++mismatches;
+            std::fprintf(stderr, "MISMATCH %s\n", paths[i].c_str());
+            PrintOutcome("recorded", replays[i].outcome);
+            PrintOutcome("replayed", outcome);
+        }
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::printf("replays:    %zu (%d mismatched)\n", replays.size(), mismatches);
+    std::printf("events:     %lld\n", events);
+    std::printf("elapsed:    %.3f s\n", seconds);
+    std::printf("events/sec: %.1f\n", PerSecond(events, seconds));
+    return mismatches == 0 ? 0 : 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const auto options = ParseOptions(argc, argv);
+    if (!options) {
+        PrintUsage();
+        return 1;
+    }
+    if (!options->replayPaths.empty()) {
+        return VerifyReplays(options->replayPaths);
+    }
+
+    std::vector<SimAction> script;
+    if (options->scriptPath) {
+        auto loaded = LoadScript(*options->scriptPath);
+        if (!loaded) {
+            return 1;
+        }
+        script = std::move(*loaded);
+    }
+    if (options->tracePath) {
+        if (!mctetris::trace::Start(*options->tracePath)) {
+            std::fprintf(stderr, "mctetris-sim: cannot write '%s'\n", options->tracePath->c_str());
+            return 1;
+        }
+    } else {
+        mctetris::trace::StartFromEnvironment();
+    }
+    mctetris::trace::SetThreadName("main");
+
+    // Game seeds and random inputs both derive from --seed so runs repeat
+    // exactly; game N gets stream N, so it can be rerun without the others.
+    std::mt19937 inputRng(options->seed ^ 0x9e3779b9u);
+    mctetris::model::GameSession session(0, options->randomizer);
+    SimTotals totals;
+    std::optional<mctetris::bot::Bot> bot;
+    if (options->autoplay) {
+        bot.emplace(options->bot);
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    for (long long game = 0; game < options->games; ++game) {
+        MCTETRIS_TRACE_SCOPE("Game");
+        session.Reset(static_cast<std::uint32_t>(
+            mctetris::model::CounterRng::StreamKey(options->seed, static_cast<std::uint64_t>(game))));
+        if (bot) {
+            RunBotGame(session, *options, *bot, totals);
+        } else {
+            RunGame(session, *options, script, inputRng, totals);
+        }
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    const bool traced = mctetris::trace::Enabled();
+    const auto traceStats = mctetris::trace::Stop();
+
+    std::printf("games:   %lld\n", totals.games);
+    std::printf("pieces:  %lld\n", totals.pieces);
+    std::printf("lines:   %lld\n", totals.lines);
+    std::printf("actions: %lld\n", totals.actions);
+    std::printf("score:   %lld (mean %.1f)\n", totals.score,
+                totals.games > 0 ? static_cast<double>(totals.score) / static_cast<double>(totals.games) : 0.0);
+    std::printf("elapsed: %.3f s\n", seconds);
+    std::printf("games/sec:  %.1f\n", PerSecond(totals.games, seconds));
+    std::printf("pieces/sec: %.1f\n", PerSecond(totals.pieces, seconds));
+    std::printf("lines/sec:  %.1f\n", PerSecond(totals.lines, seconds));
+    if (bot) {
+        const auto &stats = bot->Stats();
+        std::printf("bot threads:   %d, beam %d\n", bot->Threads(), bot->Config().beamWidth);
+        std::printf("decisions:     %lld (%lld slower than gravity)\n", static_cast<long long>(stats.decisions),
+                    static_cast<long long>(stats.lateDecisions));
+        std::printf("decision ms:   mean %.3f, max %.3f\n", stats.MeanLatencyMs(), stats.MaxLatencyMs());
+        std::printf("nodes/sec:     %.0f\n", stats.NodesPerSecond());
+        if (bot->Config().tableBits > 0) {
+            std::printf("table:         %lld hits, %lld misses (%lld torn), %lld replacements (%.1f%% hit rate)\n",
+                        static_cast<long long>(stats.table.hits), static_cast<long long>(stats.table.misses),
+                        static_cast<long long>(stats.table.rejects),
+                        static_cast<long long>(stats.table.replacements), 100.0 * stats.table.HitRate());
+        }
+    }
+    if (traced) {
+        std::printf("trace:   %llu events, %llu dropped\n", static_cast<unsigned long long>(traceStats.events),
+                    static_cast<unsigned long long>(traceStats.dropped));
+    }
+    return 0;
+}
@@ -0,0 +1,229 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "input/spsc_ring.h"
+#include "trace.h"
+
+namespace mctetris::trace {
+namespace detail {
+
+std::atomic<bool> enabled{false};
+
+} // namespace detail
+
+namespace {
+
+// 16k events of 24 bytes per thread; a frame records a few dozen.
+constexpr std::size_t kRingCapacity = std::size_t{1} << 14;
+constexpr auto kFlushInterval = std::chrono::milliseconds(20);
+
+struct Event {
+    const char *name = nullptr;
+    std::int64_t startNs = 0;
+    std::int64_t endNs = 0;
+};
+
+struct ThreadBuffer {
+    input::SpscRing<Event, kRingCapacity> ring;
+    std::atomic<std::uint64_t> dropped{0};
+    int tid = 0;
+    // Guarded by Registry::mutex.
+    std::string name;
+};
+
+// Buffers outlive their threads so events recorded just before a thread
+// exits still reach the file.
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    int nextTid = 1;
+};
+
+struct Session {
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread flusher;
+    std::FILE *file = nullptr;
+    bool firstEvent = true;
+    std::uint64_t events = 0;
+};
+
+Registry &GlobalRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+Session &GlobalSession() {
+    static Session session;
+    return session;
+}
+
+thread_local ThreadBuffer *localBuffer = nullptr;
+thread_local const char *localName = nullptr;
+
+ThreadBuffer &LocalBuffer() {
+    if (localBuffer == nullptr) {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        Registry &registry = GlobalRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        buffer->tid = registry.nextTid++;
+        buffer->name = localName ? localName : "thread " + std::to_string(buffer->tid);
+        registry.buffers.push_back(buffer);
+        localBuffer = buffer.get();
+    }
+    return *localBuffer;
+}
+
+std::vector<std::shared_ptr<ThreadBuffer>> Buffers() {
+    Registry &registry = GlobalRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.buffers;
+}
+
+void Append(Session &session, std::string &out, const char *text) {
+    if (!session.firstEvent) {
+        out += ",\n";
+    }
+    session.firstEvent = false;
+    out += text;
+}
+
+// Moves every buffered event into the file. Only one thread drains at a time:
+// the flusher while it runs, then Stop once it has joined.
+void Drain(Session &session) {
+    std::string out;
+    const int pid = static_cast<int>(getpid());
+    for (const auto &buffer : Buffers()) {
+        Event event;
+        while (buffer->ring.TryPop(event)) {
+            char line[256];
+            std::snprintf(line, sizeof(line), R"({"name":"%s","ph":"X","ts":%.3f,"dur":%.3f,"pid":%d,"tid":%d})",
+                          event.name, static_cast<double>(event.startNs) / 1000.0,
+                          static_cast<double>(event.endNs - event.startNs) / 1000.0, pid, buffer->tid);
+            Append(session, out, line);
+            ++session.events;
+        }
+    }
+    if (!out.empty()) {
+        std::fwrite(out.data(), 1, out.size(), session.file);
+    }
+}
+
+void FlushLoop(Session &session) {
+    std::unique_lock<std::mutex> lock(session.mutex);
+    while (!session.stopping) {
+        session.wake.wait_for(lock, kFlushInterval, [&]() { return session.stopping; });
+        Drain(session);
+    }
+}
+
+} // namespace
+
+namespace detail {
+
+void Record(const char *name, std::int64_t startNs, std::int64_t endNs) {
+    ThreadBuffer &buffer = LocalBuffer();
+    if (!buffer.ring.TryPush(Event{name, startNs, endNs})) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+std::int64_t Now() {
+    return ToNs(std::chrono::steady_clock::now());
+}
+
+std::int64_t ToNs(std::chrono::steady_clock::time_point time) {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time - epoch).count();
+}
+
+} // namespace detail
+
+bool Start(const std::string &path) {
+    Session &session = GlobalSession();
+    std::lock_guard<std::mutex> lock(session.mutex);
+    if (session.file != nullptr) {
+        return false;
+    }
+    session.file = std::fopen(path.c_str(), "w");
+    if (session.file == nullptr) {
+        return false;
+    }
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", session.file);
+    session.firstEvent = true;
+    session.events = 0;
+    session.stopping = false;
+    // Anything left from an earlier session is discarded.
+    for (const auto &buffer : Buffers()) {
+        Event event;
+        while (buffer->ring.TryPop(event)) {
+        }
+        buffer->dropped.store(0, std::memory_order_relaxed);
+    }
+    (void)detail::Now();
+    session.flusher = std::thread([&session]() { FlushLoop(session); });
+    detail::enabled.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+bool StartFromEnvironment() {
+    const char *path = std::getenv("MCTETRIS_TRACE");
+    return path != nullptr && *path != '\0' && Start(path);
+}
+
+TraceStats Stop() {
+    Session &session = GlobalSession();
+    TraceStats stats;
+    {
+        std::lock_guard<std::mutex> lock(session.mutex);
+        if (session.file == nullptr) {
+            return stats;
+        }
+        detail::enabled.store(false, std::memory_order_relaxed);
+        session.stopping = true;
+    }
+    session.wake.notify_one();
+    session.flusher.join();
+
+    std::lock_guard<std::mutex> lock(session.mutex);
+    Drain(session);
+    std::string out;
+    const int pid = static_cast<int>(getpid());
+    for (const auto &buffer : Buffers()) {
+        std::string name;
+        {
+            std::lock_guard<std::mutex> registryLock(GlobalRegistry().mutex);
+            name = buffer->name;
+        }
+        char line[256];
+        std::snprintf(line, sizeof(line), R"({"name":"thread_name","ph":"M","pid":%d,"tid":%d,"args":{"name":"%s"}})",
+                      pid, buffer->tid, name.c_str());
+        Append(session, out, line);
+        stats.dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    out += "\n]}\n";
+    std::fwrite(out.data(), 1, out.size(), session.file);
+    std::fclose(session.file);
+    session.file = nullptr;
+    stats.events = session.events;
+    return stats;
+}
+
+void SetThreadName(const char *name) {
+    localName = name;
+    if (localBuffer != nullptr) {
+        std::lock_guard<std::mutex> lock(GlobalRegistry().mutex);
+        localBuffer->name = name;
+    }
+}
+
+} // namespace mctetris::trace
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Build with -DMCTETRIS_TRACING=OFF to compile every trace scope away.
+#ifndef MCTETRIS_TRACING
+#define MCTETRIS_TRACING 1
+#endif
+
+namespace mctetris::trace {
+
+inline constexpr bool kCompiledIn = MCTETRIS_TRACING != 0;
+
+struct TraceStats {
+    std::uint64_t events = 0;
+    // Events lost because a thread's ring was full when it recorded them.
+    std::uint64_t dropped = 0;
+};
+
+namespace detail {
+extern std::atomic<bool> enabled;
+void Record(const char *name, std::int64_t startNs, std::int64_t endNs);
+std::int64_t Now();
+std::int64_t ToNs(std::chrono::steady_clock::time_point time);
+} // namespace detail
+
+// One relaxed load; this is all a scope costs while tracing is off.
+inline bool Enabled() {
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+// Starts writing Chrome trace-event JSON (chrome://tracing, Perfetto) to
+// `path`. Each thread records into its own lock-free ring and a background
+// thread drains the rings into the file.
+[[nodiscard]] bool Start(const std::string &path);
+// Starts tracing to $MCTETRIS_TRACE if it is set. Returns false if it is not
+// set or the file cannot be opened.
+bool StartFromEnvironment();
+// Stops recording, writes everything still buffered and closes the file.
+TraceStats Stop();
+// Names the calling thread in the trace viewer.
+void SetThreadName(const char *name);
+
+// Records a span the caller has already timed, for loops that measure their
+// phases anyway.
+inline void Complete(const char *name, std::chrono::steady_clock::time_point start,
+                     std::chrono::steady_clock::time_point end) {
+    if (Enabled()) {
+        detail::Record(name, detail::ToNs(start), detail::ToNs(end));
+    }
+}
+
+// Times the enclosing scope as one complete event. `name` must be a string
+// literal (or otherwise outlive the trace) with no characters JSON escapes.
+class Scope {
+  public:
+    explicit Scope(const char *name) : name_(Enabled() ? name : nullptr), start_(name_ ? detail::Now() : 0) {}
+    ~Scope() {
+        if (name_) {
+            detail::Record(name_, start_, detail::Now());
+        }
+    }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    const char *name_;
+    std::int64_t start_;
+};
+
+} // namespace mctetris::trace
+
+#define MCTETRIS_TRACE_CONCAT_INNER(a, b) a##b
+#define MCTETRIS_TRACE_CONCAT(a, b) MCTETRIS_TRACE_CONCAT_INNER(a, b)
+#if MCTETRIS_TRACING
+#define MCTETRIS_TRACE_SCOPE(name) const ::mctetris::trace::Scope MCTETRIS_TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define MCTETRIS_TRACE_COMPLETE(name, start, end) ::mctetris::trace::Complete(name, start, end)
+#else
+#define MCTETRIS_TRACE_SCOPE(name) static_cast<void>(0)
+#define MCTETRIS_TRACE_COMPLETE(name, start, end) static_cast<void>(0)
+#endif
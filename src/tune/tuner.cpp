@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <random>
+
+#include "bot/bot.h"
+#include "model/game_session.h"
+#include "tuner.h"
+
+namespace mctetris::tune {
+namespace {
+
+constexpr double kEliteFraction = 0.25;
+constexpr double kZ95 = 1.96;
+// Extra standard deviation added after each refit so the search does not
+// collapse onto an early elite; it decays as the run goes on.
+constexpr double kInitialNoise = 0.1;
+constexpr double kNoiseHalfLife = 10.0;
+constexpr double kInitialSigma = 0.5;
+// Held-out games use a batch number no generation reaches; mctetris-tune
+// validates on ~0.
+constexpr std::uint64_t kHeldOutBatch = ~std::uint64_t{0} - 1;
+constexpr const char *kCheckpointHeader = "mctetris-tune 2";
+
+std::uint64_t SplitMix64(std::uint64_t value) {
+    value += 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+struct Summary {
+    double mean = 0.0;
+    double halfWidth95 = 0.0;
+};
+
+template <typename Values>
+Summary Summarize(const Values &values) {
+    Summary summary;
+    const double count = static_cast<double>(values.size());
+    if (values.empty()) {
+        return summary;
+    }
+    summary.mean = std::accumulate(values.begin(), values.end(), 0.0) / count;
+    if (values.size() > 1) {
+        double squares = 0.0;
+        for (const double value : values) {
+            squares += (value - summary.mean) * (value - summary.mean);
+        }
+        summary.halfWidth95 = kZ95 * std::sqrt(squares / (count - 1.0) / count);
+    }
+    return summary;
+}
+
+void WriteVector(std::ofstream &file, const char *key, const WeightVector &vector) {
+    file << key;
+    for (const double value : vector) {
+        file << ' ' << value;
+    }
+    file << '\n';
+}
+
+bool ReadVector(std::ifstream &file, const char *key, WeightVector &vector) {
+    std::string name;
+    if (!(file >> name) || name != key) {
+        return false;
+    }
+    for (double &value : vector) {
+        if (!(file >> value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bot::Weights ToWeights(const WeightVector &vector) {
+    return bot::Weights{vector[0], vector[1], vector[2], vector[3]};
+}
+
+WeightVector FromWeights(const bot::Weights &weights) {
+    return {weights.aggregateHeight, weights.lines, weights.holes, weights.bumpiness};
+}
+
+WeightVector Normalized(WeightVector vector) {
+    // The evaluation is only ever compared, so scale carries no information.
+    double norm = 0.0;
+    for (const double value : vector) {
+        norm += value * value;
+    }
+    norm = std::sqrt(norm);
+    if (norm > 0.0) {
+        for (double &value : vector) {
+            value /= norm;
+        }
+    }
+    return vector;
+}
+
+std::uint32_t GameSeed(std::uint64_t base, std::uint64_t batch, std::uint64_t game) {
+    return static_cast<std::uint32_t>(SplitMix64(SplitMix64(base ^ SplitMix64(batch)) + game));
+}
+
+GameRunner::GameRunner(const TuneConfig &config) : config_(config), pool_(config.threads) {}
+
+std::vector<Fitness> GameRunner::Evaluate(const std::vector<WeightVector> &candidates, int games,
+                                          std::uint64_t batch) {
+    const int total = static_cast<int>(candidates.size()) * games;
+    std::vector<int> lines(static_cast<std::size_t>(total));
+    std::vector<int> pieces(static_cast<std::size_t>(total));
+    pool_.ParallelFor(total, [&](int index, int) {
+        const int candidate = index / games;
+        const int game = index % games;
+        model::GameSession session(GameSeed(config_.seed, batch, static_cast<std::uint64_t>(game)));
+        bot::BotConfig botConfig;
+        botConfig.beamWidth = config_.beamWidth;
+        botConfig.threads = 1;
+        botConfig.unknownDepth = 0;
+        botConfig.tableBits = 0;
+        botConfig.weights = ToWeights(candidates[static_cast<std::size_t>(candidate)]);
+        bot::Bot player(botConfig);
+        while (!session.Model().IsGameOver() && session.PiecesSpawned() <= config_.maxPieces) {
+            const auto decision = player.Decide(session.Model(), session.NextType());
+            if (!decision) {
+                break;
+            }
+            for (const auto action : decision->actions) {
+                (void)model::ApplyReplayAction(session, action);
+            }
+        }
+        lines[static_cast<std::size_t>(index)] = session.Model().LinesCleared();
+        pieces[static_cast<std::size_t>(index)] = session.PiecesSpawned();
+    });
+
+    std::vector<Fitness> fitness(candidates.size());
+    std::vector<double> sample(static_cast<std::size_t>(games));
+    for (std::size_t candidate = 0; candidate < candidates.size(); ++candidate) {
+        for (int game = 0; game < games; ++game) {
+            sample[static_cast<std::size_t>(game)] = lines[candidate * static_cast<std::size_t>(games) + game];
+        }
+        const Summary summary = Summarize(sample);
+        fitness[candidate] = Fitness{summary.mean, summary.halfWidth95, games};
+    }
+    piecesPlayed_ += std::accumulate(pieces.begin(), pieces.end(), 0LL);
+    return fitness;
+}
+
+long long GameRunner::PiecesPlayed() const {
+    return piecesPlayed_;
+}
+
+int GameRunner::Threads() const {
+    return pool_.Concurrency();
+}
+
+CrossEntropyTuner::CrossEntropyTuner(const TuneConfig &config, GameRunner &runner)
+    : config_(config), runner_(runner) {}
+
+void CrossEntropyTuner::Start(const WeightVector &initial) {
+    state_ = TuneState{};
+    state_.seed = config_.seed;
+    state_.mean = Normalized(initial);
+    state_.sigma.fill(kInitialSigma);
+    state_.best = state_.mean;
+    state_.eliteMean = state_.mean;
+}
+
+void CrossEntropyTuner::Resume(const TuneState &state) {
+    state_ = state;
+}
+
+GenerationReport CrossEntropyTuner::Step() {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const long long piecesBefore = runner_.PiecesPlayed();
+
+    // Sampling depends only on the seed and generation so a resumed run repeats exactly.
+    std::mt19937_64 rng(SplitMix64(state_.seed ^ SplitMix64(static_cast<std::uint64_t>(state_.generation))));
+    std::normal_distribution<double> normal(0.0, 1.0);
+    std::vector<WeightVector> candidates(static_cast<std::size_t>(config_.population));
+    for (auto &candidate : candidates) {
+        for (int i = 0; i < kWeightCount; ++i) {
+            candidate[i] = state_.mean[i] + state_.sigma[i] * normal(rng);
+        }
+        candidate = Normalized(candidate);
+    }
+
+    const auto fitness = runner_.Evaluate(candidates, config_.gamesPerCandidate,
+                                          static_cast<std::uint64_t>(state_.generation));
+    std::vector<std::size_t> order(candidates.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::sort(order.begin(), order.end(),
+              [&](std::size_t lhs, std::size_t rhs) { return fitness[lhs].mean > fitness[rhs].mean; });
+
+    const std::size_t eliteCount =
+        std::max<std::size_t>(2, static_cast<std::size_t>(std::ceil(kEliteFraction * config_.population)));
+    const std::size_t elites = std::min(eliteCount, order.size());
+    const double noise = kInitialNoise / (1.0 + state_.generation / kNoiseHalfLife);
+    double eliteFitness = 0.0;
+    for (int i = 0; i < kWeightCount; ++i) {
+        std::vector<double> values;
+        values.reserve(elites);
+        for (std::size_t rank = 0; rank < elites; ++rank) {
+            values.push_back(candidates[order[rank]][i]);
+        }
+        const Summary summary = Summarize(values);
+        double variance = 0.0;
+        for (const double value : values) {
+            variance += (value - summary.mean) * (value - summary.mean);
+        }
+        variance /= static_cast<double>(values.size());
+        state_.mean[i] = summary.mean;
+        state_.sigma[i] = std::sqrt(variance + noise * noise);
+        state_.eliteMean[i] = summary.mean;
+        state_.eliteHalfWidth95[i] = summary.halfWidth95;
+    }
+    for (std::size_t rank = 0; rank < elites; ++rank) {
+        eliteFitness += fitness[order[rank]].mean;
+    }
+    eliteFitness /= static_cast<double>(elites);
+    state_.mean = Normalized(state_.mean);
+
+    const Fitness &top = fitness[order.front()];
+    // The old best is replayed rather than trusted: every candidate here is
+    // scored on the same held-out games, so the comparison is like for like.
+    const std::vector<WeightVector> finalists = {state_.mean, candidates[order.front()], state_.best};
+    const auto heldOut = runner_.Evaluate(finalists, config_.heldOutGames, kHeldOutBatch);
+    std::size_t winner = 2;
+    for (std::size_t i = 0; i < 2; ++i) {
+        if (heldOut[i].mean > heldOut[winner].mean) {
+            winner = i;
+        }
+    }
+    state_.best = finalists[winner];
+    state_.bestFitness = heldOut[winner].mean;
+    state_.bestHalfWidth95 = heldOut[winner].halfWidth95;
+
+    GenerationReport report;
+    report.generation = state_.generation;
+    report.bestCandidate = top;
+    report.eliteFitness = eliteFitness;
+    report.heldOutMean = heldOut[0];
+    report.heldOutBest = heldOut[winner];
+    report.games = static_cast<long long>(config_.population) * config_.gamesPerCandidate +
+                   static_cast<long long>(finalists.size()) * config_.heldOutGames;
+    report.pieces = runner_.PiecesPlayed() - piecesBefore;
+    report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    ++state_.generation;
+    return report;
+}
+
+const TuneState &CrossEntropyTuner::State() const {
+    return state_;
+}
+
+bool SaveCheckpoint(const std::string &path, const TuneState &state) {
+    // Written beside the target and renamed over it so a crash never leaves half a checkpoint.
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        file.precision(17);
+        file << kCheckpointHeader << '\n';
+        file << "seed " << state.seed << '\n';
+        file << "generation " << state.generation << '\n';
+        WriteVector(file, "mean", state.mean);
+        WriteVector(file, "sigma", state.sigma);
+        WriteVector(file, "best", state.best);
+        file << "best-fitness " << state.bestFitness << '\n';
+        file << "best-ci95 " << state.bestHalfWidth95 << '\n';
+        WriteVector(file, "elite-mean", state.eliteMean);
+        WriteVector(file, "elite-ci95", state.eliteHalfWidth95);
+        if (!file.flush()) {
+            return false;
+        }
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+std::optional<TuneState> LoadCheckpoint(const std::string &path) {
+    std::ifstream file(path);
+    std::string header;
+    if (!file || !std::getline(file, header) || header != kCheckpointHeader) {
+        return std::nullopt;
+    }
+    TuneState state;
+    std::string key;
+    if (!(file >> key >> state.seed) || key != "seed" || !(file >> key >> state.generation) ||
+        key != "generation") {
+        return std::nullopt;
+    }
+    if (!ReadVector(file, "mean", state.mean) || !ReadVector(file, "sigma", state.sigma) ||
+        !ReadVector(file, "best", state.best)) {
+        return std::nullopt;
+    }
+    if (!(file >> key >> state.bestFitness) || key != "best-fitness") {
+        return std::nullopt;
+    }
+    if (!(file >> key >> state.bestHalfWidth95) || key != "best-ci95") {
+        return std::nullopt;
+    }
+    if (!ReadVector(file, "elite-mean", state.eliteMean) || !ReadVector(file, "elite-ci95", state.eliteHalfWidth95)) {
+        return std::nullopt;
+    }
+    return state;
+}
+
+} // namespace mctetris::tune
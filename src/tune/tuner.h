@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "bot/heuristics.h"
+#include "bot/work_pool.h"
+
+namespace mctetris::tune {
+
+// Aggregate height, lines, holes, bumpiness, in that order.
+constexpr int kWeightCount = 4;
+using WeightVector = std::array<double, kWeightCount>;
+
+[[nodiscard]] bot::Weights ToWeights(const WeightVector &vector);
+[[nodiscard]] WeightVector FromWeights(const bot::Weights &weights);
+
+struct TuneConfig {
+    int population = 32;
+    int gamesPerCandidate = 16;
+    // Games on a fixed seed set, the same every generation, on which the
+    // elite mean and best so far are compared.
+    int heldOutGames = 32;
+    // Games stop here so good candidates finish; fitness is lines cleared.
+    int maxPieces = 500;
+    int beamWidth = 1;
+    int threads = 0;
+    std::uint64_t seed = 1;
+};
+
+// Mean lines per game with a normal-approximation 95% interval.
+struct Fitness {
+    double mean = 0.0;
+    double halfWidth95 = 0.0;
+    int games = 0;
+};
+
+// Everything needed to continue a run: the sampling distribution and the
+// best candidate so far, by its score on the held-out games. Written after
+// every generation.
+struct TuneState {
+    std::uint64_t seed = 0;
+    int generation = 0;
+    WeightVector mean{};
+    WeightVector sigma{};
+    WeightVector best{};
+    double bestFitness = 0.0;
+    double bestHalfWidth95 = 0.0;
+    // Mean and 95% half-width of each weight across the last elite set.
+    WeightVector eliteMean{};
+    WeightVector eliteHalfWidth95{};
+};
+
+struct GenerationReport {
+    int generation = 0;
+    // On this generation's games, so the top of the population is biased up.
+    Fitness bestCandidate{};
+    double eliteFitness = 0.0;
+    // The refitted mean and the best so far, on the held-out games.
+    Fitness heldOutMean{};
+    Fitness heldOutBest{};
+    long long games = 0;
+    long long pieces = 0;
+    double seconds = 0.0;
+};
+
+// Plays bot games on every thread. Game g of a batch gets the same seed for
+// every candidate, so candidates are compared on identical piece sequences.
+class GameRunner {
+  public:
+    explicit GameRunner(const TuneConfig &config);
+
+    // Game seeds come from the configured seed and `batch`.
+    [[nodiscard]] std::vector<Fitness> Evaluate(const std::vector<WeightVector> &candidates, int games,
+                                                std::uint64_t batch);
+    [[nodiscard]] long long PiecesPlayed() const;
+    [[nodiscard]] int Threads() const;
+
+  private:
+    TuneConfig config_;
+    bot::WorkPool pool_;
+    long long piecesPlayed_ = 0;
+};
+
+// Cross-entropy method: sample a population from a diagonal Gaussian, keep
+// the top quarter, refit the Gaussian to it with a little decaying noise.
+// Each generation plays fresh seeds, and its top candidate is the luckiest
+// of many noisy estimates, so the best so far is only replaced after the
+// new mean, the generation's top and the old best are replayed on the
+// held-out seeds.
+class CrossEntropyTuner {
+  public:
+    CrossEntropyTuner(const TuneConfig &config, GameRunner &runner);
+
+    void Start(const WeightVector &initial);
+    void Resume(const TuneState &state);
+    [[nodiscard]] GenerationReport Step();
+    [[nodiscard]] const TuneState &State() const;
+
+  private:
+    TuneConfig config_;
+    GameRunner &runner_;
+    TuneState state_{};
+};
+
+[[nodiscard]] WeightVector Normalized(WeightVector vector);
+// Seed for game `game` of `batch`, independent of which thread plays it.
+[[nodiscard]] std::uint32_t GameSeed(std::uint64_t base, std::uint64_t batch, std::uint64_t game);
+
+[[nodiscard]] bool SaveCheckpoint(const std::string &path, const TuneState &state);
+[[nodiscard]] std::optional<TuneState> LoadCheckpoint(const std::string &path);
+
+} // namespace mctetris::tune
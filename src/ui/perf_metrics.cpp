@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "perf_metrics.h"
+
+namespace mctetris::ui {
+namespace {
+
+constexpr int kSubBuckets = 1 << LatencyHistogram::kSubBucketBits;
+
+double Milliseconds(std::int64_t nanoseconds) {
+    return static_cast<double>(nanoseconds) / 1e6;
+}
+
+} // namespace
+
+void LatencyHistogram::Add(std::int64_t nanoseconds) {
+    ++counts_[BucketFor(nanoseconds)];
+    ++count_;
+    max_ = std::max(max_, nanoseconds);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram &other) {
+    for (int i = 0; i < kBuckets; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    max_ = std::max(max_, other.max_);
+}
+
+void LatencyHistogram::Clear() {
+    counts_.fill(0);
+    count_ = 0;
+    max_ = 0;
+}
+
+std::uint64_t LatencyHistogram::Count() const {
+    return count_;
+}
+
+std::int64_t LatencyHistogram::Max() const {
+    return max_;
+}
+
+std::int64_t LatencyHistogram::Quantile(double q) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    const auto rank = static_cast<std::uint64_t>(q * static_cast<double>(count_ - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            return std::min(BucketUpperBound(i), max_);
+        }
+    }
+    return max_;
+}
+
+std::uint32_t LatencyHistogram::BucketCount(int bucket) const {
+    return counts_[bucket];
+}
+
+int LatencyHistogram::BucketFor(std::int64_t nanoseconds) {
+    if (nanoseconds < kSubBuckets) {
+        return static_cast<int>(std::max<std::int64_t>(nanoseconds, 0));
+    }
+    const int exponent = 63 - __builtin_clzll(static_cast<unsigned long long>(nanoseconds));
+    const int shift = exponent - kSubBucketBits;
+    const int bucket = (exponent - kSubBucketBits + 1) * kSubBuckets + static_cast<int>((nanoseconds >> shift) & (kSubBuckets - 1));
+    return std::min(bucket, kBuckets - 1);
+}
+
+std::int64_t LatencyHistogram::BucketUpperBound(int bucket) {
+    if (bucket < kSubBuckets) {
+        return bucket;
+    }
+    const int shift = bucket / kSubBuckets - 1;
+    const std::int64_t lower = static_cast<std::int64_t>(kSubBuckets + bucket % kSubBuckets) << shift;
+    return lower + (std::int64_t{1} << shift) - 1;
+}
+
+void RollingHistogram::Add(std::int64_t nanoseconds, std::chrono::steady_clock::time_point now) {
+    const std::int64_t slice = SliceOf(now);
+    const auto index = static_cast<std::size_t>(slice % kSlices);
+    if (sliceIds_[index] != slice) {
+        slices_[index].Clear();
+        sliceIds_[index] = slice;
+    }
+    slices_[index].Add(nanoseconds);
+}
+
+LatencyHistogram RollingHistogram::Window(std::chrono::steady_clock::time_point now) const {
+    const std::int64_t slice = SliceOf(now);
+    LatencyHistogram window;
+    for (int i = 0; i < kSlices; ++i) {
+        if (sliceIds_[i] > slice - kSlices && sliceIds_[i] <= slice) {
+            window.Merge(slices_[i]);
+        }
+    }
+    return window;
+}
+
+std::int64_t RollingHistogram::SliceOf(std::chrono::steady_clock::time_point now) {
+    return std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+}
+
+const char *PerfMetricName(PerfMetric metric) {
+    switch (metric) {
+    case PerfMetric::Frame:
+        return "frame";
+    case PerfMetric::Input:
+        return "input";
+    case PerfMetric::Update:
+        return "update";
+    case PerfMetric::Render:
+        return "render";
+    case PerfMetric::Doupdate:
+        return "doupdate";
+    case PerfMetric::GravityLate:
+        return "gravity late";
+    case PerfMetric::InputToFrame:
+        return "key to frame";
+    case PerfMetric::Count:
+        break;
+    }
+    return "?";
+}
+
+void PerfMetrics::Add(PerfMetric metric, std::chrono::nanoseconds duration,
+                      std::chrono::steady_clock::time_point now) {
+    const auto index = static_cast<std::size_t>(metric);
+    session_[index].Add(duration.count());
+    window_[index].Add(duration.count(), now);
+}
+
+const LatencyHistogram &PerfMetrics::Session(PerfMetric metric) const {
+    return session_[static_cast<std::size_t>(metric)];
+}
+
+LatencyHistogram PerfMetrics::Window(PerfMetric metric, std::chrono::steady_clock::time_point now) const {
+    return window_[static_cast<std::size_t>(metric)].Window(now);
+}
+
+bool PerfMetrics::Dump(const std::string &path) const {
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    std::fprintf(file, "# metric count p50_ms p90_ms p99_ms max_ms\n");
+    for (int i = 0; i < kMetricCount; ++i) {
+        const auto &histogram = session_[i];
+        std::fprintf(file, "%-14s %8llu %9.3f %9.3f %9.3f %9.3f\n", PerfMetricName(static_cast<PerfMetric>(i)),
+                     static_cast<unsigned long long>(histogram.Count()), Milliseconds(histogram.Quantile(0.5)),
+                     Milliseconds(histogram.Quantile(0.9)), Milliseconds(histogram.Quantile(0.99)),
+                     Milliseconds(histogram.Max()));
+    }
+    std::fprintf(file, "\n# metric bucket_upper_ns count\n");
+    for (int i = 0; i < kMetricCount; ++i) {
+        for (int bucket = 0; bucket < LatencyHistogram::kBuckets; ++bucket) {
+            if (const auto count = session_[i].BucketCount(bucket)) {
+                std::fprintf(file, "%s %lld %u\n", PerfMetricName(static_cast<PerfMetric>(i)),
+                             static_cast<long long>(LatencyHistogram::BucketUpperBound(bucket)), count);
+            }
+        }
+    }
+    return std::fclose(file) == 0;
+}
+
+} // namespace mctetris::ui
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace mctetris::ui {
+
+// Log-linear histogram of nanosecond durations: eight buckets per power of
+// two, so any recorded value is known to within 12.5%. Fixed size and never
+// allocates.
+class LatencyHistogram {
+  public:
+    static constexpr int kSubBucketBits = 3;
+    static constexpr int kBuckets = 280;
+
+    void Add(std::int64_t nanoseconds);
+    void Merge(const LatencyHistogram &other);
+    void Clear();
+
+    [[nodiscard]] std::uint64_t Count() const;
+    [[nodiscard]] std::int64_t Max() const;
+    // Upper edge of the bucket holding quantile `q`, capped at Max().
+    [[nodiscard]] std::int64_t Quantile(double q) const;
+    [[nodiscard]] std::uint32_t BucketCount(int bucket) const;
+    [[nodiscard]] static int BucketFor(std::int64_t nanoseconds);
+    [[nodiscard]] static std::int64_t BucketUpperBound(int bucket);
+
+  private:
+    std::array<std::uint32_t, kBuckets> counts_{};
+    std::uint64_t count_ = 0;
+    std::int64_t max_ = 0;
+};
+
+// The last kSlices seconds of samples, kept as one histogram per second so
+// old samples drop out without storing them individually.
+class RollingHistogram {
+  public:
+    static constexpr int kSlices = 5;
+
+    void Add(std::int64_t nanoseconds, std::chrono::steady_clock::time_point now);
+    // Merges the slices still inside the window ending at `now`.
+    [[nodiscard]] LatencyHistogram Window(std::chrono::steady_clock::time_point now) const;
+
+  private:
+    [[nodiscard]] static std::int64_t SliceOf(std::chrono::steady_clock::time_point now);
+
+    std::array<LatencyHistogram, kSlices> slices_{};
+    std::array<std::int64_t, kSlices> sliceIds_{-1, -1, -1, -1, -1};
+};
+
+enum class PerfMetric : std::uint8_t {
+    // Work done per loop iteration, idle waiting excluded.
+    Frame,
+    Input,
+    // One simulation step, on the simulation thread.
+    Update,
+    // Composing and diffing the frame, doupdate() excluded.
+    Render,
+    Doupdate,
+    // How late each gravity tick fired against its schedule.
+    GravityLate,
+    // From a key being read off the terminal to the frame that shows it.
+    InputToFrame,
+    Count
+};
+
+[[nodiscard]] const char *PerfMetricName(PerfMetric metric);
+
+// Every engine timing the performance HUD shows, for the whole session and
+// for the rolling window.
+class PerfMetrics {
+  public:
+    static constexpr int kMetricCount = static_cast<int>(PerfMetric::Count);
+
+    void Add(PerfMetric metric, std::chrono::nanoseconds duration, std::chrono::steady_clock::time_point now);
+
+    [[nodiscard]] const LatencyHistogram &Session(PerfMetric metric) const;
+    [[nodiscard]] LatencyHistogram Window(PerfMetric metric, std::chrono::steady_clock::time_point now) const;
+
+    // Writes per-metric percentiles and the non-empty buckets of each session
+    // histogram as text.
+    [[nodiscard]] bool Dump(const std::string &path) const;
+
+  private:
+    std::array<LatencyHistogram, kMetricCount> session_{};
+    std::array<RollingHistogram, kMetricCount> window_{};
+};
+
+} // namespace mctetris::ui
@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+
+#include <curses.h>
+
+#include "render.h"
+#include "trace/trace.h"
+
+namespace mctetris::ui {
+namespace {
+
+constexpr int kBoardOffsetX = 2;
+constexpr int kBoardOffsetY = 1;
+constexpr int kCellWidth = 4;
+constexpr int kCellHeight = 2;
+constexpr int kPanelOffsetX = 16;
+constexpr int kNextPanelWidth = kCellWidth * 4 + 4;
+constexpr int kNextPanelHeight = kCellHeight * 4 + 4;
+constexpr int kStatsPanelWidth = 18;
+constexpr int kStatsPanelHeight = 6;
+constexpr int kHudPanelWidth = 40;
+// Grid tiles: a boxed board at one character per cell with a score line under it.
+constexpr int kTileWidth = mctetris::model::kBoardWidth + 2;
+constexpr int kTileHeight = mctetris::model::kBoardHeight + 3;
+
+short ColorPairForCell(mctetris::model::Cell cell) {
+    using mctetris::model::Cell;
+    switch (cell) {
+    case Cell::I:
+        return 1;
+    case Cell::O:
+        return 2;
+    case Cell::T:
+        return 3;
+    case Cell::S:
+        return 4;
+    case Cell::Z:
+        return 5;
+    case Cell::J:
+        return 6;
+    case Cell::L:
+        return 7;
+    case Cell::Empty:
+        return 0;
+    }
+    return 0;
+}
+
+void DrawCell(ScreenBuffer &screen, int screenY, int screenX, mctetris::model::Cell cell) {
+    const auto pair = static_cast<std::uint8_t>(ColorPairForCell(cell));
+    screen.FillRect(screenY, screenX, kCellHeight, kCellWidth, ScreenCell{' ', pair, kAttrNone});
+}
+
+void RenderNextPiecePanel(ScreenBuffer &screen, int top, int left,
+                          const std::optional<mctetris::model::TetrominoType> &nextType) {
+    screen.Box(top, left, kNextPanelHeight, kNextPanelWidth);
+    screen.Print(top, left + 2, kAttrNone, "NEXT");
+    if (!nextType) {
+        return;
+    }
+
+    mctetris::model::Tetromino preview{*nextType, 0};
+    const int offsetY = top + 2;
+    const int offsetX = left + 2;
+    for (const auto &block : preview.Blocks()) {
+        if (block.y >= 0 && block.y < 4 && block.x >= 0 && block.x < 4) {
+            DrawCell(screen, offsetY + block.y * kCellHeight, offsetX + block.x * kCellWidth, preview.CellType());
+        }
+    }
+}
+
+void RenderStatsPanel(ScreenBuffer &screen, int top, int left, const mctetris::model::GameModel &model) {
+    screen.Box(top, left, kStatsPanelHeight, kStatsPanelWidth);
+    screen.Print(top, left + 2, kAttrNone, "STATS");
+    screen.Print(top + 2, left + 2, kAttrNone, "Score: %d", model.Score());
+    screen.Print(top + 3, left + 2, kAttrNone, "Level: %d", model.Level());
+    screen.Print(top + 4, left + 2, kAttrNone, "Lines: %d", model.LinesCleared());
+}
+
+void RenderPerfPanel(ScreenBuffer &screen, int top, int left, const PerfMetrics &hud) {
+    const auto now = std::chrono::steady_clock::now();
+    screen.Box(top, left, PerfMetrics::kMetricCount + 4, kHudPanelWidth);
+    screen.Print(top, left + 2, kAttrNone, "PERF last %ds (ms)", RollingHistogram::kSlices);
+    screen.Print(top + 1, left + 2, kAttrNone, "%-12s %7s %7s %7s", "", "p50", "p99", "max");
+    for (int i = 0; i < PerfMetrics::kMetricCount; ++i) {
+        const auto metric = static_cast<PerfMetric>(i);
+        const LatencyHistogram window = hud.Window(metric, now);
+        screen.Print(top + 2 + i, left + 2, kAttrNone, "%-12s %7.2f %7.2f %7.2f", PerfMetricName(metric),
+                     static_cast<double>(window.Quantile(0.5)) / 1e6, static_cast<double>(window.Quantile(0.99)) / 1e6,
+                     static_cast<double>(window.Max()) / 1e6);
+    }
+}
+
+void RenderOverlay(ScreenBuffer &screen, int centerY, int centerX, const char *text) {
+    screen.Print(centerY, centerX - static_cast<int>(strlen(text)) / 2, kAttrNone, "%s", text);
+}
+
+void RenderTile(ScreenBuffer &screen, int top, int left, int index, const GridTile &tile) {
+    using mctetris::model::kBoardHeight;
+    using mctetris::model::kBoardWidth;
+    const auto &model = *tile.model;
+    screen.Box(top, left, kBoardHeight + 2, kBoardWidth + 2);
+    screen.Print(top, left + 1, kAttrNone, "%d", index + 1);
+
+    const auto &cells = model.GetBoard().Cells();
+    for (int y = 0; y < kBoardHeight; ++y) {
+        for (int x = 0; x < kBoardWidth; ++x) {
+            if (cells[y][x] != mctetris::model::Cell::Empty) {
+                const auto pair = static_cast<std::uint8_t>(ColorPairForCell(cells[y][x]));
+                screen.Put(top + 1 + y, left + 1 + x, ScreenCell{' ', pair, kAttrNone});
+            }
+        }
+    }
+    if (model.CurrentPiece()) {
+        const auto &active = *model.CurrentPiece();
+        const auto pair = static_cast<std::uint8_t>(ColorPairForCell(active.piece.CellType()));
+        for (const auto &block : active.piece.Blocks()) {
+            const int x = active.origin.x + block.x;
+            const int y = active.origin.y + block.y;
+            if (x >= 0 && x < kBoardWidth && y >= 0 && y < kBoardHeight) {
+                screen.Put(top + 1 + y, left + 1 + x, ScreenCell{' ', pair, kAttrNone});
+            }
+        }
+    }
+    if (model.IsGameOver()) {
+        RenderOverlay(screen, top + 1 + kBoardHeight / 2, left + 1 + kBoardWidth / 2, "GAME OVER");
+    }
+    screen.Print(top + kBoardHeight + 2, left, kAttrNone, "%7d %3d", model.Score(), model.LinesCleared());
+}
+
+// Sizes the buffer for the frame and starts it blank.
+void BeginFrame(ScreenBuffer &screen, FrameSize size) {
+    screen.Resize(size.rows, size.cols);
+    screen.Clear();
+}
+
+} // namespace
+
+void InitColors() {
+    if (!has_colors()) {
+        return;
+    }
+    start_color();
+    use_default_colors();
+    init_pair(1, COLOR_CYAN, COLOR_CYAN);
+    init_pair(2, COLOR_YELLOW, COLOR_YELLOW);
+    init_pair(3, COLOR_MAGENTA, COLOR_MAGENTA);
+    init_pair(4, COLOR_GREEN, COLOR_GREEN);
+    init_pair(5, COLOR_RED, COLOR_RED);
+    init_pair(6, COLOR_BLUE, COLOR_BLUE);
+    init_pair(7, COLOR_WHITE, COLOR_WHITE);
+}
+
+FrameStats RenderGame(ScreenBuffer &screen,
+                      FrameSize size,
+                      const mctetris::model::GameModel &model,
+                      const std::optional<mctetris::model::TetrominoType> &nextType,
+                      const ControlScheme &scheme,
+                      bool paused,
+                      const PerfMetrics *hud) {
+    MCTETRIS_TRACE_SCOPE("RenderGame");
+    using mctetris::model::kBoardHeight;
+    using mctetris::model::kBoardWidth;
+
+    const int boardHeightChars = kBoardHeight * kCellHeight;
+    const int boardWidthChars = kBoardWidth * kCellWidth;
+    std::array<std::array<mctetris::model::Cell, kBoardWidth>, kBoardHeight> buffer = model.GetBoard().Cells();
+
+    if (model.CurrentPiece()) {
+        const auto &active = *model.CurrentPiece();
+        for (const auto &block : active.piece.Blocks()) {
+            const int x = active.origin.x + block.x;
+            const int y = active.origin.y + block.y;
+            if (x >= 0 && x < kBoardWidth && y >= 0 && y < kBoardHeight) {
+                buffer[y][x] = active.piece.CellType();
+            }
+        }
+    }
+
+    BeginFrame(screen, size);
+    screen.Box(kBoardOffsetY - 1, kBoardOffsetX - 1, boardHeightChars + 2, boardWidthChars + 2);
+    for (int y = 0; y < kBoardHeight; ++y) {
+        for (int x = 0; x < kBoardWidth; ++x) {
+            if (buffer[y][x] != mctetris::model::Cell::Empty) {
+                DrawCell(screen, kBoardOffsetY + y * kCellHeight, kBoardOffsetX + x * kCellWidth, buffer[y][x]);
+            }
+        }
+    }
+
+    const int panelLeft = kBoardOffsetX + boardWidthChars + kPanelOffsetX;
+    const int nextTop = kBoardOffsetY;
+    RenderNextPiecePanel(screen, nextTop, panelLeft, nextType);
+
+    const int statsTop = nextTop + kNextPanelHeight + 1;
+    RenderStatsPanel(screen, statsTop, panelLeft, model);
+    if (hud) {
+        RenderPerfPanel(screen, statsTop + kStatsPanelHeight + 1, panelLeft, *hud);
+    }
+
+    screen.Print(0, 0, kAttrNone, "Score: %d  Level: %d  Lines: %d  Scheme: %s", model.Score(), model.Level(),
+                 model.LinesCleared(), scheme.name);
+    screen.Print(kBoardOffsetY + boardHeightChars + 2, 0, kAttrNone,
+                 "%s  P: pause  H: perf  Q: quit", scheme.hint);
+
+    const int centerY = kBoardOffsetY + boardHeightChars / 2;
+    const int centerX = kBoardOffsetX + boardWidthChars / 2;
+    if (paused) {
+        RenderOverlay(screen, centerY, centerX, "PAUSED");
+    } else if (model.IsGameOver()) {
+        RenderOverlay(screen, centerY, centerX, "GAME OVER");
+    }
+    return screen.Flush();
+}
+
+FrameStats RenderGrid(ScreenBuffer &screen, FrameSize size, const std::vector<GridTile> &tiles, bool paused) {
+    MCTETRIS_TRACE_SCOPE("RenderGrid");
+    // One shared frame for every board: nothing is erased per board, and
+    // Flush sends only the cells that changed since the last frame.
+    BeginFrame(screen, size);
+    const int columns = std::max(1, size.cols / kTileWidth);
+    const int rows = std::max(1, (size.rows - 1) / kTileHeight);
+    const int shown = std::min(static_cast<int>(tiles.size()), columns * rows);
+    long long games = 0;
+    int best = 0;
+    for (const auto &tile : tiles) {
+        games += tile.gamesFinished;
+        best = std::max({best, tile.bestScore, tile.model->Score()});
+    }
+    for (int i = 0; i < shown; ++i) {
+        const int top = 1 + (i / columns) * kTileHeight;
+        RenderTile(screen, top, (i % columns) * kTileWidth, i, tiles[static_cast<std::size_t>(i)]);
+    }
+    screen.Print(0, 0, kAttrNone, "%zu boards (%d shown)  games %lld  best %d  score/lines under each  %s  Q: quit",
+                 tiles.size(), shown, games, best, paused ? "PAUSED" : "P: pause");
+    return screen.Flush();
+}
+
+FrameStats RenderMenu(ScreenBuffer &screen, FrameSize size, int selectedIndex) {
+    constexpr std::array<const char *, 4> kItems = {"Start Game", "Control Scheme", "High Scores", "Quit"};
+    const std::string title = "MCTETRIS";
+    int maxWidth = static_cast<int>(title.size());
+    for (const char *item : kItems) {
+        maxWidth = std::max(maxWidth, static_cast<int>(std::strlen(item)));
+    }
+    const int startY = (size.rows / 2) - static_cast<int>(kItems.size());
+    const int startX = (size.cols - maxWidth) / 2;
+
+    BeginFrame(screen, size);
+    screen.Print(startY - 2, (size.cols - static_cast<int>(title.size())) / 2, kAttrBold, "%s", title.c_str());
+    for (size_t i = 0; i < kItems.size(); ++i) {
+        const std::uint8_t attrs = static_cast<int>(i) == selectedIndex ? kAttrReverse : kAttrNone;
+        screen.Print(startY + static_cast<int>(i), startX, attrs, "%s", kItems[i]);
+    }
+    screen.Print(size.rows - 2, 2, kAttrNone, "Use Up/Down and Enter to select.");
+    return screen.Flush();
+}
+
+FrameStats RenderHighScores(ScreenBuffer &screen,
+                            FrameSize size,
+                            const std::vector<mctetris::scores::ScoreEntry> &top,
+                            const std::vector<mctetris::scores::ScoreEntry> &personal,
+                            const std::string &player) {
+    const std::string title = "HIGH SCORES";
+    constexpr int kRowWidth = 44;
+    const int startX = std::max(0, (size.cols - kRowWidth) / 2);
+    int y = std::max(1, size.rows / 2 - static_cast<int>(top.size() + personal.size()) / 2 - 4);
+
+    BeginFrame(screen, size);
+    screen.Print(y, (size.cols - static_cast<int>(title.size())) / 2, kAttrBold, "%s", title.c_str());
+    y += 2;
+    if (top.empty()) {
+        screen.Print(y++, startX, kAttrNone, "No scores yet.");
+    }
+    for (std::size_t i = 0; i < top.size(); ++i) {
+        const auto &entry = top[i];
+        const std::uint8_t attrs = entry.name == player ? kAttrBold : kAttrNone;
+        screen.Print(y++, startX, attrs, "%2zu. %-16s %9d  L%-3d %5d lines", i + 1, entry.name.c_str(), entry.score,
+                     entry.level, entry.lines);
+    }
+    if (!personal.empty()) {
+        y += 1;
+        screen.Print(y++, startX, kAttrBold, "Best by %s", player.c_str());
+        for (const auto &entry : personal) {
+            screen.Print(y++, startX, kAttrNone, "    %-16s %9d  L%-3d %5d lines", "", entry.score, entry.level,
+                         entry.lines);
+        }
+    }
+    screen.Print(size.rows - 2, 2, kAttrNone, "B or Esc returns.");
+    return screen.Flush();
+}
+
+FrameStats RenderControlMenu(ScreenBuffer &screen,
+                             FrameSize size,
+                             int selectedIndex,
+                             int activeIndex,
+                             const std::array<ControlScheme, 3> &schemes) {
+    const std::string title = "CONTROL SCHEME";
+    int maxWidth = static_cast<int>(title.size());
+    for (const auto &scheme : schemes) {
+        maxWidth = std::max(maxWidth, static_cast<int>(std::strlen(scheme.name)) + 3);
+    }
+    const int startY = (size.rows / 2) - static_cast<int>(schemes.size());
+    const int startX = (size.cols - maxWidth) / 2;
+
+    BeginFrame(screen, size);
+    screen.Print(startY - 2, (size.cols - static_cast<int>(title.size())) / 2, kAttrBold, "%s", title.c_str());
+    for (size_t i = 0; i < schemes.size(); ++i) {
+        const bool isSelected = static_cast<int>(i) == selectedIndex;
+        const bool isActive = static_cast<int>(i) == activeIndex;
+        screen.Print(startY + static_cast<int>(i), startX, isSelected ? kAttrReverse : kAttrNone, "%s%s",
+                     isActive ? "* " : "  ", schemes[i].name);
+    }
+    screen.Print(size.rows - 3, 2, kAttrNone, "Enter selects. B or Esc returns.");
+    screen.Print(size.rows - 2, 2, kAttrNone, "Current scheme is marked with *.");
+    return screen.Flush();
+}
+
+} // namespace mctetris::ui
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "model/game_model.h"
+#include "perf_metrics.h"
+#include "scores/score_store.h"
+#include "screen_buffer.h"
+
+namespace mctetris::ui {
+
+struct ControlScheme {
+    const char *name;
+    int left;
+    int right;
+    int down;
+    int rotate;
+    int hardDrop;
+    const char *hint;
+};
+
+// One board of the grid view.
+struct GridTile {
+    const mctetris::model::GameModel *model = nullptr;
+    int gamesFinished = 0;
+    int bestScore = 0;
+};
+
+// Registers the colour pairs used for tetromino cells. Requires an active curses screen.
+void InitColors();
+
+// Each screen composes into `screen` at `size` and flushes only what changed
+// since the previous frame. RenderGame adds the performance HUD below the stats panel
+// when `hud` is set.
+FrameStats RenderGame(ScreenBuffer &screen,
+                      FrameSize size,
+                      const mctetris::model::GameModel &model,
+                      const std::optional<mctetris::model::TetrominoType> &nextType,
+                      const ControlScheme &scheme,
+                      bool paused,
+                      const PerfMetrics *hud = nullptr);
+// Tiles as many boards as fit at one character per cell, each under a
+// one-line score; the header totals every board, shown or not.
+FrameStats RenderGrid(ScreenBuffer &screen, FrameSize size, const std::vector<GridTile> &tiles, bool paused);
+FrameStats RenderMenu(ScreenBuffer &screen, FrameSize size, int selectedIndex);
+// Best scores overall, then `player`'s own best.
+FrameStats RenderHighScores(ScreenBuffer &screen,
+                            FrameSize size,
+                            const std::vector<mctetris::scores::ScoreEntry> &top,
+                            const std::vector<mctetris::scores::ScoreEntry> &personal,
+                            const std::string &player);
+FrameStats RenderControlMenu(ScreenBuffer &screen,
+                             FrameSize size,
+                             int selectedIndex,
+                             int activeIndex,
+                             const std::array<ControlScheme, 3> &schemes);
+
+} // namespace mctetris::ui
@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+
+#include <curses.h>
+#include <unistd.h>
+
+#include "render_backend.h"
+
+namespace mctetris::ui {
+namespace {
+
+// Longest a single cell can take in an ANSI frame: a cursor move, a full
+// SGR with both colours, and a three-byte glyph.
+constexpr std::size_t kMaxAnsiCellBytes = 64;
+// The erase and reset sent ahead of a full redraw.
+constexpr std::size_t kAnsiFrameOverhead = 32;
+
+struct Rgb {
+    int r;
+    int g;
+    int b;
+};
+
+// The xterm palette entries behind the colour pairs set up by InitColors:
+// cyan, yellow, magenta, green, red, blue, white.
+constexpr std::array<Rgb, 8> kPairColors = {{
+    {0, 0, 0},
+    {0, 205, 205},
+    {205, 205, 0},
+    {205, 0, 205},
+    {0, 205, 0},
+    {205, 0, 0},
+    {0, 0, 238},
+    {229, 229, 229},
+}};
+
+chtype GlyphToChtype(std::uint8_t glyph) {
+    switch (static_cast<BoxGlyph>(glyph)) {
+    case BoxGlyph::ULCorner:
+        return ACS_ULCORNER;
+    case BoxGlyph::URCorner:
+        return ACS_URCORNER;
+    case BoxGlyph::LLCorner:
+        return ACS_LLCORNER;
+    case BoxGlyph::LRCorner:
+        return ACS_LRCORNER;
+    case BoxGlyph::HLine:
+        return ACS_HLINE;
+    case BoxGlyph::VLine:
+        return ACS_VLINE;
+    }
+    return static_cast<chtype>(glyph);
+}
+
+chtype ToChtype(const ScreenCell &cell) {
+    chtype value = GlyphToChtype(cell.glyph);
+    if (cell.color != 0) {
+        value |= COLOR_PAIR(cell.color);
+    }
+    if ((cell.attrs & kAttrBold) != 0) {
+        value |= A_BOLD;
+    }
+    if ((cell.attrs & kAttrReverse) != 0) {
+        value |= A_REVERSE;
+    }
+    return value;
+}
+
+// UTF-8 for the box glyphs; null for plain ASCII.
+const char *GlyphToUtf8(std::uint8_t glyph) {
+    switch (static_cast<BoxGlyph>(glyph)) {
+    case BoxGlyph::ULCorner:
+        return "┌";
+    case BoxGlyph::URCorner:
+        return "┐";
+    case BoxGlyph::LLCorner:
+        return "└";
+    case BoxGlyph::LRCorner:
+        return "┘";
+    case BoxGlyph::HLine:
+        return "─";
+    case BoxGlyph::VLine:
+        return "│";
+    }
+    return nullptr;
+}
+
+} // namespace
+
+void RenderBackend::Resize(int, int) {}
+
+void CursesBackend::BeginFrame(bool erase) {
+    if (erase) {
+        ::erase();
+    }
+}
+
+void CursesBackend::FillRun(int y, int x, ScreenCell cell, int count) {
+    mvhline(y, x, ToChtype(cell), count);
+}
+
+void CursesBackend::WriteRun(int y, int x, const ScreenCell *cells, int count) {
+    // Mixed cells go out as one attributed string per chunk.
+    std::array<chtype, 256> run;
+    for (int chunk = 0; chunk < count; chunk += static_cast<int>(run.size())) {
+        const int length = std::min(count - chunk, static_cast<int>(run.size()));
+        for (int i = 0; i < length; ++i) {
+            run[i] = ToChtype(cells[chunk + i]);
+        }
+        mvaddchnstr(y, x + chunk, run.data(), length);
+    }
+}
+
+void CursesBackend::EndFrame() {
+    wnoutrefresh(stdscr);
+    doupdate();
+}
+
+AnsiBackend::AnsiBackend(int fd) : fd_(fd) {}
+
+void AnsiBackend::Resize(int rows, int cols) {
+    cols_ = std::max(cols, 0);
+    const auto cells = static_cast<std::size_t>(std::max(rows, 0)) * static_cast<std::size_t>(cols_);
+    out_.reserve(cells * kMaxAnsiCellBytes + kAnsiFrameOverhead);
+    cursorY_ = -1;
+    cursorX_ = -1;
+}
+
+void AnsiBackend::BeginFrame(bool erase) {
+    out_.clear();
+    if (erase) {
+        out_ += "\x1b[0m\x1b[H\x1b[2J";
+        attrs_ = kAttrNone;
+        fg_ = 0;
+        bg_ = 0;
+        styleKnown_ = true;
+        cursorY_ = 0;
+        cursorX_ = 0;
+    }
+}
+
+void AnsiBackend::FillRun(int y, int x, ScreenCell cell, int count) {
+    MoveTo(y, x);
+    SetStyle(cell);
+    for (int i = 0; i < count; ++i) {
+        AppendCell(cell);
+    }
+    cursorX_ = x + count < cols_ ? x + count : -1;
+}
+
+void AnsiBackend::WriteRun(int y, int x, const ScreenCell *cells, int count) {
+    MoveTo(y, x);
+    for (int i = 0; i < count; ++i) {
+        SetStyle(cells[i]);
+        AppendCell(cells[i]);
+    }
+    // Past the last column the terminal is waiting to wrap, so the next run
+    // has to position the cursor itself.
+    cursorX_ = x + count < cols_ ? x + count : -1;
+}
+
+void AnsiBackend::EndFrame() {
+    lastFrameBytes_ = out_.size();
+    const char *data = out_.data();
+    std::size_t left = out_.size();
+    while (left > 0) {
+        const ssize_t written = ::write(fd_, data, left);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            // Part of the frame is lost: position and style are anyone's guess.
+            cursorY_ = -1;
+            cursorX_ = -1;
+            styleKnown_ = false;
+            break;
+        }
+        data += written;
+        left -= static_cast<std::size_t>(written);
+    }
+    out_.clear();
+}
+
+std::size_t AnsiBackend::LastFrameBytes() const {
+    return lastFrameBytes_;
+}
+
+void AnsiBackend::MoveTo(int y, int x) {
+    if (y == cursorY_ && x == cursorX_) {
+        return;
+    }
+    out_ += "\x1b[";
+    if (y == cursorY_ && cursorX_ >= 0 && x > cursorX_) {
+        // Cursor forward is shorter than an absolute move along the row.
+        if (x - cursorX_ > 1) {
+            AppendNumber(x - cursorX_);
+        }
+        out_ += 'C';
+    } else if (y != 0 || x != 0) {
+        AppendNumber(y + 1);
+        if (x != 0) {
+            out_ += ';';
+            AppendNumber(x + 1);
+        }
+        out_ += 'H';
+    } else {
+        out_ += 'H';
+    }
+    cursorY_ = y;
+    cursorX_ = x;
+}
+
+void AnsiBackend::SetStyle(const ScreenCell &cell) {
+    const std::uint8_t color = cell.color < kPairColors.size() ? cell.color : 0;
+    const bool reverse = (cell.attrs & kAttrReverse) != 0;
+    // A blank cell only shows its background, so its foreground is left as is.
+    const bool foregroundShown = cell.glyph != ' ' || reverse;
+    if (styleKnown_ && cell.attrs == attrs_ && color == bg_ && (!foregroundShown || color == fg_)) {
+        return;
+    }
+
+    out_ += "\x1b[";
+    bool first = true;
+    auto separate = [&]() {
+        if (!first) {
+            out_ += ';';
+        }
+        first = false;
+    };
+    // An attribute can only be turned off by resetting them all.
+    if (!styleKnown_ || (attrs_ & ~cell.attrs) != 0) {
+        separate();
+        out_ += '0';
+        attrs_ = kAttrNone;
+        fg_ = 0;
+        bg_ = 0;
+        styleKnown_ = true;
+    }
+    const std::uint8_t added = cell.attrs & ~attrs_;
+    if ((added & kAttrBold) != 0) {
+        separate();
+        out_ += '1';
+    }
+    if ((added & kAttrReverse) != 0) {
+        separate();
+        out_ += '7';
+    }
+    const auto appendColor = [&](const char *defaultCode, const char *rgbCode, std::uint8_t value) {
+        separate();
+        if (value == 0) {
+            out_ += defaultCode;
+            return;
+        }
+        const Rgb &rgb = kPairColors[value];
+        out_ += rgbCode;
+        AppendNumber(rgb.r);
+        out_ += ';';
+        AppendNumber(rgb.g);
+        out_ += ';';
+        AppendNumber(rgb.b);
+    };
+    if (foregroundShown && color != fg_) {
+        appendColor("39", "38;2;", color);
+        fg_ = color;
+    }
+    if (color != bg_) {
+        appendColor("49", "48;2;", color);
+        bg_ = color;
+    }
+    attrs_ = cell.attrs;
+    out_ += 'm';
+}
+
+void AnsiBackend::AppendCell(const ScreenCell &cell) {
+    if (const char *box = GlyphToUtf8(cell.glyph)) {
+        out_ += box;
+    } else if (cell.glyph >= 0x20 && cell.glyph < 0x7f) {
+        out_ += static_cast<char>(cell.glyph);
+    } else {
+        // Anything else would throw off where the cursor is believed to be.
+        out_ += '?';
+    }
+}
+
+void AnsiBackend::AppendNumber(int value) {
+    char digits[12];
+    int length = 0;
+    do {
+        digits[length++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (length > 0) {
+        out_ += digits[--length];
+    }
+}
+
+void NullBackend::BeginFrame(bool) {}
+
+void NullBackend::FillRun(int, int, ScreenCell, int) {}
+
+void NullBackend::WriteRun(int, int, const ScreenCell *, int) {}
+
+void NullBackend::EndFrame() {}
+
+const char *RenderOutputName(RenderOutput output) {
+    switch (output) {
+    case RenderOutput::Curses:
+        return "curses";
+    case RenderOutput::Ansi:
+        return "ansi";
+    case RenderOutput::Null:
+        return "null";
+    }
+    return "curses";
+}
+
+std::optional<RenderOutput> ParseRenderOutput(const std::string &name) {
+    for (const auto output : {RenderOutput::Curses, RenderOutput::Ansi, RenderOutput::Null}) {
+        if (name == RenderOutputName(output)) {
+            return output;
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace mctetris::ui
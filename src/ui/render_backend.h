@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include "screen_buffer.h"
+
+namespace mctetris::ui {
+
+// Where ScreenBuffer::Flush sends the cells that changed. A frame is one
+// BeginFrame, the changed runs in row order, and an EndFrame if anything
+// was drawn or erased.
+class RenderBackend {
+  public:
+    virtual ~RenderBackend() = default;
+
+    // The screen is now rows x cols; a full redraw follows.
+    virtual void Resize(int rows, int cols);
+    // Starts a frame, clearing the terminal first when `erase` is set.
+    virtual void BeginFrame(bool erase) = 0;
+    // `count` copies of `cell` from (y, x) rightwards.
+    virtual void FillRun(int y, int x, ScreenCell cell, int count) = 0;
+    // `count` cells from (y, x) rightwards.
+    virtual void WriteRun(int y, int x, const ScreenCell *cells, int count) = 0;
+    // Sends the frame to the terminal.
+    virtual void EndFrame() = 0;
+};
+
+// Draws on the curses stdscr and sends the frame with doupdate().
+class CursesBackend : public RenderBackend {
+  public:
+    void BeginFrame(bool erase) override;
+    void FillRun(int y, int x, ScreenCell cell, int count) override;
+    void WriteRun(int y, int x, const ScreenCell *cells, int count) override;
+    void EndFrame() override;
+};
+
+// Writes ANSI escapes straight to `fd`, bypassing curses. The frame is
+// built in one buffer, sized for a full redraw whenever the screen resizes,
+// and sent with a single write(). The cursor is only moved when a run does
+// not start where the last one ended, and SGR only sends the attributes and
+// 24-bit colours that differ from the cell before. Box glyphs go out as
+// UTF-8. Terminal modes (raw input, alternate screen, hidden cursor) are
+// left to whoever set up the terminal.
+class AnsiBackend : public RenderBackend {
+  public:
+    explicit AnsiBackend(int fd);
+
+    void Resize(int rows, int cols) override;
+    void BeginFrame(bool erase) override;
+    void FillRun(int y, int x, ScreenCell cell, int count) override;
+    void WriteRun(int y, int x, const ScreenCell *cells, int count) override;
+    void EndFrame() override;
+
+    // Bytes of the last frame sent.
+    [[nodiscard]] std::size_t LastFrameBytes() const;
+
+  private:
+    void MoveTo(int y, int x);
+    void SetStyle(const ScreenCell &cell);
+    void AppendCell(const ScreenCell &cell);
+    void AppendNumber(int value);
+
+    int fd_ = -1;
+    int cols_ = 0;
+    std::string out_;
+    std::size_t lastFrameBytes_ = 0;
+    // Where the terminal is now; -1 when unknown.
+    int cursorY_ = -1;
+    int cursorX_ = -1;
+    // The terminal's current SGR state; colour 0 is the default colour.
+    std::uint8_t attrs_ = kAttrNone;
+    std::uint8_t fg_ = 0;
+    std::uint8_t bg_ = 0;
+    bool styleKnown_ = false;
+};
+
+// Discards every frame: composition and diffing without any terminal cost,
+// for benchmarks and CI.
+class NullBackend : public RenderBackend {
+  public:
+    void BeginFrame(bool erase) override;
+    void FillRun(int y, int x, ScreenCell cell, int count) override;
+    void WriteRun(int y, int x, const ScreenCell *cells, int count) override;
+    void EndFrame() override;
+};
+
+enum class RenderOutput {
+    Curses,
+    Ansi,
+    Null
+};
+
+// "curses", "ansi" or "null".
+[[nodiscard]] const char *RenderOutputName(RenderOutput output);
+[[nodiscard]] std::optional<RenderOutput> ParseRenderOutput(const std::string &name);
+
+} // namespace mctetris::ui
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#include "render_backend.h"
+#include "screen_buffer.h"
+#include "terminal_output.h"
+
+namespace mctetris::ui {
+namespace {
+
+static_assert(sizeof(ScreenCell) == 3, "rows are compared with memcmp");
+
+// Stateless, so every buffer on curses can share it.
+CursesBackend &SharedCursesBackend() {
+    static CursesBackend backend;
+    return backend;
+}
+
+ScreenCell Glyph(BoxGlyph glyph) {
+    return ScreenCell{static_cast<std::uint8_t>(glyph), 0, kAttrNone};
+}
+
+} // namespace
+
+ScreenBuffer::ScreenBuffer() : backend_(&SharedCursesBackend()) {}
+
+void ScreenBuffer::Resize(int rows, int cols) {
+    if (rows <= 0 || cols <= 0) {
+        rows = 0;
+        cols = 0;
+    }
+    if (rows == rows_ && cols == cols_) {
+        return;
+    }
+    rows_ = rows;
+    cols_ = cols;
+    const auto size = static_cast<std::size_t>(rows_) * static_cast<std::size_t>(cols_);
+    back_.assign(size, ScreenCell{});
+    front_.assign(size, ScreenCell{});
+    needsErase_ = true;
+    backend_->Resize(rows_, cols_);
+}
+
+void ScreenBuffer::Invalidate() {
+    std::fill(front_.begin(), front_.end(), ScreenCell{});
+    needsErase_ = true;
+}
+
+void ScreenBuffer::Clear() {
+    std::fill(back_.begin(), back_.end(), ScreenCell{});
+}
+
+void ScreenBuffer::Put(int y, int x, ScreenCell cell) {
+    if (InBounds(y, x)) {
+        back_[static_cast<std::size_t>(y) * cols_ + x] = cell;
+    }
+}
+
+void ScreenBuffer::HLine(int y, int x, int length, ScreenCell cell) {
+    if (y < 0 || y >= rows_) {
+        return;
+    }
+    const int begin = std::max(x, 0);
+    const int end = std::min(x + length, cols_);
+    if (begin >= end) {
+        return;
+    }
+    const auto row = back_.begin() + static_cast<std::ptrdiff_t>(y) * cols_;
+    std::fill(row + begin, row + end, cell);
+}
+
+void ScreenBuffer::FillRect(int top, int left, int height, int width, ScreenCell cell) {
+    for (int y = top; y < top + height; ++y) {
+        HLine(y, left, width, cell);
+    }
+}
+
+void ScreenBuffer::Box(int top, int left, int height, int width) {
+    const int bottom = top + height - 1;
+    const int right = left + width - 1;
+    HLine(top, left + 1, width - 2, Glyph(BoxGlyph::HLine));
+    HLine(bottom, left + 1, width - 2, Glyph(BoxGlyph::HLine));
+    for (int y = top + 1; y < bottom; ++y) {
+        Put(y, left, Glyph(BoxGlyph::VLine));
+        Put(y, right, Glyph(BoxGlyph::VLine));
+    }
+    Put(top, left, Glyph(BoxGlyph::ULCorner));
+    Put(top, right, Glyph(BoxGlyph::URCorner));
+    Put(bottom, left, Glyph(BoxGlyph::LLCorner));
+    Put(bottom, right, Glyph(BoxGlyph::LRCorner));
+}
+
+void ScreenBuffer::Print(int y, int x, std::uint8_t attrs, const char *format, ...) {
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    const int length = std::vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    const int count = std::min(length, static_cast<int>(sizeof(text)) - 1);
+    for (int i = 0; i < count; ++i) {
+        Put(y, x + i, ScreenCell{static_cast<std::uint8_t>(text[i]), 0, attrs});
+    }
+}
+
+void ScreenBuffer::SetOutputMeter(const OutputMeter *meter) {
+    meter_ = meter;
+}
+
+void ScreenBuffer::SetBackend(RenderBackend *backend) {
+    backend_ = backend;
+    backend_->Resize(rows_, cols_);
+    Invalidate();
+}
+
+FrameStats ScreenBuffer::Flush() {
+    FrameStats stats;
+    const OutputCounters before = meter_ ? meter_->Sample() : OutputCounters{};
+    const bool erased = needsErase_;
+    backend_->BeginFrame(needsErase_);
+    needsErase_ = false;
+
+    for (int y = 0; y < rows_; ++y) {
+        const std::size_t rowStart = static_cast<std::size_t>(y) * cols_;
+        if (std::memcmp(&back_[rowStart], &front_[rowStart], sizeof(ScreenCell) * cols_) == 0) {
+            continue;
+        }
+        int x = 0;
+        while (x < cols_) {
+            if (back_[rowStart + x] == front_[rowStart + x]) {
+                ++x;
+                continue;
+            }
+            // Extend over consecutive changed cells.
+            const int start = x;
+            bool uniform = true;
+            while (x < cols_ && back_[rowStart + x] != front_[rowStart + x]) {
+                uniform = uniform && back_[rowStart + x] == back_[rowStart + start];
+                front_[rowStart + x] = back_[rowStart + x];
+                ++x;
+            }
+            const int length = x - start;
+            if (uniform) {
+                backend_->FillRun(y, start, back_[rowStart + start], length);
+            } else {
+                backend_->WriteRun(y, start, &back_[rowStart + start], length);
+            }
+            stats.cellsChanged += length;
+            ++stats.runs;
+        }
+    }
+
+    if (erased || stats.runs > 0) {
+        const auto updateStart = std::chrono::steady_clock::now();
+        backend_->EndFrame();
+        stats.updateNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - updateStart).count();
+    }
+    if (meter_) {
+        const OutputCounters after = meter_->Sample();
+        stats.bytes = after.bytes - before.bytes;
+        stats.writes = after.writes - before.writes;
+    }
+    lastFrame_ = stats;
+    return stats;
+}
+
+int ScreenBuffer::Rows() const {
+    return rows_;
+}
+
+int ScreenBuffer::Cols() const {
+    return cols_;
+}
+
+const FrameStats &ScreenBuffer::LastFrame() const {
+    return lastFrame_;
+}
+
+bool ScreenBuffer::InBounds(int y, int x) const {
+    return y >= 0 && y < rows_ && x >= 0 && x < cols_;
+}
+
+} // namespace mctetris::ui
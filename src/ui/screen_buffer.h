@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace mctetris::ui {
+
+class OutputMeter;
+class RenderBackend;
+
+// Glyph codes below 0x20 stand for line-drawing characters; everything else
+// is plain ASCII.
+enum class BoxGlyph : std::uint8_t {
+    ULCorner = 1,
+    URCorner,
+    LLCorner,
+    LRCorner,
+    HLine,
+    VLine
+};
+
+constexpr std::uint8_t kAttrNone = 0;
+constexpr std::uint8_t kAttrBold = 1u << 0;
+constexpr std::uint8_t kAttrReverse = 1u << 1;
+
+struct ScreenCell {
+    std::uint8_t glyph = ' ';
+    std::uint8_t color = 0;
+    std::uint8_t attrs = kAttrNone;
+
+    friend bool operator==(const ScreenCell &lhs, const ScreenCell &rhs) {
+        return lhs.glyph == rhs.glyph && lhs.color == rhs.color && lhs.attrs == rhs.attrs;
+    }
+    friend bool operator!=(const ScreenCell &lhs, const ScreenCell &rhs) {
+        return !(lhs == rhs);
+    }
+};
+
+struct FrameStats {
+    int cellsChanged = 0;
+    int runs = 0;
+    // Terminal output for the frame; zero unless an OutputMeter is attached.
+    std::uint64_t bytes = 0;
+    std::uint64_t writes = 0;
+    // Time spent in the backend's EndFrame, the part of Flush that talks to
+    // the terminal (doupdate() for curses).
+    std::int64_t updateNs = 0;
+};
+
+// Rows and columns a frame is composed at.
+struct FrameSize {
+    int rows = 0;
+    int cols = 0;
+};
+
+// Frame composed in memory and diffed against the previous frame, so each
+// Flush only sends the cells that changed, in runs of identical attributes.
+class ScreenBuffer {
+  public:
+    // Draws through curses until SetBackend says otherwise.
+    ScreenBuffer();
+
+    // Sizes the buffer to the terminal; a size change forces a full redraw.
+    void Resize(int rows, int cols);
+    // Forces the next Flush to clear the terminal and redraw everything.
+    void Invalidate();
+    // Blanks the frame being composed. Does not touch the terminal.
+    void Clear();
+
+    void Put(int y, int x, ScreenCell cell);
+    void HLine(int y, int x, int length, ScreenCell cell);
+    void FillRect(int top, int left, int height, int width, ScreenCell cell);
+    void Box(int top, int left, int height, int width);
+    void Print(int y, int x, std::uint8_t attrs, const char *format, ...);
+
+    // Measures the bytes each Flush sends to the terminal; pass nullptr to stop.
+    // The meter must belong to the thread that calls Flush.
+    void SetOutputMeter(const OutputMeter *meter);
+    // Sends later frames to `backend`, starting with a full redraw. The
+    // backend must outlive the buffer or be replaced first.
+    void SetBackend(RenderBackend *backend);
+    // Passes the changed cells to the backend and ends the frame.
+    FrameStats Flush();
+
+    [[nodiscard]] int Rows() const;
+    [[nodiscard]] int Cols() const;
+    [[nodiscard]] const FrameStats &LastFrame() const;
+
+  private:
+    [[nodiscard]] bool InBounds(int y, int x) const;
+
+    int rows_ = 0;
+    int cols_ = 0;
+    bool needsErase_ = true;
+    const OutputMeter *meter_ = nullptr;
+    RenderBackend *backend_ = nullptr;
+    std::vector<ScreenCell> back_;
+    std::vector<ScreenCell> front_;
+    FrameStats lastFrame_{};
+};
+
+} // namespace mctetris::ui
@@ -0,0 +1,123 @@
+#include <cerrno>
+#include <cstring>
+
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "render.h"
+#include "terminal.h"
+
+namespace mctetris::ui {
+namespace {
+
+// Alternate screen and hidden cursor for ANSI output, and back again.
+constexpr const char *kAnsiEnter = "\x1b[?1049h\x1b[?25l";
+constexpr const char *kAnsiLeave = "\x1b[0m\x1b[?25h\x1b[?1049l";
+
+void WriteAll(int fd, const char *text) {
+    std::size_t left = std::strlen(text);
+    while (left > 0) {
+        const ssize_t written = ::write(fd, text, left);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return;
+        }
+        text += written;
+        left -= static_cast<std::size_t>(written);
+    }
+}
+
+} // namespace
+
+Terminal::Terminal(RenderOutput output) : output_(output) {
+    if (output_ == RenderOutput::Null) {
+        size_ = kNullSize;
+    }
+}
+
+Terminal::~Terminal() {
+    End();
+}
+
+bool Terminal::Start() {
+    if (started_) {
+        return true;
+    }
+    if (output_ == RenderOutput::Curses) {
+        // Unlike initscr(), newterm() reports a missing terminal instead of exiting.
+        screen_ = newterm(nullptr, stdout, stdin);
+        if (!screen_) {
+            return false;
+        }
+        cbreak();
+        noecho();
+        keypad(stdscr, true);
+        curs_set(0);
+        InitColors();
+        started_ = true;
+        return true;
+    }
+
+    // Keys are read a byte at a time by the input thread, without echo, as
+    // curses' cbreak() and noecho() would leave them. Without ISIG, Ctrl+C
+    // and Ctrl+\ arrive as keys too, so neither can kill the game before
+    // End() has put these modes back; the input thread makes Ctrl+C quit.
+    if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &savedModes_) == 0) {
+        termios modes = savedModes_;
+        modes.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO | ISIG);
+        modes.c_cc[VMIN] = 1;
+        modes.c_cc[VTIME] = 0;
+        modesSaved_ = tcsetattr(STDIN_FILENO, TCSANOW, &modes) == 0;
+    }
+    if (output_ == RenderOutput::Ansi) {
+        WriteAll(STDOUT_FILENO, kAnsiEnter);
+    }
+    started_ = true;
+    return true;
+}
+
+void Terminal::End() {
+    if (!started_) {
+        return;
+    }
+    started_ = false;
+    if (screen_) {
+        endwin();
+        delscreen(screen_);
+        screen_ = nullptr;
+        return;
+    }
+    if (output_ == RenderOutput::Ansi) {
+        WriteAll(STDOUT_FILENO, kAnsiLeave);
+    }
+    if (modesSaved_) {
+        (void)tcsetattr(STDIN_FILENO, TCSADRAIN, &savedModes_);
+        modesSaved_ = false;
+    }
+}
+
+bool Terminal::Draws() const {
+    return output_ != RenderOutput::Null;
+}
+
+FrameSize Terminal::Size() {
+    if (output_ == RenderOutput::Null) {
+        return size_;
+    }
+    // Keys never go through getch(), so curses does not see a resize by itself.
+    winsize window{};
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &window) == 0 && window.ws_row != 0 && window.ws_col != 0) {
+        size_ = FrameSize{window.ws_row, window.ws_col};
+        if (screen_ && is_term_resized(size_.rows, size_.cols)) {
+            resizeterm(size_.rows, size_.cols);
+        }
+    }
+    if (screen_) {
+        return FrameSize{LINES, COLS};
+    }
+    return size_;
+}
+
+} // namespace mctetris::ui
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <curses.h>
+#include <termios.h>
+
+#include "render_backend.h"
+#include "screen_buffer.h"
+
+namespace mctetris::ui {
+
+// The terminal as one render output needs it. Curses sets up its own screen
+// on the controlling terminal. ANSI output puts stdin in cbreak mode itself
+// and draws on the alternate screen with the cursor hidden. Null output
+// draws nowhere, needs no terminal or TERM, and composes at a fixed size;
+// only stdin is switched to cbreak mode when it is a terminal.
+class Terminal {
+  public:
+    // The size null output composes at.
+    static constexpr FrameSize kNullSize{60, 120};
+
+    explicit Terminal(RenderOutput output);
+    ~Terminal();
+
+    Terminal(const Terminal &) = delete;
+    Terminal &operator=(const Terminal &) = delete;
+
+    // Takes the terminal over. False if curses cannot open it.
+    [[nodiscard]] bool Start();
+    // Hands the terminal back as it was found. Does nothing unless started.
+    void End();
+    // True when frames are drawn on stdout.
+    [[nodiscard]] bool Draws() const;
+    // The size to compose the next frame at, picking up any resize.
+    [[nodiscard]] FrameSize Size();
+
+  private:
+    RenderOutput output_;
+    bool started_ = false;
+    SCREEN *screen_ = nullptr;
+    bool modesSaved_ = false;
+    termios savedModes_{};
+    // Kept when the terminal cannot say how big it is.
+    FrameSize size_{24, 80};
+};
+
+} // namespace mctetris::ui
@@ -0,0 +1,64 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "terminal_output.h"
+
+namespace mctetris::ui {
+namespace {
+
+std::uint64_t FieldValue(const char *text, const char *field) {
+    const char *found = std::strstr(text, field);
+    if (!found) {
+        return 0;
+    }
+    return std::strtoull(found + std::strlen(field), nullptr, 10);
+}
+
+// The calling thread's counters; /proc/self/io would sum every thread.
+int OpenThreadCounters() {
+    const int fd = open("/proc/thread-self/io", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        return fd;
+    }
+    // Kernels before 3.17 have no thread-self link.
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/self/task/%ld/io", static_cast<long>(syscall(SYS_gettid)));
+    return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+} // namespace
+
+OutputMeter::OutputMeter() : fd_(OpenThreadCounters()) {}
+
+OutputMeter::~OutputMeter() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool OutputMeter::Available() const {
+    return fd_ >= 0;
+}
+
+OutputCounters OutputMeter::Sample() const {
+    OutputCounters counters;
+    if (fd_ < 0) {
+        return counters;
+    }
+    char text[512];
+    const ssize_t length = pread(fd_, text, sizeof(text) - 1, 0);
+    if (length <= 0) {
+        return counters;
+    }
+    text[length] = '\0';
+    counters.bytes = FieldValue(text, "wchar:");
+    counters.writes = FieldValue(text, "syscw:");
+    return counters;
+}
+
+} // namespace mctetris::ui
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+namespace mctetris::ui {
+
+struct OutputCounters {
+    std::uint64_t bytes = 0;
+    std::uint64_t writes = 0;
+};
+
+// Cumulative bytes and write() calls issued by the thread that created the
+// meter, read from its /proc task io file. Other threads' writes (wake pipes,
+// the trace and score writers) are not counted, so on the render thread the
+// deltas around a flush give what that frame cost on the wire. Unavailable
+// outside Linux.
+class OutputMeter {
+  public:
+    OutputMeter();
+    ~OutputMeter();
+
+    OutputMeter(const OutputMeter &) = delete;
+    OutputMeter &operator=(const OutputMeter &) = delete;
+
+    [[nodiscard]] bool Available() const;
+    [[nodiscard]] OutputCounters Sample() const;
+
+  private:
+    int fd_ = -1;
+};
+
+} // namespace mctetris::ui
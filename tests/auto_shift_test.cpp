@@ -0,0 +1,226 @@
+// AutoShift fed synthetic key sequences on a made-up clock: repeats at the
+// configured rate with and without release events, zero ARR and zero soft
+// drop going straight to the edge, left and right handing over, and a held
+// drop that stops at the floor while a fresh press locks.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+#include "engine/auto_shift.h"
+#include "model/game_session.h"
+#include "model/replay.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+using mctetris::engine::AutoShift;
+using mctetris::engine::AutoShiftConfig;
+using mctetris::engine::ShiftKey;
+using mctetris::engine::ShiftSteps;
+
+constexpr int kToEdge = ShiftSteps::kToEdge;
+
+int failures = 0;
+
+void Expect(bool condition, const char *what) {
+    if (!condition) {
+        if (failures < 10) {
+            std::fprintf(stderr, "failed: %s\n", what);
+        }
+        ++failures;
+    }
+}
+
+AutoShiftConfig Config(int das, int arr, int softDrop) {
+    AutoShiftConfig config;
+    config.das = milliseconds(das);
+    config.arr = milliseconds(arr);
+    config.softDrop = milliseconds(softDrop);
+    return config;
+}
+
+// Moves owed by a key held for `held`: the press, then one at DAS and one
+// per ARR after it.
+int ExpectedMoves(milliseconds held, int das, int arr) {
+    if (held.count() < das) {
+        return 1;
+    }
+    return 2 + static_cast<int>((held.count() - das) / arr);
+}
+
+// The drop half of the simulation thread's StepAutoShift.
+void ApplyDrops(mctetris::model::GameSession &session, const ShiftSteps &steps) {
+    const int spawned = session.PiecesSpawned();
+    for (int i = 0; i < steps.drops && session.PiecesSpawned() == spawned; ++i) {
+        const auto &model = session.Model();
+        const auto &piece = model.CurrentPiece();
+        if (!piece) {
+            break;
+        }
+        const bool landed = model.GetBoard().DropDistance(piece->piece, piece->origin.x, piece->origin.y) == 0;
+        if ((landed && !(i == 0 && steps.dropPressed)) ||
+            !mctetris::model::ApplyReplayAction(session, mctetris::model::ReplayAction::SoftDrop)) {
+            break;
+        }
+    }
+}
+
+// Random holds with release events, polled at random times: the moves add up
+// to the count owed at the release, however the polls fall.
+void CheckRepeatRate(std::mt19937 &rng) {
+    for (int trial = 0; trial < 2000; ++trial) {
+        const int das = 20 + static_cast<int>(rng() % 200);
+        const int arr = 1 + static_cast<int>(rng() % 50);
+        AutoShift shift(Config(das, arr, 25));
+        shift.SetReleaseEvents(true);
+        const auto start = Clock::now();
+        const auto held = milliseconds(rng() % 1000);
+        const ShiftKey key = rng() % 2 == 0 ? ShiftKey::Left : ShiftKey::Right;
+        shift.Press(key, start, false);
+        int moved = 0;
+        for (auto at = start; at < start + held; at += milliseconds(rng() % 60)) {
+            // The terminal's own repeats change nothing once releases are reported.
+            shift.Press(key, at, true);
+            moved += shift.Advance(at).horizontal;
+        }
+        shift.Release(key, start + held);
+        moved += shift.Advance(start + held + milliseconds(rng() % 500)).horizontal;
+        const int expected = ExpectedMoves(held, das, arr);
+        Expect(moved == (key == ShiftKey::Left ? -expected : expected), "moves owed at the release");
+        Expect(!shift.NextDeadline(), "nothing due once released");
+    }
+}
+
+void CheckZeroArr() {
+    AutoShift shift(Config(83, 0, 25));
+    shift.SetReleaseEvents(true);
+    const auto start = Clock::now();
+    shift.Press(ShiftKey::Left, start, false);
+    Expect(shift.NextDeadline() == start, "the press is due at once");
+    Expect(shift.Advance(start).horizontal == -1, "the press moves one");
+    Expect(shift.NextDeadline() == start + milliseconds(83), "next due at DAS");
+    Expect(shift.Advance(start + milliseconds(82)).horizontal == 0, "nothing before DAS");
+    Expect(shift.Advance(start + milliseconds(83)).horizontal == -kToEdge, "zero ARR goes to the wall at DAS");
+    // A piece that spawns or rotates off the wall goes straight back to it.
+    Expect(shift.Advance(start + milliseconds(200)).horizontal == -kToEdge, "kToEdge again while held");
+    shift.Release(ShiftKey::Left, start + milliseconds(300));
+    Expect(shift.Advance(start + milliseconds(300)).horizontal == 0, "nothing after the release");
+    Expect(!shift.NextDeadline(), "nothing due after the release");
+}
+
+// Without release events the terminal's repeats are the only sign of a hold.
+void CheckWithoutReleases() {
+    const auto start = Clock::now();
+    {
+        // Taps further apart than the terminal repeats move one each.
+        AutoShift shift(Config(83, 0, 25));
+        shift.Press(ShiftKey::Right, start, false);
+        Expect(shift.Advance(start).horizontal == 1, "a tap moves one");
+        Expect(shift.Advance(start + milliseconds(90)).horizontal == 0, "a tap does not repeat");
+        shift.Press(ShiftKey::Right, start + milliseconds(150), false);
+        Expect(shift.Advance(start + milliseconds(150)).horizontal == 1, "a second tap moves one");
+        Expect(shift.Advance(start + milliseconds(400)).horizontal == 0, "a tap expires");
+        Expect(!shift.NextDeadline(), "nothing due after a tap");
+    }
+    {
+        // Repeats every 30 ms until 300 ms; the hold ends 60 ms after the last.
+        AutoShift shift(Config(83, 20, 25));
+        int moved = 0;
+        for (int ms = 0; ms <= 300; ms += 30) {
+            shift.Press(ShiftKey::Left, start + milliseconds(ms), ms != 0);
+            moved += shift.Advance(start + milliseconds(ms)).horizontal;
+        }
+        Expect(shift.NextDeadline().has_value(), "the hold is still timed");
+        moved += shift.Advance(start + milliseconds(1000)).horizontal;
+        Expect(moved == -ExpectedMoves(milliseconds(360), 83, 20), "a repeated key moves at ARR until it expires");
+        Expect(!shift.NextDeadline(), "nothing due once the repeats stop");
+    }
+    {
+        AutoShift shift(Config(83, 0, 25));
+        shift.Press(ShiftKey::Left, start, false);
+        Expect(shift.Advance(start).horizontal == -1, "the first press moves one");
+        shift.Press(ShiftKey::Left, start + milliseconds(30), true);
+        Expect(shift.Advance(start + milliseconds(60)).horizontal == 0, "a repeat waits for DAS");
+        shift.Press(ShiftKey::Left, start + milliseconds(60), true);
+        Expect(shift.Advance(start + milliseconds(90)).horizontal == -kToEdge, "zero ARR reaches the wall");
+        Expect(shift.Advance(start + milliseconds(500)).horizontal == 0, "the hold expires without a release");
+    }
+}
+
+void CheckHandover() {
+    AutoShift shift(Config(83, 0, 25));
+    shift.SetReleaseEvents(true);
+    const auto start = Clock::now();
+    shift.Press(ShiftKey::Left, start, false);
+    Expect(shift.Advance(start + milliseconds(100)).horizontal == -kToEdge, "left reaches the wall");
+    // The direction pressed last moves while both are down.
+    shift.Press(ShiftKey::Right, start + milliseconds(150), false);
+    Expect(shift.Advance(start + milliseconds(150)).horizontal == 1, "right takes over with a step");
+    Expect(shift.Advance(start + milliseconds(233)).horizontal == kToEdge, "right reaches the wall at its DAS");
+    // Letting go of right hands back to left after a fresh DAS, without a step.
+    shift.Release(ShiftKey::Right, start + milliseconds(300));
+    Expect(shift.Advance(start + milliseconds(300)).horizontal == 0, "left resumes without a step");
+    Expect(shift.Advance(start + milliseconds(382)).horizontal == 0, "left waits a fresh DAS");
+    Expect(shift.Advance(start + milliseconds(383)).horizontal == -kToEdge, "left goes back to the wall");
+
+    // With a repeat rate, moves already owed when the other direction takes
+    // over or is let go of are still made, even with no Advance() between.
+    AutoShift timed(Config(50, 10, 25));
+    timed.SetReleaseEvents(true);
+    timed.Press(ShiftKey::Right, start, false);
+    timed.Press(ShiftKey::Left, start + milliseconds(75), false);
+    timed.Release(ShiftKey::Left, start + milliseconds(100));
+    Expect(timed.Advance(start + milliseconds(100)).horizontal == ExpectedMoves(milliseconds(75), 50, 10) - 1,
+           "moves owed by both keys are summed");
+    Expect(timed.Advance(start + milliseconds(149)).horizontal == 0, "right waits a fresh DAS");
+    Expect(timed.Advance(start + milliseconds(170)).horizontal == 3, "right repeats after it");
+}
+
+void CheckHeldDrop() {
+    for (const int softDrop : {0, 25}) {
+        mctetris::model::GameSession session(7);
+        AutoShift shift(Config(83, 0, softDrop));
+        shift.SetReleaseEvents(true);
+        const auto start = Clock::now();
+        const int spawned = session.PiecesSpawned();
+
+        shift.Press(ShiftKey::Down, start, false);
+        const ShiftSteps first = shift.Advance(start);
+        Expect(first.dropPressed, "a fresh press is marked");
+        Expect(first.drops == (softDrop == 0 ? kToEdge : 1), "the press drops at once");
+        ApplyDrops(session, first);
+        for (int ms = 10; ms <= 2000; ms += 10) {
+            const ShiftSteps steps = shift.Advance(start + milliseconds(ms));
+            Expect(!steps.dropPressed, "held drops are not marked");
+            ApplyDrops(session, steps);
+        }
+        const auto &piece = session.Model().CurrentPiece();
+        Expect(session.PiecesSpawned() == spawned && piece.has_value(), "a held drop does not lock");
+        Expect(piece && session.Model().GetBoard().DropDistance(piece->piece, piece->origin.x, piece->origin.y) == 0,
+               "a held drop reaches the floor");
+
+        shift.Release(ShiftKey::Down, start + milliseconds(2000));
+        (void)shift.Advance(start + milliseconds(2000));
+        shift.Press(ShiftKey::Down, start + milliseconds(2100), false);
+        const ShiftSteps again = shift.Advance(start + milliseconds(2100));
+        Expect(again.dropPressed, "a second press is marked");
+        ApplyDrops(session, again);
+        Expect(session.PiecesSpawned() == spawned + 1, "a fresh press locks a landed piece");
+    }
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(5);
+    CheckRepeatRate(rng);
+    CheckZeroArr();
+    CheckWithoutReleases();
+    CheckHandover();
+    CheckHeldDrop();
+    std::printf("%d failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+// Differential test of BatchEnv against GameModel: each game is replayed on
+// a GameModel fed from the same piece stream, the way GameSession feeds one,
+// with the same random actions and gravity interval. Rewards, dones, scores
+// and every observation byte must agree at every step.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "env/batch_env.h"
+#include "model/game_model.h"
+#include "model/piece_generator.h"
+
+namespace {
+
+using mctetris::env::BatchEnv;
+using mctetris::env::EnvAction;
+using mctetris::env::kNextPieceOffset;
+using mctetris::env::kObservationBytes;
+using mctetris::model::Cell;
+using mctetris::model::GameModel;
+using mctetris::model::kBoardHeight;
+using mctetris::model::kBoardWidth;
+using mctetris::model::PieceGenerator;
+
+// One game as GameSession plays it, restarted on BatchEnv's stream for each
+// episode.
+class ReferenceGame {
+  public:
+    ReferenceGame(std::uint64_t seed, int index, int gravityInterval)
+        : seed_(seed), index_(index), gravityInterval_(gravityInterval) {
+        Reset();
+    }
+
+    // Returns the reward; sets `done` when the game ended and restarted.
+    float Step(EnvAction action, bool &done) {
+        const int before = model_.Score();
+        bool locked = false;
+        switch (action) {
+        case EnvAction::Left:
+            (void)model_.Move(-1, 0);
+            break;
+        case EnvAction::Right:
+            (void)model_.Move(1, 0);
+            break;
+        case EnvAction::Rotate:
+            (void)model_.RotateCW();
+            break;
+        case EnvAction::SoftDrop:
+            locked = !model_.SoftDrop();
+            break;
+        case EnvAction::HardDrop:
+            model_.HardDrop();
+            locked = true;
+            break;
+        case EnvAction::None:
+            break;
+        }
+        ++ticks_;
+        if (!locked && gravityInterval_ > 0 && ticks_ % gravityInterval_ == 0) {
+            model_.TickGravity();
+        }
+        if (!model_.CurrentPiece()) {
+            (void)model_.Spawn(pieces_.Next());
+        }
+        const auto reward = static_cast<float>(model_.Score() - before);
+        done = model_.IsGameOver();
+        if (done) {
+            Reset();
+        }
+        return reward;
+    }
+
+    void Observe(std::uint8_t *out) const {
+        std::memset(out, 0, kObservationBytes);
+        const auto &cells = model_.GetBoard().Cells();
+        for (int y = 0; y < kBoardHeight; ++y) {
+            for (int x = 0; x < kBoardWidth; ++x) {
+                out[y * kBoardWidth + x] = cells[y][x] != Cell::Empty ? 1 : 0;
+            }
+        }
+        const auto &piece = *model_.CurrentPiece();
+        for (const auto &block : piece.piece.Blocks()) {
+            const int x = piece.origin.x + block.x;
+            const int y = piece.origin.y + block.y;
+            if (x >= 0 && x < kBoardWidth && y >= 0 && y < kBoardHeight) {
+                out[kBoardWidth * kBoardHeight + y * kBoardWidth + x] = 1;
+            }
+        }
+        out[kNextPieceOffset + static_cast<std::size_t>(pieces_.Peek(0))] = 1;
+    }
+
+    [[nodiscard]] int Score() const {
+        return model_.Score();
+    }
+
+    // Starts the game's next episode, as BatchEnv::Reset does.
+    void Reset() {
+        const std::uint64_t stream = static_cast<std::uint64_t>(index_) << 32 | episodes_++;
+        pieces_.Reset(mctetris::model::CounterRng::StreamKey(seed_, stream));
+        model_ = GameModel{};
+        ticks_ = 0;
+        (void)model_.Spawn(pieces_.Next());
+    }
+
+  private:
+    std::uint64_t seed_;
+    int index_;
+    int gravityInterval_;
+    GameModel model_{};
+    PieceGenerator pieces_;
+    std::uint32_t episodes_ = 0;
+    int ticks_ = 0;
+};
+
+int Run(int count, std::uint64_t seed, int gravityInterval, int threads, int steps, long &dones) {
+    BatchEnv env(count, seed, gravityInterval, threads);
+    std::vector<ReferenceGame> games;
+    for (int i = 0; i < count; ++i) {
+        games.emplace_back(seed, i, gravityInterval);
+    }
+
+    std::mt19937 rng(static_cast<std::uint32_t>(seed * 31 + static_cast<std::uint64_t>(gravityInterval)));
+    std::vector<std::uint8_t> actions(count);
+    std::vector<std::uint8_t> observations(count * kObservationBytes);
+    std::vector<float> rewards(count);
+    std::vector<std::uint8_t> doneFlags(count);
+    std::vector<std::uint8_t> expected(kObservationBytes);
+    int failures = 0;
+    const auto fail = [&](const char *what, int step, int game) {
+        if (failures < 10) {
+            std::fprintf(stderr, "gravity %d, step %d, game %d: %s differs\n", gravityInterval, step, game, what);
+        }
+        ++failures;
+    };
+
+    env.Reset(observations.data());
+    for (int i = 0; i < count; ++i) {
+        games[i].Reset();
+        games[i].Observe(expected.data());
+        if (std::memcmp(expected.data(), observations.data() + i * kObservationBytes, kObservationBytes) != 0) {
+            fail("first observation", 0, i);
+        }
+    }
+    for (int step = 1; step <= steps; ++step) {
+        // Values past None included: the env treats them as None.
+        for (auto &action : actions) {
+            const unsigned roll = rng() % 16;
+            action = static_cast<std::uint8_t>(roll < 2 ? 6 + roll : roll % 6);
+        }
+        env.Step(actions.data(), observations.data(), rewards.data(), doneFlags.data());
+        for (int i = 0; i < count; ++i) {
+            const auto action = actions[i] <= static_cast<std::uint8_t>(EnvAction::None)
+                                    ? static_cast<EnvAction>(actions[i])
+                                    : EnvAction::None;
+            bool done = false;
+            const float reward = games[i].Step(action, done);
+            dones += done ? 1 : 0;
+            if (rewards[i] != reward) {
+                fail("reward", step, i);
+            }
+            if ((doneFlags[i] != 0) != done) {
+                fail("done", step, i);
+            }
+            if (env.Score(i) != games[i].Score()) {
+                fail("score", step, i);
+            }
+            games[i].Observe(expected.data());
+            if (std::memcmp(expected.data(), observations.data() + i * kObservationBytes, kObservationBytes) != 0) {
+                fail("observation", step, i);
+            }
+        }
+    }
+    return failures;
+}
+
+} // namespace
+
+int main() {
+    // More games than one pool block, on two threads, so blocks run concurrently.
+    constexpr int kGames = 150;
+    constexpr int kSteps = 1500;
+    int failures = 0;
+    long dones = 0;
+    for (const int gravity : {0, 1, 3}) {
+        failures += Run(kGames, 11, gravity, 2, kSteps, dones);
+    }
+    std::printf("%d games x %d steps at gravity 0, 1 and 3, %ld games ended, %d failures\n", kGames, kSteps, dones,
+                failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+// Differential test of the batch feature kernels against the cell-by-cell
+// reference: every kernel this CPU supports, on random batches of random
+// boards, padding lanes included.
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bot/batch_features.h"
+#include "model/board.h"
+
+namespace {
+
+using mctetris::bot::BoardBatch;
+using mctetris::bot::DetailedFeatures;
+using mctetris::bot::FeatureBatch;
+using mctetris::bot::FeatureKernel;
+using mctetris::model::Board;
+using mctetris::model::kBoardHeight;
+using mctetris::model::kBoardWidth;
+using mctetris::model::Tetromino;
+using mctetris::model::TetrominoType;
+
+bool SameFeatures(const DetailedFeatures &lhs, const DetailedFeatures &rhs) {
+    return lhs.columnHeights == rhs.columnHeights && lhs.aggregateHeight == rhs.aggregateHeight &&
+           lhs.maxHeight == rhs.maxHeight && lhs.holes == rhs.holes && lhs.bumpiness == rhs.bumpiness &&
+           lhs.wells == rhs.wells && lhs.rowTransitions == rhs.rowTransitions;
+}
+
+// Pieces stamped at random spots below a random stack top, floating and
+// overlapping, clipped at the walls and floor, at a random density, so
+// holes, overhangs, wells and full rows all turn up.
+Board NoiseBoard(std::mt19937 &rng) {
+    Board board;
+    const int top = static_cast<int>(rng() % (kBoardHeight + 1));
+    const int pieces = static_cast<int>(rng() % ((kBoardHeight - top) * kBoardWidth / 2 + 1));
+    for (int i = 0; i < pieces; ++i) {
+        const Tetromino piece{static_cast<TetrominoType>(rng() % 7), static_cast<int>(rng() % 4)};
+        const int x = static_cast<int>(rng() % (kBoardWidth + 3)) - 3;
+        const int y = top + static_cast<int>(rng() % (kBoardHeight - top));
+        board.Place(piece, x, y);
+    }
+    return board;
+}
+
+// Pieces hard-dropped at random columns, lines cleared, as in play.
+Board StackedBoard(std::mt19937 &rng) {
+    Board board;
+    const int pieces = static_cast<int>(rng() % 60);
+    for (int i = 0; i < pieces; ++i) {
+        const Tetromino piece{static_cast<TetrominoType>(rng() % 7), static_cast<int>(rng() % 4)};
+        const int x = static_cast<int>(rng() % (kBoardWidth + 3)) - 3;
+        if (!board.CanPlace(piece, x, 0)) {
+            continue;
+        }
+        board.Place(piece, x, board.DropDistance(piece, x, 0));
+        (void)board.ClearFullLines();
+    }
+    return board;
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(2024);
+    const DetailedFeatures empty = mctetris::bot::ComputeFeaturesReference(Board{});
+    int failures = 0;
+    for (const auto kernel : {FeatureKernel::Scalar, FeatureKernel::Sse41, FeatureKernel::Avx2}) {
+        const char *name = mctetris::bot::KernelName(kernel);
+        if (!mctetris::bot::KernelSupported(kernel)) {
+            std::printf("%s: not supported on this CPU, skipped\n", name);
+            continue;
+        }
+        // One batch reused throughout, so padding left over from a larger
+        // batch would show up in a smaller one.
+        BoardBatch batch;
+        FeatureBatch features;
+        long long boards = 0;
+        int kernelFailures = 0;
+        for (int round = 0; round < 1500; ++round) {
+            batch.Clear();
+            std::vector<Board> added;
+            const int size = 1 + static_cast<int>(rng() % 70);
+            for (int i = 0; i < size; ++i) {
+                added.push_back(rng() % 2 == 0 ? NoiseBoard(rng) : StackedBoard(rng));
+                (void)batch.Add(added.back());
+            }
+            mctetris::bot::ComputeFeatureBatch(batch, features, kernel);
+            for (int lane = 0; lane < batch.Stride(); ++lane) {
+                const auto index = static_cast<std::size_t>(lane);
+                const DetailedFeatures expected =
+                    lane < size ? mctetris::bot::ComputeFeaturesReference(added[index]) : empty;
+                if (!SameFeatures(features.At(lane), expected) && kernelFailures++ < 10) {
+                    std::fprintf(stderr, "  %s: round %d lane %d of %d (%s) disagrees with the reference\n", name,
+                                 round, lane, batch.Stride(), lane < size ? "board" : "padding");
+                }
+            }
+            boards += batch.Stride();
+        }
+        std::printf("%s: %lld lanes, %d failures\n", name, boards, kernelFailures);
+        failures += kernelFailures;
+    }
+    return failures == 0 ? 0 : 1;
+}
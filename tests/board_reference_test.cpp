@@ -0,0 +1,203 @@
+// Differential test of the bitmask Board against the original grid-walking
+// implementation, kept here as the reference: random games on every
+// instantiated size, comparing CanPlace, DropDistance and ClearFullLines
+// and checking the derived masks, counts, skyline and hash after each move.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "model/board.h"
+
+namespace {
+
+using mctetris::model::BasicBoard;
+using mctetris::model::Cell;
+using mctetris::model::Tetromino;
+using mctetris::model::TetrominoType;
+
+// The cell grid and the grid-walking operations Board had before it kept
+// row masks.
+template <int Width, int Height>
+struct ReferenceBoard {
+    using Grid = typename BasicBoard<Width, Height>::CellGrid;
+
+    Grid cells{};
+
+    ReferenceBoard() {
+        for (auto &row : cells) {
+            row.fill(Cell::Empty);
+        }
+    }
+
+    [[nodiscard]] static bool IsInside(int x, int y) {
+        return x >= 0 && x < Width && y >= 0 && y < Height;
+    }
+
+    [[nodiscard]] bool IsEmpty(int x, int y) const {
+        return IsInside(x, y) && cells[y][x] == Cell::Empty;
+    }
+
+    [[nodiscard]] bool CanPlace(const Tetromino &piece, int originX, int originY) const {
+        for (const auto &block : piece.Blocks()) {
+            if (!IsEmpty(originX + block.x, originY + block.y)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] int DropDistance(const Tetromino &piece, int originX, int originY) const {
+        int distance = 0;
+        while (CanPlace(piece, originX, originY + distance + 1)) {
+            ++distance;
+        }
+        return distance;
+    }
+
+    void Place(const Tetromino &piece, int originX, int originY) {
+        for (const auto &block : piece.Blocks()) {
+            if (IsInside(originX + block.x, originY + block.y)) {
+                cells[originY + block.y][originX + block.x] = piece.CellType();
+            }
+        }
+    }
+
+    // Full rows in [firstRow, lastRow] are removed; everything above them
+    // moves down.
+    int ClearFullLines(int firstRow, int lastRow) {
+        int cleared = 0;
+        int writeRow = Height - 1;
+        for (int readRow = Height - 1; readRow >= 0; --readRow) {
+            const auto &row = cells[readRow];
+            const bool full = std::all_of(row.begin(), row.end(), [](Cell cell) { return cell != Cell::Empty; });
+            if (full && readRow >= firstRow && readRow <= lastRow) {
+                ++cleared;
+                continue;
+            }
+            if (writeRow != readRow) {
+                cells[writeRow] = row;
+            }
+            --writeRow;
+        }
+        for (int row = writeRow; row >= 0; --row) {
+            cells[row].fill(Cell::Empty);
+        }
+        return cleared;
+    }
+};
+
+struct Failures {
+    int count = 0;
+
+    void Check(bool ok, const char *what, int width, int height, int game, int move) {
+        if (!ok && count++ < 20) {
+            std::fprintf(stderr, "  %dx%d game %d move %d: %s\n", width, height, game, move, what);
+        }
+    }
+};
+
+// Every derived field of `board` must match what its cells imply.
+template <int Width, int Height>
+bool DerivedStateMatches(const BasicBoard<Width, Height> &board) {
+    using Board = BasicBoard<Width, Height>;
+    std::array<typename Board::RowMask, Height> masks{};
+    std::array<std::uint8_t, Width> heights{};
+    for (int y = 0; y < Height; ++y) {
+        int fill = 0;
+        for (int x = 0; x < Width; ++x) {
+            if (board.Cells()[y][x] != Cell::Empty) {
+                masks[y] = static_cast<typename Board::RowMask>(masks[y] | (typename Board::RowMask{1} << x));
+                ++fill;
+                heights[x] = std::max(heights[x], static_cast<std::uint8_t>(Height - y));
+            }
+        }
+        if (board.RowFillCounts()[y] != fill) {
+            return false;
+        }
+    }
+    Board rebuilt;
+    rebuilt.SetCells(board.Cells(), masks);
+    return board.RowMasks() == masks && board.ColumnHeights() == heights && board.Hash() == rebuilt.Hash();
+}
+
+template <int Width, int Height>
+int RunGames(std::uint32_t seed, int games) {
+    std::mt19937 rng(seed);
+    Failures failures;
+    for (int game = 0; game < games; ++game) {
+        BasicBoard<Width, Height> board;
+        ReferenceBoard<Width, Height> reference;
+        for (int move = 0; move < 4 * Height * Width; ++move) {
+            const Tetromino base{static_cast<TetrominoType>(rng() % 7), 0};
+
+            // Compare every origin a 4x4 box can take around the board, and
+            // collect the resting positions, tucks included.
+            struct Spot {
+                Tetromino piece;
+                int x;
+                int y;
+            };
+            std::vector<Spot> resting;
+            for (int rotation = 0; rotation < 4; ++rotation) {
+                const Tetromino piece{base.type, rotation};
+                for (int y = -4; y <= Height; ++y) {
+                    for (int x = -4; x <= Width; ++x) {
+                        const bool fits = board.CanPlace(piece, x, y);
+                        failures.Check(fits == reference.CanPlace(piece, x, y), "CanPlace", Width, Height, game, move);
+                        if (!fits) {
+                            continue;
+                        }
+                        failures.Check(board.DropDistance(piece, x, y) == reference.DropDistance(piece, x, y),
+                                       "DropDistance", Width, Height, game, move);
+                        if (!reference.CanPlace(piece, x, y + 1)) {
+                            resting.push_back(Spot{piece, x, y});
+                        }
+                    }
+                }
+            }
+            if (resting.empty()) {
+                break;
+            }
+
+            const Spot spot = resting[rng() % resting.size()];
+            const auto hashAfter = board.HashAfterPlace(spot.piece, spot.x, spot.y);
+            board.Place(spot.piece, spot.x, spot.y);
+            reference.Place(spot.piece, spot.x, spot.y);
+            if (hashAfter) {
+                failures.Check(*hashAfter == board.Hash(), "HashAfterPlace", Width, Height, game, move);
+            }
+
+            // Mostly the whole board, sometimes a window as the lock paths use.
+            int firstRow = 0;
+            int lastRow = Height - 1;
+            if (rng() % 3 == 0) {
+                firstRow = static_cast<int>(rng() % Height);
+                lastRow = firstRow + static_cast<int>(rng() % 4);
+            }
+            const int cleared = firstRow == 0 && lastRow == Height - 1 ? board.ClearFullLines()
+                                                                       : board.ClearFullLines(firstRow, lastRow);
+            failures.Check(cleared == reference.ClearFullLines(firstRow, lastRow), "ClearFullLines count", Width,
+                           Height, game, move);
+            failures.Check(board.Cells() == reference.cells, "cells", Width, Height, game, move);
+            failures.Check(DerivedStateMatches(board), "masks, counts, skyline or hash", Width, Height, game, move);
+        }
+    }
+    std::printf("%dx%d: %d games, %d failures\n", Width, Height, games, failures.count);
+    return failures.count;
+}
+
+} // namespace
+
+int main() {
+    int failures = 0;
+    failures += RunGames<10, 20>(1, 40);
+    failures += RunGames<10, 40>(2, 10);
+    failures += RunGames<4, 20>(3, 40);
+    failures += RunGames<16, 24>(4, 10);
+    failures += RunGames<32, 32>(5, 4);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+// The wire protocol against the games it carries: a client copy kept only by
+// decoding and applying each State must match the server's game after every
+// action. Every message must fit kMaxMessageBytes, and truncated, padded,
+// oversized, mistyped or out-of-range messages must be refused.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "model/game_session.h"
+#include "model/replay.h"
+#include "net/protocol.h"
+
+namespace {
+
+using mctetris::model::GameModel;
+using mctetris::model::GameSession;
+using mctetris::model::kBoardHeight;
+using mctetris::model::ReplayAction;
+namespace net = mctetris::net;
+
+using Message = std::vector<std::uint8_t>;
+
+int failures = 0;
+
+void Expect(bool condition, const char *what) {
+    if (!condition) {
+        if (failures < 10) {
+            std::fprintf(stderr, "failed: %s\n", what);
+        }
+        ++failures;
+    }
+}
+
+template <typename Encode, typename Value>
+Message Encoded(Encode encode, const Value &value) {
+    Message message(net::kMaxMessageBytes);
+    message.resize(encode(value, message.data()));
+    return message;
+}
+
+void SetBodySize(Message &message, std::size_t body) {
+    message[0] = static_cast<std::uint8_t>(body);
+    message[1] = static_cast<std::uint8_t>(body >> 8);
+}
+
+ReplayAction RandomAction(std::mt19937 &rng) {
+    const unsigned roll = rng() % 20;
+    if (roll < 6) {
+        return ReplayAction::Gravity;
+    }
+    if (roll < 8) {
+        return ReplayAction::HardDrop;
+    }
+    return static_cast<ReplayAction>(roll % 4);
+}
+
+// Builds a State the way the server does, carrying only rows that changed.
+net::State MakeState(const GameSession &session,
+                     std::uint16_t sequence,
+                     std::array<net::PackedRow, kBoardHeight> &sentRows,
+                     bool &sentAny) {
+    const GameModel &model = session.Model();
+    net::State state;
+    state.sequence = sequence;
+    state.gameOver = model.IsGameOver();
+    state.score = model.Score();
+    state.lines = model.LinesCleared();
+    state.level = model.Level();
+    state.piece = model.CurrentPiece();
+    state.next = session.NextType();
+    const auto &cells = model.GetBoard().Cells();
+    for (int y = 0; y < kBoardHeight; ++y) {
+        const auto packed = net::PackRow(cells[y]);
+        if (!sentAny || packed != sentRows[y]) {
+            state.rowMask |= 1u << y;
+            state.rows[y] = packed;
+            sentRows[y] = packed;
+        }
+    }
+    sentAny = true;
+    return state;
+}
+
+bool SamePiece(const std::optional<mctetris::model::ActivePiece> &lhs,
+               const std::optional<mctetris::model::ActivePiece> &rhs) {
+    if (lhs.has_value() != rhs.has_value()) {
+        return false;
+    }
+    return !lhs || (lhs->piece.type == rhs->piece.type && lhs->piece.rotation == rhs->piece.rotation &&
+                    lhs->origin.x == rhs->origin.x && lhs->origin.y == rhs->origin.y);
+}
+
+bool SameState(const net::State &lhs, const net::State &rhs) {
+    if (lhs.sequence != rhs.sequence || lhs.gameOver != rhs.gameOver || lhs.score != rhs.score ||
+        lhs.lines != rhs.lines || lhs.level != rhs.level || lhs.next != rhs.next || lhs.rowMask != rhs.rowMask ||
+        !SamePiece(lhs.piece, rhs.piece)) {
+        return false;
+    }
+    for (int y = 0; y < kBoardHeight; ++y) {
+        if ((lhs.rowMask & (1u << y)) != 0 && lhs.rows[y] != rhs.rows[y]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SameGame(const GameModel &lhs, const GameModel &rhs) {
+    return lhs.GetBoard().Cells() == rhs.GetBoard().Cells() && SamePiece(lhs.CurrentPiece(), rhs.CurrentPiece()) &&
+           lhs.Score() == rhs.Score() && lhs.LinesCleared() == rhs.LinesCleared() && lhs.Level() == rhs.Level() &&
+           lhs.IsGameOver() == rhs.IsGameOver();
+}
+
+// A message cut short or with a byte too many, its length prefix agreeing or not.
+void CheckFraming(const Message &message, std::mt19937 &rng) {
+    for (std::size_t size = 0; size < message.size(); ++size) {
+        const auto waiting = net::MessageSize(message.data(), size);
+        Expect(waiting == std::size_t{0}, "a partial message is awaited");
+        Expect(!net::DecodeState(message.data(), size), "a cut State is refused");
+    }
+    Message cut(message.begin(), message.end() - static_cast<std::ptrdiff_t>(1 + rng() % (message.size() - 3)));
+    SetBodySize(cut, cut.size() - 2);
+    Expect(!net::DecodeState(cut.data(), cut.size()), "a short State with a matching prefix is refused");
+    Message padded = message;
+    padded.push_back(static_cast<std::uint8_t>(rng()));
+    SetBodySize(padded, padded.size() - 2);
+    Expect(!net::DecodeState(padded.data(), padded.size()), "a padded State is refused");
+}
+
+void CheckRejections() {
+    const std::uint8_t empty[2] = {0, 0};
+    Expect(!net::MessageSize(empty, sizeof(empty)), "an empty body is malformed");
+    std::uint8_t largest[net::kMaxMessageBytes] = {};
+    largest[0] = static_cast<std::uint8_t>(net::kMaxMessageBytes - 2);
+    Expect(net::MessageSize(largest, sizeof(largest)) == net::kMaxMessageBytes, "the largest message fits");
+    Expect(net::MessageSize(largest, sizeof(largest) - 1) == std::size_t{0}, "the largest message is awaited");
+    for (std::size_t body = net::kMaxMessageBytes - 1; body < 0x10000; body += 97) {
+        std::uint8_t prefix[2] = {static_cast<std::uint8_t>(body), static_cast<std::uint8_t>(body >> 8)};
+        Expect(!net::MessageSize(prefix, sizeof(prefix)), "an oversized length is malformed");
+    }
+
+    net::Hello hello;
+    hello.nameLength = 5;
+    hello.name = {'a', 'l', 'i', 'c', 'e'};
+    hello.seed = 0xdeadbeef;
+    hello.flags = net::kClientGravity;
+    hello.randomizer = mctetris::model::Randomizer::History;
+    const Message helloMessage = Encoded(net::EncodeHello, hello);
+    const auto decodedHello = net::DecodeHello(helloMessage.data(), helloMessage.size());
+    Expect(decodedHello && decodedHello->seed == hello.seed && decodedHello->flags == hello.flags &&
+               decodedHello->randomizer == hello.randomizer && decodedHello->nameLength == 5 &&
+               decodedHello->name == hello.name,
+           "Hello round trip");
+    Expect(net::TypeOf(helloMessage.data(), helloMessage.size()) == net::MessageType::Hello, "Hello type");
+    Expect(!net::DecodeState(helloMessage.data(), helloMessage.size()), "a Hello is not a State");
+    Expect(!net::DecodeInput(helloMessage.data(), helloMessage.size()), "a Hello is not an Input");
+    Message longName = helloMessage;
+    longName[2 + 7] = static_cast<std::uint8_t>(net::kMaxNameBytes + 1);
+    Expect(!net::DecodeHello(longName.data(), longName.size()), "a name past kMaxNameBytes is refused");
+    Message badRandomizer = helloMessage;
+    badRandomizer[2 + 2] = 0xff;
+    Expect(!net::DecodeHello(badRandomizer.data(), badRandomizer.size()), "an unknown randomizer is refused");
+
+    for (int action = 0; action <= static_cast<int>(ReplayAction::Gravity); ++action) {
+        const net::Input input{static_cast<ReplayAction>(action), static_cast<std::uint16_t>(0xfff0 + action)};
+        const Message message = Encoded(net::EncodeInput, input);
+        const auto decoded = net::DecodeInput(message.data(), message.size());
+        Expect(decoded && decoded->action == input.action && decoded->sequence == input.sequence, "Input round trip");
+        Expect(!net::DecodeState(message.data(), message.size()), "an Input is not a State");
+        Expect(!net::DecodeHello(message.data(), message.size()), "an Input is not a Hello");
+    }
+    Message badAction = Encoded(net::EncodeInput, net::Input{});
+    badAction[3] = static_cast<std::uint8_t>(ReplayAction::Gravity) + 1;
+    Expect(!net::DecodeInput(badAction.data(), badAction.size()), "an unknown action is refused");
+    Message unknownType = badAction;
+    unknownType[2] = 9;
+    Expect(!net::TypeOf(unknownType.data(), unknownType.size()), "an unknown type has no type");
+
+    net::State state;
+    state.piece = mctetris::model::ActivePiece{};
+    state.rowMask = 1;
+    const Message stateMessage = Encoded(net::EncodeState, state);
+    Expect(net::DecodeState(stateMessage.data(), stateMessage.size()).has_value(), "a one-row State decodes");
+    // Body offsets: type 0, sequence 1, flags 3, score 4, lines 8, level 12,
+    // piece 14, x 15, y 16, next 17, row mask 18.
+    Message badPiece = stateMessage;
+    badPiece[2 + 14] = static_cast<std::uint8_t>(mctetris::model::kTetrominoTypeCount);
+    Expect(!net::DecodeState(badPiece.data(), badPiece.size()), "an unknown piece type is refused");
+    Message badRotation = stateMessage;
+    badRotation[2 + 14] = 4u << 4;
+    Expect(!net::DecodeState(badRotation.data(), badRotation.size()), "an unknown rotation is refused");
+    Message badNext = stateMessage;
+    badNext[2 + 17] = static_cast<std::uint8_t>(mctetris::model::kTetrominoTypeCount);
+    Expect(!net::DecodeState(badNext.data(), badNext.size()), "an unknown next piece is refused");
+    Message extraRow = stateMessage;
+    extraRow[2 + 18 + 2] = static_cast<std::uint8_t>(1u << (kBoardHeight - 16));
+    Expect(!net::DecodeState(extraRow.data(), extraRow.size()), "a row past the board is refused");
+}
+
+} // namespace
+
+int main() {
+    CheckRejections();
+
+    std::mt19937 rng(77);
+    std::size_t largest = 0;
+    long states = 0;
+    for (std::uint32_t seed = 0; seed < 40; ++seed) {
+        GameSession session(seed);
+        GameModel client;
+        std::array<net::PackedRow, kBoardHeight> sentRows{};
+        bool sentAny = false;
+        std::uint16_t sequence = 0;
+        for (int step = 0; step < 2000 && !session.Model().IsGameOver(); ++step) {
+            (void)mctetris::model::ApplyReplayAction(session, RandomAction(rng));
+            const net::State state = MakeState(session, ++sequence, sentRows, sentAny);
+            const Message message = Encoded(net::EncodeState, state);
+            largest = std::max(largest, message.size());
+            ++states;
+            Expect(message.size() <= net::kMaxMessageBytes, "a State fits kMaxMessageBytes");
+            Expect(net::MessageSize(message.data(), message.size()) == message.size(), "MessageSize of a State");
+            Expect(net::TypeOf(message.data(), message.size()) == net::MessageType::State, "State type");
+            Expect(!net::DecodeHello(message.data(), message.size()), "a State is not a Hello");
+            Expect(!net::DecodeInput(message.data(), message.size()), "a State is not an Input");
+            const auto decoded = net::DecodeState(message.data(), message.size());
+            Expect(decoded && SameState(*decoded, state), "State round trip");
+            if (decoded) {
+                net::ApplyState(*decoded, client);
+            }
+            Expect(SameGame(client, session.Model()), "the client copy matches the game");
+            if (step % 50 == 0) {
+                CheckFraming(message, rng);
+            }
+        }
+    }
+
+    std::printf("%ld states, largest %zu of %zu bytes, %d failures\n", states, largest, net::kMaxMessageBytes,
+                failures);
+    return failures == 0 ? 0 : 1;
+}
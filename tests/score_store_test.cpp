@@ -0,0 +1,254 @@
+// The score store against a brute-force ranking of every valid record: random
+// appends and compactions, a torn tail the next append drops, records that
+// fail their checksum, and an index left behind by a log replaced under it.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "scores/score_store.h"
+
+namespace {
+
+using mctetris::scores::kNameBytes;
+using mctetris::scores::ScoreEntry;
+using mctetris::scores::ScoreStore;
+
+// The store's file layout, which the faults below are written against.
+constexpr std::size_t kLogHeaderBytes = 16;
+constexpr std::size_t kRecordBytes = 48;
+constexpr std::size_t kScoreOffset = 16;
+
+// Two of these truncate to the same stored name.
+const char *const kNames[] = {"ann", "bob", "carol", "a-very-long-player-name", "a-very-long-play", "dave"};
+
+// What the store should hold: every record in log order, and whether it still
+// passes its checksum.
+struct ModelRecord {
+    ScoreEntry entry;
+    bool valid = true;
+};
+
+ScoreEntry RandomEntry(std::mt19937 &rng) {
+    ScoreEntry entry;
+    entry.name = kNames[rng() % std::size(kNames)];
+    // Few distinct scores, so ties between the index and the tail are common.
+    entry.score = static_cast<int>(rng() % 40) * 100;
+    entry.level = static_cast<int>(rng() % 30);
+    entry.lines = static_cast<int>(rng() % 300);
+    entry.timestamp = static_cast<std::int64_t>(rng());
+    entry.replayHash = (static_cast<std::uint64_t>(rng()) << 32) | rng();
+    return entry;
+}
+
+std::vector<ScoreEntry> Expected(const std::vector<ModelRecord> &model, const std::string *name, int count) {
+    std::vector<std::size_t> ordinals;
+    for (std::size_t i = 0; i < model.size(); ++i) {
+        if (model[i].valid && (name == nullptr || model[i].entry.name == name->substr(0, kNameBytes))) {
+            ordinals.push_back(i);
+        }
+    }
+    std::stable_sort(ordinals.begin(), ordinals.end(),
+                     [&](std::size_t lhs, std::size_t rhs) { return model[lhs].entry.score > model[rhs].entry.score; });
+    ordinals.resize(std::min(ordinals.size(), static_cast<std::size_t>(count)));
+    std::vector<ScoreEntry> entries;
+    for (const std::size_t ordinal : ordinals) {
+        entries.push_back(model[ordinal].entry);
+    }
+    return entries;
+}
+
+bool Same(const std::vector<ScoreEntry> &lhs, const std::vector<ScoreEntry> &rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+        if (lhs[i].name != rhs[i].name || lhs[i].score != rhs[i].score || lhs[i].level != rhs[i].level ||
+            lhs[i].lines != rhs[i].lines || lhs[i].timestamp != rhs[i].timestamp ||
+            lhs[i].replayHash != rhs[i].replayHash) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AppendRaw(const std::string &path, const std::vector<std::uint8_t> &bytes) {
+    const int fd = open(path.c_str(), O_WRONLY | O_APPEND);
+    const bool ok = fd >= 0 && write(fd, bytes.data(), bytes.size()) == static_cast<ssize_t>(bytes.size());
+    if (fd >= 0) {
+        close(fd);
+    }
+    return ok;
+}
+
+// Changes one score byte without fixing the checksum.
+bool Corrupt(const std::string &path, std::size_t ordinal) {
+    const int fd = open(path.c_str(), O_RDWR);
+    if (fd < 0) {
+        return false;
+    }
+    const off_t offset = static_cast<off_t>(kLogHeaderBytes + ordinal * kRecordBytes + kScoreOffset);
+    std::uint8_t byte = 0;
+    bool ok = pread(fd, &byte, 1, offset) == 1;
+    byte ^= 0x5a;
+    ok = ok && pwrite(fd, &byte, 1, offset) == 1;
+    close(fd);
+    return ok;
+}
+
+class Checker {
+  public:
+    explicit Checker(std::string path) : path_(std::move(path)) {}
+
+    void Check(const std::vector<ModelRecord> &model, std::mt19937 &rng, const char *stage) {
+        const ScoreStore store = ScoreStore::Open(path_);
+        ++checks_;
+        if (store.RecordCount() != model.size()) {
+            Fail(stage, "record count", static_cast<int>(store.RecordCount()));
+            return;
+        }
+        const int count = static_cast<int>(rng() % 25);
+        if (!Same(store.Top(count), Expected(model, nullptr, count))) {
+            Fail(stage, "Top", count);
+        }
+        for (const char *name : kNames) {
+            const std::string player = name;
+            if (!Same(store.TopForPlayer(player, count), Expected(model, &player, count))) {
+                Fail(stage, player.c_str(), count);
+            }
+        }
+    }
+
+    [[nodiscard]] int Checks() const {
+        return checks_;
+    }
+
+    [[nodiscard]] int Failures() const {
+        return failures_;
+    }
+
+  private:
+    void Fail(const char *stage, const char *what, int count) {
+        if (failures_ < 10) {
+            std::fprintf(stderr, "%s: %s (%d) disagrees with the reference\n", stage, what, count);
+        }
+        ++failures_;
+    }
+
+    std::string path_;
+    int checks_ = 0;
+    int failures_ = 0;
+};
+
+std::size_t BestOrdinal(const std::vector<ModelRecord> &model) {
+    std::size_t best = 0;
+    for (std::size_t i = 0; i < model.size(); ++i) {
+        if (model[i].valid && (!model[best].valid || model[i].entry.score > model[best].entry.score)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+bool AppendBatch(const std::string &path, std::vector<ModelRecord> &model, std::mt19937 &rng) {
+    std::vector<ScoreEntry> batch(1 + rng() % 40);
+    for (auto &entry : batch) {
+        entry = RandomEntry(rng);
+        model.push_back(ModelRecord{entry, true});
+        model.back().entry.name.resize(std::min(entry.name.size(), kNameBytes));
+    }
+    return ScoreStore::Append(path, batch);
+}
+
+} // namespace
+
+int main() {
+    char directory[] = "/tmp/mctetris_score_store_XXXXXX";
+    if (mkdtemp(directory) == nullptr) {
+        std::fprintf(stderr, "cannot make a temporary directory\n");
+        return 1;
+    }
+    const std::string path = std::string(directory) + "/scores";
+    const std::string replacement = std::string(directory) + "/replacement";
+
+    std::mt19937 rng(1234);
+    Checker checker(path);
+    std::vector<ModelRecord> model;
+    bool ok = true;
+
+    for (int round = 0; round < 400 && ok; ++round) {
+        switch (rng() % 16) {
+        case 0:
+            ok = ScoreStore::Compact(path);
+            checker.Check(model, rng, "compact");
+            break;
+        case 1:
+            // A crash mid-append: complete records stay, the next append drops the rest.
+            if (!model.empty()) {
+                std::vector<std::uint8_t> torn(1 + rng() % (kRecordBytes - 1));
+                for (auto &byte : torn) {
+                    byte = static_cast<std::uint8_t>(rng());
+                }
+                ok = AppendRaw(path, torn);
+                checker.Check(model, rng, "torn tail");
+                ok = ok && AppendBatch(path, model, rng);
+                checker.Check(model, rng, "append after torn tail");
+            }
+            break;
+        case 2:
+            if (!model.empty()) {
+                // Half the time the current best, which every Top must then read past.
+                std::size_t ordinal = rng() % model.size();
+                if (rng() % 2 == 0) {
+                    ordinal = BestOrdinal(model);
+                }
+                if (!model[ordinal].valid) {
+                    break;
+                }
+                ok = Corrupt(path, ordinal);
+                model[ordinal].valid = false;
+                checker.Check(model, rng, "corrupt record");
+            }
+            break;
+        case 3:
+            // A different log renamed over this one keeps the old index beside it.
+            if (!model.empty()) {
+                std::vector<ModelRecord> fresh;
+                (void)unlink(replacement.c_str());
+                const int batches = 1 + static_cast<int>(rng() % 3);
+                for (int i = 0; i < batches && ok; ++i) {
+                    ok = AppendBatch(replacement, fresh, rng);
+                }
+                ok = ok && std::rename(replacement.c_str(), path.c_str()) == 0;
+                model = std::move(fresh);
+                checker.Check(model, rng, "replaced log");
+            }
+            break;
+        default:
+            ok = AppendBatch(path, model, rng);
+            checker.Check(model, rng, "append");
+            break;
+        }
+    }
+
+    (void)unlink(path.c_str());
+    (void)unlink((path + ".idx").c_str());
+    (void)unlink(replacement.c_str());
+    (void)rmdir(directory);
+
+    if (!ok) {
+        std::fprintf(stderr, "a score file operation failed\n");
+        return 1;
+    }
+    std::printf("%d checks, %zu records at the end, %d failures\n", checker.Checks(), model.size(),
+                checker.Failures());
+    return checker.Failures() == 0 ? 0 : 1;
+}
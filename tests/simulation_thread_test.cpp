@@ -0,0 +1,153 @@
+// Commands sent faster than the simulation takes them must all arrive, in
+// order. Bursts far larger than the command queue, with held keys released
+// at the end of each, must leave nothing undelivered. Bursts of moves must
+// leave each game as the same moves applied in order to a copy of it would,
+// including the last burst, which Stop() has to deliver by itself.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "engine/simulation_thread.h"
+#include "input/input_wait.h"
+#include "model/replay.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using mctetris::engine::ShiftKey;
+using mctetris::engine::SimulationThread;
+using mctetris::model::GameSession;
+using mctetris::model::ReplayAction;
+
+// A game as the simulation thread handed it back when it ended.
+struct EndedGame {
+    std::uint32_t seed = 0;
+    GameSession session;
+    bool gravity = false;
+};
+
+bool SameGame(const GameSession &lhs, const GameSession &rhs) {
+    const auto &a = lhs.Model();
+    const auto &b = rhs.Model();
+    const auto &pieceA = a.CurrentPiece();
+    const auto &pieceB = b.CurrentPiece();
+    const bool samePiece = pieceA.has_value() == pieceB.has_value() &&
+                           (!pieceA || (pieceA->piece.type == pieceB->piece.type &&
+                                        pieceA->piece.rotation == pieceB->piece.rotation &&
+                                        pieceA->origin.x == pieceB->origin.x && pieceA->origin.y == pieceB->origin.y));
+    return samePiece && a.GetBoard().Cells() == b.GetBoard().Cells() && a.Score() == b.Score() &&
+           a.IsGameOver() == b.IsGameOver() && lhs.PiecesSpawned() == rhs.PiecesSpawned();
+}
+
+// Bursts with held keys; only the counts are known in advance.
+int CheckCounts() {
+    SimulationThread sim(mctetris::model::Randomizer::Bag7, mctetris::engine::AutoShiftConfig{}, nullptr,
+                         [](const GameSession &, const mctetris::model::Replay &, bool) {});
+    if (!sim.Start()) {
+        std::fprintf(stderr, "cannot start the simulation thread\n");
+        return 1;
+    }
+
+    constexpr int kBursts = 8;
+    constexpr int kBurstSize = 1000;
+    std::uint64_t issued = 0;
+    for (int burst = 0; burst < kBursts; ++burst) {
+        sim.NewGame(static_cast<std::uint32_t>(burst));
+        ++issued;
+        for (int i = 0; i < kBurstSize; ++i) {
+            const auto now = Clock::now();
+            if (i % 4 == 0) {
+                sim.Press(ShiftKey::Left, now, i % 8 != 0);
+            } else {
+                sim.Apply(i % 4 == 1 ? ReplayAction::MoveRight : ReplayAction::RotateCW);
+            }
+            ++issued;
+        }
+        sim.Release(ShiftKey::Left, Clock::now());
+        ++issued;
+    }
+
+    // Wait the way the front end does until the simulation has applied it all.
+    const auto deadline = Clock::now() + std::chrono::seconds(20);
+    while (sim.Latest().applied < issued && Clock::now() < deadline) {
+        (void)mctetris::input::WaitForInput(sim.WakeFd(), Clock::now() + std::chrono::milliseconds(100));
+        sim.AcknowledgeWake();
+        (void)sim.Update();
+    }
+    const std::uint64_t applied = sim.Latest().applied;
+    sim.Stop();
+
+    std::printf("issued %llu, sent %llu, applied %llu\n", static_cast<unsigned long long>(issued),
+                static_cast<unsigned long long>(sim.Sent()), static_cast<unsigned long long>(applied));
+    return sim.Sent() == issued && applied == issued ? 0 : 1;
+}
+
+// Bursts of moves, each on a new game, checked against the same moves
+// applied in order to a GameSession. The last burst is left for Stop().
+int CheckOrder() {
+    std::vector<EndedGame> ended;
+    SimulationThread sim(mctetris::model::Randomizer::Bag7, mctetris::engine::AutoShiftConfig{}, nullptr,
+                         [&ended](const GameSession &session, const mctetris::model::Replay &recording, bool) {
+                             EndedGame game{recording.seed, session, false};
+                             for (const auto &event : recording.events) {
+                                 game.gravity = game.gravity || event.action == ReplayAction::Gravity;
+                             }
+                             ended.push_back(game);
+                         });
+    if (!sim.Start()) {
+        std::fprintf(stderr, "cannot start the simulation thread\n");
+        return 1;
+    }
+
+    constexpr int kBursts = 6;
+    constexpr int kBurstSize = 3000;
+    std::mt19937 rng(9);
+    std::vector<GameSession> expected;
+    std::uint64_t issued = 0;
+    for (int burst = 0; burst < kBursts; ++burst) {
+        const auto seed = static_cast<std::uint32_t>(100 + burst);
+        sim.NewGame(seed);
+        GameSession reference(seed);
+        for (int i = 0; i < kBurstSize; ++i) {
+            const unsigned roll = rng() % 40;
+            const auto action = roll == 0 ? ReplayAction::HardDrop : static_cast<ReplayAction>(roll % 3);
+            sim.Apply(action);
+            if (!reference.Model().IsGameOver()) {
+                (void)mctetris::model::ApplyReplayAction(reference, action);
+            }
+        }
+        expected.push_back(reference);
+        issued += 1 + kBurstSize;
+    }
+    sim.Stop();
+    (void)sim.Update();
+
+    int checked = 0;
+    int wrong = 0;
+    for (std::size_t i = 0; i < ended.size() && i < expected.size(); ++i) {
+        // A game that ran long enough for gravity to fall cannot be compared.
+        if (ended[i].gravity) {
+            continue;
+        }
+        ++checked;
+        if (ended[i].seed != expected[i].Seed() || !SameGame(ended[i].session, expected[i])) {
+            std::fprintf(stderr, "game %zu does not match its moves applied in order\n", i);
+            ++wrong;
+        }
+    }
+    std::printf("%zu of %d games ended, %d compared, %d out of order; applied %llu of %llu\n", ended.size(),
+                kBursts, checked, wrong, static_cast<unsigned long long>(sim.Latest().applied),
+                static_cast<unsigned long long>(issued));
+    return ended.size() == kBursts && checked > 0 && wrong == 0 && sim.Latest().applied == issued ? 0 : 1;
+}
+
+} // namespace
+
+int main() {
+    const int counts = CheckCounts();
+    const int order = CheckOrder();
+    return counts == 0 && order == 0 ? 0 : 1;
+}
@@ -0,0 +1,230 @@
+// Snapshots of random positions must decode to the same game: the cells, the
+// derived row masks, fill counts, skyline and hash, the piece and the scalars.
+// Session snapshots must resume with the same pieces. A short buffer, another
+// version, an unknown piece type or a piece overlapping the board must be
+// refused with the model left as it was.
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "model/game_session.h"
+#include "model/replay.h"
+#include "model/snapshot.h"
+
+namespace {
+
+using mctetris::model::ActivePiece;
+using mctetris::model::Board;
+using mctetris::model::Cell;
+using mctetris::model::GameModel;
+using mctetris::model::GameSession;
+using mctetris::model::kBoardHeight;
+using mctetris::model::kBoardWidth;
+using mctetris::model::kSessionSnapshotBytes;
+using mctetris::model::kSnapshotBytes;
+using mctetris::model::ReplayAction;
+using mctetris::model::Tetromino;
+using mctetris::model::TetrominoType;
+
+// Snapshot header offsets.
+constexpr std::size_t kFlagsByte = 1;
+constexpr std::size_t kOriginXByte = 2;
+constexpr std::size_t kOriginYByte = 3;
+constexpr int kTypeShift = 2;
+
+int failures = 0;
+int overlapsTried = 0;
+
+void Expect(bool condition, const char *what) {
+    if (!condition) {
+        if (failures < 10) {
+            std::fprintf(stderr, "failed: %s\n", what);
+        }
+        ++failures;
+    }
+}
+
+Board RandomBoard(std::mt19937 &rng) {
+    Board board;
+    const int top = static_cast<int>(rng() % (kBoardHeight + 1));
+    const unsigned density = 1 + rng() % 9;
+    for (int y = top; y < kBoardHeight; ++y) {
+        Board::Row row{};
+        for (auto &cell : row) {
+            cell = rng() % 10 < density ? static_cast<Cell>(1 + rng() % 7) : Cell::Empty;
+        }
+        board.SetRow(y, row);
+    }
+    return board;
+}
+
+// A piece placed wherever it fits, or none once enough tries fail.
+std::optional<ActivePiece> RandomPiece(const Board &board, std::mt19937 &rng) {
+    for (int attempt = 0; attempt < 50; ++attempt) {
+        const Tetromino piece{static_cast<TetrominoType>(rng() % 7), static_cast<int>(rng() % 4)};
+        const int x = static_cast<int>(rng() % (kBoardWidth + 4)) - 3;
+        const int y = static_cast<int>(rng() % (kBoardHeight + 4)) - 3;
+        if (board.CanPlace(piece, x, y)) {
+            return ActivePiece{piece, {x, y}};
+        }
+    }
+    return std::nullopt;
+}
+
+bool SamePiece(const std::optional<ActivePiece> &lhs, const std::optional<ActivePiece> &rhs) {
+    if (lhs.has_value() != rhs.has_value()) {
+        return false;
+    }
+    return !lhs || (lhs->piece.type == rhs->piece.type && lhs->piece.rotation == rhs->piece.rotation &&
+                    lhs->origin.x == rhs->origin.x && lhs->origin.y == rhs->origin.y);
+}
+
+bool SameGame(const GameModel &lhs, const GameModel &rhs) {
+    return lhs.GetBoard().Cells() == rhs.GetBoard().Cells() && SamePiece(lhs.CurrentPiece(), rhs.CurrentPiece()) &&
+           lhs.Score() == rhs.Score() && lhs.LinesCleared() == rhs.LinesCleared() && lhs.Level() == rhs.Level() &&
+           lhs.IsGameOver() == rhs.IsGameOver();
+}
+
+// The derived state rebuilt from the cells alone.
+void CheckDerived(const Board &decoded, const Board &original) {
+    const auto &cells = decoded.Cells();
+    std::array<std::uint8_t, kBoardWidth> heights{};
+    for (int y = kBoardHeight - 1; y >= 0; --y) {
+        int fill = 0;
+        Board::RowMask mask = 0;
+        for (int x = 0; x < kBoardWidth; ++x) {
+            if (cells[y][x] != Cell::Empty) {
+                ++fill;
+                mask = static_cast<Board::RowMask>(mask | (1u << x));
+                heights[x] = static_cast<std::uint8_t>(kBoardHeight - y);
+            }
+        }
+        Expect(decoded.RowMasks()[y] == mask, "row mask");
+        Expect(decoded.RowFillCounts()[y] == fill, "row fill count");
+    }
+    Expect(decoded.ColumnHeights() == heights, "skyline");
+    Expect(decoded.Hash() == original.Hash(), "hash");
+}
+
+void CheckRejections(const std::vector<std::uint8_t> &snapshot, const GameModel &source, std::mt19937 &rng) {
+    GameModel model;
+    model.Restore(RandomBoard(rng), std::nullopt, 3, 1, 42, false);
+    const GameModel before = model;
+
+    Expect(!mctetris::model::DecodeSnapshot(snapshot.data(), kSnapshotBytes - 1, model), "a short buffer is refused");
+    auto version = snapshot;
+    version[0] = static_cast<std::uint8_t>(mctetris::model::kSnapshotVersion + 1);
+    Expect(!mctetris::model::DecodeSnapshot(version.data(), version.size(), model), "another version is refused");
+    auto type = snapshot;
+    type[kFlagsByte] = static_cast<std::uint8_t>(type[kFlagsByte] | 1u | 7u << kTypeShift);
+    Expect(!mctetris::model::DecodeSnapshot(type.data(), type.size(), model), "an unknown piece type is refused");
+
+    // Moves the piece onto a filled cell, where the board has one.
+    if (source.CurrentPiece()) {
+        const Board &board = source.GetBoard();
+        const Tetromino piece = source.CurrentPiece()->piece;
+        for (int y = -3; y < kBoardHeight; ++y) {
+            for (int x = -3; x < kBoardWidth; ++x) {
+                bool overlaps = false;
+                bool inside = true;
+                for (const auto &block : piece.Blocks()) {
+                    const int bx = x + block.x;
+                    const int by = y + block.y;
+                    inside = inside && bx >= 0 && bx < kBoardWidth && by < kBoardHeight;
+                    overlaps = overlaps || (inside && by >= 0 && board.Cells()[by][bx] != Cell::Empty);
+                }
+                if (!inside || !overlaps) {
+                    continue;
+                }
+                auto overlapping = snapshot;
+                overlapping[kOriginXByte] = static_cast<std::uint8_t>(static_cast<std::int8_t>(x));
+                overlapping[kOriginYByte] = static_cast<std::uint8_t>(static_cast<std::int8_t>(y));
+                Expect(!mctetris::model::DecodeSnapshot(overlapping.data(), overlapping.size(), model),
+                       "an overlapping piece is refused");
+                ++overlapsTried;
+                y = kBoardHeight;
+                break;
+            }
+        }
+    }
+    Expect(SameGame(model, before) && model.GetBoard().Hash() == before.GetBoard().Hash(),
+           "a refused snapshot leaves the model alone");
+}
+
+ReplayAction RandomAction(std::mt19937 &rng) {
+    const unsigned roll = rng() % 10;
+    return roll < 3 ? ReplayAction::Gravity : roll < 4 ? ReplayAction::HardDrop : static_cast<ReplayAction>(roll % 4);
+}
+
+void CheckSessions(std::mt19937 &rng) {
+    for (std::uint32_t seed = 0; seed < 20; ++seed) {
+        GameSession session(seed, static_cast<mctetris::model::Randomizer>(seed % 3));
+        const int played = static_cast<int>(rng() % 400);
+        for (int i = 0; i < played && !session.Model().IsGameOver(); ++i) {
+            (void)mctetris::model::ApplyReplayAction(session, RandomAction(rng));
+        }
+        std::array<std::uint8_t, kSessionSnapshotBytes> snapshot{};
+        Expect(mctetris::model::EncodeSessionSnapshot(session, snapshot.data()) == kSessionSnapshotBytes,
+               "session snapshot size");
+        GameSession resumed(~seed);
+        Expect(!mctetris::model::DecodeSessionSnapshot(snapshot.data(), kSessionSnapshotBytes - 1, resumed),
+               "a short session buffer is refused");
+        auto randomizer = snapshot;
+        randomizer[kSnapshotBytes] = 0xff;
+        Expect(!mctetris::model::DecodeSessionSnapshot(randomizer.data(), randomizer.size(), resumed),
+               "an unknown randomizer is refused");
+        if (!mctetris::model::DecodeSessionSnapshot(snapshot.data(), snapshot.size(), resumed)) {
+            Expect(false, "session snapshot decodes");
+            continue;
+        }
+        Expect(resumed.Seed() == session.Seed() && resumed.PiecesSpawned() == session.PiecesSpawned() &&
+                   resumed.Pieces().Kind() == session.Pieces().Kind() &&
+                   resumed.Pieces().Index() == session.Pieces().Index() && resumed.NextType() == session.NextType(),
+               "session state");
+        // Both must go on to play the same game.
+        for (int i = 0; i < 300 && !session.Model().IsGameOver(); ++i) {
+            const ReplayAction action = RandomAction(rng);
+            (void)mctetris::model::ApplyReplayAction(session, action);
+            (void)mctetris::model::ApplyReplayAction(resumed, action);
+        }
+        Expect(SameGame(resumed.Model(), session.Model()), "a resumed session plays on identically");
+    }
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(2024);
+    constexpr int kPositions = 20000;
+    for (int i = 0; i < kPositions; ++i) {
+        const Board board = RandomBoard(rng);
+        GameModel source;
+        source.Restore(board, rng() % 8 == 0 ? std::nullopt : RandomPiece(board, rng),
+                       static_cast<int>(rng() % 100000), static_cast<int>(rng() % 100),
+                       static_cast<int>(rng() % 100000000), rng() % 4 == 0);
+
+        std::vector<std::uint8_t> snapshot(kSnapshotBytes);
+        Expect(mctetris::model::EncodeSnapshot(source, snapshot.data()) == kSnapshotBytes, "snapshot size");
+        GameModel decoded;
+        if (!mctetris::model::DecodeSnapshot(snapshot.data(), snapshot.size(), decoded)) {
+            Expect(false, "snapshot decodes");
+            continue;
+        }
+        Expect(SameGame(decoded, source), "round trip");
+        CheckDerived(decoded.GetBoard(), source.GetBoard());
+        std::vector<std::uint8_t> again(kSnapshotBytes);
+        (void)mctetris::model::EncodeSnapshot(decoded, again.data());
+        Expect(again == snapshot, "re-encoding gives the same bytes");
+        if (i % 20 == 0) {
+            CheckRejections(snapshot, source, rng);
+        }
+    }
+    CheckSessions(rng);
+
+    std::printf("%d positions, %d overlapping pieces tried, %d failures\n", kPositions, overlapsTried, failures);
+    return failures == 0 ? 0 : 1;
+}